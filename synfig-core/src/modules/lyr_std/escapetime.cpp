@@ -0,0 +1,248 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file escapetime.cpp
+**	\brief Implementation of escape-time iteration and rendering tasks of fractal layers
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+**
+** ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "escapetime.h"
+
+#include <synfig/rendering/software/surfacesw.h>
+
+#endif
+
+// SSE2 is always available on x86-64, so it is used without runtime detection
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+#	define ESCAPETIME_SSE2
+#	include <emmintrin.h>
+#endif
+
+// calc_row() must give the same bits as calc(), so multiplications and additions
+// of calc() are not fused into FMA instructions, which SSE2 code doesn't use
+#if defined(__clang__)
+#	pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#	pragma GCC optimize("fp-contract=off")
+#endif
+
+using namespace synfig;
+using namespace modules;
+using namespace lyr_std;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+EscapeTime::Result
+EscapeTime::calc(const Vector &pos) const
+{
+	Real cr, ci, zr, zi, zr_hold;
+	if (julia) {
+		cr = seed[0]; ci = seed[1];
+		zr = pos[0]; zi = pos[1];
+	} else {
+		cr = pos[0]; ci = pos[1];
+		zr = zi = 0;
+	}
+
+	// magnitude is stored in ColorReal, so the rounded value is compared with bailout
+	ColorReal mag(0);
+	for(int i = 0; i < iterations; ++i) {
+		zr_hold = zr;
+		zr = zr*zr - zi*zi + cr;
+		if (broken && !julia) zr += zi;
+		zi = zr_hold*zi*2 + ci;
+		if (broken && julia) zr += zi;
+
+		mag = zr*zr + zi*zi;
+		if (mag > bailout)
+			return Result{i, zr, zi, mag};
+	}
+	return Result{-1, zr, zi, mag};
+}
+
+void
+EscapeTime::calc_row(const Vector &pos, const Vector &dx, int count, Result *out) const
+{
+	int i = 0;
+
+	#ifdef ESCAPETIME_SSE2
+	// two points are iterated by the same instructions until both escape,
+	// operations are the same as in calc(), so results are identical
+	const __m128d two = _mm_set1_pd(2.0);
+	const __m128d bailout2 = _mm_set1_pd(bailout);
+	const __m128d seed_r = _mm_set1_pd(seed[0]);
+	const __m128d seed_i = _mm_set1_pd(seed[1]);
+	for(; i + 2 <= count; i += 2) {
+		const Vector p0 = pos + dx*Real(i);
+		const Vector p1 = pos + dx*Real(i + 1);
+		const __m128d pr = _mm_setr_pd(p0[0], p1[0]);
+		const __m128d pi = _mm_setr_pd(p0[1], p1[1]);
+
+		__m128d cr, ci, zr, zi;
+		if (julia) {
+			cr = seed_r; ci = seed_i;
+			zr = pr; zi = pi;
+		} else {
+			cr = pr; ci = pi;
+			zr = zi = _mm_setzero_pd();
+		}
+
+		__m128d mag = _mm_setzero_pd();
+		__m128d res_zr = zr, res_zi = zi, res_mag = mag;
+		int iteration[2] = { -1, -1 };
+		int active = 3;
+
+		for(int j = 0; j < iterations; ++j) {
+			const __m128d zr_hold = zr;
+			zr = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(zr, zr), _mm_mul_pd(zi, zi)), cr);
+			if (broken && !julia) zr = _mm_add_pd(zr, zi);
+			zi = _mm_add_pd(_mm_mul_pd(_mm_mul_pd(zr_hold, zi), two), ci);
+			if (broken && julia) zr = _mm_add_pd(zr, zi);
+
+			mag = _mm_add_pd(_mm_mul_pd(zr, zr), _mm_mul_pd(zi, zi));
+			mag = _mm_cvtps_pd(_mm_cvtpd_ps(mag));
+
+			const int escaped = _mm_movemask_pd(_mm_cmpgt_pd(mag, bailout2)) & active;
+			if (escaped) {
+				const __m128d mask = _mm_castsi128_pd(_mm_setr_epi32(
+					escaped & 1 ? -1 : 0, escaped & 1 ? -1 : 0,
+					escaped & 2 ? -1 : 0, escaped & 2 ? -1 : 0 ));
+				res_zr  = _mm_or_pd(_mm_and_pd(mask, zr),  _mm_andnot_pd(mask, res_zr));
+				res_zi  = _mm_or_pd(_mm_and_pd(mask, zi),  _mm_andnot_pd(mask, res_zi));
+				res_mag = _mm_or_pd(_mm_and_pd(mask, mag), _mm_andnot_pd(mask, res_mag));
+				if (escaped & 1) iteration[0] = j;
+				if (escaped & 2) iteration[1] = j;
+				active &= ~escaped;
+				if (!active)
+					break;
+			}
+		}
+
+		// points inside of the set keep values of the last iteration
+		if (active) {
+			const __m128d mask = _mm_castsi128_pd(_mm_setr_epi32(
+				active & 1 ? -1 : 0, active & 1 ? -1 : 0,
+				active & 2 ? -1 : 0, active & 2 ? -1 : 0 ));
+			res_zr  = _mm_or_pd(_mm_and_pd(mask, zr),  _mm_andnot_pd(mask, res_zr));
+			res_zi  = _mm_or_pd(_mm_and_pd(mask, zi),  _mm_andnot_pd(mask, res_zi));
+			res_mag = _mm_or_pd(_mm_and_pd(mask, mag), _mm_andnot_pd(mask, res_mag));
+		}
+
+		double r[2], im[2], m[2];
+		_mm_storeu_pd(r, res_zr);
+		_mm_storeu_pd(im, res_zi);
+		_mm_storeu_pd(m, res_mag);
+		out[i]     = Result{iteration[0], r[0], im[0], (ColorReal)m[0]};
+		out[i + 1] = Result{iteration[1], r[1], im[1], (ColorReal)m[1]};
+	}
+	#endif
+
+	for(; i < count; ++i)
+		out[i] = calc(pos + dx*Real(i));
+}
+
+
+rendering::Transformation::Handle
+TaskEscapeTime::get_transformation() const
+{
+	// transformation of the task would not be applied to the context
+	if (context_task())
+		return rendering::Transformation::Handle();
+	return transformation.handle();
+}
+
+void
+TaskEscapeTime::set_coords_sub_tasks()
+{
+	if (const Task::Handle &target = sub_task(0))
+		target->set_coords(source_rect, target_rect.get_size());
+
+	if (const Task::Handle &context = context_task()) {
+		if (is_valid_coords())
+			context->set_coords(get_context_rect(), VectorInt(get_context_size(), get_context_size()));
+		else
+			context->set_coords_zero();
+	}
+}
+
+
+bool
+TaskEscapeTimeSW::run_escape_time_task() const
+{
+	const TaskEscapeTime *task = dynamic_cast<const TaskEscapeTime*>(this);
+	if (!task)
+		return false;
+
+	const rendering::Task::Handle &context = task->context_task();
+	if (!context || !context->is_valid())
+		return run_task();
+
+	LockRead lock(context);
+	if (!lock)
+		return false;
+
+	// units to pixels of context surface, the same as in Layer_RenderingTask
+	const RectInt &tr = context->target_rect;
+	const Rect &sr = context->source_rect;
+	context_matrix = Matrix();
+	context_matrix.m00 = (tr.maxx - tr.minx)/(sr.maxx - sr.minx);
+	context_matrix.m11 = (tr.maxy - tr.miny)/(sr.maxy - sr.miny);
+	context_matrix.m20 = tr.minx - sr.minx*context_matrix.m00;
+	context_matrix.m21 = tr.miny - sr.miny*context_matrix.m11;
+	context_rect = Rect(tr.minx, tr.miny, tr.maxx, tr.maxy);
+	context_surface = &lock->get_surface();
+
+	const bool success = run_task();
+	context_surface = nullptr;
+	return success;
+}
+
+Color
+TaskEscapeTimeSW::get_context_color(const Vector &pos) const
+{
+	if (context_surface) {
+		const Vector p = context_matrix.get_transformed(pos);
+		if (context_rect.is_inside(p))
+			return context_surface->linear_sample(p[0], p[1]);
+	}
+	return Color(0.0, 0.0, 0.0, 0.0);
+}
+
+Real
+TaskEscapeTimeSW::get_split_pixel_cost() const
+{
+	const TaskEscapeTime *task = dynamic_cast<const TaskEscapeTime*>(this);
+	return TaskPaintPixelSW::get_split_pixel_cost() + (task ? 0.5*task->escape_time.iterations : 0.0);
+}
+
+/* === E N T R Y P O I N T ================================================= */
@@ -0,0 +1,151 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file escapetime.h
+**	\brief Header file for escape-time iteration and rendering tasks of fractal layers
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+**
+** ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_ESCAPETIME_H
+#define __SYNFIG_ESCAPETIME_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/color.h>
+#include <synfig/matrix.h>
+#include <synfig/rect.h>
+#include <synfig/surface.h>
+#include <synfig/vector.h>
+
+#include <synfig/rendering/common/task/tasktransformation.h>
+#include <synfig/rendering/software/task/taskpaintpixelsw.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace modules
+{
+namespace lyr_std
+{
+
+/*!	\class EscapeTime
+**	\brief Iterates z = z*z + c until |z|^2 exceeds the bailout
+**
+**	For the Mandelbrot set z starts from zero and c is the position of pixel,
+**	for the Julia set z starts from the position and c is the seed.
+*/
+class EscapeTime
+{
+public:
+	struct Result
+	{
+		//! iteration where z escaped, -1 if the point is inside of the set
+		int iteration;
+		//! z at the moment of escape or after the last iteration
+		Real zr, zi;
+		//! squared magnitude of z
+		ColorReal mag;
+	};
+
+	bool julia;
+	//! "broken" variant of equation, it differs for Mandelbrot and Julia sets
+	bool broken;
+	int iterations;
+	//! bound of squared magnitude
+	Real bailout;
+	//! c for the Julia set
+	Vector seed;
+
+	EscapeTime(): julia(), broken(), iterations(), bailout(4) { }
+
+	Result calc(const Vector &pos) const;
+	//! Calculates \a count points starting at \a pos with step \a dx,
+	//! several points are iterated simultaneously when SIMD is available
+	void calc_row(const Vector &pos, const Vector &dx, int count, Result *out) const;
+};
+
+/*!	\class TaskEscapeTime
+**	\brief Base of rendering tasks of fractal layers
+**
+**	When the layer shows the context inside or outside of the set,
+**	the context is rendered by the sub-task in the fixed window around the origin
+**	and the task can't absorb transformations, because they would not be applied to the context.
+**	The sub_task(0) is reserved for blending to target.
+*/
+class TaskEscapeTime: public rendering::Task, public rendering::TaskInterfaceTransformation
+{
+public:
+	typedef etl::handle<TaskEscapeTime> Handle;
+
+	EscapeTime escape_time;
+
+	const Task::Handle& context_task() const { return sub_task(1); }
+	Task::Handle& context_task() { return sub_task(1); }
+
+	//! Window and resolution where the context is rendered
+	static Rect get_context_rect() { return Rect(-5.0, -5.0, 5.0, 5.0); }
+	static int get_context_size() { return 512; }
+
+	rendering::Transformation::Handle get_transformation() const override;
+	void set_coords_sub_tasks() override;
+
+private:
+	rendering::Holder<rendering::TransformationAffine> transformation;
+};
+
+/*!	\class TaskEscapeTimeSW
+**	\brief Software part of fractal tasks, which samples the rendered context
+**
+**	The task is split between threads by OptimizerSplit as any TaskPaintPixelSW,
+**	get_split_pixel_cost() makes it split even for small target rects.
+*/
+class TaskEscapeTimeSW: public rendering::TaskPaintPixelSW
+{
+private:
+	//! valid while run_escape_time_task() is running, each part of split task is a separate copy
+	mutable const Surface *context_surface;
+	mutable Matrix context_matrix;
+	mutable Rect context_rect;
+
+public:
+	TaskEscapeTimeSW(): context_surface() { }
+
+	//! Call it from run() instead of run_task()
+	bool run_escape_time_task() const;
+
+	//! Color of the context at the point, transparent outside of the rendered window
+	Color get_context_color(const Vector &pos) const;
+
+	//! iterations are the most of work
+	Real get_split_pixel_cost() const override;
+};
+
+}; // END of namespace lyr_std
+}; // END of namespace modules
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
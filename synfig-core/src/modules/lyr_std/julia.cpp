@@ -34,6 +34,7 @@
 #endif
 
 #include "julia.h"
+#include "escapetime.h"
 
 #include <synfig/localization.h>
 
@@ -61,6 +62,107 @@ SYNFIG_LAYER_SET_VERSION(Julia,"0.2");
 
 /* === M E T H O D S ======================================================= */
 
+class TaskJulia: public TaskEscapeTime
+{
+public:
+	typedef etl::handle<TaskJulia> Handle;
+	SYNFIG_EXPORT static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	Color icolor;
+	Color ocolor;
+	Angle color_shift;
+
+	bool distort_inside, shade_inside, solid_inside, invert_inside, color_inside;
+	bool distort_outside, shade_outside, solid_outside, invert_outside, color_outside;
+	bool color_cycle;
+	bool smooth_outside;
+
+	TaskJulia():
+		distort_inside(), shade_inside(), solid_inside(), invert_inside(), color_inside(),
+		distort_outside(), shade_outside(), solid_outside(), invert_outside(), color_outside(),
+		color_cycle(), smooth_outside()
+	{ }
+};
+
+class TaskJuliaSW: public TaskJulia, public TaskEscapeTimeSW
+{
+public:
+	typedef etl::handle<TaskJuliaSW> Handle;
+	SYNFIG_EXPORT static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	bool run(RunParams&) const override
+	{
+		return run_escape_time_task();
+	}
+
+	Color get_color(const Vector& pos) const override
+	{
+		return get_color(pos, escape_time.calc(pos));
+	}
+
+	void get_colors(const Vector& pos, const Vector& dx, int count, Color* out) const override
+	{
+		std::vector<EscapeTime::Result> results(count);
+		escape_time.calc_row(pos, dx, count, results.data());
+		for(int i = 0; i < count; ++i)
+			out[i] = get_color(pos + dx*Real(i), results[i]);
+	}
+
+private:
+	Color get_color(const Vector& pos, const EscapeTime::Result& r) const
+	{
+		Color ret;
+		if (r.iteration >= 0) {
+			ColorReal depth;
+			if (smooth_outside) {
+				// Linas Vepstas algo (see Julia::get_color())
+				depth = (ColorReal)r.iteration - log(log(sqrt(r.mag))) / LOG_OF_2;
+				if (depth < 0) depth = 0;
+			} else {
+				depth = static_cast<ColorReal>(r.iteration);
+			}
+
+			if (solid_outside)
+				ret = ocolor;
+			else
+				ret = get_context_color(distort_outside ? Point(r.zr, r.zi) : pos);
+
+			if (invert_outside)
+				ret = ~ret;
+			if (color_outside)
+				ret = ret.set_uv(r.zr, r.zi).clamped_negative();
+			if (color_cycle)
+				ret = ret.rotate_uv(color_shift.operator*(depth)).clamped_negative();
+			if (shade_outside) {
+				ColorReal alpha = depth/static_cast<ColorReal>(escape_time.iterations);
+				ret = (ocolor - ret)*alpha + ret;
+			}
+			return ret;
+		}
+
+		if (solid_inside)
+			ret = icolor;
+		else
+			ret = get_context_color(distort_inside ? Point(r.zr, r.zi) : pos);
+
+		if (invert_inside)
+			ret = ~ret;
+		if (color_inside)
+			ret = ret.set_uv(r.zr, r.zi).clamped_negative();
+		if (shade_inside)
+			ret = (icolor - ret)*r.mag + ret;
+		return ret;
+	}
+};
+
+SYNFIG_EXPORT rendering::Task::Token TaskJulia::token(
+	DescAbstract<TaskJulia>("TaskJulia") );
+SYNFIG_EXPORT rendering::Task::Token TaskJuliaSW::token(
+	DescReal<TaskJuliaSW, TaskJulia>("TaskJuliaSW") );
+
+
 Julia::Julia():
 param_color_shift(ValueBase(Angle::deg(0)))
 {
@@ -357,3 +459,37 @@ Julia::get_param_vocab()const
 
 	return ret;
 }
+
+rendering::Task::Handle
+Julia::build_rendering_task_vfunc(Context context) const
+{
+	TaskJulia::Handle task(new TaskJulia());
+	task->escape_time.julia = true;
+	task->escape_time.broken = param_broken.get(bool());
+	task->escape_time.iterations = param_iterations.get(int());
+	task->escape_time.bailout = squared_bailout;
+	task->escape_time.seed = param_seed.get(Point());
+
+	task->icolor = param_icolor.get(Color());
+	task->ocolor = param_ocolor.get(Color());
+	task->color_shift = param_color_shift.get(Angle());
+
+	task->distort_inside = param_distort_inside.get(bool());
+	task->shade_inside = param_shade_inside.get(bool());
+	task->solid_inside = param_solid_inside.get(bool());
+	task->invert_inside = param_invert_inside.get(bool());
+	task->color_inside = param_color_inside.get(bool());
+	task->distort_outside = param_distort_outside.get(bool());
+	task->shade_outside = param_shade_outside.get(bool());
+	task->solid_outside = param_solid_outside.get(bool());
+	task->invert_outside = param_invert_outside.get(bool());
+	task->color_outside = param_color_outside.get(bool());
+	task->color_cycle = param_color_cycle.get(bool());
+	task->smooth_outside = param_smooth_outside.get(bool());
+
+	// solid colors inside and outside of the set hide the context
+	if (!task->solid_inside || !task->solid_outside)
+		task->context_task() = context.build_rendering_task();
+
+	return task;
+}
@@ -34,6 +34,7 @@
 #endif
 
 #include "mandelbrot.h"
+#include "escapetime.h"
 
 #include <synfig/localization.h>
 
@@ -97,6 +98,111 @@ color_neg_flip(Color &color)
 
 /* === M E T H O D S ======================================================= */
 
+class TaskMandelbrot: public TaskEscapeTime
+{
+public:
+	typedef etl::handle<TaskMandelbrot> Handle;
+	SYNFIG_EXPORT static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	Real lp;
+
+	bool distort_inside, shade_inside, solid_inside, invert_inside;
+	Gradient gradient_inside;
+	Real gradient_offset_inside;
+	bool gradient_loop_inside;
+
+	bool distort_outside, shade_outside, solid_outside, invert_outside;
+	Gradient gradient_outside;
+	bool smooth_outside;
+	Real gradient_offset_outside;
+	Real gradient_scale_outside;
+
+	TaskMandelbrot():
+		lp(),
+		distort_inside(), shade_inside(), solid_inside(), invert_inside(),
+		gradient_offset_inside(), gradient_loop_inside(),
+		distort_outside(), shade_outside(), solid_outside(), invert_outside(),
+		smooth_outside(), gradient_offset_outside(), gradient_scale_outside(1.0)
+	{ }
+};
+
+class TaskMandelbrotSW: public TaskMandelbrot, public TaskEscapeTimeSW
+{
+public:
+	typedef etl::handle<TaskMandelbrotSW> Handle;
+	SYNFIG_EXPORT static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	bool run(RunParams&) const override
+	{
+		return run_escape_time_task();
+	}
+
+	Color get_color(const Vector& pos) const override
+	{
+		return get_color(pos, escape_time.calc(pos));
+	}
+
+	void get_colors(const Vector& pos, const Vector& dx, int count, Color* out) const override
+	{
+		std::vector<EscapeTime::Result> results(count);
+		escape_time.calc_row(pos, dx, count, results.data());
+		for(int i = 0; i < count; ++i)
+			out[i] = get_color(pos + dx*Real(i), results[i]);
+	}
+
+private:
+	Color get_color(const Vector& pos, const EscapeTime::Result& r) const
+	{
+		Color ret;
+		if (r.iteration >= 0) {
+			ColorReal depth;
+			if (smooth_outside) {
+				// Linas Vepstas algo (see Mandelbrot::get_color())
+				depth = (ColorReal)r.iteration + LOG_OF_2*lp - log(log(sqrt(r.mag))) / LOG_OF_2;
+				if (depth < 0) depth = 0;
+			} else {
+				depth = static_cast<ColorReal>(r.iteration);
+			}
+
+			ColorReal amount(depth/static_cast<ColorReal>(escape_time.iterations));
+			amount = amount*gradient_scale_outside + gradient_offset_outside;
+			amount -= floor(amount);
+
+			if (solid_outside)
+				return gradient_outside(amount);
+
+			ret = get_context_color(distort_outside ? Point(pos[0] + r.zr, pos[1] + r.zi) : pos);
+			if (invert_outside)
+				ret = ~ret;
+			if (shade_outside)
+				ret = Color::blend(gradient_outside(amount), ret, 1.0);
+			return ret;
+		}
+
+		ColorReal amount(std::fabs(r.mag + gradient_offset_inside));
+		if (gradient_loop_inside)
+			amount -= floor(amount);
+
+		if (solid_inside)
+			return gradient_inside(amount);
+
+		ret = get_context_color(distort_inside ? Point(pos[0] + r.zr, pos[1] + r.zi) : pos);
+		if (invert_inside)
+			ret = ~ret;
+		if (shade_inside)
+			ret = Color::blend(gradient_inside(amount), ret, 1.0);
+		return ret;
+	}
+};
+
+SYNFIG_EXPORT rendering::Task::Token TaskMandelbrot::token(
+	DescAbstract<TaskMandelbrot>("TaskMandelbrot") );
+SYNFIG_EXPORT rendering::Task::Token TaskMandelbrotSW::token(
+	DescReal<TaskMandelbrotSW, TaskMandelbrot>("TaskMandelbrotSW") );
+
+
 Mandelbrot::Mandelbrot():
 	param_gradient_inside(ValueBase(Gradient(Color::alpha(),Color::black()))),
 	param_gradient_offset_inside(ValueBase(Real(0.0))),
@@ -432,3 +538,43 @@ Mandelbrot::set_version(const String &ver)
 
 	return true;
 }
+
+rendering::Task::Handle
+Mandelbrot::build_rendering_task_vfunc(Context context) const
+{
+	const bool invert_gradient_to_fix = param_broken_gradient.get(bool());
+
+	TaskMandelbrot::Handle task(new TaskMandelbrot());
+	task->escape_time.julia = false;
+	task->escape_time.broken = param_broken.get(bool());
+	task->escape_time.iterations = param_iterations.get(int());
+	task->escape_time.bailout = param_bailout.get(Real());
+	task->lp = lp;
+
+	task->distort_inside = param_distort_inside.get(bool());
+	task->shade_inside = param_shade_inside.get(bool());
+	task->solid_inside = param_solid_inside.get(bool());
+	task->invert_inside = param_invert_inside.get(bool());
+	task->gradient_inside = param_gradient_inside.get(Gradient());
+	if (invert_gradient_to_fix)
+		task->gradient_inside = Gradient::from_bad_version(task->gradient_inside);
+	task->gradient_offset_inside = param_gradient_offset_inside.get(Real());
+	task->gradient_loop_inside = param_gradient_loop_inside.get(bool());
+
+	task->distort_outside = param_distort_outside.get(bool());
+	task->shade_outside = param_shade_outside.get(bool());
+	task->solid_outside = param_solid_outside.get(bool());
+	task->invert_outside = param_invert_outside.get(bool());
+	task->gradient_outside = param_gradient_outside.get(Gradient());
+	if (invert_gradient_to_fix)
+		task->gradient_outside = Gradient::from_bad_version(task->gradient_outside);
+	task->smooth_outside = param_smooth_outside.get(bool());
+	task->gradient_offset_outside = param_gradient_offset_outside.get(Real());
+	task->gradient_scale_outside = param_gradient_scale_outside.get(Real());
+
+	// solid colors inside and outside of the set hide the context
+	if (!task->solid_inside || !task->solid_outside)
+		task->context_task() = context.build_rendering_task();
+
+	return task;
+}
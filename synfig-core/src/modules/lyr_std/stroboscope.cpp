@@ -106,15 +106,20 @@ Layer_Stroboscope::get_param_vocab()const
 	return ret;
 }
 
-void
-Layer_Stroboscope::set_time_vfunc(IndependentContext context, Time t)const
+Time
+Layer_Stroboscope::get_strobe_time(Time t)const
 {
 	float frequency=param_frequency.get(float());
-	
+
 	Time ret_time=Time::begin();
 	if(frequency > 0.0)
 		ret_time = Time(1.0)/frequency*floor(t*frequency);
+	return ret_time;
+}
 
-	context.set_time(ret_time);
+void
+Layer_Stroboscope::set_time_vfunc(IndependentContext context, Time t)const
+{
+	context.set_time(get_strobe_time(t));
 }
 
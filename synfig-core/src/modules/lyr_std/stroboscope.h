@@ -59,6 +59,9 @@ private:
 	//!Parameter (float)
 	ValueBase param_frequency;
 
+	//! Moment of the last strobe flash before \a time
+	Time get_strobe_time(Time time)const;
+
 protected:
 	Layer_Stroboscope();
 
@@ -112,6 +112,18 @@ public:
 				(Color::value_type)bindex / (Color::value_type)255.0,
 				1.0);
 	}
+
+	void get_colors(const Vector& pos, const Vector& dx, int count, Color* out) const override
+	{
+		// the same as get_color() for each pixel, but without virtual calls
+		Vector p = pos;
+		for(Color *end = out + count; out < end; ++out, p += dx)
+			*out = TaskXORPatternSW::get_color(p);
+	}
+
+	//! color of pixel is a few integer operations
+	Real get_split_pixel_cost() const override
+		{ return 2.0; }
 };
 
 SYNFIG_EXPORT rendering::Task::Token TaskXORPattern::token(
@@ -147,7 +147,6 @@ inline short little_endian_short(const short &x)
 
 bmp::bmp(const synfig::filesystem::Path& Filename, const synfig::TargetParam& params):
 	rowspan(),
-	imagecount(),
 	multi_image(false),
 	filename(Filename),
 	pf()
@@ -168,12 +167,18 @@ bmp::is_multiple_files() const
 
 filesystem::Path
 bmp::get_filename() const
+{
+	return get_frame_filename(desc.get_frame_start());
+}
+
+filesystem::Path
+bmp::get_frame_filename(int frame) const
 {
 	if (!multi_image)
 		return filename;
 	if (filename.u8string() == "-")
 		return filename;
-	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), desc.get_frame_start()));
+	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), frame));
 }
 
 bool
@@ -197,7 +202,6 @@ bmp::set_rend_desc(RendDesc *given_desc)
 	if(desc.get_frame_end()-desc.get_frame_start()>0)
 	{
 		multi_image=true;
-		imagecount=desc.get_frame_start();
 	}
 	else
 		multi_image=false;
@@ -210,7 +214,6 @@ bmp::end_frame()
 {
 	file.reset();
 	color_buffer.clear();
-	imagecount++;
 }
 
 bool
@@ -224,11 +227,11 @@ bmp::start_frame(synfig::ProgressCallback *callback)
 
 	if (filename.u8string() == "-") {
 		if (callback)
-			callback->task(strprintf("(stdout) %d",imagecount));
+			callback->task(strprintf("(stdout) %d",get_frame()));
 		file = stdout;
 	} else {
 		if (multi_image) {
-			newfilename.add_suffix(strprintf("%s%04d", sequence_separator.c_str(), imagecount));
+			newfilename = get_frame_filename(get_frame());
 
 			if (callback)
 				callback->task(newfilename.u8string() + _(" (animated)"));
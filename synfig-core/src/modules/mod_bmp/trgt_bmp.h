@@ -47,7 +47,6 @@ class bmp : public synfig::Target_Scanline
 private:
 
 	int rowspan;
-	int imagecount;
 	bool multi_image;
 	synfig::SmartFILE file;
 	synfig::filesystem::Path filename;
@@ -62,6 +61,7 @@ public:
 
 	bool is_multiple_files() const override;
 	synfig::filesystem::Path get_filename() const override;
+	synfig::filesystem::Path get_frame_filename(int frame) const override;
 
 	bool set_rend_desc(synfig::RendDesc* desc) override;
 
@@ -35,6 +35,9 @@
 
 #include "mptr_ffmpeg.h"
 
+#include <algorithm>
+#include <cctype>
+
 #include <synfig/general.h>
 #include <synfig/localization.h>
 
@@ -69,72 +72,68 @@ bool ffmpeg_mptr::is_animated()
 	return true;
 }
 
-bool
-ffmpeg_mptr::seek_to(const Time& time)
+OS::RunPipe::Handle
+ffmpeg_mptr::seek_to(const Time& time) const
 {
-	//if(frame<cur_frame || !file)
-	//{
-		pipe = nullptr;
-		
-		// FIXME: 24 fps is hardcoded now, but in fact we have to get it from canvas
-		//float position = (frame+1)/24; // ffmpeg didn't work with 0 frame
-		//float position = 1000/24; // ffmpeg didn't work with 0 frame
-		const std::string position = time.get_string(Time::FORMAT_NORMAL);
-
-		OS::RunArgs args;
-		args.push_back({"-ss", position});
-		args.push_back("-i");
-		args.push_back(filesystem::Path(identifier.filename));
-		args.push_back({"-vframes", "1"});
-		args.push_back("-an");
-		args.push_back({"-f", "image2pipe"});
-		args.push_back({"-vcodec", "ppm"});
-		args.push_back("-");
+	// FIXME: 24 fps is hardcoded now, but in fact we have to get it from canvas
+	//float position = (frame+1)/24; // ffmpeg didn't work with 0 frame
+	//float position = 1000/24; // ffmpeg didn't work with 0 frame
+	const std::string position = time.get_string(Time::FORMAT_NORMAL);
+
+	OS::RunArgs args;
+	args.push_back({"-ss", position});
+	args.push_back("-i");
+	args.push_back(filesystem::Path(identifier.filename));
+	args.push_back({"-vframes", "1"});
+	args.push_back("-an");
+	args.push_back({"-f", "image2pipe"});
+	args.push_back({"-vcodec", "ppm"});
+	args.push_back("-");
 
 #ifdef _WIN32
-		synfig::filesystem::Path binary_path = synfig::OS::get_binary_path();
-		if (!binary_path.empty())
-			binary_path = binary_path.parent_path();
-		binary_path /= filesystem::Path("ffmpeg.exe");
+	synfig::filesystem::Path binary_path = synfig::OS::get_binary_path();
+	if (!binary_path.empty())
+		binary_path = binary_path.parent_path();
+	binary_path /= filesystem::Path("ffmpeg.exe");
 #else
-		synfig::filesystem::Path binary_path("ffmpeg");
+	synfig::filesystem::Path binary_path("ffmpeg");
 #endif
-		pipe = OS::run_async(binary_path, args, OS::RUN_MODE_READ);
+	OS::RunPipe::Handle pipe = OS::run_async(binary_path, args, OS::RUN_MODE_READ);
 
-		if(!pipe)
-		{
-			synfig::error(_("Unable to open pipe to ffmpeg"));
-			return false;
-		}
-		cur_frame=-1;
-	//}
-
-	//while(cur_frame<frame-1)
-	//{
-	//	cerr<<"Seeking to..."<<frame<<'('<<cur_frame<<')'<<endl;
-	//	if(!grab_frame())
-	//		return false;
-	//}
-	return true;
+	if(!pipe)
+		synfig::error(_("Unable to open pipe to ffmpeg"));
+	return pipe;
 }
 
-bool
-ffmpeg_mptr::grab_frame(void)
+//! Reads the number from PPM header, skips whitespaces and comments before it
+static bool
+read_header_value(OS::RunPipe &pipe, int &value)
 {
-	if(!pipe)
-	{
-		synfig::error(_("unable to open %s"), identifier.filename.u8_str());
-		return false;
+	int c = pipe.getc();
+	while(c == '#' || isspace(c)) {
+		if (c == '#')
+			while(c != EOF && c != '\n') c = pipe.getc();
+		c = pipe.getc();
 	}
-	int w,h;
-	float divisor;
+	if (!isdigit(c))
+		return false;
+	for(value = 0; isdigit(c); c = pipe.getc())
+		value = value*10 + (c - '0');
+	// single whitespace after the number, it is the end of header after maxval
+	return isspace(c);
+}
+
+bool
+ffmpeg_mptr::grab_frame(OS::RunPipe &pipe)
+{
+	int w, h, maxval;
 	char cookie[2];
-	cookie[0]=pipe->getc();
+	cookie[0]=pipe.getc();
 
-	if(pipe->eof())
+	if(pipe.eof())
 		return false;
 
-	cookie[1]=pipe->getc();
+	cookie[1]=pipe.getc();
 
 	if(cookie[0]!='P' || cookie[1]!='6')
 	{
@@ -142,33 +141,55 @@ ffmpeg_mptr::grab_frame(void)
 		return false;
 	}
 
-	pipe->getc();
-	pipe->scanf("%d %d\n",&w,&h);
-	pipe->scanf("%f",&divisor);
-	pipe->getc();
+	if ( !read_header_value(pipe, w)
+	  || !read_header_value(pipe, h)
+	  || !read_header_value(pipe, maxval)
+	  || w <= 0 || h <= 0 || maxval <= 0 || maxval > 65535 )
+	{
+		synfig::error(_("wrong PPM header in stream of %s"), identifier.filename.u8_str());
+		return false;
+	}
 
-	if(pipe->eof())
+	// whole frame is read by one call, samples bigger than 255 take two bytes
+	const int sample_size = maxval > 255 ? 2 : 1;
+	const std::size_t row_size = (std::size_t)w*3*sample_size;
+	buffer.resize(row_size*h);
+	if (pipe.read(buffer.data(), row_size, h) != (std::size_t)h)
 		return false;
 
+	// samples are linear, as they always were, so the table has no gamma
+	if (table.get_maxval() != maxval)
+		table.set(Gamma(), maxval);
+	const ColorReal *tr = table.get(0);
+	const ColorReal *tg = table.get(1);
+	const ColorReal *tb = table.get(2);
+
 	frame.set_wh(w, h);
-	const ColorReal k = 1/255.0;
-	for(int y = 0; y < frame.get_h(); ++y)
-		for(int x = 0; x < frame.get_w(); ++x)
+	for(int y = 0; y < h; ++y)
+	{
+		const unsigned char *src = &buffer[y*row_size];
+		Color *dst = frame[y];
+		if (sample_size == 1)
 		{
-			if(pipe->eof())
-				return false;
-			ColorReal r = k*(unsigned char)pipe->getc();
-			ColorReal g = k*(unsigned char)pipe->getc();
-			ColorReal b = k*(unsigned char)pipe->getc();
-			frame[y][x] = Color(r, g, b);
+			for(int x = 0; x < w; ++x, src += 3)
+				dst[x] = Color(tr[src[0]], tg[src[1]], tb[src[2]]);
 		}
-	cur_frame++;
+		else
+		{
+			// big-endian samples, values over maxval are clamped
+			for(int x = 0; x < w; ++x, src += 6)
+				dst[x] = Color(
+					tr[std::min(maxval, (src[0] << 8) | src[1])],
+					tg[std::min(maxval, (src[2] << 8) | src[3])],
+					tb[std::min(maxval, (src[4] << 8) | src[5])] );
+		}
+	}
 	return true;
 }
 
 ffmpeg_mptr::ffmpeg_mptr(const synfig::FileSystem::Identifier& identifier)
 	: synfig::Importer(identifier),
-	  pipe(nullptr), cur_frame(-1), fps(23.98)
+	  fps(23.98)
 {
 #ifdef HAVE_TERMIOS_H
 	tcgetattr (0, &oldtty);
@@ -177,7 +198,6 @@ ffmpeg_mptr::ffmpeg_mptr(const synfig::FileSystem::Identifier& identifier)
 
 ffmpeg_mptr::~ffmpeg_mptr()
 {
-	pipe = nullptr;
 #ifdef HAVE_TERMIOS_H
 	tcsetattr(0,TCSANOW,&oldtty);
 #endif
@@ -186,10 +206,18 @@ ffmpeg_mptr::~ffmpeg_mptr()
 bool
 ffmpeg_mptr::get_frame(synfig::Surface &surface, const synfig::RendDesc &/*renddesc*/, Time time, synfig::ProgressCallback *)
 {
-	synfig::warning("time: %f", (float)time);
-	if(!seek_to(time))
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// the next frames of sequential rendering are decoded in advance
+	// by the frame cache of Importer in IO slots of ThreadPool,
+	// while the current frame is rendered, so each frame is decoded on request
+	OS::RunPipe::Handle pipe = seek_to(time);
+	if (!pipe)
+	{
+		synfig::error(_("unable to open %s"), identifier.filename.u8_str());
 		return false;
-	if(!grab_frame())
+	}
+	if (!grab_frame(*pipe))
 		return false;
 
 	surface=frame;
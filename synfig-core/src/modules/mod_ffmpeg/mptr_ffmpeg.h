@@ -30,6 +30,10 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <mutex>
+#include <vector>
+
+#include <synfig/color/gamma.h>
 #include <synfig/importer.h>
 #include <synfig/os.h>
 #include <synfig/surface.h>
@@ -48,16 +52,19 @@ class ffmpeg_mptr : public synfig::Importer
 {
 	SYNFIG_IMPORTER_MODULE_EXT
 private:
-	synfig::OS::RunPipe::Handle pipe;
-	int cur_frame;
 	synfig::Surface frame;
+	std::vector<unsigned char> buffer;
+	//! Samples are converted by table, it is rebuilt only when maxval of stream is changed
+	synfig::GammaTable table;
 	float fps;
 #ifdef HAVE_TERMIOS_H
 	struct termios oldtty;
 #endif
 
-	bool seek_to(const synfig::Time& time);
-	bool grab_frame(void);
+	std::mutex mutex;
+
+	synfig::OS::RunPipe::Handle seek_to(const synfig::Time& time) const;
+	bool grab_frame(synfig::OS::RunPipe &pipe);
 
 public:
 	ffmpeg_mptr(const synfig::FileSystem::Identifier &identifier);
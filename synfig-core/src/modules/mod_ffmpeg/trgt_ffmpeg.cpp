@@ -36,6 +36,9 @@
 
 #include "trgt_ffmpeg.h"
 
+#include <cstdint>
+#include <cstring>
+
 #include <synfig/filesystemnative.h>
 #include <synfig/general.h>
 #include <synfig/localization.h>
@@ -43,6 +46,12 @@
 
 #endif
 
+// SSE2 is always available on x86-64, so it is used without runtime detection
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+#	define TRGT_FFMPEG_SSE2
+#	include <emmintrin.h>
+#endif
+
 /* === M A C R O S ========================================================= */
 
 using namespace synfig;
@@ -69,7 +78,12 @@ ffmpeg_trgt::ffmpeg_trgt(const synfig::filesystem::Path& Filename, const synfig:
 	imagecount(0),
 	multi_image(false),
 	filename(Filename),
-	bitrate()
+	bitrate(),
+	raw_format(RAW_RGB24),
+	scanline(0),
+	frame(nullptr),
+	writer_stop(false),
+	writer_failed(false)
 {
 	// Set default video codec and bitrate if they weren't given.
 	if (params.video_codec == "none")
@@ -82,6 +96,21 @@ ffmpeg_trgt::ffmpeg_trgt(const synfig::filesystem::Path& Filename, const synfig:
 	else
 		bitrate = params.bitrate;
 
+	// variants with alpha and with explicit byte order are accepted too
+	std::string pixel_format = params.pixel_format;
+	if (pixel_format.size() > 2 && pixel_format.compare(pixel_format.size() - 2, 2, "le") == 0)
+		pixel_format.resize(pixel_format.size() - 2);
+	if (pixel_format.empty() || pixel_format == "rgb24" || pixel_format == "rgba")
+		raw_format = RAW_RGB24;
+	else
+	if (pixel_format == "rgb48" || pixel_format == "rgba64")
+		raw_format = RAW_RGB48;
+	else
+	if (pixel_format == "gbrpf32" || pixel_format == "gbrapf32")
+		raw_format = RAW_GBRPF32;
+	else
+		synfig::warning(_("Unknown pixel format \"%s\", rgb24 will be used"), params.pixel_format.c_str());
+
 	if (does_video_codec_support_alpha_channel(video_codec))
 		set_alpha_mode(TARGET_ALPHA_MODE_KEEP);
 	else
@@ -90,6 +119,9 @@ ffmpeg_trgt::ffmpeg_trgt(const synfig::filesystem::Path& Filename, const synfig:
 
 ffmpeg_trgt::~ffmpeg_trgt()
 {
+	// ffmpeg should get all of the rendered frames before the pipe is closed
+	stop_writer();
+
 	if(pipe)
 	{
 		pipe->close();
@@ -223,8 +255,6 @@ ffmpeg_trgt::init(ProgressCallback* cb = nullptr)
 	if(desc.get_frame_end()-desc.get_frame_start()>0)
 		multi_image=true;
 
-	const bool use_alpha = get_alpha_mode() == TARGET_ALPHA_MODE_KEEP;
-
 	std::string video_codec_real = (video_codec == "libx264-lossless" ? "libx264" : video_codec);
 
 	OS::RunArgs vargs;
@@ -233,9 +263,11 @@ ffmpeg_trgt::init(ProgressCallback* cb = nullptr)
 		vargs.push_back(sound_filename);
 	}
 	vargs.push_back("-f");
-	vargs.push_back("image2pipe");
-	vargs.push_back("-vcodec");
-	vargs.push_back(use_alpha ? "pam" : "ppm");
+	vargs.push_back("rawvideo");
+	vargs.push_back("-pix_fmt");
+	vargs.push_back(get_raw_pix_fmt());
+	vargs.push_back("-s");
+	vargs.push_back(strprintf("%dx%d", desc.get_w(), desc.get_h()));
 	vargs.push_back("-r");
 	{
 		// this should avoid conflicts with locale settings
@@ -254,10 +286,10 @@ ffmpeg_trgt::init(ProgressCallback* cb = nullptr)
 		vargs.push_back("-tune");
 		vargs.push_back("fastdecode");
 		vargs.push_back("-pix_fmt");
-		vargs.push_back(use_alpha ? "yuva420p" : "yuv420p");
+		vargs.push_back(use_alpha() ? "yuva420p" : "yuv420p");
 		vargs.push_back("-qp");
 		vargs.push_back("0");
-	} else if (use_alpha){
+	} else if (use_alpha()){
 		if (video_codec == "hap") {
 			vargs.push_back("-format");
 			vargs.push_back("hap_alpha");
@@ -297,67 +329,246 @@ ffmpeg_trgt::init(ProgressCallback* cb = nullptr)
 
 	synfig::info(_("Running async command: %s"), pipe->get_command().c_str());
 
+	frame_buffers.assign(frame_buffer_count, FrameBuffer(get_frame_size()));
+	for(FrameBuffer &buffer : frame_buffers)
+		free_frames.push_back(&buffer);
+	writer = std::thread(&ffmpeg_trgt::write_frames, this);
+
 	return true;
 }
 
+bool
+ffmpeg_trgt::use_alpha() const
+{
+	return get_alpha_mode() == TARGET_ALPHA_MODE_KEEP;
+}
+
+const char*
+ffmpeg_trgt::get_raw_pix_fmt() const
+{
+	// words and floats are written in the byte order of the host
+	switch(raw_format) {
+#ifdef WORDS_BIGENDIAN
+	case RAW_RGB48:   return use_alpha() ? "rgba64be" : "rgb48be";
+	case RAW_GBRPF32: return use_alpha() ? "gbrapf32be" : "gbrpf32be";
+#else
+	case RAW_RGB48:   return use_alpha() ? "rgba64le" : "rgb48le";
+	case RAW_GBRPF32: return use_alpha() ? "gbrapf32le" : "gbrpf32le";
+#endif
+	default: break;
+	}
+	return use_alpha() ? "rgba" : "rgb24";
+}
+
+std::size_t
+ffmpeg_trgt::get_frame_size() const
+{
+	const std::size_t channels = use_alpha() ? 4 : 3;
+	const std::size_t channel_size = raw_format == RAW_RGB24 ? 1
+	                               : raw_format == RAW_RGB48 ? 2 : 4;
+	return (std::size_t)desc.get_w()*desc.get_h()*channels*channel_size;
+}
+
+static inline std::uint16_t
+color_to_word(ColorReal x)
+	{ return (std::uint16_t)(synfig::clamp(x, 0.f, 1.f)*65535.f + 0.5f); }
+
+//! Converts row of colors to 16-bit words, \a dst should have space for one more pixel
+static void
+colors_to_words(std::uint16_t *dst, const Color *src, int count, int channels)
+{
+	int x = 0;
+
+	#ifdef TRGT_FFMPEG_SSE2
+	// two pixels by the one pack, rounding is the same as in color_to_word(),
+	// words are packed as signed with offset, because SSE2 has no unsigned pack of dwords
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 k = _mm_set1_ps(65535.f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128i offset = _mm_set1_epi32(32768);
+	const __m128i sign = _mm_set1_epi16(-32768);
+	for(; x + 2 <= count; x += 2, src += 2) {
+		__m128i c[2];
+		for(int i = 0; i < 2; ++i) {
+			__m128 v = _mm_loadu_ps((const float*)(src + i));
+			v = _mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, zero), one), k), half);
+			c[i] = _mm_sub_epi32(_mm_cvttps_epi32(v), offset);
+		}
+		const __m128i words = _mm_xor_si128(_mm_packs_epi32(c[0], c[1]), sign);
+		if (channels == 4) {
+			_mm_storeu_si128((__m128i*)dst, words);
+			dst += 8;
+		} else {
+			// alpha of each pixel is overwritten by the next one
+			_mm_storel_epi64((__m128i*)dst, words);
+			_mm_storel_epi64((__m128i*)(dst + 3), _mm_srli_si128(words, 8));
+			dst += 6;
+		}
+	}
+	#endif
+
+	for(; x < count; ++x, ++src, dst += channels) {
+		dst[0] = color_to_word(src->get_r());
+		dst[1] = color_to_word(src->get_g());
+		dst[2] = color_to_word(src->get_b());
+		if (channels == 4)
+			dst[3] = color_to_word(src->get_a());
+	}
+}
+
+void
+ffmpeg_trgt::convert_scanline(unsigned char *dst, const Color *src, int y)
+{
+	const int w = desc.get_w();
+	const int h = desc.get_h();
+	const int channels = use_alpha() ? 4 : 3;
+
+	// rows are converted into the native words or floats and then copied at once
+	switch(raw_format) {
+	case RAW_RGB24:
+		color_to_pixelformat(
+			dst + (std::size_t)y*w*channels, src,
+			use_alpha() ? PF_RGB|PF_A : PF_RGB, nullptr, w );
+		break;
+	case RAW_RGB48: {
+		colors_to_words(row_words.data(), src, w, channels);
+		const std::size_t size = (std::size_t)w*channels*sizeof(std::uint16_t);
+		memcpy(dst + y*size, row_words.data(), size);
+		break;
+	}
+	case RAW_GBRPF32: {
+		// separate planes of green, blue, red and alpha,
+		// simple loops without branches are vectorized by compiler
+		const std::size_t size = (std::size_t)w*sizeof(float);
+		for(int p = 0; p < channels; ++p) {
+			float *row = row_floats.data();
+			switch(p) {
+			case 0: for(int x = 0; x < w; ++x) row[x] = src[x].get_g(); break;
+			case 1: for(int x = 0; x < w; ++x) row[x] = src[x].get_b(); break;
+			case 2: for(int x = 0; x < w; ++x) row[x] = src[x].get_r(); break;
+			default: for(int x = 0; x < w; ++x) row[x] = src[x].get_a(); break;
+			}
+			memcpy(dst + ((std::size_t)p*h + y)*size, row, size);
+		}
+		break;
+	}
+	}
+}
+
+void
+ffmpeg_trgt::write_frames()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		cond.wait(lock, [this] { return writer_stop || !queued_frames.empty(); });
+		if (queued_frames.empty())
+			break;
+
+		// whole frame is written by one call, without lock,
+		// so the next frame is converted at the same time
+		FrameBuffer *buffer = queued_frames.front();
+		lock.unlock();
+		bool success = pipe->write(buffer->data(), 1, buffer->size()) == buffer->size();
+		pipe->flush();
+		lock.lock();
+
+		queued_frames.pop_front();
+		free_frames.push_back(buffer);
+		if (!success)
+			writer_failed = true;
+		cond.notify_all();
+	}
+}
+
+void
+ffmpeg_trgt::stop_writer()
+{
+	if (!writer.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		writer_stop = true;
+	}
+	cond.notify_all();
+	writer.join();
+}
+
+bool
+ffmpeg_trgt::render(ProgressCallback *cb)
+{
+	bool success = Target_Scanline::render(cb);
+
+	// the render is done only when ffmpeg got all of the frames and finished the file
+	stop_writer();
+	if (writer_failed) {
+		if (cb) cb->error(_("Unable to write frame to ffmpeg"));
+		synfig::error(_("Unable to write frame to ffmpeg"));
+		success = false;
+	}
+	if (pipe) {
+		int status = pipe->close();
+		pipe = nullptr;
+		if (status != 0) {
+			if (cb) cb->error(strprintf(_("ffmpeg exited with status %d"), status));
+			synfig::error(_("ffmpeg exited with status %d"), status);
+			success = false;
+		}
+	}
+	return success;
+}
+
 void
 ffmpeg_trgt::end_frame()
 {
-	//pipe->print(" ");
-	pipe->flush();
+	if (frame) {
+		std::lock_guard<std::mutex> lock(mutex);
+		queued_frames.push_back(frame);
+		frame = nullptr;
+	}
+	cond.notify_all();
 	imagecount++;
 }
 
 bool
 ffmpeg_trgt::start_frame(synfig::ProgressCallback */*callback*/)
 {
-	std::size_t w=desc.get_w(),h=desc.get_h();
-
-	if(!pipe || !pipe->is_writable())
+	if(!pipe || !pipe->is_writable() || !writer.joinable())
 		return false;
 
-	const bool use_alpha = get_alpha_mode() == TARGET_ALPHA_MODE_KEEP;
-
-	if (!use_alpha) {
-		pipe->printf("P6\n");
-		pipe->printf("%zu %zu\n", w, h);
-		pipe->printf("%d\n", 255);
-	} else {
-		pipe->printf("P7\n");
-		pipe->printf("WIDTH %zu\n", w);
-		pipe->printf("HEIGHT %zu\n", h);
-		pipe->printf("DEPTH 4\n");
-		pipe->printf("MAXVAL %d\n", 255);
-		pipe->printf("TUPLTYPE RGB_ALPHA\n");
-		pipe->printf("ENDHDR\n");
+	// wait until ffmpeg takes one of the previous frames
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this] { return writer_failed || !free_frames.empty(); });
+		if (writer_failed) {
+			synfig::error(_("Unable to write frame to ffmpeg"));
+			return false;
+		}
+		frame = free_frames.front();
+		free_frames.pop_front();
 	}
 
-	buffer.resize(w * (use_alpha ? 4 : 3));
-	color_buffer.resize(w);
+	color_buffer.resize(desc.get_w());
+	row_words.resize(((std::size_t)desc.get_w() + 1)*4);
+	row_floats.resize(desc.get_w());
 
 	return true;
 }
 
 Color *
-ffmpeg_trgt::start_scanline(int /*scanline*/)
+ffmpeg_trgt::start_scanline(int scanline)
 {
+	this->scanline = scanline;
 	return color_buffer.empty() ? nullptr : color_buffer.data();
 }
 
 bool
 ffmpeg_trgt::end_scanline()
 {
-	if(!pipe)
+	if(!frame || scanline < 0 || scanline >= desc.get_h())
 		return false;
 
-	PixelFormat format = PF_RGB;
-	if(get_alpha_mode() == TARGET_ALPHA_MODE_KEEP)
-		format |= PF_A;
-
-	color_to_pixelformat(buffer.data(), color_buffer.data(), format, 0, desc.get_w());
-
-	if(!pipe->write(buffer.data(),1,buffer.size()))
-		return false;
+	convert_scanline(frame->data(), color_buffer.data(), scanline);
 
 	return true;
 }
@@ -31,6 +31,12 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #include <synfig/os.h>
 #include <synfig/string.h>
 #include <synfig/target_scanline.h>
@@ -48,18 +54,53 @@ class ffmpeg_trgt : public synfig::Target_Scanline
 	SYNFIG_TARGET_MODULE_EXT
 
 private:
+	//! Pixel formats of raw frames passed to ffmpeg, each of them has the variant with alpha
+	enum RawFormat {
+		RAW_RGB24,   //!< rgb24 or rgba
+		RAW_RGB48,   //!< rgb48le or rgba64le
+		RAW_GBRPF32  //!< gbrpf32le or gbrapf32le, planar
+	};
+
+	//! While one frame buffer is written to ffmpeg, the next frame is converted into the other one
+	static constexpr int frame_buffer_count = 2;
+
+	typedef std::vector<unsigned char> FrameBuffer;
+
 	int imagecount;
 	bool multi_image;
 	synfig::OS::RunPipe::Handle pipe;
 	synfig::filesystem::Path filename;
 	synfig::filesystem::Path sound_filename;
-	std::vector<unsigned char> buffer;
 	std::vector<synfig::Color> color_buffer;
+	std::vector<std::uint16_t> row_words;
+	std::vector<float> row_floats;
 	std::string video_codec;
 	int bitrate;
+	RawFormat raw_format;
+
+	int scanline;
+	FrameBuffer *frame;
+	std::vector<FrameBuffer> frame_buffers;
+	std::deque<FrameBuffer*> free_frames;
+	std::deque<FrameBuffer*> queued_frames;
+
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool writer_stop;
+	bool writer_failed;
 
 	bool does_video_codec_support_alpha_channel(const synfig::String& video_codec) const;
 
+	bool use_alpha() const;
+	const char* get_raw_pix_fmt() const;
+	std::size_t get_frame_size() const;
+	void convert_scanline(unsigned char *dst, const synfig::Color *src, int y);
+
+	//! Writes the queued frames to the pipe, runs in the writer thread
+	void write_frames();
+	void stop_writer();
+
 public:
 
 	ffmpeg_trgt(const synfig::filesystem::Path& filename,
@@ -73,6 +114,9 @@ public:
 	//! Initialization tasks of ffmpeg target.
 	//! @returns true if the initialization has no errors
 	bool init(synfig::ProgressCallback* cb) override;
+	//! Renders all of the frames and waits until ffmpeg writes them.
+	//! @returns false if ffmpeg did not accept some frame or failed to encode them
+	bool render(synfig::ProgressCallback* cb) override;
 
 	bool start_frame(synfig::ProgressCallback* cb) override;
 	void end_frame() override;
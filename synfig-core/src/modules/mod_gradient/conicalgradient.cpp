@@ -101,7 +101,8 @@ public:
 		return run_task();
 	}
 
-	Color get_color(const Vector& p) const override
+	//! Position \a x in gradient and half-width \a w of averaging
+	void get_position(const Vector& p, Real& x, Real& w) const
 	{
 		const Point centered(p-center);
 		Real supersample;
@@ -112,12 +113,23 @@ public:
 
 		Angle::rot a = Angle::tan(-centered[1],centered[0]).mod();
 		a += angle;
-		Real dist(a.mod().get());
+		x = a.mod().get();
+		w = supersample*0.5;
+	}
 
-		supersample *= 0.5;
-		return compiled_gradient.average(dist - supersample, dist + supersample);
+	Color get_color(const Vector& p) const override
+	{
+		Real dist, w;
+		get_position(p, dist, w);
+		return compiled_gradient.average(dist - w, dist + w);
 		//return compiled_gradient.color(dist);
 	}
+
+	void get_colors(const Vector& p, const Vector& dx, int count, Color* out) const override
+	{
+		compiled_gradient.average_row(p, dx, count, out,
+			[this](const Vector& point, Real& x, Real& w) { get_position(point, x, w); });
+	}
 };
 
 SYNFIG_EXPORT rendering::Task::Token TaskConicalGradient::token(
@@ -95,12 +95,26 @@ public:
 		return run_task();
 	}
 
+	//! Position \a x in gradient and half-width \a w of averaging
+	void get_position(const Vector& p, Real& x, Real& w) const
+	{
+		x = (p - params.p1)*params.diff;
+		w = supersample;
+	}
+
 	Color get_color(const Vector& p) const override
 	{
-		Real dist((p - params.p1)*params.diff);
-		return params.gradient.average(dist - supersample, dist + supersample);
+		Real dist, w;
+		get_position(p, dist, w);
+		return params.gradient.average(dist - w, dist + w);
 		//return params.gradient.color(dist);
 	}
+
+	void get_colors(const Vector& p, const Vector& dx, int count, Color* out) const override
+	{
+		params.gradient.average_row(p, dx, count, out,
+			[this](const Vector& point, Real& x, Real& w) { get_position(point, x, w); });
+	}
 };
 
 SYNFIG_EXPORT rendering::Task::Token TaskLinearGradient::token(
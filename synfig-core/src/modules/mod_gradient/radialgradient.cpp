@@ -101,13 +101,26 @@ public:
 		return run_task();
 	}
 
-	Color get_color(const Vector& p) const override
+	//! Position \a x in gradient and half-width \a w of averaging
+	void get_position(const Vector& p, Real& x, Real& w) const
 	{
-		Real dist((p-center).mag()/radius);
+		x = (p-center).mag()/radius;
+		w = supersample;
+	}
 
-		return compiled_gradient.average(dist - supersample, dist + supersample);
+	Color get_color(const Vector& p) const override
+	{
+		Real dist, w;
+		get_position(p, dist, w);
+		return compiled_gradient.average(dist - w, dist + w);
 		//return params.gradient.color(dist);
 	}
+
+	void get_colors(const Vector& p, const Vector& dx, int count, Color* out) const override
+	{
+		compiled_gradient.average_row(p, dx, count, out,
+			[this](const Vector& point, Real& x, Real& w) { get_position(point, x, w); });
+	}
 };
 
 SYNFIG_EXPORT rendering::Task::Token TaskRadialGradient::token(
@@ -101,7 +101,8 @@ public:
 		return run_task();
 	}
 
-	Color get_color(const Vector& p) const override
+	//! Position \a x in gradient and half-width \a w of averaging
+	void get_position(const Vector& p, Real& x, Real& w) const
 	{
 		const Point centered(p-center);
 		Real supersample = (1.41421*pw/radius+(1.41421*pw/centered.mag())/(PI*2))*0.5;
@@ -118,9 +119,23 @@ public:
 			dist-=Angle::rot(a.mod()).get();
 
 //		supersample *= 0.5;
-		return compiled_gradient.average(dist - supersample, dist + supersample);
+		x = dist;
+		w = supersample;
+	}
+
+	Color get_color(const Vector& p) const override
+	{
+		Real dist, w;
+		get_position(p, dist, w);
+		return compiled_gradient.average(dist - w, dist + w);
 		//return compiled_gradient.color(dist);
 	}
+
+	void get_colors(const Vector& p, const Vector& dx, int count, Color* out) const override
+	{
+		compiled_gradient.average_row(p, dx, count, out,
+			[this](const Vector& point, Real& x, Real& w) { get_position(point, x, w); });
+	}
 };
 
 SYNFIG_EXPORT rendering::Task::Token TaskSpiralGradient::token(
@@ -55,7 +55,6 @@ SYNFIG_TARGET_SET_VERSION(imagemagick_trgt,"0.1");
 /* === M E T H O D S ======================================================= */
 
 imagemagick_trgt::imagemagick_trgt(const synfig::filesystem::Path& Filename, const synfig::TargetParam& params):
-	imagecount(),
 	multi_image(false),
 	filename(Filename),
 	pf(),
@@ -74,12 +73,18 @@ imagemagick_trgt::is_multiple_files() const
 
 filesystem::Path
 imagemagick_trgt::get_filename() const
+{
+	return get_frame_filename(desc.get_frame_start());
+}
+
+filesystem::Path
+imagemagick_trgt::get_frame_filename(int frame) const
 {
 	if (!multi_image)
 		return filename;
 	if (filename.u8string() == "-")
 		return filename;
-	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), desc.get_frame_start()));
+	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), frame));
 }
 
 bool
@@ -97,7 +102,6 @@ imagemagick_trgt::set_rend_desc(RendDesc *given_desc)
 bool
 imagemagick_trgt::init(synfig::ProgressCallback * /* cb */)
 {
-	imagecount=desc.get_frame_start();
 	if(desc.get_frame_end()-desc.get_frame_start()>0)
 		multi_image=true;
 
@@ -113,7 +117,6 @@ imagemagick_trgt::end_frame()
 		pipe->close();
 		pipe = nullptr;
 	}
-	imagecount++;
 }
 
 bool
@@ -121,10 +124,7 @@ imagemagick_trgt::start_frame(synfig::ProgressCallback *cb)
 {
 	const char *msg=_("Unable to open pipe to imagemagick utility");
 
-	synfig::filesystem::Path newfilename = filename;
-
-	if (multi_image)
-		newfilename.add_suffix(sequence_separator + strprintf("%04d", imagecount));
+	const synfig::filesystem::Path newfilename = get_frame_filename(get_frame());
 
 	// pair (binary name, first argument)
 	std::vector<std::pair<std::string, std::string>> binaries {
@@ -45,7 +45,6 @@ class imagemagick_trgt : public synfig::Target_Scanline
 	SYNFIG_TARGET_MODULE_EXT
 
 private:
-	int imagecount;
 	bool multi_image;
 	synfig::OS::RunPipe::Handle pipe;
 	synfig::filesystem::Path filename;
@@ -62,6 +61,7 @@ public:
 
 	bool is_multiple_files() const override;
 	synfig::filesystem::Path get_filename() const override;
+	synfig::filesystem::Path get_frame_filename(int frame) const override;
 
 	bool set_rend_desc(synfig::RendDesc* desc) override;
 	bool init(synfig::ProgressCallback* cb) override;
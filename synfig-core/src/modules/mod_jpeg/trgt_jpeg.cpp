@@ -59,7 +59,6 @@ jpeg_trgt::jpeg_trgt(const synfig::filesystem::Path& Filename, const synfig::Tar
 	jerr(),
 	multi_image(),
 	ready(false),
-	imagecount(),
 	filename(Filename),
 	sequence_separator(params.sequence_separator)
 {
@@ -84,19 +83,24 @@ jpeg_trgt::is_multiple_files() const
 
 filesystem::Path
 jpeg_trgt::get_filename() const
+{
+	return get_frame_filename(desc.get_frame_start());
+}
+
+filesystem::Path
+jpeg_trgt::get_frame_filename(int frame) const
 {
 	if (!multi_image)
 		return filename;
 	if (filename.u8string() == "-")
 		return filename;
-	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), desc.get_frame_start()));
+	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), frame));
 }
 
 bool
 jpeg_trgt::set_rend_desc(RendDesc *given_desc)
 {
 	desc=*given_desc;
-	imagecount=desc.get_frame_start();
 	if(desc.get_frame_end()-desc.get_frame_start()>0)
 		multi_image=true;
 	else
@@ -111,13 +115,10 @@ jpeg_trgt::start_frame(synfig::ProgressCallback *callback)
 
 	if (filename.u8string() == "-") {
 		if (callback)
-			callback->task(strprintf("(stdout) %d", imagecount));
+			callback->task(strprintf("(stdout) %d", get_frame()));
 		file = stdout;
 	} else {
-		synfig::filesystem::Path newfilename(filename);
-		if (multi_image) {
-			newfilename.add_suffix(sequence_separator + strprintf("%04d", imagecount));
-		}
+		const synfig::filesystem::Path newfilename = get_frame_filename(get_frame());
 		file = SmartFILE(newfilename, "wb");
 		if (callback)
 			callback->task(newfilename.u8string());
@@ -175,7 +176,6 @@ jpeg_trgt::end_frame()
 	}
 
 	file.reset();
-	imagecount++;
 }
 
 Color *
@@ -57,7 +57,6 @@ private:
 
 
 	bool multi_image,ready;
-	int imagecount;
 	synfig::filesystem::Path filename;
 	std::vector<unsigned char> buffer;
 	std::vector<synfig::Color> color_buffer;
@@ -68,6 +67,7 @@ public:
 
 	bool is_multiple_files() const override;
 	synfig::filesystem::Path get_filename() const override;
+	synfig::filesystem::Path get_frame_filename(int frame) const override;
 
 	bool set_rend_desc(synfig::RendDesc* desc) override;
 
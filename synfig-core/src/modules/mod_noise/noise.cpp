@@ -45,6 +45,7 @@
 #include <synfig/rendering/software/task/taskpaintpixelsw.h>
 #include <synfig/value.h>
 #include <ctime>
+#include <vector>
 
 #endif
 
@@ -102,7 +103,16 @@ public:
 		pixel_size = (std::fabs(get_units_per_pixel()[0]) + std::fabs(get_units_per_pixel()[1])) * 0.5f;
 	}
 
-	Color get_color(const Vector& point) const override
+	RandomNoise::SmoothType get_smooth_type() const
+	{
+		return (!speed && smooth == RandomNoise::SMOOTH_SPLINE)
+			 ? RandomNoise::SMOOTH_FAST_SPLINE
+			 : smooth;
+	}
+
+	//! Calculates noise \a amount, half-width \a da of averaging in gradient
+	//! (used when supersampling) and \a alpha at \a point
+	void get_noise(const Vector& point, RandomNoise::SmoothType smooth_type, float ftime, float& amount, Real& da, float& alpha) const
 	{
 		float x(point[0] / size[0] * (1 << detail));
 		float y(point[1] / size[1] * (1 << detail));
@@ -113,16 +123,10 @@ public:
 			y2 = (point[1] + pixel_size) / size[1] * (1 << detail);
 		}
 
-		const RandomNoise::SmoothType smooth_type((!speed && smooth == RandomNoise::SMOOTH_SPLINE)
-													? RandomNoise::SMOOTH_FAST_SPLINE
-													: smooth);
-
-		const float ftime(speed * time_mark);
-
-		float amount = 0.0f;
+		amount = 0.0f;
 		float amount2 = 0.0f;
 		float amount3 = 0.0f;
-		float alpha = 0.0f;
+		alpha = 0.0f;
 		for (int i = 0; i < detail; i++) {
 			amount = random(smooth_type, 0 + (detail - i) * 5, x, y, ftime) + amount * 0.5;
 			amount = synfig::clamp(amount, -1.f, 1.f);
@@ -167,26 +171,46 @@ public:
 			}
 		}
 
-		Color color;
-
+		da = 0;
 		if (super_sample && pixel_size) {
-			Real da = std::max(amount3, std::max(amount, amount2)) - std::min(amount3, std::min(amount, amount2));
+			da = std::max(amount3, std::max(amount, amount2)) - std::min(amount3, std::min(amount, amount2));
 			if (da < 0)
 				da = -da;
 			if (approximate_greater(da, 2.))
 				da = 2.;
 			da *= 0.5;
-			color = compiled_gradient.average(amount - da, amount + da);
-		} else {
-			color = compiled_gradient.color(amount);
 		}
+	}
 
-		if (do_alpha)
-			color.set_a(color.get_a() * alpha);
-
+	Color get_color(const Vector& point) const override
+	{
+		Color color;
+		get_colors(point, Vector(), 1, &color);
 		return color;
 	}
 
+	void get_colors(const Vector& p, const Vector& dx, int count, Color* out) const override
+	{
+		const RandomNoise::SmoothType smooth_type = get_smooth_type();
+		const float ftime(speed * time_mark);
+
+		// without supersampling the width is zero, so the average is the color at the position
+		std::vector<float> alpha(do_alpha ? count : 0);
+		float *a = alpha.data();
+		compiled_gradient.average_row(p, dx, count, out,
+			[&](const Vector& point, Real& x, Real& w) {
+				float amount, pixel_alpha;
+				get_noise(point, smooth_type, ftime, amount, w, pixel_alpha);
+				x = amount;
+				if (a)
+					*a++ = pixel_alpha;
+			});
+
+		if (do_alpha)
+			for (int i = 0; i < count; ++i)
+				out[i].set_a(out[i].get_a() * alpha[i]);
+	}
+
 	bool run(RunParams&) const override {
 		return run_task();
 	}
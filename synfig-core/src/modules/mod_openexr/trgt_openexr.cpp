@@ -34,7 +34,23 @@
 #endif
 
 #include "trgt_openexr.h"
-#include <cstdio>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+
+#include <OpenEXR/OpenEXRConfig.h>
+#include <OpenEXR/ImfChannelList.h>
+#include <OpenEXR/ImfFrameBuffer.h>
+#include <OpenEXR/ImfHeader.h>
+#include <OpenEXR/ImfOutputFile.h>
+#include <OpenEXR/ImfThreading.h>
+#include <OpenEXR/ImfTileDescription.h>
+#include <OpenEXR/ImfTiledOutputFile.h>
+
+#include <synfig/general.h>
+#include <synfig/localization.h>
 
 #endif
 
@@ -42,36 +58,95 @@
 
 using namespace synfig;
 
+// DWAA and DWAB compressions are available since OpenEXR 2.2
+#if defined(OPENEXR_VERSION_MAJOR) && (OPENEXR_VERSION_MAJOR > 2 || (OPENEXR_VERSION_MAJOR == 2 && OPENEXR_VERSION_MINOR >= 2))
+#	define EXR_HAS_DWA
+#endif
+
 /* === G L O B A L S ======================================================= */
 
 SYNFIG_TARGET_INIT(exr_trgt);
 SYNFIG_TARGET_SET_NAME(exr_trgt,"openexr");
 SYNFIG_TARGET_SET_EXT(exr_trgt,"exr");
-SYNFIG_TARGET_SET_VERSION(exr_trgt,"1.0.4");
+SYNFIG_TARGET_SET_VERSION(exr_trgt,"1.1.0");
 
-/* === M E T H O D S ======================================================= */
+/* === P R O C E D U R E S ================================================= */
 
-bool
-exr_trgt::ready()
+static Imf::Compression
+get_compression(const String &name)
+{
+	if (name.empty() || name == "zip") return Imf::ZIP_COMPRESSION;
+	if (name == "none")  return Imf::NO_COMPRESSION;
+	if (name == "rle")   return Imf::RLE_COMPRESSION;
+	if (name == "zips")  return Imf::ZIPS_COMPRESSION;
+	if (name == "piz")   return Imf::PIZ_COMPRESSION;
+	if (name == "pxr24") return Imf::PXR24_COMPRESSION;
+	if (name == "b44")   return Imf::B44_COMPRESSION;
+	if (name == "b44a")  return Imf::B44A_COMPRESSION;
+#ifdef EXR_HAS_DWA
+	if (name == "dwaa")  return Imf::DWAA_COMPRESSION;
+	if (name == "dwab")  return Imf::DWAB_COMPRESSION;
+#endif
+	synfig::warning(_("OpenEXR compression \"%s\" is not supported, ZIP is used"), name.c_str());
+	return Imf::ZIP_COMPRESSION;
+}
+
+static Imf::PixelType
+get_pixel_type(const String &name)
 {
-	return (bool)exr_file;
+	if (name.empty() || name == "half") return Imf::HALF;
+	if (name == "float") return Imf::FLOAT;
+	synfig::warning(_("OpenEXR pixel type \"%s\" is not supported, HALF is used"), name.c_str());
+	return Imf::HALF;
 }
 
+//! Bounding box of pixels with non-zero alpha, OpenEXR requires at least one pixel
+static Imath::Box2i
+get_data_window(const Surface &surface)
+{
+	const int w = surface.get_w(), h = surface.get_h();
+	int x0 = w, y0 = h, x1 = -1, y1 = -1;
+	for(int y = 0; y < h; ++y) {
+		const Color *row = surface[y];
+		int first = 0, last = w - 1;
+		while(first < w && row[first].get_a() <= 0) ++first;
+		if (first == w)
+			continue;
+		while(last > first && row[last].get_a() <= 0) --last;
+		if (y0 > y) y0 = y;
+		y1 = y;
+		if (x0 > first) x0 = first;
+		if (x1 < last) x1 = last;
+	}
+	if (x1 < 0)
+		return Imath::Box2i(Imath::V2i(0, 0), Imath::V2i(0, 0));
+	return Imath::Box2i(Imath::V2i(x0, y0), Imath::V2i(x1, y1));
+}
+
+/* === M E T H O D S ======================================================= */
+
 exr_trgt::exr_trgt(const synfig::filesystem::Path& Filename, const synfig::TargetParam& params):
 	multi_image(false),
-	imagecount(0),
-	scanline(),
 	filename(Filename),
-	exr_file(nullptr),
-	sequence_separator(params.sequence_separator)
+	sequence_separator(params.sequence_separator),
+	pixel_type(get_pixel_type(params.exr_pixel_type)),
+	compression(get_compression(params.exr_compression)),
+	tile_size(std::max(0, params.exr_tile_size)),
+	data_window(params.exr_data_window)
 {
 	// OpenEXR uses linear gamma
+
+	// compression of blocks of scanlines or tiles is distributed
+	// over the global thread pool of OpenEXR library
+	int threads = params.exr_threads;
+	if (threads < 0)
+		threads = (int)std::thread::hardware_concurrency();
+	if (threads != Imf::globalThreadCount())
+		Imf::setGlobalThreadCount(threads);
 }
 
 exr_trgt::~exr_trgt()
-{
-	if(exr_file) delete exr_file;
-}
+	{ }
 
 bool
 exr_trgt::is_multiple_files() const
@@ -81,20 +156,24 @@ exr_trgt::is_multiple_files() const
 
 filesystem::Path
 exr_trgt::get_filename() const
+{
+	return get_frame_filename(desc.get_frame_start());
+}
+
+filesystem::Path
+exr_trgt::get_frame_filename(int frame) const
 {
 	if (!multi_image)
 		return filename;
 	if (filename.u8string() == "-")
 		return filename;
-	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), desc.get_frame_start()));
+	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), frame));
 }
 
 bool
 exr_trgt::set_rend_desc(RendDesc *given_desc)
 {
-	//given_desc->set_pixel_format(PixelFormat((int)PF_RAW_COLOR));
 	desc=*given_desc;
-	imagecount=desc.get_frame_start();
 	if(desc.get_frame_end()-desc.get_frame_start()>0)
 		multi_image=true;
 	else
@@ -105,71 +184,68 @@ exr_trgt::set_rend_desc(RendDesc *given_desc)
 bool
 exr_trgt::start_frame(synfig::ProgressCallback *cb)
 {
-	int w=desc.get_w(),h=desc.get_h();
-
-	if (exr_file)
-		delete exr_file;
-
-	synfig::filesystem::Path frame_name = filename;
-
-	if (multi_image) {
-		frame_name.add_suffix(sequence_separator + strprintf("%04d",imagecount));
-	}
+	frame_name = get_frame_filename(get_frame());
 	if (cb)
 		cb->task(frame_name.u8string());
 
-	// OpenEXR implementation does not support wchar_t, so MS Windows users will have troubles sometimes
-	exr_file=new Imf::RgbaOutputFile(frame_name.u8_str(),w,h,Imf::WRITE_RGBA,desc.get_pixel_aspect());
-	buffer_color.resize(w);
-	//buffer.resize(w);
-	out_surface.set_wh(w,h);
-
+	surface.set_wh(desc.get_w(), desc.get_h());
 	return true;
 }
 
 void
-exr_trgt::end_frame()
+exr_trgt::write_frame()
 {
-	if(exr_file)
-	{
-		exr_file->setFrameBuffer(out_surface[0],1,desc.get_w());
-		exr_file->writePixels(desc.get_h());
-
-		delete exr_file;
+	const int w = surface.get_w(), h = surface.get_h();
+	const Imath::Box2i display_window(Imath::V2i(0, 0), Imath::V2i(w - 1, h - 1));
+	const Imath::Box2i window = data_window ? get_data_window(surface) : display_window;
+
+	Imf::Header header(display_window, window, desc.get_pixel_aspect());
+	header.compression() = compression;
+
+	// slices point to the channels of rendered colors,
+	// library converts them to half floats if needed
+	static_assert(sizeof(Color) == 4*sizeof(float), "Color must be four floats");
+	const char *channels[] = { "R", "G", "B", "A" };
+	char *base = (char*)surface[0];
+	Imf::FrameBuffer frame_buffer;
+	for(int i = 0; i < 4; ++i) {
+		header.channels().insert(channels[i], Imf::Channel(pixel_type));
+		frame_buffer.insert(channels[i], Imf::Slice(
+			Imf::FLOAT, base + i*sizeof(float), sizeof(Color), surface.get_pitch() ));
 	}
 
-	exr_file=0;
+	// OpenEXR implementation does not support wchar_t, so MS Windows users will have troubles sometimes
+	if (tile_size > 0) {
+		header.setTileDescription(Imf::TileDescription(tile_size, tile_size, Imf::ONE_LEVEL));
+		Imf::TiledOutputFile file(frame_name.u8_str(), header);
+		file.setFrameBuffer(frame_buffer);
+		file.writeTiles(0, file.numXTiles() - 1, 0, file.numYTiles() - 1);
+	} else {
+		Imf::OutputFile file(frame_name.u8_str(), header);
+		file.setFrameBuffer(frame_buffer);
+		file.writePixels(window.max.y - window.min.y + 1);
+	}
+}
 
-	imagecount++;
+void
+exr_trgt::end_frame()
+{
+	try {
+		write_frame();
+	} catch (const std::exception& e) {
+		synfig::error(_("Unable to write \"%s\": %s"), frame_name.u8_str(), e.what());
+		set_frame_failed();
+	}
 }
 
 Color *
 exr_trgt::start_scanline(int i)
 {
-	scanline=i;
-	return buffer_color.data();
+	return surface[i];
 }
 
 bool
 exr_trgt::end_scanline()
 {
-	if(!ready())
-		return false;
-
-	int i;
-	for(i=0;i<desc.get_w();i++)
-	{
-//		Imf::Rgba &rgba=buffer[i];
-		Imf::Rgba &rgba=out_surface[scanline][i];
-		Color &color=buffer_color[i];
-		rgba.r=color.get_r();
-		rgba.g=color.get_g();
-		rgba.b=color.get_b();
-		rgba.a=color.get_a();
-	}
-
-    //exr_file->setFrameBuffer(buffer,1,desc.get_w());
-	//exr_file->writePixels(1);
-
 	return true;
 }
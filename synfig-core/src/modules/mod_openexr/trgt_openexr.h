@@ -33,8 +33,8 @@
 #include <synfig/target_scanline.h>
 #include <synfig/string.h>
 #include <synfig/surface.h>
-#include <OpenEXR/ImfArray.h>
-#include <OpenEXR/ImfRgbaFile.h>
+#include <OpenEXR/ImfCompression.h>
+#include <OpenEXR/ImfPixelType.h>
 
 /* === M A C R O S ========================================================= */
 
@@ -50,15 +50,19 @@ public:
 private:
 
 	bool multi_image;
-	int imagecount,scanline;
 	synfig::filesystem::Path filename;
-	Imf::RgbaOutputFile *exr_file;
-	//std::vector<Imf::Rgba> buffer;
-	synfig::surface<Imf::Rgba> out_surface;
-	std::vector<synfig::Color> buffer_color;
+	synfig::filesystem::Path frame_name;
+	//! frame is rendered to the surface and written by OpenEXR at end_frame()
+	synfig::Surface surface;
 
-	bool ready();
 	synfig::String sequence_separator;
+	Imf::PixelType pixel_type;
+	Imf::Compression compression;
+	int tile_size;
+	bool data_window;
+
+	//! Writes the surface to frame_name, throws exceptions of OpenEXR library
+	void write_frame();
 
 public:
 
@@ -67,6 +71,7 @@ public:
 
 	bool is_multiple_files() const override;
 	synfig::filesystem::Path get_filename() const override;
+	synfig::filesystem::Path get_frame_filename(int frame) const override;
 
 	bool set_rend_desc(synfig::RendDesc* desc) override;
 
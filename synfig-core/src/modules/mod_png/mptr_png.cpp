@@ -62,12 +62,10 @@ SYNFIG_IMPORTER_SET_SUPPORTS_FILE_SYSTEM_WRAPPER(png_mptr, true);
 /* === M E T H O D S ======================================================= */
 
 namespace {
-	inline ColorReal get_channel(png_bytep *rows, int bit_depth, int row, int col) {
-		int x = bit_depth > 8
-			  ? GUINT16_FROM_BE((png_uint_16p(rows[row]))[col])
-			  : rows[row][col];
-		int max = (1 << bit_depth) - 1;
-		return x/ColorReal(max);
+	inline int get_channel(png_bytep *rows, int bit_depth, int row, int col) {
+		return bit_depth > 8
+			 ? GUINT16_FROM_BE((png_uint_16p(rows[row]))[col])
+			 : rows[row][col];
 	}
 }
 
@@ -239,41 +237,46 @@ png_mptr::get_frame(synfig::Surface &surface, const synfig::RendDesc &/*renddesc
 		return false;
 	}
 
+	// samples are converted by table, so pow() is not calculated for each pixel
+	GammaTable table;
+	if (color_type != PNG_COLOR_TYPE_PALETTE)
+		table.set(gamma, (1 << bit_depth) - 1);
+
 	surface.set_wh(width, height);
 	switch(color_type)
 	{
 	case PNG_COLOR_TYPE_RGB:
 		for(int y = 0; y < surface.get_h(); ++y)
 			for(int x = 0; x < surface.get_w(); ++x)
-				surface[y][x]=gamma.apply(Color(
+				surface[y][x] = table.apply(
 					get_channel(row_pointers.data(), bit_depth, y, x*3+0),
 					get_channel(row_pointers.data(), bit_depth, y, x*3+1),
-					get_channel(row_pointers.data(), bit_depth, y, x*3+2) ));
+					get_channel(row_pointers.data(), bit_depth, y, x*3+2) );
 		break;
 	case PNG_COLOR_TYPE_RGB_ALPHA:
 		for(int y = 0; y < surface.get_h(); ++y)
 			for(int x = 0; x < surface.get_w(); ++x)
-				surface[y][x]=gamma.apply(Color(
+				surface[y][x] = table.apply(
 					get_channel(row_pointers.data(), bit_depth, y, x*4+0),
 					get_channel(row_pointers.data(), bit_depth, y, x*4+1),
 					get_channel(row_pointers.data(), bit_depth, y, x*4+2),
-					get_channel(row_pointers.data(), bit_depth, y, x*4+3) ));
+					get_channel(row_pointers.data(), bit_depth, y, x*4+3) );
 		break;
 	case PNG_COLOR_TYPE_GRAY:
 		for(int y = 0; y < surface.get_h(); ++y)
 			for(int x = 0; x < surface.get_w(); ++x)
 			{
-				ColorReal gray = get_channel(row_pointers.data(), bit_depth, y, x);
-				surface[y][x] = gamma.apply(Color(gray, gray, gray));
+				int gray = get_channel(row_pointers.data(), bit_depth, y, x);
+				surface[y][x] = table.apply(gray, gray, gray);
 			}
 		break;
 	case PNG_COLOR_TYPE_GRAY_ALPHA:
 		for(int y = 0; y < surface.get_h(); ++y)
 			for(int x = 0; x < surface.get_w(); ++x)
 			{
-				ColorReal gray = get_channel(row_pointers.data(), bit_depth, y, x*2+0);
-				ColorReal a    = get_channel(row_pointers.data(), bit_depth, y, x*2+1);
-				surface[y][x] = gamma.apply(Color(gray, gray, gray, a));
+				int gray = get_channel(row_pointers.data(), bit_depth, y, x*2+0);
+				int a    = get_channel(row_pointers.data(), bit_depth, y, x*2+1);
+				surface[y][x] = table.apply(gray, gray, gray, a);
 			}
 		break;
 
@@ -291,18 +294,22 @@ png_mptr::get_frame(synfig::Surface &surface, const synfig::RendDesc &/*renddesc
 		int num_trans = 0;
 		bool has_alpha = png_get_tRNS(png_ptr, info_ptr, &trans_alpha, &num_trans, nullptr)
 		               & PNG_INFO_tRNS;
+		// convert palette once instead of each pixel
 		const ColorReal k = 1/255.0;
+		Color colors[256];
+		for(int i = 0; i < num_palette && i < 256; ++i)
+		{
+			ColorReal r = k*(unsigned char)palette[i].red;
+			ColorReal g = k*(unsigned char)palette[i].green;
+			ColorReal b = k*(unsigned char)palette[i].blue;
+			ColorReal a = 1;
+			if (has_alpha && num_trans > 0 && trans_alpha && i < num_trans)
+				a = k*(unsigned char)trans_alpha[i];
+			colors[i] = gamma.apply(Color(r, g, b, a));
+		}
 		for(int y = 0; y < surface.get_h(); ++y)
 			for(int x = 0; x < surface.get_w(); ++x)
-			{
-				ColorReal r = k*(unsigned char)palette[row_pointers[y][x]].red;
-				ColorReal g = k*(unsigned char)palette[row_pointers[y][x]].green;
-				ColorReal b = k*(unsigned char)palette[row_pointers[y][x]].blue;
-				ColorReal a = 1;
-				if (has_alpha && num_trans > 0 && trans_alpha && row_pointers[y][x] < num_trans)
-                    a = k*(unsigned char)trans_alpha[row_pointers[y][x]];
-				surface[y][x] = gamma.apply(Color(r, g, b, a));
-			}
+				surface[y][x] = colors[row_pointers[y][x]];
 		break;
 	}
 	default:
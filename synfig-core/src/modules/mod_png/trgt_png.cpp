@@ -37,6 +37,7 @@
 
 #include <png.h>
 
+#include <algorithm>
 #include <cstring> // memset and strlen
 
 #include <synfig/general.h>
@@ -56,6 +57,21 @@ SYNFIG_TARGET_SET_NAME(png_trgt,"png");
 SYNFIG_TARGET_SET_EXT(png_trgt,"png");
 SYNFIG_TARGET_SET_VERSION(png_trgt,"0.1");
 
+/* === P R O C E D U R E S ================================================= */
+
+static int
+get_png_filters(const String &name)
+{
+	if (name.empty() || name == "none") return PNG_FILTER_NONE;
+	if (name == "sub")     return PNG_FILTER_SUB;
+	if (name == "up")      return PNG_FILTER_UP;
+	if (name == "average") return PNG_FILTER_AVG;
+	if (name == "paeth")   return PNG_FILTER_PAETH;
+	if (name == "all")     return PNG_ALL_FILTERS;
+	synfig::warning("png_trgt: unknown filter \"%s\", using \"none\"", name.c_str());
+	return PNG_FILTER_NONE;
+}
+
 /* === M E T H O D S ======================================================= */
 
 void
@@ -82,9 +98,10 @@ png_trgt::png_trgt(const synfig::filesystem::Path& Filename, const synfig::Targe
 	info_ptr(nullptr),
 	multi_image(),
 	ready(false),
-	imagecount(),
 	filename(Filename),
-	sequence_separator(params.sequence_separator)
+	sequence_separator(params.sequence_separator),
+	compression_level(params.png_compression_level),
+	filters(get_png_filters(params.png_filter))
 { }
 
 png_trgt::~png_trgt()
@@ -99,12 +116,18 @@ png_trgt::is_multiple_files() const
 
 filesystem::Path
 png_trgt::get_filename() const
+{
+	return get_frame_filename(desc.get_frame_start());
+}
+
+filesystem::Path
+png_trgt::get_frame_filename(int frame) const
 {
 	if (!multi_image)
 		return filename;
 	if (filename.u8string() == "-")
 		return filename;
-	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), desc.get_frame_start()));
+	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), frame));
 }
 
 bool
@@ -112,7 +135,6 @@ png_trgt::set_rend_desc(RendDesc *given_desc)
 {
 	//given_desc->set_pixel_format(PixelFormat((int)PF_RGB|(int)PF_A));
 	desc=*given_desc;
-	imagecount=desc.get_frame_start();
 	if(desc.get_frame_end()-desc.get_frame_start()>0)
 		multi_image=true;
 	else
@@ -130,7 +152,6 @@ png_trgt::end_frame()
 	}
 
 	file.reset();
-	imagecount++;
 	ready=false;
 }
 
@@ -141,13 +162,10 @@ png_trgt::start_frame(synfig::ProgressCallback *callback)
 
 	if (filename.u8string() == "-") {
 		if (callback)
-			callback->task(strprintf("(stdout) %d", imagecount));
+			callback->task(strprintf("(stdout) %d", get_frame()));
 		file = stdout;
 	} else {
-		synfig::filesystem::Path newfilename(filename);
-		if (multi_image) {
-			newfilename.add_suffix(sequence_separator + strprintf("%04d", imagecount));
-		}
+		const synfig::filesystem::Path newfilename = get_frame_filename(get_frame());
 		file = SmartFILE(newfilename, "wb");
 		if (callback)
 			callback->task(newfilename.u8string());
@@ -189,7 +207,9 @@ png_trgt::start_frame(synfig::ProgressCallback *callback)
 		return false;
 	}
 	png_init_io(png_ptr, file.get());
-	png_set_filter(png_ptr,0,PNG_FILTER_NONE);
+	png_set_filter(png_ptr,0,filters);
+	if (compression_level >= 0)
+		png_set_compression_level(png_ptr, std::min(compression_level, 9));
 
 	setjmp(png_jmpbuf(png_ptr));
 	if (get_alpha_mode()==TARGET_ALPHA_MODE_KEEP)
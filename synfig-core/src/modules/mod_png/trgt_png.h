@@ -54,11 +54,12 @@ private:
 	static void png_out_error(png_struct *png,const char *msg);
 	static void png_out_warning(png_struct *png,const char *msg);
 	bool multi_image,ready;
-	int imagecount;
 	synfig::filesystem::Path filename;
 	std::vector<unsigned char> buffer;
 	std::vector<synfig::Color> color_buffer;
 	synfig::String sequence_separator;
+	int compression_level;
+	int filters;
 
 public:
 
@@ -67,6 +68,7 @@ public:
 
 	bool is_multiple_files() const override;
 	synfig::filesystem::Path get_filename() const override;
+	synfig::filesystem::Path get_frame_filename(int frame) const override;
 
 	bool set_rend_desc(synfig::RendDesc* desc) override;
 
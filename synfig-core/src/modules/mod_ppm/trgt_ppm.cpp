@@ -54,7 +54,6 @@ SYNFIG_TARGET_SET_VERSION(ppm,"0.1");
 /* === M E T H O D S ======================================================= */
 
 ppm::ppm(const synfig::filesystem::Path& Filename, const synfig::TargetParam& params):
-	imagecount(),
 	multi_image(false),
 	file(),
 	filename(Filename),
@@ -75,12 +74,18 @@ ppm::is_multiple_files() const
 
 filesystem::Path
 ppm::get_filename() const
+{
+	return get_frame_filename(desc.get_frame_start());
+}
+
+filesystem::Path
+ppm::get_frame_filename(int frame) const
 {
 	if (!multi_image)
 		return filename;
 	if (filename.u8string() == "-")
 		return filename;
-	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), desc.get_frame_start()));
+	return filesystem::Path(filename).add_suffix(strprintf("%s%04d", sequence_separator.c_str(), frame));
 }
 
 bool
@@ -88,7 +93,6 @@ ppm::set_rend_desc(RendDesc *given_desc)
 {
 	//given_desc->set_pixel_format(PF_RGB);
 	desc=*given_desc;
-	imagecount=desc.get_frame_start();
 	if(desc.get_frame_end()-desc.get_frame_start()>0)
 		multi_image=true;
 	else
@@ -99,7 +103,6 @@ ppm::set_rend_desc(RendDesc *given_desc)
 void
 ppm::end_frame()
 {
-	imagecount++;
 }
 
 bool
@@ -109,13 +112,10 @@ ppm::start_frame(synfig::ProgressCallback *callback)
 
 	if (filename.u8string() == "-") {
 		if (callback)
-			callback->task(strprintf("(stdout) %d", imagecount));
+			callback->task(strprintf("(stdout) %d", get_frame()));
 		file = SmartFILE(stdout);
 	} else {
-		synfig::filesystem::Path newfilename(filename);
-		if (multi_image) {
-			newfilename.add_suffix(sequence_separator + strprintf("%04d", imagecount));
-		}
+		const synfig::filesystem::Path newfilename = get_frame_filename(get_frame());
 		file = SmartFILE(newfilename, "wb");
 		if (callback)
 			callback->task(newfilename.u8string());
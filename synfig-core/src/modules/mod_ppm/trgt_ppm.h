@@ -46,7 +46,6 @@ class ppm : public synfig::Target_Scanline
 
 private:
 
-	int imagecount;
 	bool multi_image;
 	synfig::SmartFILE file;
 	synfig::filesystem::Path filename;
@@ -61,6 +60,7 @@ public:
 
 	bool is_multiple_files() const override;
 	synfig::filesystem::Path get_filename() const override;
+	synfig::filesystem::Path get_frame_filename(int frame) const override;
 
 	bool set_rend_desc(synfig::RendDesc* desc) override;
 
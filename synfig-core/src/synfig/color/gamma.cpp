@@ -0,0 +1,155 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file gamma.cpp
+**	\brief Gamma correction of rows and tables of integer samples
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+
+#include "gamma.h"
+
+#endif
+
+// SSE2 is always available on x86-64, so it is used without runtime detection
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+#	define GAMMA_SSE2
+#	include <emmintrin.h>
+#endif
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+#ifdef GAMMA_SSE2
+
+//! pow(x, gamma) for each channel as exp2(gamma*log2(x)) by polynomials,
+//! sign of x is kept like in Gamma::calculate()
+inline __m128
+pow_sse2(__m128 x, __m128 gamma)
+{
+	const __m128 sign_mask = _mm_set1_ps(-0.f);
+	const __m128 sign = _mm_and_ps(x, sign_mask);
+	const __m128 ax = _mm_andnot_ps(sign_mask, x);
+	// zero for zero and denormalized values
+	const __m128 nonzero = _mm_cmpge_ps(ax, _mm_set1_ps(1.17549435e-38f));
+
+	// x = m*2^e, where m in [sqrt(0.5), sqrt(2))
+	const __m128i bits = _mm_castps_si128(ax);
+	const __m128i e = _mm_srai_epi32(_mm_sub_epi32(bits, _mm_set1_epi32(0x3f3504f3)), 23);
+	const __m128 m = _mm_castsi128_ps(_mm_sub_epi32(bits, _mm_slli_epi32(e, 23)));
+
+	// ln(m) = 2*atanh(s) = 2*(s + s^3/3 + s^5/5 + ...), where s = (m - 1)/(m + 1), |s| < 0.172
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 s = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+	const __m128 s2 = _mm_mul_ps(s, s);
+	__m128 p = _mm_set1_ps(1.f/9.f);
+	p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(1.f/7.f));
+	p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(1.f/5.f));
+	p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(1.f/3.f));
+	p = _mm_add_ps(_mm_mul_ps(p, s2), one);
+	const __m128 log2_m = _mm_mul_ps(_mm_mul_ps(p, s), _mm_set1_ps(2.f/0.693147180559945f));
+
+	// y = gamma*log2(x), limited by range of normalized floats
+	__m128 y = _mm_mul_ps(gamma, _mm_add_ps(_mm_cvtepi32_ps(e), log2_m));
+	y = _mm_min_ps(_mm_max_ps(y, _mm_set1_ps(-126.f)), _mm_set1_ps(127.f));
+
+	// 2^y = 2^n * exp(f*ln(2)), where n is integer and f in [-0.5, 0.5]
+	const __m128i n = _mm_cvtps_epi32(y);
+	const __m128 t = _mm_mul_ps(_mm_sub_ps(y, _mm_cvtepi32_ps(n)), _mm_set1_ps(0.693147180559945f));
+	__m128 q = _mm_set1_ps(1.f/5040.f);
+	q = _mm_add_ps(_mm_mul_ps(q, t), _mm_set1_ps(1.f/720.f));
+	q = _mm_add_ps(_mm_mul_ps(q, t), _mm_set1_ps(1.f/120.f));
+	q = _mm_add_ps(_mm_mul_ps(q, t), _mm_set1_ps(1.f/24.f));
+	q = _mm_add_ps(_mm_mul_ps(q, t), _mm_set1_ps(1.f/6.f));
+	q = _mm_add_ps(_mm_mul_ps(q, t), _mm_set1_ps(0.5f));
+	q = _mm_add_ps(_mm_mul_ps(q, t), one);
+	q = _mm_add_ps(_mm_mul_ps(q, t), one);
+	const __m128 exp2_n = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+
+	return _mm_or_ps(_mm_and_ps(nonzero, _mm_mul_ps(q, exp2_n)), sign);
+}
+
+#endif // GAMMA_SSE2
+
+} // end of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+void
+Gamma::apply_row(Color *dst, const Color *src, int count) const
+{
+	assert(count >= 0);
+
+	#ifdef GAMMA_SSE2
+	static_assert(sizeof(Color) == sizeof(__m128), "Color must be four floats");
+
+	// alpha and channels without gamma keep source values
+	const __m128 gamma = _mm_setr_ps(get_r(), get_g(), get_b(), 1.f);
+	const __m128 keep = _mm_cmpeq_ps(gamma, _mm_set1_ps(1.f));
+	if (_mm_movemask_ps(keep) == 0xf) {
+		if (dst != src)
+			std::copy(src, src + count, dst);
+		return;
+	}
+
+	for(const Color *end = src + count; src < end; ++src, ++dst) {
+		const __m128 x = _mm_loadu_ps((const float*)src);
+		const __m128 y = pow_sse2(x, gamma);
+		_mm_storeu_ps((float*)dst, _mm_or_ps(_mm_and_ps(keep, x), _mm_andnot_ps(keep, y)));
+	}
+	#else
+	for(const Color *end = src + count; src < end; ++src, ++dst)
+		*dst = apply(*src);
+	#endif
+}
+
+
+void
+GammaTable::set(const Gamma &gamma, int maxval)
+{
+	assert(maxval > 0 && maxval <= 65535);
+	this->maxval = maxval;
+	table.resize(4*(maxval + 1));
+
+	ColorReal *t = &table.front();
+	for(int c = 0; c < 3; ++c)
+		for(int i = 0; i <= maxval; ++i, ++t)
+			*t = gamma.apply(c, i/ColorReal(maxval));
+	for(int i = 0; i <= maxval; ++i, ++t)
+		*t = i/ColorReal(maxval);
+}
+
+/* === E N T R Y P O I N T ================================================= */
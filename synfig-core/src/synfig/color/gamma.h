@@ -30,6 +30,8 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <vector>
+
 #include "color.h"
 
 /* === M A C R O S ========================================================= */
@@ -111,12 +113,46 @@ public:
 	ColorReal apply_b(ColorReal x) const { return apply(2, x); }
 	Color apply(const Color &x) const
 		{ return Color(apply_r(x.get_r()), apply_g(x.get_g()), apply_b(x.get_b()), x.get_a()); }
+
+	//! Applies gamma to the row of colors, \a dst may be equal to \a src.
+	//! Uses the vectorized approximation of pow() where it is available,
+	//! relative error is about 1e-6, that is much less than the step of 16-bit samples.
+	//! Channels with gamma equal to 1 and alpha are copied as is.
+	void apply_row(Color *dst, const Color *src, int count) const;
 	
 	void invert() { *this = get_inverted(); }
 	Gamma get_inverted() const
 		{ return Gamma(1/get_r(), 1/get_g(), 1/get_b()); }
 }; // END of class Gamma
 
+
+/*!	\class GammaTable
+**	\brief Colors of integer samples in range [0, maxval] with applied gamma.
+**	Use it to convert 8 or 16-bit images to colors without calculation of pow() for each pixel.
+*/
+class GammaTable
+{
+private:
+	int maxval;
+	//! tables for red, green, blue and alpha (without gamma)
+	std::vector<ColorReal> table;
+
+public:
+	GammaTable(): maxval() { }
+	GammaTable(const Gamma &gamma, int maxval): GammaTable() { set(gamma, maxval); }
+
+	void set(const Gamma &gamma, int maxval);
+
+	int get_maxval() const { return maxval; }
+	const ColorReal* get(int channel) const { return &table[channel*(maxval + 1)]; }
+
+	ColorReal apply(int channel, int sample) const { return get(channel)[sample]; }
+	Color apply(int r, int g, int b) const
+		{ return Color(apply(0, r), apply(1, g), apply(2, b), ColorReal(1)); }
+	Color apply(int r, int g, int b, int a) const
+		{ return Color(apply(0, r), apply(1, g), apply(2, b), apply(3, a)); }
+}; // END of class GammaTable
+
 }; // END of namespace synfig
 
 /* === E N D =============================================================== */
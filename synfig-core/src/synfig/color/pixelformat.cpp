@@ -29,6 +29,14 @@
 
 #include "pixelformat.h"
 #include <cassert>
+#include <cstring>
+#include <vector>
+
+// SSE2 is always available on x86-64, so it is used without runtime detection
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+#	define PIXELFORMAT_SSE2
+#	include <emmintrin.h>
+#endif
 
 using namespace synfig;
 
@@ -116,7 +124,6 @@ namespace {
 
 
 	template<
-		bool with_gamma,
 		bool gray,
 		bool bgr,
 		bool alpha,
@@ -126,17 +133,15 @@ namespace {
 	color2pf(
 		unsigned char *dst,
 		const Color &src,
-		const Gamma *gamma )
+		const Gamma* )
 	{
-		const Color src_gm = with_gamma ? gamma->apply(src) : src;
-
 		// get color values
 		int ri, gi, bi, ac;
-		ri = (int)(clamp(src_gm.get_r())*ColorReal(65535.99));
-		gi = (int)(clamp(src_gm.get_g())*ColorReal(65535.99));
-		bi = (int)(clamp(src_gm.get_b())*ColorReal(65535.99));
+		ri = (int)(clamp(src.get_r())*ColorReal(65535.99));
+		gi = (int)(clamp(src.get_g())*ColorReal(65535.99));
+		bi = (int)(clamp(src.get_b())*ColorReal(65535.99));
 		if (alpha)
-			ac = (int)(clamp(src_gm.get_a())*ColorReal(255.99));
+			ac = (int)(clamp(src.get_a())*ColorReal(255.99));
 
 		// put alpha before color channels if need
 		if (alpha && alpha_start)
@@ -203,54 +208,132 @@ namespace {
 	}
 
 
-	template<bool with_gamma, bool gray, bool bgr>
+#ifdef PIXELFORMAT_SSE2
+	//! converts four pixels to 8-bit channels in the same way as color2pf_simple()
+	template<bool bgr, bool alpha_start>
+	static inline __m128i
+	color2pf_simple_sse2(const Color *src)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 k = _mm_set1_ps(255.9f);
+		__m128i c[4];
+		for(int i = 0; i < 4; ++i) {
+			__m128 v = _mm_loadu_ps((const float*)(src + i));
+			if (bgr && alpha_start)
+				v = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+			else if (bgr)
+				v = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 1, 2));
+			else if (alpha_start)
+				v = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 1, 0, 3));
+			c[i] = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, zero), one), k));
+		}
+		return _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3]));
+	}
+#endif
+
+
+	template<
+		bool bgr,
+		bool alpha,
+		bool alpha_start >
+	static unsigned char*
+	color2pf_image_simple(Color2PFParams params) {
+		#ifdef PIXELFORMAT_SSE2
+		while(params.height-- > 0) {
+			const Color *src_end = params.src + params.width;
+			for(; params.src + 4 <= src_end; params.src += 4) {
+				const __m128i pixels = color2pf_simple_sse2<bgr, alpha_start>(params.src);
+				if (alpha) {
+					_mm_storeu_si128((__m128i*)params.dst, pixels);
+					params.dst += 16;
+				} else {
+					// skip alpha
+					alignas(16) unsigned char buffer[16];
+					_mm_store_si128((__m128i*)buffer, pixels);
+					for(int i = 0; i < 16; i += 4, params.dst += 3)
+						std::memcpy(params.dst, buffer + i, 3);
+				}
+			}
+			for(; params.src < src_end; ++params.src)
+				params.dst = color2pf_simple<bgr, alpha, alpha_start>(params.dst, *params.src, nullptr);
+			params.dst += params.dst_stride_extra;
+			params.src += params.src_stride_extra;
+		}
+		return params.dst;
+		#else
+		return color2pf_image< color2pf_simple<bgr, alpha, alpha_start> >(params);
+		#endif
+	}
+
+
+	template<bool gray, bool bgr>
 	static inline unsigned char*
 	color2pf_image_partauto(const Color2PFParams &params) {
 		if (!FLAGS(params.pf, PF_A))
-			return     color2pf_image< color2pf<with_gamma, gray, bgr, false, false, false> >(params);
+			return     color2pf_image< color2pf<gray, bgr, false, false, false> >(params);
 		if (FLAGS(params.pf, PF_A_PREMULT)) {
 			if (FLAGS(params.pf, PF_A_START))
-				return color2pf_image< color2pf<with_gamma, gray, bgr, true,  true,  true>  >(params);
-			return     color2pf_image< color2pf<with_gamma, gray, bgr, true,  false, true>  >(params);
+				return color2pf_image< color2pf<gray, bgr, true,  true,  true>  >(params);
+			return     color2pf_image< color2pf<gray, bgr, true,  false, true>  >(params);
 		}
 		if (FLAGS(params.pf, PF_A_START))
-			return     color2pf_image< color2pf<with_gamma, gray, bgr, true,  true,  false> >(params);
-		return         color2pf_image< color2pf<with_gamma, gray, bgr, true,  false, false> >(params);
+			return     color2pf_image< color2pf<gray, bgr, true,  true,  false> >(params);
+		return         color2pf_image< color2pf<gray, bgr, true,  false, false> >(params);
 	}
 
 
+	//! \param simple allows the simple quantization of 8-bit RGB/BGR(A) by color2pf_simple()
 	static inline unsigned char*
-	color2pf_image_auto(const Color2PFParams &params) {
-		if (FLAGS(params.pf, PF_RAW_COLOR))
-			return color2pf_image<color2pf_raw>(params);
-
-		bool with_gamma    = (bool)params.gamma;
+	color2pf_image_convert(const Color2PFParams &params, bool simple) {
 		bool gray          = FLAGS(params.pf, PF_GRAY);
 		bool bgr           = !gray && FLAGS(params.pf, PF_BGR);
 		bool alpha         = FLAGS(params.pf, PF_A);
 		bool alpha_premult = alpha && FLAGS(params.pf, PF_A_PREMULT);
 
-		if (!gray && !alpha_premult && !with_gamma) {
-			// simple
+		if (simple && !gray && !alpha_premult) {
 			bool alpha_start = alpha && FLAGS(params.pf, PF_A_START);
 			if (bgr) {
-				if (alpha_start) return color2pf_image< color2pf_simple<true,  true,  true>  >(params);
-				if (alpha)       return color2pf_image< color2pf_simple<true,  true,  false> >(params);
-				return                  color2pf_image< color2pf_simple<true,  false, false> >(params);
+				if (alpha_start) return color2pf_image_simple<true,  true,  true>  (params);
+				if (alpha)       return color2pf_image_simple<true,  true,  false> (params);
+				return                  color2pf_image_simple<true,  false, false> (params);
 			}
-			if (alpha_start) return     color2pf_image< color2pf_simple<false, true,  true>  >(params);
-			if (alpha)       return     color2pf_image< color2pf_simple<false, true,  false> >(params);
-			return                      color2pf_image< color2pf_simple<false, false, false> >(params);
+			if (alpha_start) return     color2pf_image_simple<false, true,  true>  (params);
+			if (alpha)       return     color2pf_image_simple<false, true,  false> (params);
+			return                      color2pf_image_simple<false, false, false> (params);
 		}
 
-		if (with_gamma) {
-			if (gray) return color2pf_image_partauto<true,  true,  false>(params);
-			if (bgr)  return color2pf_image_partauto<true,  false, true >(params);
-			return           color2pf_image_partauto<true,  false, false>(params);
+		if (gray) return color2pf_image_partauto<true,  false>(params);
+		if (bgr)  return color2pf_image_partauto<false, true >(params);
+		return           color2pf_image_partauto<false, false>(params);
+	}
+
+
+	static inline unsigned char*
+	color2pf_image_auto(const Color2PFParams &params) {
+		if (FLAGS(params.pf, PF_RAW_COLOR))
+			return color2pf_image<color2pf_raw>(params);
+
+		if (params.gamma) {
+			// apply gamma to each row by vectorized code, then convert it without gamma.
+			// Gamma-corrected colors were always quantized by color2pf() (16-bit value >> 8),
+			// the simple 8-bit quantization is not used here to keep the same output.
+			std::vector<Color> row(params.width);
+			Color2PFParams row_params(params);
+			row_params.gamma = nullptr;
+			row_params.height = 1;
+			row_params.src = row.data();
+			row_params.src_stride_extra = 0;
+			const Color *src = params.src;
+			for(int y = 0; y < params.height; ++y) {
+				params.gamma->apply_row(row.data(), src, params.width);
+				row_params.dst = color2pf_image_convert(row_params, false) + params.dst_stride_extra;
+				src += params.width + params.src_stride_extra;
+			}
+			return row_params.dst;
 		}
-		if (gray) return     color2pf_image_partauto<false, true,  false>(params);
-		if (bgr)  return     color2pf_image_partauto<false, false, true >(params);
-		return               color2pf_image_partauto<false, false, false>(params);
+
+		return color2pf_image_convert(params, true);
 	}
 } // namespace
 
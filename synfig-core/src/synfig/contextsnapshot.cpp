@@ -0,0 +1,146 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file contextsnapshot.cpp
+**	\brief Copy of a layer context evaluated at a fixed time
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "contextsnapshot.h"
+
+#include "canvas.h"
+#include "layer.h"
+#include "layers/layer_pastecanvas.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+// same limit as Layer_PasteCanvas uses for set_time() recursion
+#define MAX_DEPTH 10
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+Layer::Handle
+ContextSnapshot::clone_layer(const Layer::Handle &layer, int depth)
+{
+	// the same as Layer::simple_clone(), but value nodes are just shared:
+	// connect_dynamic_param() would register the clone as a parent of each node
+	// and move non-exported nodes to its canvas, and ~Layer would unregister it again
+	if (!Layer::book().count(layer->get_name()))
+		return Layer::Handle();
+	Layer::Handle ret = Layer::create(layer->get_name()).get();
+	if (!ret)
+		return ret;
+	ret->set_active(layer->active());
+	ret->set_optimized(layer->optimized());
+	ret->set_exclude_from_rendering(layer->get_exclude_from_rendering());
+	ret->set_outline_grow_mark(layer->get_outline_grow_mark());
+	clones.push_back(ret);
+
+	// pasted canvas is evaluated together with the layer,
+	// so the copy should paste the copy of the canvas,
+	// and the original canvas is not even temporarily attached to the clone
+	Layer::ParamList param_list = layer->get_param_list();
+	Layer::DynamicParamList dynamic_param_list = layer->dynamic_param_list_;
+	Layer_PasteCanvas::Handle paste = Layer_PasteCanvas::Handle::cast_dynamic(ret);
+	if (paste) {
+		param_list.erase("canvas");
+		dynamic_param_list.erase("canvas");
+	}
+	ret->set_param_list(param_list);
+	ret->dynamic_param_list_.swap(dynamic_param_list);
+
+	if (paste) {
+		Canvas::Handle sub_canvas = Layer_PasteCanvas::Handle::cast_dynamic(layer)->get_sub_canvas();
+		if (sub_canvas && depth < MAX_DEPTH)
+			paste->set_sub_canvas(clone_canvas(sub_canvas, depth + 1));
+	}
+
+	// the same canvas as the original layer has, so file names are resolved
+	// as usual, but the clone is not inserted into it
+	ret->set_canvas(layer->get_canvas());
+	return ret;
+}
+
+Canvas::Handle
+ContextSnapshot::clone_canvas(const Canvas::Handle &canvas, int depth)
+{
+	// Canvas::clone() registers groups of the layers in the parent canvas,
+	// so the copy is built by hand with push_back_simple().
+	// The copy is inline in the parent of the original canvas (not in the original itself),
+	// it is empty at this moment, so there are no groups to merge into the parent.
+	Canvas::Handle copy = Canvas::create();
+	if (Canvas::LooseHandle parent = canvas->parent())
+		copy->set_inline(parent);
+	copy->rend_desc() = canvas->rend_desc();
+	for(Canvas::const_iterator i = canvas->begin(); i != canvas->end(); ++i)
+		if (Layer::Handle layer = clone_layer(*i, depth))
+			copy->push_back_simple(layer);
+	copy->set_outline_grow(canvas->get_outline_grow());
+	return copy;
+}
+
+ContextSnapshot::ContextSnapshot(const Context &context, Time time):
+	params(context.get_params()),
+	time(time)
+{
+	for(IndependentContext i = context; *i; ++i)
+		if (Layer::Handle layer = clone_layer(*i, 0))
+			layers.push_back(layer);
+	layers.push_back(Layer::Handle());
+
+	// all layers are already at the requested time
+	params.force_set_time = false;
+
+	set_time(time);
+}
+
+ContextSnapshot::~ContextSnapshot()
+{
+	// clones were never registered as parents of the shared value nodes,
+	// so ~Layer should not unregister them
+	for(std::vector<Layer::Handle>::const_iterator i = clones.begin(); i != clones.end(); ++i)
+		(*i)->dynamic_param_list_.clear();
+}
+
+void
+ContextSnapshot::set_time(Time time)
+{
+	this->time = time;
+	IndependentContext independent_context(layers.begin());
+	independent_context.set_time(time, true);
+	independent_context.load_resources(time, true);
+}
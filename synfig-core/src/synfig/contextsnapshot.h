@@ -0,0 +1,102 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file contextsnapshot.h
+**	\brief Copy of a layer context evaluated at a fixed time
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_CONTEXTSNAPSHOT_H
+#define __SYNFIG_CONTEXTSNAPSHOT_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <vector>
+
+#include <synfig/canvasbase.h>
+#include <synfig/context.h>
+#include <synfig/time.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+/*!	\class ContextSnapshot
+**	\brief Private copy of the layers of a Context, evaluated at a given time.
+**
+**	Layers are cloned once (and the canvases pasted by them are copied recursively),
+**	then the copies are set to the requested time. The original layers and
+**	canvases are never touched, so a layer like Layer_MotionBlur can build
+**	rendering tasks for several moments of time without moving the document
+**	back and forth with Context::set_time(). For the next moment of time
+**	the same snapshot is evaluated again by set_time().
+**
+**	Value nodes are shared with the original layers and only read while the
+**	snapshot is being evaluated. The clones are not registered as parents
+**	of the value nodes, so changes of the document are not propagated
+**	to the snapshot and the snapshot does not disturb the document.
+*/
+class ContextSnapshot: public etl::shared_object
+{
+public:
+	typedef etl::handle<ContextSnapshot> Handle;
+
+private:
+	CanvasBase layers;
+	ContextParams params;
+	Time time;
+	//! all cloned layers, including the layers of copied canvases
+	std::vector<Layer::Handle> clones;
+
+	Layer::Handle clone_layer(const Layer::Handle &layer, int depth);
+	Canvas::Handle clone_canvas(const Canvas::Handle &canvas, int depth);
+
+public:
+	//! Clones layers of \a context and evaluates them at \a time
+	ContextSnapshot(const Context &context, Time time);
+	~ContextSnapshot();
+
+	//! Evaluates the cloned layers at \a time, value nodes are read again
+	//! even if the time is the same, because their state may be changed
+	//! (like the index of ValueNode_Duplicate)
+	void set_time(Time time);
+
+	Time get_time() const { return time; }
+	Context get_context() const { return Context(layers.begin(), params); }
+
+	//! Builds rendering task from the snapshot, no set_time() is called on the way.
+	//! Tasks keep their own copies of values, so the snapshot may be evaluated
+	//! at the other time after that
+	rendering::Task::Handle build_rendering_task() const
+		{ return get_context().build_rendering_task(); }
+
+	static Handle create(const Context &context, Time time)
+		{ return new ContextSnapshot(context, time); }
+}; // END of class ContextSnapshot
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
@@ -380,3 +380,21 @@ CompiledGradient::set(const Gradient &gradient, bool repeat, bool zigzag) {
 	
 	summary_color = find(1.0)->summary(1.0);
 }
+
+void
+CompiledGradient::average(const Real *x, const Real *w, int count, Color *out) const
+{
+	List::const_iterator hint0 = list.begin(), hint1 = list.begin();
+	for(const Real *end = x + count; x < end; ++x, ++w, ++out) {
+		// see average(x0, x1)
+		Real x0 = *x - *w, x1 = *x + *w;
+		Real ww = x1 - x0;
+		if (std::isnan(ww) || std::isinf(ww))
+			*out = average();
+		else
+		if (fabs(ww) < real_precision<Real>())
+			*out = color(x0);
+		else
+			*out = ((summary(x1, hint1) - summary(x0, hint0))/ww).color();
+	}
+}
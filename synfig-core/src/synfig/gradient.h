@@ -32,11 +32,13 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <algorithm>
 #include <vector>
 
 #include "real.h"
 #include "color.h"
 #include "uniqueid.h"
+#include "vector.h"
 
 /* === M A C R O S ========================================================= */
 
@@ -289,6 +291,15 @@ public:
 	inline List::const_iterator find(Real x) const
 		{ return std::lower_bound(list.begin(), list.end()-1, x); }
 
+	//! Same as find(x), but checks the segment \a hint first,
+	//! neighbour pixels usually fall into the same segment
+	inline List::const_iterator find(Real x, List::const_iterator hint) const {
+		if ( (hint == list.begin() || (hint-1)->next_pos < x)
+		  && (hint == list.end()-1 || !(hint->next_pos < x)) )
+			return hint;
+		return find(x);
+	}
+
 	inline Color color(Real x) const {
 		if (repeat) x -= floor(x);
 		return find(x)->color(x);
@@ -306,6 +317,18 @@ public:
 		return find(x)->summary(x);
 	}
 
+	//! Same as summary(x), \a hint is the segment found by the previous call
+	inline Accumulator summary(Real x, List::const_iterator &hint) const {
+		if (repeat) {
+			Real count = floor(x);
+			x -= count;
+			hint = find(x, hint);
+			return summary_color*count + hint->summary(x);
+		}
+		hint = find(x, hint);
+		return hint->summary(x);
+	}
+
 	inline Color average() const
 		{ return summary_color.color(); }
 
@@ -316,6 +339,28 @@ public:
 		if (fabs(w) < real_precision<Real>()) return color(x0);
 		return ((summary(x1) - summary(x0))/w).color();
 	}
+
+	//! Calculates average(x[i] - w[i], x[i] + w[i]) for \a count positions,
+	//! it is faster for positions of neighbour pixels
+	void average(const Real *x, const Real *w, int count, Color *out) const;
+
+	//! Calculates colors of the row of \a count pixels starting at \a p with step \a dx,
+	//! \a position(point, x, w) gives the position \a x in gradient and half-width \a w
+	//! of averaging for the pixel at \a point.
+	//! Positions are calculated by chunks and then averaged at once.
+	template<typename F>
+	void average_row(const Vector &p, const Vector &dx, int count, Color *out, F position) const
+	{
+		const int chunk = 64;
+		Real x[chunk], w[chunk];
+		Vector point = p;
+		for(int i = 0; i < count; i += chunk, out += chunk) {
+			const int n = std::min(chunk, count - i);
+			for(int j = 0; j < n; ++j, point += dx)
+				position(point, x[j], w[j]);
+			average(x, w, n, out);
+		}
+	}
 };
 
 }; // END of namespace synfig
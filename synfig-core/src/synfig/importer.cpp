@@ -48,6 +48,7 @@
 #include "importer.h"
 #include "string.h"
 #include "surface.h"
+#include "threadpool.h"
 
 #include <synfig/rendering/software/surfacesw.h>
 #include <synfig/rendering/software/surfaceswpacked.h>
@@ -64,6 +65,9 @@ Importer::Book* synfig::Importer::book_;
 
 static std::map<FileSystem::Identifier,Importer::LooseHandle> *__open_importers;
 
+size_t Importer::frame_cache_budget_ = 256*1024*1024;
+int Importer::prefetch_frames_ = 2;
+
 /* === P R O C E D U R E S ================================================= */
 
 /* === M E T H O D S ======================================================= */
@@ -73,6 +77,8 @@ Importer::subsys_init()
 {
 	book_=new Book();
 	__open_importers=new std::map<FileSystem::Identifier,Importer::LooseHandle>();
+	if (const char *s = getenv("SYNFIG_IMPORTER_CACHE_SIZE"))
+		set_frame_cache_budget((size_t)std::max(0, atoi(s))*1024*1024);
 	return true;
 }
 
@@ -144,6 +150,9 @@ void Importer::forget(const FileSystem::Identifier &identifier)
 }
 
 Importer::Importer(const FileSystem::Identifier &identifier):
+	cache_size_(),
+	use_counter_(),
+	has_last_time_(),
 	identifier(identifier)
 {
 }
@@ -159,25 +168,147 @@ Importer::~Importer()
 }
 
 rendering::Surface::Handle
-Importer::get_frame(const RendDesc & /* renddesc */, const Time &time)
+Importer::decode_frame(const RendDesc &renddesc, const Time &time)
 {
-	if (last_surface_ && last_surface_->is_exists() && !is_animated())
-		return last_surface_;
-
 	Surface surface;
-	if(!get_frame(surface, RendDesc(), time)) {
+	if(!get_frame(surface, renddesc, time)) {
 		warning(strprintf(_("Unable to get frame from \"%s\" [%s]"), identifier.filename.u8_str(), time.get_string().c_str()));
 		return nullptr;
 	}
 
+	rendering::Surface::Handle frame;
 	const char *s = getenv("SYNFIG_PACK_IMAGES");
 	if (s == nullptr || atoi(s) != 0)
-		last_surface_ = new rendering::SurfaceSWPacked();
+		frame = new rendering::SurfaceSWPacked();
 	else
-		last_surface_ = new rendering::SurfaceSW();
+		frame = new rendering::SurfaceSW();
 
 	if (surface.is_valid())
-		last_surface_->assign(surface[0], surface.get_w(), surface.get_h());
+		frame->assign(surface[0], surface.get_w(), surface.get_h());
+
+	return frame;
+}
+
+rendering::Surface::Handle
+Importer::load_frame(const RendDesc &renddesc, const Time &time)
+{
+	std::lock_guard<std::mutex> lock(decode_mutex_);
+	return decode_frame(renddesc, time);
+}
+
+void
+Importer::use_frame(FrameCache::iterator i)
+{
+	if (i->second.last_use)
+		use_order_.erase(i->second.last_use);
+	i->second.last_use = ++use_counter_;
+	use_order_[i->second.last_use] = i->first;
+}
+
+void
+Importer::store_frame(const Time &time, const rendering::Surface::Handle &surface)
+{
+	if (!frame_cache_budget_)
+		return;
+
+	FrameCache::iterator i = cache_.insert(FrameCache::value_type(time, CachedFrame())).first;
+	CachedFrame &frame = i->second;
+	cache_size_ -= frame.size;
+	frame.surface = surface;
+	frame.size = surface->get_buffer_size();
+	cache_size_ += frame.size;
+	use_frame(i);
+
+	// remove least recently used frames, the new one is the last in use order
+	while(cache_size_ > frame_cache_budget_ && cache_.size() > 1) {
+		FrameCache::iterator lru = cache_.find(use_order_.begin()->second);
+		use_order_.erase(use_order_.begin());
+		cache_size_ -= lru->second.size;
+		cache_.erase(lru);
+	}
+}
+
+void
+Importer::schedule_prefetch(const RendDesc &renddesc, const Time &time)
+{
+	if (frame_cache_budget_ && prefetch_frames_ > 0 && has_last_time_ && time > last_time_) {
+		// expect the same step between the next requested frames
+		const Time step = time - last_time_;
+		for(int i = 1; i <= prefetch_frames_; ++i) {
+			const Time t = time + step*(Real)i;
+			if (cache_.count(t) || pending_.count(t))
+				continue;
+			pending_[t] = false;
+			ThreadPool::instance().enqueue(
+				sigc::bind(sigc::ptr_fun(&Importer::prefetch_frame), Handle(this), renddesc, t),
+				ThreadPool::PRIORITY_IO );
+		}
+	}
+	last_time_ = time;
+	has_last_time_ = true;
+}
+
+void
+Importer::prefetch_frame(const Handle &importer, RendDesc renddesc, Time time)
+{
+	{
+		// frame may be already taken by get_frame()
+		std::lock_guard<std::mutex> lock(importer->cache_mutex_);
+		PendingFrames::iterator i = importer->pending_.find(time);
+		if (i == importer->pending_.end() || i->second)
+			return;
+		i->second = true;
+	}
+
+	rendering::Surface::Handle surface = importer->load_frame(renddesc, time);
+
+	std::lock_guard<std::mutex> lock(importer->cache_mutex_);
+	importer->pending_.erase(time);
+	if (surface)
+		importer->store_frame(time, surface);
+	importer->cache_cond_.notify_all();
+}
+
+rendering::Surface::Handle
+Importer::get_frame(const RendDesc &renddesc, const Time &time)
+{
+	if (!is_animated()) {
+		if (!last_surface_ || !last_surface_->is_exists()) {
+			rendering::Surface::Handle surface = load_frame(renddesc, time);
+			if (!surface)
+				return nullptr;
+			last_surface_ = surface;
+		}
+		return last_surface_;
+	}
+
+	std::unique_lock<std::mutex> lock(cache_mutex_);
+	schedule_prefetch(renddesc, time);
+
+	while(true) {
+		FrameCache::iterator i = cache_.find(time);
+		if (i != cache_.end()) {
+			use_frame(i);
+			return i->second.surface;
+		}
+
+		// wait for the frame which is decoded now,
+		// but decode it here, if it is still in queue of prefetching
+		PendingFrames::iterator j = pending_.find(time);
+		if (j == pending_.end())
+			{ pending_[time] = true; break; }
+		if (!j->second)
+			{ j->second = true; break; }
+		cache_cond_.wait(lock);
+	}
+
+	lock.unlock();
+	rendering::Surface::Handle surface = load_frame(renddesc, time);
+	lock.lock();
 
-	return last_surface_;
+	pending_.erase(time);
+	if (surface)
+		store_frame(time, surface);
+	cache_cond_.notify_all();
+	return surface;
 }
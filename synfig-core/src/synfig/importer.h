@@ -30,7 +30,9 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <condition_variable>
 #include <map>
+#include <mutex>
 
 #include "filesystem.h"
 #include "handle.h"
@@ -143,9 +145,52 @@ public:
 	typedef etl::handle<const Importer> ConstHandle;
 
 private:
+	//! Decoded frame of animated importer
+	struct CachedFrame {
+		rendering::Surface::Handle surface;
+		size_t size;
+		long long last_use;
+		CachedFrame(): size(), last_use() { }
+	};
+
+	typedef std::map<Time, CachedFrame> FrameCache;
+	//! Times of cached frames ordered by last use, the first one is evicted first
+	typedef std::map<long long, Time> UseOrder;
+	//! Frames which are decoded now or queued for prefetching,
+	//! value is true when decoding of frame is started
+	typedef std::map<Time, bool> PendingFrames;
+
 	rendering::Surface::Handle last_surface_;
 
+	//! get_frame() of the particular importer is not called simultaneously
+	std::mutex decode_mutex_;
+
+	std::mutex cache_mutex_;
+	std::condition_variable cache_cond_;
+	FrameCache cache_;
+	UseOrder use_order_;
+	PendingFrames pending_;
+	size_t cache_size_;
+	long long use_counter_;
+	bool has_last_time_;
+	Time last_time_;
+
+	static size_t frame_cache_budget_;
+	static int prefetch_frames_;
+
+	rendering::Surface::Handle load_frame(const RendDesc &renddesc, const Time &time);
+	//! cache mutex must be locked
+	void use_frame(FrameCache::iterator i);
+	//! cache mutex must be locked
+	void store_frame(const Time &time, const rendering::Surface::Handle &surface);
+	//! cache mutex must be locked
+	void schedule_prefetch(const RendDesc &renddesc, const Time &time);
+	static void prefetch_frame(const Handle &importer, RendDesc renddesc, Time time);
+
 protected:
+	//! Decodes frame for get_frame(renddesc, time), it is not called simultaneously.
+	//! By default it converts result of get_frame(surface, renddesc, time)
+	virtual rendering::Surface::Handle decode_frame(const RendDesc &renddesc, const Time &time);
 
 	Importer(const FileSystem::Identifier &identifier);
 
@@ -164,8 +209,21 @@ public:
 	*/
 	virtual bool get_frame(Surface &surface, const RendDesc &renddesc, Time time, ProgressCallback *callback=nullptr) = 0;
 
+	//! Returns frame as rendering surface.
+	//! Frames of animated importers are cached, and when frames are requested
+	//! one after another, the next ones are decoded in advance by IO slots of ThreadPool,
+	//! which don't wait while the current frame is rendered by the whole thread budget
 	virtual rendering::Surface::Handle get_frame(const RendDesc &renddesc, const Time &time);
 
+	//! Size of cache of decoded frames for each animated importer in bytes, 0 disables cache and prefetching.
+	//! Default is 256 Mb or SYNFIG_IMPORTER_CACHE_SIZE environment variable (in megabytes)
+	static void set_frame_cache_budget(size_t bytes) { frame_cache_budget_ = bytes; }
+	static size_t get_frame_cache_budget() { return frame_cache_budget_; }
+
+	//! Count of frames decoded in advance, 0 disables prefetching
+	static void set_prefetch_frames(int count) { prefetch_frames_ = count; }
+	static int get_prefetch_frames() { return prefetch_frames_; }
+
 	//! Returns \c true if the importer pays attention to the \a time parameter of get_frame()
 	virtual bool is_animated() { return false; }
 
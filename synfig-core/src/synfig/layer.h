@@ -198,6 +198,7 @@ class Layer : public Node
 	friend class ValueNode;
 	friend class IndependentContext;
 	friend class Context;
+	friend class ContextSnapshot;
 
 	/*
  --	** -- T Y P E S -----------------------------------------------------------
@@ -40,6 +40,7 @@
 
 #include <synfig/canvas.h>
 #include <synfig/context.h>
+#include <synfig/contextsnapshot.h>
 #include <synfig/paramdesc.h>
 #include <synfig/renddesc.h>
 #include <synfig/string.h>
@@ -174,16 +175,21 @@ Layer_Duplicate::build_rendering_task_vfunc(Context context) const
 
 	std::lock_guard<std::mutex> lock(mutex);
 	duplicate_param->reset_index(time_cur);
-	ContextParams dup_context_params(context.get_params());
-	dup_context_params.force_set_time = true;
-	Context dup_context(context, dup_context_params);
+	// copies are evaluated in the private copy of the context,
+	// so the layers of the document are not re-evaluated for each index
+	ContextSnapshot::Handle snapshot;
 	do
 	{
+		if (snapshot)
+			snapshot->set_time(time_cur);
+		else
+			snapshot = ContextSnapshot::create(context, time_cur);
+
 		rendering::TaskBlend::Handle task_blend(new rendering::TaskBlend());
 		task_blend->amount = amount;
 		task_blend->blend_method = blend_method;
 		task_blend->sub_task_a() = task;
-		task_blend->sub_task_b() = dup_context.build_rendering_task();
+		task_blend->sub_task_b() = snapshot->build_rendering_task();
 		task = task_blend;
 	}
 	while (duplicate_param->step(time_cur));
@@ -38,6 +38,7 @@
 #include <synfig/localization.h>
 
 #include <synfig/context.h>
+#include <synfig/contextsnapshot.h>
 #include <synfig/paramdesc.h>
 #include <synfig/string.h>
 #include <synfig/time.h>
@@ -206,6 +207,10 @@ Layer_MotionBlur::build_rendering_task_vfunc(Context context) const
 	const Color::BlendMethod blend_method = no_blur_effect ? Color::BLEND_COMPOSITE : Color::BLEND_ADD_COMPOSITE;
 	const Real k = no_blur_effect ? 1.0 : (approximate_zero(sum) ? 0.0 : (1.0/sum));
 
+	// samples are evaluated in the private copy of the context,
+	// so the document itself stays at the current time
+	ContextSnapshot::Handle snapshot;
+
 	rendering::Task::Handle task;
 	for(int i = 0; i < samples; i++)
 	{
@@ -216,13 +221,17 @@ Layer_MotionBlur::build_rendering_task_vfunc(Context context) const
 
 		Real pos = (Real)i/(Real)(samples - 1);
 		Real ipos = 1.0 - pos;
-		context.set_time(get_time_mark() - aperture*ipos);
+		const Time sample_time = get_time_mark() - aperture*ipos;
+		if (snapshot)
+			snapshot->set_time(sample_time);
+		else
+			snapshot = ContextSnapshot::create(context, sample_time);
 
 		rendering::TaskBlend::Handle task_blend(new rendering::TaskBlend());
 		task_blend->amount = amount;
 		task_blend->blend_method = blend_method;
 		task_blend->sub_task_a() = task;
-		task_blend->sub_task_b() = context.build_rendering_task();
+		task_blend->sub_task_b() = snapshot->build_rendering_task();
 		task = task_blend;
 	}
 
@@ -57,13 +57,16 @@ private:
 
 	Importer::Handle get_sub_importer(const RendDesc &renddesc, Time time, ProgressCallback *cb);
 
+protected:
+	virtual rendering::Surface::Handle decode_frame(const RendDesc &renddesc, const Time &time);
+
 public:
 	ListImporter(const FileSystem::Identifier &identifier);
 
 	~ListImporter();
 
 	virtual bool get_frame(Surface &surface, const RendDesc &renddesc, Time time, ProgressCallback* cb = nullptr);
-	virtual rendering::Surface::Handle get_frame(const RendDesc &renddesc, const Time &time);
+	using Importer::get_frame;
 	virtual bool is_animated();
 
 };
@@ -373,6 +373,10 @@ public:
 	{
 		return fgetc(read_file);
 	}
+	size_t read(void* ptr, size_t size, size_t n) override
+	{
+		return fread(ptr, size, n, read_file);
+	}
 	int scanf(const char* __format, ...) override
 	{
 		va_list args;
@@ -684,6 +688,7 @@ public:
 		return "";
 	}
 	int getc() override { return fgetc(read_file); }
+	size_t read(void* ptr, size_t size, size_t n) override { return fread(ptr, size, n, read_file); }
 	int scanf(const char* __format, ...) override
 	{
 		va_list args;
@@ -188,6 +188,8 @@ struct RunPipe {
 	virtual std::string read_contents(size_t max_bytes) = 0;
 	/** read a byte coming from stdout. */
 	virtual int getc() = 0;
+	/** read @a n items of @a size bytes coming from stdout, returns count of complete items, like fread(). */
+	virtual size_t read(void *ptr, size_t size, size_t n) = 0;
 	virtual int scanf(const char *__format, ...) = 0;
 	virtual bool eof() const = 0;
 
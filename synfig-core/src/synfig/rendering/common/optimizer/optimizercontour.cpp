@@ -0,0 +1,69 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/common/optimizer/optimizercontour.cpp
+**	\brief OptimizerContourRasterizer
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "optimizercontour.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+OptimizerContourRasterizer::OptimizerContourRasterizer(TaskContour::Rasterizer rasterizer):
+	rasterizer(rasterizer)
+{
+	category_id = CATEGORY_ID_BEGIN;
+	for_task = true;
+}
+
+void
+OptimizerContourRasterizer::run(const RunParams &params) const
+{
+	if (TaskContour::Handle contour = TaskContour::Handle::cast_dynamic(params.ref_task))
+	{
+		if (contour->rasterizer != rasterizer)
+		{
+			contour = TaskContour::Handle::cast_dynamic(contour->clone());
+			contour->rasterizer = rasterizer;
+			apply(params, contour);
+		}
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
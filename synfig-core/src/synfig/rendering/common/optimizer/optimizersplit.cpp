@@ -37,6 +37,9 @@
 
 #include "optimizersplit.h"
 
+#include "../../costmodel.h"
+#include "../../renderer.h"
+
 #endif
 
 using namespace synfig;
@@ -46,44 +49,102 @@ using namespace rendering;
 
 /* === G L O B A L S ======================================================= */
 
+const Real OptimizerSplit::min_part_seconds = 0.5e-3;
+const Real OptimizerSplit::max_overhead = 0.25;
+const int OptimizerSplit::min_part_size = 16;
+
 /* === P R O C E D U R E S ================================================= */
 
 /* === M E T H O D S ======================================================= */
 
-OptimizerSplit::OptimizerSplit()
+OptimizerSplit::OptimizerSplit(int threads):
+	threads(threads)
 {
 	category_id = CATEGORY_ID_LIST;
 	depends_from = CATEGORY_SPECIALIZED;
 	for_list = true;
+	CostModel::set_enabled(true);
+}
+
+VectorInt
+OptimizerSplit::get_grid(
+	const RectInt &rect,
+	Real pixel_cost,
+	Real part_cost,
+	bool by_rows,
+	Real seconds_per_unit,
+	int threads )
+{
+	const int w = rect.maxx - rect.minx;
+	const int h = rect.maxy - rect.miny;
+	if (threads < 2 || w <= 0 || h <= 0)
+		return VectorInt(1, 1);
+
+	// count of parts
+	const Real pixels_seconds = seconds_per_unit*pixel_cost*Real(w)*Real(h);
+	const Real part_seconds = seconds_per_unit*part_cost + CostModel::part_overhead_seconds;
+	int count = (int)std::min(Real(threads), std::floor(pixels_seconds/min_part_seconds));
+	while(count > 1 && (count - 1)*part_seconds > max_overhead*(pixels_seconds + part_seconds))
+		--count;
+	if (count < 2)
+		return VectorInt(1, 1);
+
+	const int max_cols = by_rows ? 1 : std::max(1, w/min_part_size);
+	const int max_rows = std::max(1, h/min_part_size);
+
+	// choose the most square parts among the grids with the most parts
+	VectorInt grid(1, 1);
+	Real best_aspect = 0;
+	for(int cols = 1; cols <= std::min(count, max_cols); ++cols) {
+		int rows = std::min(count/cols, max_rows);
+		Real aspect = std::fabs(std::log( (Real(w)/cols)/(Real(h)/rows) ));
+		if ( cols*rows > grid[0]*grid[1]
+		  || (cols*rows == grid[0]*grid[1] && aspect < best_aspect) )
+			{ grid = VectorInt(cols, rows); best_aspect = aspect; }
+	}
+	return grid;
 }
 
 void
 OptimizerSplit::run(const RunParams &params) const
 {
 	if (!params.list) return;
-	const int min_area = 256*256;
+	const int threads = this->threads > 0 ? this->threads : Renderer::get_max_simultaneous_threads();
 	for(Task::List::iterator i = params.list->begin(); i != params.list->end(); ++i)
 	{
 		if (TaskInterfaceSplit *split = i->type_pointer<TaskInterfaceSplit>())
 		if (split->is_splittable())
 		{
-			RectInt r = (*i)->target_rect;
-			int w = r.maxx - r.minx;
-			int h = r.maxy - r.miny;
-			int t = std::min(h/10, w*h/min_area);
-			if (t >= 2)
+			const RectInt r = (*i)->target_rect;
+			const VectorInt grid = get_grid(
+				r,
+				split->get_split_pixel_cost(),
+				split->get_split_part_cost(),
+				split->is_split_by_rows(),
+				CostModel::get_seconds_per_unit(**i),
+				threads );
+			const int count = grid[0]*grid[1];
+			if (count >= 2)
 			{
-				int hh = h/t;
-				int y = r.miny;
-				for(int j = 1; j < t; ++j, y += hh)
+				// task may be shared with other lists (see Renderer::optimize),
+				// so it is cloned before it will be prepared for splitting
+				const Task::Handle task = (*i)->clone();
+				task.type_pointer<TaskInterfaceSplit>()->on_split(count);
+				for(int j = 0; j < count; ++j)
 				{
-					Task::Handle task = (*i)->clone();
-					task->trunc_target_rect( RectInt(r.minx, y, r.maxx, y + hh) );
-					i = params.list->insert(i, task);
-					++i;
+					int col = j % grid[0], row = j / grid[0];
+					RectInt part(
+						r.minx + (r.maxx - r.minx)*col/grid[0],
+						r.miny + (r.maxy - r.miny)*row/grid[1],
+						r.minx + (r.maxx - r.minx)*(col + 1)/grid[0],
+						r.miny + (r.maxy - r.miny)*(row + 1)/grid[1] );
+					Task::Handle t = task->clone();
+					t->trunc_target_rect(part);
+					if (j + 1 < count)
+						{ i = params.list->insert(i, t); ++i; }
+					else
+						*i = t;
 				}
-				*i = (*i)->clone();
-				(*i)->trunc_target_rect( RectInt(r.minx, y, r.maxx, r.maxy) );
 				apply(params);
 			}
 		}
@@ -43,11 +43,35 @@ namespace synfig
 namespace rendering
 {
 
+/*!	\class OptimizerSplit
+**	\brief Splits the heavy tasks into parts to render them by several threads.
+**
+**	Count of parts is chosen by CostModel: each part should take at least
+**	min_part_seconds, the work repeated by each part should not exceed
+**	max_overhead of the whole task, and there are no more parts than threads.
+*/
 class OptimizerSplit: public Optimizer
 {
 public:
-	OptimizerSplit();
+	static const Real min_part_seconds;
+	static const Real max_overhead;
+	static const int min_part_size;
+
+	//! Max count of parts, zero means the count of rendering threads of Renderer
+	const int threads;
+
+	explicit OptimizerSplit(int threads = 0);
 	virtual void run(const RunParams &params) const;
+
+	//! Returns count of columns and rows of the parts of the task with target \a rect,
+	//! (1, 1) if the task should not be split
+	static VectorInt get_grid(
+		const RectInt &rect,
+		Real pixel_cost,
+		Real part_cost,
+		bool by_rows,
+		Real seconds_per_unit,
+		int threads );
 };
 
 } /* end namespace rendering */
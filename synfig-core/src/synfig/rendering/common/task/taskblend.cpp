@@ -71,6 +71,16 @@ TaskBlend::get_pass_subtask_index() const
 	return PASSTO_THIS_TASK;
 }
 
+bool
+TaskBlend::hash_params(TaskHash &hash) const
+{
+	if (!is_hashable_as(token))
+		return false;
+	hash.add(blend_method);
+	hash.add(amount);
+	return true;
+}
+
 Rect
 TaskBlend::calc_bounds() const
 {
@@ -94,6 +94,9 @@ public:
 		{ return sub_task_b() ? TaskList::calc_target_offset(*this, *sub_task_b()) : VectorInt(); }
 
 	virtual Rect calc_bounds() const;
+
+protected:
+	virtual bool hash_params(TaskHash &hash) const;
 };
 
 
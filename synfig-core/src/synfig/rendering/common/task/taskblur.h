@@ -61,6 +61,9 @@ public:
 
 	virtual Rect calc_bounds() const;
 	virtual void set_coords_sub_tasks();
+
+protected:
+	virtual bool hash_params(TaskHash &hash) const;
 };
 
 } /* end namespace rendering */
@@ -52,6 +52,34 @@ SYNFIG_EXPORT Task::Token TaskContour::token(
 	DescAbstract<TaskContour>("Contour") );
 
 
+bool
+TaskContour::hash_params(TaskHash &hash) const
+{
+	if (!is_hashable_as(token))
+		return false;
+	hash.add(detail);
+	hash.add(allow_antialias);
+	hash.add(rasterizer);
+	hash.add_data(transformation->matrix.m, sizeof(transformation->matrix.m));
+	hash.add(bool(contour));
+	if (contour) {
+		hash.add(contour->invert);
+		hash.add(contour->antialias);
+		hash.add(contour->winding_style);
+		hash.add_data(&contour->color, sizeof(contour->color));
+		hash.add(contour->beginning_of_unclosed());
+		const Contour::ChunkList &chunks = contour->get_chunks();
+		hash.add(chunks.size());
+		for(Contour::ChunkList::const_iterator i = chunks.begin(); i != chunks.end(); ++i) {
+			hash.add(i->type);
+			hash.add(i->p1);
+			hash.add(i->pp0);
+			hash.add(i->pp1);
+		}
+	}
+	return true;
+}
+
 Rect
 TaskContour::calc_bounds() const
 {
@@ -52,18 +52,27 @@ public:
 	SYNFIG_EXPORT static Token token;
 	virtual Token::Handle get_token() const { return token.handle(); }
 
+	enum Rasterizer {
+		RASTERIZER_SORTED, //!< sort all marks of polyspan and walk them
+		RASTERIZER_ROWS    //!< accumulate marks in the buffer of each row, without global sort
+	};
+
 public:
 	std::shared_ptr<Contour> contour;
 	Real detail;
 	bool allow_antialias;
+	Rasterizer rasterizer;
 	Holder<TransformationAffine> transformation;
 
-	TaskContour(): detail(1.0), allow_antialias(true) { }
+	TaskContour(): detail(1.0), allow_antialias(true), rasterizer(RASTERIZER_SORTED) { }
 
 	virtual Rect calc_bounds() const;
 
 	virtual Transformation::Handle get_transformation() const
 		{ return transformation.handle(); }
+
+protected:
+	virtual bool hash_params(TaskHash &hash) const;
 };
 
 } /* end namespace rendering */
@@ -113,6 +113,9 @@ public:
 			&& approximate_equal_lp(gamma.get_g(), ColorReal(1.0))
 			&& approximate_equal_lp(gamma.get_b(), ColorReal(1.0));
 	}
+
+protected:
+	virtual bool hash_params(TaskHash &hash) const;
 };
 
 
@@ -133,6 +136,9 @@ public:
 		{ return matrix.is_constant(); }
 	virtual bool is_affects_transparent() const
 		{ return matrix.is_affects_transparent(); }
+
+protected:
+	virtual bool hash_params(TaskHash &hash) const;
 };
 
 
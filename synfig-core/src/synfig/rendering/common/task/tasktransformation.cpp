@@ -129,6 +129,17 @@ TaskTransformation::set_coords_sub_tasks()
 }
 
 
+bool
+TaskTransformationAffine::hash_params(TaskHash &hash) const
+{
+	if (!is_hashable_as(token))
+		return false;
+	hash.add(interpolation);
+	hash.add(supersample);
+	hash.add_data(transformation->matrix.m, sizeof(transformation->matrix.m));
+	return true;
+}
+
 int
 TaskTransformationAffine::get_pass_subtask_index() const
 {
@@ -117,6 +117,9 @@ public:
 		{ return transformation.handle(); }
 
 	virtual int get_pass_subtask_index() const;
+
+protected:
+	virtual bool hash_params(TaskHash &hash) const;
 };
 
 
@@ -0,0 +1,110 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/costmodel.cpp
+**	\brief CostModel
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "costmodel.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+// weight of the new measurement in the running average
+#define COSTMODEL_WEIGHT 0.1
+
+/* === G L O B A L S ======================================================= */
+
+const Real CostModel::default_seconds_per_unit = 5e-9;
+const Real CostModel::part_overhead_seconds = 50e-6;
+
+std::atomic<bool> CostModel::enabled(false);
+std::mutex CostModel::mutex;
+std::map<Task::Token::Handle, CostModel::Entry> CostModel::entries;
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+CostModel::Timer::Timer(const Task &task):
+	task(enabled && dynamic_cast<const TaskInterfaceSplit*>(&task) ? &task : nullptr)
+{
+	if (this->task) begin = Clock::now();
+}
+
+CostModel::Timer::~Timer()
+{
+	if (!task) return;
+	Real seconds = std::chrono::duration<Real>(Clock::now() - begin).count();
+	add(*task, get_units(*task), seconds);
+}
+
+Real
+CostModel::get_units(const Task &task)
+{
+	const TaskInterfaceSplit *split = dynamic_cast<const TaskInterfaceSplit*>(&task);
+	if (!split || !task.target_rect.is_valid())
+		return 0.0;
+	const RectInt &r = task.target_rect;
+	return split->get_split_part_cost()
+	     + split->get_split_pixel_cost()*Real(r.maxx - r.minx)*Real(r.maxy - r.miny);
+}
+
+Real
+CostModel::get_seconds_per_unit(const Task &task)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::map<Task::Token::Handle, Entry>::const_iterator i = entries.find(task.get_token());
+	return i == entries.end() ? default_seconds_per_unit : i->second.seconds_per_unit;
+}
+
+void
+CostModel::add(const Task &task, Real units, Real seconds)
+{
+	if (units < 1.0 || seconds <= 0.0)
+		return;
+	std::lock_guard<std::mutex> lock(mutex);
+	Entry &entry = entries[task.get_token()];
+	Real x = seconds/units;
+	entry.seconds_per_unit = entry.count++
+	                       ? entry.seconds_per_unit + (x - entry.seconds_per_unit)*COSTMODEL_WEIGHT
+	                       : x;
+}
+
+void
+CostModel::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+}
+
+/* === E N T R Y P O I N T ================================================= */
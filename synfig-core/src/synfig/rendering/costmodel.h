@@ -0,0 +1,114 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/costmodel.h
+**	\brief CostModel Header
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_COSTMODEL_H
+#define __SYNFIG_RENDERING_COSTMODEL_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#include <synfig/real.h>
+
+#include "task.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+/*!	\class CostModel
+**	\brief Converts the estimated cost of splittable tasks into time.
+**
+**	TaskInterfaceSplit estimates the cost of the task in units of simple
+**	processing of one pixel. RenderQueue measures the real time of each
+**	splittable task, and the model keeps the running average of seconds
+**	per unit for each type of task, so the estimation used by OptimizerSplit
+**	becomes more exact while the long animation renders.
+**
+**	Measurements are enabled by OptimizerSplit, the only user of the model,
+**	so without it RenderQueue does not measure tasks at all.
+*/
+class CostModel
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	//! Default speed for the types of tasks which are not measured yet
+	static const Real default_seconds_per_unit;
+	//! Cost of each part of the split task in the render queue, independent of the task type
+	static const Real part_overhead_seconds;
+
+	//! Measures the time of its life as the time of the task
+	class Timer {
+	private:
+		const Task *task;
+		Clock::time_point begin;
+
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+
+	public:
+		explicit Timer(const Task &task);
+		~Timer();
+	};
+
+private:
+	struct Entry {
+		long long count;
+		Real seconds_per_unit;
+		Entry(): count(), seconds_per_unit(default_seconds_per_unit) { }
+	};
+
+	static std::atomic<bool> enabled;
+	static std::mutex mutex;
+	static std::map<Task::Token::Handle, Entry> entries;
+
+public:
+	static bool is_enabled() { return enabled; }
+	static void set_enabled(bool x) { enabled = x; }
+
+	//! Estimated cost of the \a task with its current target rect, zero if task is not splittable
+	static Real get_units(const Task &task);
+	static Real get_seconds_per_unit(const Task &task);
+	static void add(const Task &task, Real units, Real seconds);
+	static void reset();
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
@@ -0,0 +1,135 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/primitive/edgetable.cpp
+**	\brief EdgeTable
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "edgetable.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+int
+EdgeTable::get_bucket(Real y) const
+{
+	int count = (int)offsets.size() - 1;
+	int bucket = (int)std::floor((y - window.miny)/BUCKET_SIZE);
+	return std::max(0, std::min(count - 1, bucket));
+}
+
+void
+EdgeTable::clear()
+{
+	window = RectInt();
+	detail = 0;
+	primitives.clear();
+	miny.clear();
+	maxy.clear();
+	offsets.clear();
+	indices.clear();
+}
+
+void
+EdgeTable::init(const RectInt &window, PrimitiveList &primitives, Real detail)
+{
+	clear();
+	this->window = window;
+	this->detail = detail;
+	this->primitives.swap(primitives);
+	if (!window.is_valid())
+		return;
+
+	const int count = (int)this->primitives.size();
+	miny.resize(count);
+	maxy.resize(count);
+	for(int i = 0; i < count; ++i) {
+		const Primitive &p = this->primitives[i];
+		miny[i] = maxy[i] = p.points[0][1];
+		for(int j = 1; j < p.count; ++j) {
+			miny[i] = std::min(miny[i], p.points[j][1]);
+			maxy[i] = std::max(maxy[i], p.points[j][1]);
+		}
+	}
+
+	// count primitives of each bucket, then place them by the offsets
+	const int buckets = (window.maxy - window.miny + BUCKET_SIZE - 1)/BUCKET_SIZE;
+	offsets.resize(buckets + 1, 0);
+	for(int i = 0; i < count; ++i)
+		for(int j = get_bucket(miny[i]), last = get_bucket(maxy[i]); j <= last; ++j)
+			++offsets[j + 1];
+	for(int j = 0; j < buckets; ++j)
+		offsets[j + 1] += offsets[j];
+
+	indices.resize(offsets.back());
+	std::vector<int> positions(offsets.begin(), offsets.end() - 1);
+	for(int i = 0; i < count; ++i)
+		for(int j = get_bucket(miny[i]), last = get_bucket(maxy[i]); j <= last; ++j)
+			indices[positions[j]++] = i;
+}
+
+void
+EdgeTable::add_to(Polyspan &polyspan) const
+{
+	const RectInt &rows = polyspan.get_window();
+	if (primitives.empty() || !rows.is_valid())
+		return;
+	assert(window.miny <= rows.miny && rows.maxy <= window.maxy);
+
+	const int first = get_bucket(rows.miny);
+	const int last = get_bucket(rows.maxy - 1);
+	for(int j = first; j <= last; ++j) {
+		for(int k = offsets[j]; k < offsets[j + 1]; ++k) {
+			const int i = indices[k];
+
+			// primitive may cross several buckets, draw it only once
+			if (std::max(get_bucket(miny[i]), first) != j)
+				continue;
+			// primitives above or below of the rows are clipped entirely
+			if (maxy[i] < rows.miny || miny[i] >= rows.maxy)
+				continue;
+			polyspan.draw_primitive(primitives[i], detail);
+		}
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
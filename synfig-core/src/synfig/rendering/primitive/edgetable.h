@@ -0,0 +1,96 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/primitive/edgetable.h
+**	\brief EdgeTable Header
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_EDGETABLE_H
+#define __SYNFIG_RENDERING_EDGETABLE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <vector>
+
+#include <synfig/rect.h>
+
+#include "polyspan.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+/*!	\class EdgeTable
+**	\brief Lines and curves of contour in pixel coordinates, sorted into buckets of rows.
+**
+**	Contour is transformed and its short lines are merged once for the whole
+**	window (see Polyspan::init_primitives()), then each part of window (strip)
+**	subdivides and rasterizes only the primitives crossing its rows.
+**	Table is not changed by add_to(), so parts may be processed concurrently.
+*/
+class EdgeTable
+{
+public:
+	typedef Polyspan::Primitive Primitive;
+	typedef Polyspan::PrimitiveList PrimitiveList;
+
+	enum { BUCKET_SIZE = 16 };
+
+private:
+	RectInt window;
+	Real detail;
+	PrimitiveList primitives;
+	std::vector<Real> miny; //!< top of bounds of each primitive
+	std::vector<Real> maxy; //!< bottom of bounds of each primitive
+	std::vector<int> offsets; //!< first item in 'indices' for each bucket and the end
+	std::vector<int> indices; //!< primitives crossing the rows of bucket
+
+	int get_bucket(Real y) const;
+
+public:
+	EdgeTable(): detail() { }
+
+	const RectInt& get_window() const { return window; }
+	size_t get_count() const { return primitives.size(); }
+	bool empty() const { return primitives.empty(); }
+
+	void clear();
+
+	//! Takes primitives stored by Polyspan::init_primitives() with the same window and detail
+	void init(const RectInt &window, PrimitiveList &primitives, Real detail);
+
+	//! Rasterizes primitives crossing the rows of polyspan window, it should be inside of table window
+	void add_to(Polyspan &polyspan) const;
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
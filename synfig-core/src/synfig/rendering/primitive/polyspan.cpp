@@ -65,7 +65,8 @@ Polyspan::Polyspan():
 	cur_line_y(0.0),
 	close_x(0.0),
 	close_y(0.0),
-	flags(NotSorted)
+	flags(NotSorted),
+	primitives()
 { }
 
 //0 out all the variables involved in processing
@@ -77,6 +78,7 @@ Polyspan::clear()
 	open_index = 0;
 	current.set(0, 0, 0, 0);
 	flags = NotSorted;
+	primitives = nullptr;
 }
 
 //add the current cell, but only if there is information to add
@@ -161,6 +163,15 @@ Polyspan::sort_marks()
 	}
 }
 
+//add the pending marks, but keep them unsorted
+void
+Polyspan::finish_marks()
+{
+	finish_line();
+	addcurrent();
+	current.setcover(0,0);
+}
+
 //encapsulate the current sublist of marks (used for drawing)
 void
 Polyspan::encapsulate_current()
@@ -183,6 +194,50 @@ Polyspan::move_to(Real x, Real y)
 	close_x = cur_x = x;
 }
 
+void
+Polyspan::add_primitive(const Point &p0, const Point &p1)
+{
+	primitives->push_back(Primitive());
+	Primitive &primitive = primitives->back();
+	primitive.points[0] = p0;
+	primitive.points[1] = p1;
+	primitive.count = 2;
+}
+
+void
+Polyspan::add_primitive(const Point &p0, const Point &p1, const Point &p2)
+{
+	add_primitive(p0, p1);
+	primitives->back().points[2] = p2;
+	primitives->back().count = 3;
+}
+
+void
+Polyspan::add_primitive(const Point &p0, const Point &p1, const Point &p2, const Point &p3)
+{
+	add_primitive(p0, p1, p2);
+	primitives->back().points[3] = p3;
+	primitives->back().count = 4;
+}
+
+void
+Polyspan::draw_primitive(const Primitive &primitive, Real detail)
+{
+	const Point *p = primitive.points;
+	flags &= ~NotFinishedLine;
+	cur_x = p[0][0];
+	cur_y = p[0][1];
+	move_pen((int)floor(cur_x), (int)floor(cur_y));
+
+	switch(primitive.count) {
+	case 2: line_to(p[1][0], p[1][1], 0.0); break; //lines are already merged
+	case 3: conic_to(p[2][0], p[2][1], p[1][0], p[1][1], detail); break;
+	case 4: cubic_to(p[3][0], p[3][1], p[1][0], p[1][1], p[2][0], p[2][1], detail); break;
+	default: break;
+	}
+	finish_line();
+}
+
 void
 Polyspan::finish_line()
 {
@@ -218,6 +273,16 @@ Polyspan::line_to(Real x, Real y, Real detail)
 
 	flags &= ~NotFinishedLine;
 
+	if (primitives) {
+		//horizontal lines have no cover
+		if (y != cur_y)
+			add_primitive(Point(cur_x, cur_y), Point(x, y));
+		cur_x = x;
+		cur_y = y;
+		flags |= NotClosed;
+		return;
+	}
+
 	Real n[4] = {0,0,0,0};
 	bool afterx = false;
 	const Real xin(x), yin(y);
@@ -479,6 +544,14 @@ Polyspan::conic_to(Real x, Real y, Real x1, Real y1, Real detail)
 	}
 	finish_line();
 
+	if (primitives) {
+		add_primitive(arc[2], arc[1], arc[0]);
+		cur_x = x;
+		cur_y = y;
+		flags |= NotClosed;
+		return;
+	}
+
 	//just draw the line if it's outside
 	if(clip_conic(arc,window))
 	{
@@ -619,6 +692,14 @@ Polyspan::cubic_to(Real x, Real y, Real x1, Real y1, Real x2, Real y2, Real deta
 	}
 	finish_line();
 
+	if (primitives) {
+		add_primitive(arc[3], arc[2], arc[1], arc[0]);
+		cur_x = x;
+		cur_y = y;
+		flags |= NotClosed;
+		return;
+	}
+
 	//just draw the line if it's outside
 	if(clip_cubic(arc,window))
 	{
@@ -75,6 +75,17 @@ public:
 
 	typedef	std::vector<PenMark> cover_array;
 
+	//line or curve of contour (start point, control points, end point), see init_primitives()
+	struct Primitive
+	{
+		Point points[4];
+		int count;
+
+		Primitive(): count() { }
+	};
+
+	typedef std::vector<Primitive> PrimitiveList;
+
 	//for assignment to flags value
 	enum PolySpanFlags
 	{
@@ -114,6 +125,13 @@ private:
 	//the window that will be drawn (used for clipping)
 	RectInt		    window;
 
+	//if set then primitives are stored here instead of rasterization
+	PrimitiveList	*primitives;
+
+	void add_primitive(const Point &p0, const Point &p1);
+	void add_primitive(const Point &p0, const Point &p1, const Point &p2);
+	void add_primitive(const Point &p0, const Point &p1, const Point &p2, const Point &p3);
+
 	//add the current cell, but only if there is information to add
 	void addcurrent();
 
@@ -155,6 +173,11 @@ public:
 		window.maxy = maxy;
 	}
 
+	//store the primitives into the list instead of rasterization,
+	//short lines are merged just as for rasterization
+	void init_primitives(const RectInt &window, PrimitiveList &primitives)
+		{ clear(); this->window = window; this->primitives = &primitives; }
+
 	//close the primitives with a line (or rendering will not work as expected)
 	void close();
 
@@ -164,6 +187,9 @@ public:
 	//will sort the marks if they are not sorted
 	void sort_marks();
 
+	//add the pending marks, but keep them unsorted (see software::Contour::render_polyspan_rows())
+	void finish_marks();
+
 	//encapsulate the current sublist of marks (used for drawing)
 	void encapsulate_current();
 
@@ -175,6 +201,10 @@ public:
 	void conic_to(Real x, Real y, Real x1, Real y1, Real detail = 1.0);
 	void cubic_to(Real x, Real y, Real x1, Real y1, Real x2, Real y2, Real detail = 1.0);
 
+	//rasterize the single primitive stored by init_primitives() with the same detail,
+	//do not mix with move_to() and close() in the same polyspan
+	void draw_primitive(const Primitive &primitive, Real detail = 1.0);
+
 	void draw_scanline(int y, Real x1, Real y1, Real x2, Real y2);
 	void draw_line(Real x1, Real y1, Real x2, Real y2);
 
@@ -0,0 +1,251 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/profiler.cpp
+**	\brief Profiler
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+
+#include <synfig/color.h>
+#include <synfig/general.h>
+
+#include "profiler.h"
+#include "task.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+const size_t Profiler::max_buffered_events = 16384;
+
+std::atomic<bool> Profiler::enabled(false);
+std::mutex Profiler::mutex;
+std::mutex Profiler::file_mutex;
+std::ofstream Profiler::file;
+filesystem::Path Profiler::filename;
+Profiler::Clock::time_point Profiler::origin;
+Profiler::EventList Profiler::events;
+bool Profiler::file_empty = true;
+int Profiler::threads_count = 0;
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+long long
+rect_bytes(const RectInt &rect)
+{
+	return rect.is_valid()
+	     ? (long long)(rect.maxx - rect.minx)*(rect.maxy - rect.miny)*sizeof(Color)
+	     : 0;
+}
+
+void
+write_string(std::ostream &stream, const String &s)
+{
+	stream << '"';
+	for(char c : s)
+		if (c == '"' || c == '\\')
+			stream << '\\' << c;
+		else
+		if ((unsigned char)c >= 0x20)
+			stream << c;
+	stream << '"';
+}
+
+} // end of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+Profiler::Timer::Timer(const Task &task, int thread_index):
+	task(task), thread_index(thread_index), enabled(Profiler::is_enabled())
+{
+	if (enabled) begin = Clock::now();
+}
+
+Profiler::Timer::~Timer()
+	{ if (enabled) add(task, thread_index, begin, Clock::now()); }
+
+bool
+Profiler::start(const filesystem::Path &filename)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::lock_guard<std::mutex> file_lock(file_mutex);
+	if (enabled) return false;
+
+	file.open(filename.c_str());
+	if (!file) {
+		file.clear();
+		synfig::error("rendering::Profiler: cannot write trace to file: %s", filename.u8_str());
+		return false;
+	}
+	Profiler::filename = filename;
+	file_empty = true;
+	threads_count = 0;
+	write_begin(file);
+
+	origin = Clock::now();
+	events.clear();
+	events.reserve(max_buffered_events);
+	enabled = true;
+	return true;
+}
+
+bool
+Profiler::stop()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!enabled) return false;
+	enabled = false;
+
+	std::lock_guard<std::mutex> file_lock(file_mutex);
+	flush(events);
+	EventList().swap(events);
+	write_end(file, threads_count, file_empty);
+	file.close();
+
+	const bool success = !file.fail();
+	if (!success)
+		synfig::error("rendering::Profiler: cannot write trace to file: %s", filename.u8_str());
+	file.clear();
+	filename = filesystem::Path();
+	return success;
+}
+
+void
+Profiler::flush(const EventList &list)
+{
+	for(const Event &event : list)
+		threads_count = std::max(threads_count, event.thread_index + 1);
+	write_events(file, list, file_empty);
+}
+
+void
+Profiler::add(const Task &task, int thread_index, Clock::time_point begin, Clock::time_point end)
+{
+	Event event;
+	event.name = task.get_token()->name;
+	event.thread_index = thread_index;
+	event.width = task.target_rect.is_valid() ? task.target_rect.maxx - task.target_rect.minx : 0;
+	event.height = task.target_rect.is_valid() ? task.target_rect.maxy - task.target_rect.miny : 0;
+	event.bytes = get_bytes(task);
+	event.batch_index = task.renderer_data.batch_index;
+	event.index = task.renderer_data.index;
+
+	EventList list;
+	std::unique_lock<std::mutex> lock(mutex);
+	if (!enabled) return;
+	event.begin = std::chrono::duration_cast<std::chrono::microseconds>(begin - origin).count();
+	event.end = std::chrono::duration_cast<std::chrono::microseconds>(end - origin).count();
+	events.push_back(event);
+	if (events.size() < max_buffered_events)
+		return;
+
+	// file is locked before the buffer is released,
+	// so stop() can't complete the file until these events are written
+	list.reserve(max_buffered_events);
+	list.swap(events);
+	std::lock_guard<std::mutex> file_lock(file_mutex);
+	lock.unlock();
+	flush(list);
+}
+
+long long
+Profiler::get_bytes(const Task &task)
+{
+	long long bytes = rect_bytes(task.target_rect);
+	for(const Task::Handle &sub_task : task.sub_tasks)
+		if (sub_task)
+			bytes += rect_bytes(sub_task->target_rect);
+	return bytes;
+}
+
+void
+Profiler::write_begin(std::ostream &stream)
+{
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+}
+
+void
+Profiler::write_events(std::ostream &stream, const EventList &events, bool &first)
+{
+	for(const Event &event : events) {
+		if (!first) stream << ",";
+		first = false;
+		stream << "\n{\"name\":";
+		write_string(stream, event.name);
+		stream << ",\"cat\":\"task\",\"ph\":\"X\",\"pid\":1"
+		       << ",\"tid\":" << event.thread_index
+		       << ",\"ts\":" << event.begin
+		       << ",\"dur\":" << (event.end - event.begin)
+		       << ",\"args\":{"
+		       << "\"width\":" << event.width
+		       << ",\"height\":" << event.height
+		       << ",\"bytes\":" << event.bytes
+		       << ",\"batch\":" << event.batch_index
+		       << ",\"index\":" << event.index
+		       << "}}";
+	}
+}
+
+void
+Profiler::write_end(std::ostream &stream, int threads_count, bool &first)
+{
+	// names of threads, see RenderQueue::get()
+	for(int i = 0; i < threads_count; ++i) {
+		if (!first) stream << ",";
+		first = false;
+		stream << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+		       << ",\"args\":{\"name\":";
+		write_string(stream, i ? strprintf("render %d", i) : String("render single-threaded"));
+		stream << "}}";
+	}
+	stream << "\n]}\n";
+}
+
+void
+Profiler::write_trace(std::ostream &stream, const EventList &events)
+{
+	int threads_count = 0;
+	for(const Event &event : events)
+		threads_count = std::max(threads_count, event.thread_index + 1);
+
+	bool first = true;
+	write_begin(stream);
+	write_events(stream, events, first);
+	write_end(stream, threads_count, first);
+}
+
+/* === E N T R Y P O I N T ================================================= */
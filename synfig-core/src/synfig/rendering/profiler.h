@@ -0,0 +1,151 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/profiler.h
+**	\brief Profiler Header
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_PROFILER_H
+#define __SYNFIG_RENDERING_PROFILER_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <synfig/filesystem_path.h>
+#include <synfig/string.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+class Task;
+
+/*!	\class Profiler
+**	\brief Records each task performed by RenderQueue.
+**
+**	Unlike Statistics it keeps every run of task separately: thread,
+**	start and end time, size of target rect and approximate count of
+**	bytes touched (target and sub-task surfaces). Result is written in
+**	Chrome trace event format, so it can be opened in chrome://tracing
+**	or https://ui.perfetto.dev.
+**
+**	Started by environment variable SYNFIG_RENDERING_DEBUG_TRACE or by
+**	the option --trace of synfig tool. The file is opened by start(),
+**	events are appended to it each time max_buffered_events are collected,
+**	and the file is completed when Renderer deinitializes. Disabled by
+**	default, then RenderQueue does not create timers at all.
+*/
+class Profiler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Event {
+		String name;
+		int thread_index;
+		long long begin; //!< microseconds since start()
+		long long end;   //!< microseconds since start()
+		int width;
+		int height;
+		long long bytes;
+		int batch_index;
+		int index;
+		Event(): thread_index(), begin(), end(), width(), height(), bytes(), batch_index(), index() { }
+	};
+
+	typedef std::vector<Event> EventList;
+
+	//! Records the task performed while the timer is alive
+	class Timer {
+	private:
+		const Task &task;
+		int thread_index;
+		bool enabled;
+		Clock::time_point begin;
+
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+
+	public:
+		Timer(const Task &task, int thread_index);
+		~Timer();
+	};
+
+	//! Count of events kept in memory before they are appended to the file
+	static const size_t max_buffered_events;
+
+private:
+	static std::atomic<bool> enabled;
+	//! guards events and origin
+	static std::mutex mutex;
+	//! guards file and the fields below, locked after mutex when both are needed
+	static std::mutex file_mutex;
+	static std::ofstream file;
+	static filesystem::Path filename;
+	static Clock::time_point origin;
+	static EventList events;
+	static bool file_empty;
+	static int threads_count;
+
+	//! Appends \a list to the file, file_mutex should be locked
+	static void flush(const EventList &list);
+
+public:
+	static bool is_enabled() { return enabled; }
+
+	//! Opens \a filename and starts recording, returns false if file cannot be written
+	static bool start(const filesystem::Path &filename);
+	//! Stops recording and completes the file, returns false if file was not written
+	static bool stop();
+
+	static void add(const Task &task, int thread_index, Clock::time_point begin, Clock::time_point end);
+
+	//! Approximate count of bytes read and written by the task
+	static long long get_bytes(const Task &task);
+
+	static void write_begin(std::ostream &stream);
+	//! Writes \a events, \a first is true if nothing was written after write_begin()
+	static void write_events(std::ostream &stream, const EventList &events, bool &first);
+	//! Writes names of \a threads_count threads and closes the list
+	static void write_end(std::ostream &stream, int threads_count, bool &first);
+	//! Writes the whole trace at once
+	static void write_trace(std::ostream &stream, const EventList &events);
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
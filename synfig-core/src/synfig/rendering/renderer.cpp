@@ -44,8 +44,10 @@
 #include <synfig/debug/log.h>
 #include <synfig/debug/measure.h>
 
+#include "profiler.h"
 #include "renderer.h"
 #include "renderqueue.h"
+#include "statistics.h"
 
 #include "software/renderersw.h"
 #include "software/rendererdraftsw.h"
@@ -76,10 +78,25 @@ using namespace rendering;
 
 /* === M A C R O S ========================================================= */
 
+// how many optimized task lists are kept for reuse by each renderer
+#define OPTIMIZED_LISTS_CACHE_SIZE 8
+
+// sub-trees with less tasks are cheaper to render than to keep in the surface cache
+#define SURFACE_CACHE_MIN_TASKS 3
+
 /* === G L O B A L S ======================================================= */
 
 /* === P R O C E D U R E S ================================================= */
 
+static bool
+has_target_surfaces(const Task::List &list)
+{
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i)
+		if (*i && ((*i)->target_surface || has_target_surfaces((*i)->sub_tasks)))
+			return true;
+	return false;
+}
+
 /* === M E T H O D S ======================================================= */
 
 Renderer::Handle Renderer::blank;
@@ -88,6 +105,7 @@ RenderQueue *Renderer::queue;
 Renderer::DebugOptions Renderer::debug_options;
 long long Renderer::last_registered_optimizer_index = 0;
 long long Renderer::last_batch_index = 0;
+size_t Renderer::surface_cache_max_size = 0;
 
 
 void
@@ -124,13 +142,17 @@ Renderer::deinitialize_renderers()
 
 
 
+Renderer::Renderer():
+	surface_cache(surface_cache_max_size)
+{ }
+
 Renderer::~Renderer() { }
 
 int
-Renderer::get_max_simultaneous_threads() const
+Renderer::get_max_simultaneous_threads()
 {
-	assert(queue);
-	return queue->get_threads_count() - 1;
+	// thread 0 of the queue is reserved for the tasks without multithreading
+	return queue ? queue->get_threads_count() - 1 : 1;
 }
 
 bool
@@ -404,7 +426,7 @@ Renderer::optimize_recursive(
 
 		// run optimizers
 		bool first_pass = true;
-		ThreadPool::Group group;
+		ThreadPool::Group group(ThreadPool::PRIORITY_OPTIMIZE);
 		while (jumps[count] != count) {
 			for(int j = count, i = jumps[j]; i < count; i = jumps[i]) {
 				Optimizer::RunParams &sp = sub_params[i];
@@ -485,7 +507,7 @@ Renderer::optimize_recursive(
 }
 
 void
-Renderer::optimize(Task::List &list) const
+Renderer::optimize(Task::List &list, SurfaceCacheUsage *surface_cache_usage) const
 {
 	#ifdef DEBUG_TASK_MEASURE
 	debug::Measure t("Renderer::optimize");
@@ -507,7 +529,10 @@ Renderer::optimize(Task::List &list) const
 		while (prepared_category_id < current_category_id) {
 			switch (++prepared_category_id) {
 			case Optimizer::CATEGORY_ID_COORDS:
-				calc_coords(list); break;
+				calc_coords(list);
+				if (surface_cache_usage)
+					use_surface_cache(list, *surface_cache_usage);
+				break;
 			case Optimizer::CATEGORY_ID_SPECIALIZED:
 				specialize(list); break;
 			case Optimizer::CATEGORY_ID_LIST:
@@ -671,6 +696,212 @@ Renderer::optimize(Task::List &list) const
 	remove_dummy(list);
 }
 
+Task::Handle
+Renderer::use_surface_cache(
+	const Task::Handle &task,
+	Task::List &tasks_to_cache,
+	SurfaceCacheUsage &usage ) const
+{
+	Task::Handle new_task = task;
+	for(int i = 0; i < (int)task->sub_tasks.size(); ++i) {
+		const Task::Handle &sub_task = task->sub_tasks[i];
+		if (!sub_task)
+			continue;
+
+		Task::Handle new_sub_task = sub_task;
+		SurfaceCache::Key key;
+		if ( sub_task->is_valid()
+		  && sub_task->target_surface
+		  && sub_task->target_surface != task->target_surface
+		  && subtasks_count(sub_task, SURFACE_CACHE_MIN_TASKS) >= SURFACE_CACHE_MIN_TASKS )
+			key = SurfaceCache::get_key(*sub_task, sub_task->target_surface->get_size());
+
+		if (key.hash) {
+			if (SurfaceResource::Handle surface = surface_cache.get(key)) {
+				// already rendered
+				new_sub_task = new TaskSurface();
+				new_sub_task->assign_target(*sub_task);
+				new_sub_task->target_surface = surface;
+				usage.used.push_back(SurfaceCache::Entry(key, surface));
+			} else
+			if (surface_cache.admit(key)) {
+				// render separately before the parent, and keep the result when frame is done
+				tasks_to_cache.push_back(sub_task);
+				usage.to_cache.push_back(SurfaceCache::Entry(key, sub_task->target_surface));
+				new_sub_task = new TaskSurface();
+				new_sub_task->assign_target(*sub_task);
+			} else {
+				// seen for the first time, static parts of it may be cached
+				usage.pending = true;
+				new_sub_task = use_surface_cache(sub_task, tasks_to_cache, usage);
+			}
+		} else {
+			new_sub_task = use_surface_cache(sub_task, tasks_to_cache, usage);
+		}
+
+		if (new_sub_task != sub_task) {
+			if (new_task == task) new_task = task->clone();
+			new_task->sub_tasks[i] = new_sub_task;
+		}
+	}
+	return new_task;
+}
+
+void
+Renderer::use_surface_cache(Task::List &list, SurfaceCacheUsage &usage) const
+{
+	#ifdef DEBUG_OPTIMIZATION_MEASURE
+	debug::Measure t("use surface cache");
+	#endif
+
+	// input tasks draw directly to the targets, so only sub-tasks are cached
+	for(Task::List::iterator i = list.begin(); i != list.end(); ++i) {
+		if (!*i) continue;
+		Task::List tasks_to_cache;
+		*i = use_surface_cache(*i, tasks_to_cache, usage);
+		i = list.insert(i, tasks_to_cache.begin(), tasks_to_cache.end()) + tasks_to_cache.size();
+	}
+}
+
+TaskHash::Type
+Renderer::get_list_hash(const Task::List &list, std::string &key)
+{
+	key.clear();
+	TaskHash hash(&key);
+	hash.add(list.size());
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i) {
+		// only target surfaces of the input tasks can be substituted,
+		// sub-tasks which already have surfaces (images, prebuilt results) are not supported,
+		// and legacy layers (TaskLayer) are not described by hash at all
+		if ( !*i || !(*i)->target_surface || has_target_surfaces((*i)->sub_tasks)
+		  || !(*i)->add_to_hash(hash) )
+			{ key.clear(); return 0; }
+		hash.add((*i)->target_surface->get_size());
+
+		// same surface may be shared by several input tasks
+		int first = 0;
+		while(list[first]->target_surface != (*i)->target_surface) ++first;
+		hash.add(first);
+	}
+	return hash.get() ? hash.get() : 1;
+}
+
+Task::Handle
+Renderer::clone_with_surfaces(const Task::Handle &task, SurfaceMap &surfaces, TaskMap &tasks)
+{
+	if (!task)
+		return task;
+
+	Task::Handle &clone = tasks[task.get()];
+	if (clone)
+		return clone;
+
+	clone = task->clone();
+	clone->renderer_data = Task::RendererData();
+	if (clone->target_surface) {
+		SurfaceResource::Handle &surface = surfaces[clone->target_surface];
+		if (!surface) {
+			surface = new SurfaceResource();
+			if (clone->target_surface->is_exists())
+				surface->create(clone->target_surface->get_width(), clone->target_surface->get_height());
+		}
+		clone->target_surface = surface;
+	}
+
+	for(Task::List::iterator i = clone->sub_tasks.begin(); i != clone->sub_tasks.end(); ++i)
+		*i = clone_with_surfaces(*i, surfaces, tasks);
+	return clone;
+}
+
+Task::List
+Renderer::clone_with_surfaces(const Task::List &list, SurfaceMap &surfaces)
+{
+	TaskMap tasks;
+	Task::List clone;
+	clone.reserve(list.size());
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i)
+		clone.push_back(clone_with_surfaces(*i, surfaces, tasks));
+	return clone;
+}
+
+bool
+Renderer::restore_optimized(TaskHash::Type hash, const std::string &key, const Task::List &list, Task::List &optimized_list) const
+{
+	const bool surface_cache_enabled = surface_cache.is_enabled();
+	std::lock_guard<std::mutex> lock(optimized_lists_mutex);
+	for(std::list<OptimizedListEntry>::iterator i = optimized_lists.begin(); i != optimized_lists.end(); ++i) {
+		if ( i->hash != hash
+		  || i->surface_cache_enabled != surface_cache_enabled
+		  || i->targets.size() != list.size()
+		  || i->key != key )
+			continue;
+
+		// list which refers to the evicted surfaces should be optimized again
+		bool cached = true;
+		for(SurfaceCache::EntryList::const_iterator j = i->cached_surfaces.begin(); cached && j != i->cached_surfaces.end(); ++j)
+			cached = surface_cache.get(j->key) == j->surface;
+		if (!cached) {
+			optimized_lists.erase(i);
+			return false;
+		}
+
+		// cached surfaces are complete and shared as is
+		SurfaceMap surfaces;
+		for(SurfaceCache::EntryList::const_iterator j = i->cached_surfaces.begin(); j != i->cached_surfaces.end(); ++j)
+			surfaces[j->surface] = j->surface;
+		for(int j = 0; j < (int)list.size(); ++j)
+			surfaces[i->targets[j]] = list[j]->target_surface;
+		optimized_list = clone_with_surfaces(i->list, surfaces);
+
+		optimized_lists.splice(optimized_lists.begin(), optimized_lists, i);
+		return true;
+	}
+	return false;
+}
+
+void
+Renderer::store_optimized(
+	TaskHash::Type hash,
+	const std::string &key,
+	const Task::List &list,
+	const Task::List &optimized_list,
+	const SurfaceCache::EntryList &cached_surfaces ) const
+{
+	// keep copy which doesn't refer to any surface of the current run,
+	// so rendered pixels will not be retained by the cache,
+	// only the complete surfaces of the surface cache are kept
+	OptimizedListEntry entry;
+	entry.hash = hash;
+	entry.key = key;
+	entry.surface_cache_enabled = surface_cache.is_enabled();
+	entry.cached_surfaces = cached_surfaces;
+	SurfaceMap surfaces;
+	for(SurfaceCache::EntryList::const_iterator i = cached_surfaces.begin(); i != cached_surfaces.end(); ++i)
+		surfaces[i->surface] = i->surface;
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i) {
+		SurfaceResource::Handle &target = surfaces[(*i)->target_surface];
+		if (!target)
+			target = new SurfaceResource();
+		entry.targets.push_back(target);
+	}
+	entry.list = clone_with_surfaces(optimized_list, surfaces);
+
+	std::lock_guard<std::mutex> lock(optimized_lists_mutex);
+	optimized_lists.push_front(entry);
+	if (optimized_lists.size() > OPTIMIZED_LISTS_CACHE_SIZE)
+		optimized_lists.pop_back();
+}
+
+void
+Renderer::clear_caches() const
+{
+	{
+		std::lock_guard<std::mutex> lock(optimized_lists_mutex);
+		optimized_lists.clear();
+	}
+	surface_cache.clear();
+}
+
 void
 Renderer::find_deps(const Task::List &list, long long batch_index) const
 {
@@ -837,9 +1068,37 @@ Renderer::enqueue(const Task::List &list, const TaskEvent::Handle &finish_event_
 	if (!quiet && !get_debug_options().task_list_log.empty())
 		log(get_debug_options().task_list_log, list, "input list");
 
-	Task::List optimized_list(list);
-	optimize(optimized_list);
-	find_deps(optimized_list, ++last_batch_index);
+	// tasks with the same structure as in one of the previous runs
+	// (static scene, for example) reuse the result of optimization.
+	// When surface cache is enabled, optimized list depends on the state of the cache,
+	// so it is stored only when it will not change while the used surfaces are cached
+	Task::List optimized_list;
+	SurfaceCacheUsage surface_cache_usage;
+	const SurfaceCache::EntryList &surfaces_to_cache = surface_cache_usage.to_cache;
+	bool use_surface_cache = surface_cache.is_enabled();
+	{
+		Statistics::Timer timer("optimize");
+		std::string key;
+		TaskHash::Type hash = get_list_hash(list, key);
+		if (!hash || !restore_optimized(hash, key, list, optimized_list)) {
+			optimized_list = list;
+			optimize(optimized_list, use_surface_cache ? &surface_cache_usage : nullptr);
+			if (hash && surface_cache_usage.is_stable())
+				store_optimized(hash, key, list, optimized_list, surface_cache_usage.used);
+		}
+	}
+	{
+		Statistics::Timer timer("linearize");
+		find_deps(optimized_list, ++last_batch_index);
+	}
+
+	if (!quiet && use_surface_cache && !get_debug_options().surface_cache_log.empty()) {
+		SurfaceCache::Stats stats = surface_cache.get_stats();
+		debug::Log::info(get_debug_options().surface_cache_log,
+			"%s: surface cache hits %lld, misses %lld, evictions %lld, surfaces %zu, %zu of %zu bytes used, %zu surfaces to cache",
+			get_name().c_str(), stats.hits, stats.misses, stats.evictions,
+			stats.count, stats.size, stats.max_size, surfaces_to_cache.size() );
+	}
 
 	#ifdef DEBUG_TASK_LIST
 	if (!quiet) log("", optimized_list, "optimized list");
@@ -856,6 +1115,11 @@ Renderer::enqueue(const Task::List &list, const TaskEvent::Handle &finish_event_
 		optimized_list.push_back(finish_event_task);
 	}
 
+	// surfaces are complete only when all tasks are done
+	if (!surfaces_to_cache.empty())
+		finish_event_task->signal_finished.connect(sigc::bind(
+			sigc::ptr_fun(&Renderer::store_surfaces_func), get_renderer(get_name()), surfaces_to_cache ));
+
 	// try to find existing handle to this renderer instead,
 	// because creation and destruction of handle may cause destruction of renderer
 	// if it never stored in handles before
@@ -988,6 +1252,18 @@ Renderer::initialize()
 		debug_options.task_list_optimized_log = {s};
 	if (const char *s = getenv("SYNFIG_RENDERING_DEBUG_RESULT_IMAGE"))
 		debug_options.result_image = {s};
+	if (const char *s = getenv("SYNFIG_RENDERING_DEBUG_SURFACE_CACHE_LOG"))
+		debug_options.surface_cache_log = {s};
+	if (const char *s = getenv("SYNFIG_RENDERING_DEBUG_TRACE"))
+		debug_options.trace = {s};
+
+	// trace may be already started from the command line
+	if (!debug_options.trace.empty() && !Profiler::is_enabled())
+		Profiler::start(debug_options.trace);
+
+	// memory limit for the cache of rendered static sub-trees in megabytes
+	if (const char *s = getenv("SYNFIG_RENDERING_SURFACE_CACHE_SIZE"))
+		surface_cache_max_size = (size_t)std::max(0l, atol(s))*1024*1024;
 
 	renderers = new std::map<String, Handle>();
 	queue = new RenderQueue();
@@ -1010,6 +1286,9 @@ Renderer::deinitialize()
 	renderers = nullptr;
 	delete queue;
 	queue = nullptr;
+
+	// all tasks are finished, so the trace is complete
+	Profiler::stop();
 }
 
 void
@@ -32,10 +32,13 @@
 
 #include <cstdio>
 
+#include <list>
 #include <map>
+#include <mutex>
 #include <atomic>
 
 #include "optimizer.h"
+#include "surfacecache.h"
 #include "synfig/filesystem_path.h"
 
 /* === M A C R O S ========================================================= */
@@ -61,6 +64,8 @@ public:
 		filesystem::Path task_list_log;
 		filesystem::Path task_list_optimized_log;
 		filesystem::Path result_image;
+		filesystem::Path surface_cache_log;
+		filesystem::Path trace;
 	};
 
 private:
@@ -70,12 +75,50 @@ private:
 	static DebugOptions debug_options;
 	static long long last_registered_optimizer_index;
 	static long long last_batch_index; // TODO: atomic
+	static size_t surface_cache_max_size;
 
 	ModeList modes;
 	Optimizer::List optimizers[Optimizer::CATEGORIES_COUNT];
 
+	//! Usage of the surface cache by the optimized list
+	struct SurfaceCacheUsage {
+		//! sub-tasks rendered separately, their results should be put into the cache
+		SurfaceCache::EntryList to_cache;
+		//! cached surfaces used instead of sub-tasks
+		SurfaceCache::EntryList used;
+		//! some of sub-tasks are seen for the first time and may be cached in the next runs
+		bool pending;
+		SurfaceCacheUsage(): pending() { }
+		//! optimized list will be the same in the next runs while the used surfaces are cached
+		bool is_stable() const
+			{ return to_cache.empty() && !pending; }
+	};
+
+	//! Result of optimization of the input task list, see get_list_hash()
+	struct OptimizedListEntry {
+		TaskHash::Type hash;
+		//! hashed data of the input list, compared on reuse to exclude collisions
+		std::string key;
+		//! surface cache was enabled when the list was optimized
+		bool surface_cache_enabled;
+		//! cached surfaces used by the optimized list, list is valid only while all of them are cached
+		SurfaceCache::EntryList cached_surfaces;
+		//! stand-ins for the target surfaces of the input tasks
+		std::vector<SurfaceResource::Handle> targets;
+		//! optimized tasks, they are never enqueued, only cloned
+		Task::List list;
+		OptimizedListEntry(): hash(), surface_cache_enabled() { }
+	};
+
+	mutable std::mutex optimized_lists_mutex;
+	mutable std::list<OptimizedListEntry> optimized_lists; //!< most recently used first
+
+	//! rendered results of the static sub-trees
+	mutable SurfaceCache surface_cache;
+
 public:
 
+	Renderer();
 	virtual ~Renderer();
 
 	virtual String get_name() const = 0;
@@ -120,6 +163,29 @@ private:
 		int max_level ) const;
 
 	void optimize(Optimizer::Category category, Task::List &list) const;
+	void optimize(Task::List &list, SurfaceCacheUsage *surface_cache_usage) const;
+
+	Task::Handle use_surface_cache(
+		const Task::Handle &task,
+		Task::List &tasks_to_cache,
+		SurfaceCacheUsage &usage ) const;
+	void use_surface_cache(Task::List &list, SurfaceCacheUsage &usage) const;
+	static void store_surfaces_func(bool success, Renderer::Handle renderer, SurfaceCache::EntryList surfaces)
+		{ if (success) renderer->surface_cache.put(surfaces); }
+
+	typedef std::map<SurfaceResource::Handle, SurfaceResource::Handle> SurfaceMap;
+	typedef std::map<const Task*, Task::Handle> TaskMap;
+
+	static TaskHash::Type get_list_hash(const Task::List &list, std::string &key);
+	static Task::Handle clone_with_surfaces(const Task::Handle &task, SurfaceMap &surfaces, TaskMap &tasks);
+	static Task::List clone_with_surfaces(const Task::List &list, SurfaceMap &surfaces);
+	bool restore_optimized(TaskHash::Type hash, const std::string &key, const Task::List &list, Task::List &optimized_list) const;
+	void store_optimized(
+		TaskHash::Type hash,
+		const std::string &key,
+		const Task::List &list,
+		const Task::List &optimized_list,
+		const SurfaceCache::EntryList &cached_surfaces ) const;
 
 	void log(
 		const filesystem::Path& logfile,
@@ -143,8 +209,15 @@ private:
 	void find_deps(const Task::List &list, long long batch_index) const;
 
 public:
-	int get_max_simultaneous_threads() const;
-	void optimize(Task::List &list) const;
+	static int get_max_simultaneous_threads();
+	void optimize(Task::List &list) const
+		{ optimize(list, nullptr); }
+
+	SurfaceCache& get_surface_cache() const
+		{ return surface_cache; }
+
+	//! Drops reused optimized lists and cached surfaces, so the next run starts from scratch
+	void clear_caches() const;
 
 	bool run(
 		const Task::List &list,
@@ -37,12 +37,16 @@
 
 #include <synfig/general.h>
 #include <synfig/localization.h>
+#include <synfig/threadpool.h>
 #include <synfig/debug/debugsurface.h>
 #include <synfig/debug/log.h>
 #include <synfig/debug/measure.h>
 
 #include "renderqueue.h"
 #include "renderer.h"
+#include "costmodel.h"
+#include "profiler.h"
+#include "statistics.h"
 
 #endif
 
@@ -86,19 +90,29 @@ Task::Token TaskSubQueue::token(
 } // end of anonimous namespace
 
 
-RenderQueue::RenderQueue(): started(false) { start(); }
+RenderQueue::RenderQueue():
+	started(false),
+	threads_count(),
+	next_lane(),
+	ready_count(),
+	single_ready_count(),
+	sleeping_count(),
+	single_sleeping_count()
+	{ start(); }
+
 RenderQueue::~RenderQueue() { stop(); }
 
 void
 RenderQueue::start()
 {
-	std::lock_guard<std::mutex> lock(mutex);
+	std::lock_guard<std::mutex> lock(threads_mutex);
 	if (started) return;
 
 	// one thread reserved for non-multithreading tasks (OpenGL)
 	// also this thread almost don't use CPU time
 	// so we have ~50% of one core for GUI
-	unsigned int count = std::thread::hardware_concurrency();
+	// the budget of threads is common with ThreadPool
+	unsigned int count = ThreadPool::get_thread_budget();
 
 	#ifdef DEBUG_TASK_SURFACE
 	count = 2;
@@ -110,30 +124,48 @@ RenderQueue::start()
 	if (count > SYNFIG_RENDERING_MAX_THREADS) count = SYNFIG_RENDERING_MAX_THREADS;
 	if (count < 2) count = 2;
 
+	// lanes must be ready before threads start
+	lanes.reset(new Lane[count]);
+	threads_count = count;
+	started = true;
+
 	for(unsigned int i = 0; i < count; ++i)
 		threads.push_back(
 			std::thread(
 				sigc::bind(sigc::mem_fun(*this, &RenderQueue::process), i) ));
 	info("rendering threads %d", count);
-	started = true;
 }
 
 void
 RenderQueue::stop()
 {
+	std::lock_guard<std::mutex> lock(threads_mutex);
+	started = false;
 	{
-		std::lock_guard<std::mutex> lock(mutex);
-		started = false;
+		std::lock_guard<std::mutex> sleep_lock(sleep_mutex);
 		cond.notify_all();
 		single_cond.notify_all();
 	}
-	while(!threads.empty())
-		{ threads.front().join(); threads.pop_front(); }
+	for(ThreadList::iterator i = threads.begin(); i != threads.end(); ++i)
+		i->join();
+	threads.clear();
+}
+
+bool
+RenderQueue::run(int thread_index, Task &task)
+{
+	if (!thread_index)
+		return task.run(task.renderer_data.params);
+	ThreadPool::BusyLock busy_lock;
+	return task.run(task.renderer_data.params);
 }
 
 void
 RenderQueue::process(int thread_index)
 {
+	if (thread_index)
+		ThreadPool::pin_current_thread(thread_index - 1);
+
 	while(Task::Handle task = get(thread_index))
 	{
 		#ifdef DEBUG_THREAD_TASK
@@ -146,14 +178,35 @@ RenderQueue::process(int thread_index)
 
 		if (TaskSubQueue::Handle task_sub_queue = TaskSubQueue::Handle::cast_dynamic(task))
 		{
+			if (task_sub_queue->renderer_data.cancelled)
+				task_sub_queue->sub_task()->renderer_data.success = false;
 			done(thread_index, task_sub_queue->sub_task());
 			done(thread_index, task_sub_queue);
 			continue;
 		}
 
+		// cancelled tasks are not performed, but tasks which depends on them
+		// still should be released, so skipped task passes through done()
+		if (task->renderer_data.cancelled)
+		{
+			task->renderer_data.success = false;
+			if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(task))
+				task_event->finish(false);
+			done(thread_index, task);
+			continue;
+		}
+
 		bool success = false;
 		try {
-			success = task->run(task->renderer_data.params);
+			// timers are created only when somebody collects measurements
+			if (Statistics::is_enabled() || Profiler::is_enabled() || CostModel::is_enabled()) {
+				Statistics::Timer timer(*task);
+				Profiler::Timer profiler_timer(*task, thread_index);
+				CostModel::Timer cost_timer(*task);
+				success = run(thread_index, *task);
+			} else {
+				success = run(thread_index, *task);
+			}
 		} catch(...) { }
 		if (!success)
 			task->renderer_data.success = false;
@@ -196,165 +249,204 @@ void
 RenderQueue::done(int thread_index, const Task::Handle &task)
 {
 	assert(task);
-	int single_signals = 0;
-	int signals = 0;
-	std::lock_guard<std::mutex> lock(mutex);
-	for(Task::Set::iterator i = task->renderer_data.back_deps.begin(); i != task->renderer_data.back_deps.end(); ++i)
+
+	// back_deps are taken out of the task, so it will not be visited by cancel() anymore,
+	// deps are already done, so just release them
+	Task::Set back_deps;
+	{
+		std::lock_guard<std::mutex> lock(task->renderer_data.deps_mutex);
+		back_deps.swap(task->renderer_data.back_deps);
+		task->renderer_data.deps.clear();
+	}
+
+	for(Task::Set::const_iterator i = back_deps.begin(); i != back_deps.end(); ++i)
 	{
 		assert(*i);
-		(*i)->renderer_data.deps.erase(task);
-		if ((*i)->renderer_data.deps.empty())
+		assert((*i)->renderer_data.deps_count > 0);
+		if (--(*i)->renderer_data.deps_count == 0)
+			push(thread_index, *i);
+	}
+}
+
+Task::Handle
+RenderQueue::take(int thread_index)
+{
+	if (thread_index == 0)
+	{
+		// single-thread lane keeps the order of tasks
+		Lane &lane = lanes[0];
+		std::lock_guard<std::mutex> lock(lane.mutex);
+		if (lane.tasks.empty()) return Task::Handle();
+		Task::Handle task = lane.tasks.front();
+		lane.tasks.pop_front();
+		--single_ready_count;
+		return task;
+	}
+
+	// own lane, the last pushed task first, its data is probably still in cache
+	{
+		Lane &lane = lanes[thread_index];
+		std::lock_guard<std::mutex> lock(lane.mutex);
+		if (!lane.tasks.empty())
+		{
+			Task::Handle task = lane.tasks.back();
+			lane.tasks.pop_back();
+			--ready_count;
+			return task;
+		}
+	}
+
+	// steal the oldest task from other lanes
+	int lanes_count = threads_count - 1;
+	for(int i = 1; i < lanes_count; ++i)
+	{
+		Lane &lane = lanes[1 + (thread_index - 1 + i)%lanes_count];
+		std::lock_guard<std::mutex> lock(lane.mutex);
+		if (!lane.tasks.empty())
 		{
-			bool mt = (*i)->get_allow_multithreading();
-			TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-			TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-			wait.erase(*i);
-			queue.push_back(*i);
-			++(mt ? signals : single_signals);
+			Task::Handle task = lane.tasks.front();
+			lane.tasks.pop_front();
+			--ready_count;
+			return task;
 		}
 	}
-	task->renderer_data.back_deps.clear();
-	assert( tasks_in_process.count(thread_index) == 1 );
-	tasks_in_process.erase(thread_index);
-	//info("rendering threads used %d", tasks_in_process.size());
-
-	// limit signals count
-	int threads = get_threads_count() - 1;
-	if (signals > threads) signals = threads;
-	if (single_signals > 1) single_signals = 1;
-
-	// we don't need to wakeup the current thread
-	--(thread_index ? signals : single_signals);
-
-	// wake up
-	while(signals-- > 0) cond.notify_one();
-	while(single_signals-- > 0) single_cond.notify_one();
+
+	return Task::Handle();
 }
 
 Task::Handle
 RenderQueue::get(int thread_index)
 {
-	std::unique_lock<std::mutex> lock(mutex);
+	std::atomic<int> &ready    = thread_index ? ready_count    : single_ready_count;
+	std::atomic<int> &sleeping = thread_index ? sleeping_count : single_sleeping_count;
+	std::condition_variable &c = thread_index ? cond           : single_cond;
 
-	TaskQueue &queue  = thread_index == 0 ? single_ready_tasks     : ready_tasks;
-	TaskQueue &queue2 = thread_index != 0 ? single_ready_tasks     : ready_tasks;
-	TaskSet   &wait   = thread_index == 0 ? single_not_ready_tasks : not_ready_tasks;
 	while(started)
 	{
-		if (!queue.empty())
-		{
-			Task::Handle task = queue.front();
-			queue.pop_front();
-			if (!task) continue;
-			assert( tasks_in_process.count(thread_index) == 0 );
-			tasks_in_process[thread_index] = task;
-			//info("rendering threads used %d", tasks_in_process.size());
+		if (Task::Handle task = take(thread_index))
 			return task;
-		}
 
 		#ifdef DEBUG_THREAD_WAIT
-		if (!wait.empty())
-			info("thread %d: rendering wait for task", thread_index);
+		info("thread %d: rendering wait for task", thread_index);
 		#endif
 
-		assert( wait.empty() || !tasks_in_process.empty() || !queue2.empty() );
-
-		(thread_index ? cond : single_cond).wait(lock);
+		// counter of sleeping threads is incremented before the check of ready tasks,
+		// and push() increments counter of ready tasks before the check of sleeping threads,
+		// so at least one of them will see the changes of another
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		++sleeping;
+		if (started && ready <= 0)
+			c.wait(lock);
+		--sleeping;
 	}
 	return Task::Handle();
 }
 
+void
+RenderQueue::push(int thread_index, const Task::Handle &task)
+{
+	assert(task);
+	bool mt = task->get_allow_multithreading();
+
+	int lane_index = 0;
+	if (mt)
+		lane_index = thread_index > 0
+		           ? thread_index
+		           : 1 + (int)(next_lane++%(unsigned int)(threads_count - 1));
+
+	{
+		Lane &lane = lanes[lane_index];
+		std::lock_guard<std::mutex> lock(lane.mutex);
+		lane.tasks.push_back(task);
+	}
+	++(mt ? ready_count : single_ready_count);
+	wakeup(mt);
+}
+
+void
+RenderQueue::wakeup(bool multithreading)
+{
+	if ((multithreading ? sleeping_count : single_sleeping_count) <= 0)
+		return;
+	std::lock_guard<std::mutex> lock(sleep_mutex);
+	(multithreading ? cond : single_cond).notify_one();
+}
+
 void
 RenderQueue::fix_task(const Task &task, const Task::RunParams &params)
 {
-	//for(Task::List::iterator i = task.back_deps.begin(); i != task.back_deps.end();)
-	//	if (*i) ++i; else i = (*i)->back_deps.erase(i);
 	task.renderer_data.params = params;
 	task.renderer_data.params.sub_queue.clear();
 	task.renderer_data.success = true;
+	task.renderer_data.cancelled = false;
+	task.renderer_data.deps_count = (int)task.renderer_data.deps.size();
 }
 
 int
 RenderQueue::get_threads_count() const
 {
-	return threads.size();
+	return threads_count;
 }
 
 bool
-RenderQueue::remove_if_orphan(const Task::Handle &task, bool in_queue)
+RenderQueue::is_orphan(const Task &task)
 {
-	// mutex must be already locked
-
-	if (!task)
-		return true;
-
-	TaskSet* tasks = nullptr;
-	TaskSet::iterator ii;
-	if (!in_queue) {
-		bool mt = task->get_allow_multithreading();
-		tasks = mt ? &not_ready_tasks : &single_not_ready_tasks;
-		ii = tasks->find(task);
-		if (ii == tasks->end())
-			return true;
-	}
-
-	if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(task))
-		if (!task_event->is_finished())
-			return false;
-
-	if (!task->renderer_data.back_deps.empty())
+	// task is orphan when all tasks which requires it are cancelled,
+	// task without back_deps is already done or it is a root of list
+	std::lock_guard<std::mutex> lock(task.renderer_data.deps_mutex);
+	if (task.renderer_data.back_deps.empty())
 		return false;
-		
-	for(TaskSet::iterator i = task->renderer_data.deps.begin(); i != task->renderer_data.deps.end(); ++i)
-		if (*i) {
-			(*i)->renderer_data.back_deps.erase(task);
-			if ((*i)->renderer_data.back_deps.empty())
-				remove_if_orphan(*i, false);
-		}
-	task->renderer_data.deps.clear();
-
-	// don't remove task if 'in_queue' is set (it will removed by caller)
-	if (tasks) tasks->erase(ii);
+	for(Task::Set::const_iterator i = task.renderer_data.back_deps.begin(); i != task.renderer_data.back_deps.end(); ++i)
+		if (*i && !(*i)->renderer_data.cancelled)
+			return false;
 	return true;
 }
 
 void
-RenderQueue::remove_orphans()
+RenderQueue::mark_cancelled(const Task::List &list, bool with_back_deps, TaskEvent::List &events)
 {
-	// mutex must be already locked
+	// never lock deps_mutex of two tasks at the same time,
+	// lists of deps are copied instead
 
-	for(TaskQueue::iterator i = ready_tasks.begin(); i != ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) ready_tasks.erase(i++); else ++i;
-	for(TaskQueue::iterator i = single_ready_tasks.begin(); i != single_ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) single_ready_tasks.erase(i++); else ++i;
+	Task::List tasks;
+	for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i)
+		if (*i && !(*i)->renderer_data.cancelled.exchange(true))
+			tasks.push_back(*i);
 
-	for(TaskSet::iterator i = not_ready_tasks.begin(); i != not_ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) not_ready_tasks.erase(i++); else ++i;
-	for(TaskSet::iterator i = single_not_ready_tasks.begin(); i != single_not_ready_tasks.end();)
-		if (remove_if_orphan(*i, true)) single_not_ready_tasks.erase(i++); else ++i;
-}
+	while(!tasks.empty())
+	{
+		Task::Handle task = tasks.back();
+		tasks.pop_back();
+
+		if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(task))
+			events.push_back(task_event);
+
+		Task::Set deps, back_deps;
+		{
+			std::lock_guard<std::mutex> lock(task->renderer_data.deps_mutex);
+			deps = task->renderer_data.deps;
+			if (with_back_deps)
+				back_deps = task->renderer_data.back_deps;
+		}
 
+		for(Task::Set::const_iterator i = deps.begin(); i != deps.end(); ++i)
+			if (*i && !(*i)->renderer_data.cancelled && is_orphan(**i))
+				if (!(*i)->renderer_data.cancelled.exchange(true))
+					tasks.push_back(*i);
+
+		for(Task::Set::const_iterator i = back_deps.begin(); i != back_deps.end(); ++i)
+			if (*i && !(*i)->renderer_data.cancelled.exchange(true))
+				tasks.push_back(*i);
+	}
+}
 
 void
 RenderQueue::enqueue(const Task::Handle &task, const Task::RunParams &params)
 {
 	if (!task) return;
 	fix_task(*task, params);
-	std::lock_guard<std::mutex> lock(mutex);
-
-	bool mt = task->get_allow_multithreading();
-	TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-	TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-	if (task->renderer_data.deps.empty()) {
-		queue.push_back(task);
-		(mt ? cond : single_cond).notify_one();
-	}
-	else
-	{
-		wait.insert(task);
-	}
-
-	remove_orphans();
+	if (task->renderer_data.deps_count == 0)
+		push(-1, task);
 }
 
 void
@@ -362,77 +454,26 @@ RenderQueue::enqueue(const Task::List &tasks, const Task::RunParams &params)
 {
 	Task::RunParams p(params);
 	p.sub_queue.clear();
-	int count = 0;
-	for(Task::List::const_iterator i = tasks.begin(); i != tasks.end(); ++i)
-		if (*i) { fix_task(**i, p); ++count; }
-	if (!count) return;
 
-	std::lock_guard<std::mutex> lock(mutex);
-	int single_signals = 0;
-	int signals = 0;
+	// all counters must be set before the first task will be pushed,
+	// because pushed task may be done before the end of this loop
+	Task::List ready;
 	for(Task::List::const_iterator i = tasks.begin(); i != tasks.end(); ++i)
-	{
-		if (*i)
-		{
-			bool mt = (*i)->get_allow_multithreading();
-			if ((*i)->renderer_data.deps.empty()) {
-				TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-				queue.push_back(*i);
-				++(mt ? signals : single_signals);
-			} else {
-				TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-				wait.insert(*i);
-			}
+		if (*i) {
+			fix_task(**i, p);
+			if ((*i)->renderer_data.deps_count == 0)
+				ready.push_back(*i);
 		}
-	}
-
-	// limit signals count
-	int threads = get_threads_count() - 1;
-	if (signals > threads) signals = threads;
-	if (single_signals > 1) single_signals = 1;
-
-	// wake up
-	while(signals-- > 0) cond.notify_one();
-	while(single_signals-- > 0) single_cond.notify_one();
 
-	remove_orphans();
-}
-
-bool
-RenderQueue::remove_task(const Task::Handle &task)
-{
-	bool found = false;
-	if (task) {
-		bool mt = task->get_allow_multithreading();
-		TaskQueue &queue = mt ? ready_tasks     : single_ready_tasks;
-		TaskSet   &wait  = mt ? not_ready_tasks : single_not_ready_tasks;
-
-		for(TaskQueue::iterator i = queue.begin(); i != queue.end(); ) {
-			if (*i == task) {
-				found = true;
-				i = queue.erase(i);
-			} else {
-				++i;
-			}
-		}
-		if (wait.erase(task)) found = true;
-	}
-	return found;
+	for(Task::List::const_iterator i = ready.begin(); i != ready.end(); ++i)
+		push(-1, *i);
 }
 
 void
 RenderQueue::cancel(const Task::Handle &task)
 {
 	if (!task) return;
-
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		if (remove_task(task))
-			remove_orphans();
-	}
-
-	if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(task))
-		task_event->finish(false);
+	cancel(Task::List(1, task));
 }
 
 void
@@ -441,18 +482,7 @@ RenderQueue::cancel(const Task::List &list)
 	if (list.empty()) return;
 
 	TaskEvent::List events;
-
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		bool found = false;
-		for(Task::List::const_iterator i = list.begin(); i != list.end(); ++i) {
-			if (remove_task(*i))
-				found = true;
-			if (TaskEvent::Handle task_event = TaskEvent::Handle::cast_dynamic(*i))
-				events.push_back(task_event);
-		}
-		if (found) remove_orphans();
-	}
+	mark_cancelled(list, false, events);
 
 	for(TaskEvent::List::const_iterator i = events.begin(); i != events.end(); ++i)
 		(*i)->finish(false);
@@ -461,11 +491,19 @@ RenderQueue::cancel(const Task::List &list)
 void
 RenderQueue::clear()
 {
-	std::lock_guard<std::mutex> lock(mutex);
-	ready_tasks.clear();
-	single_ready_tasks.clear();
-	not_ready_tasks.clear();
-	single_not_ready_tasks.clear();
+	Task::List list;
+	for(int i = 0; i < threads_count; ++i)
+	{
+		Lane &lane = lanes[i];
+		std::lock_guard<std::mutex> lock(lane.mutex);
+		list.insert(list.end(), lane.tasks.begin(), lane.tasks.end());
+	}
+
+	TaskEvent::List events;
+	mark_cancelled(list, true, events);
+
+	for(TaskEvent::List::const_iterator i = events.begin(); i != events.end(); ++i)
+		(*i)->finish(false);
 }
 
 /* === E N T R Y P O I N T ================================================= */
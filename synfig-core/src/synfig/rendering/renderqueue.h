@@ -30,11 +30,13 @@
 
 /* === H E A D E R S ======================================================= */
 
-#include <map>
-
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <vector>
 
 #include "task.h"
 
@@ -49,43 +51,63 @@ namespace synfig
 namespace rendering
 {
 
+/*!	\class RenderQueue
+**	\brief Runs tasks by multiple threads when their dependencies are done.
+**
+**	Each task has a counter of dependencies which are not done yet,
+**	the task becomes ready when the counter reaches zero.
+**	Ready tasks are stored in per-thread lanes: the thread takes tasks
+**	from the back of its own lane, and steals tasks from the front of
+**	the lanes of other threads when its own lane is empty. So threads
+**	don't share one lock while the tasks are processed.
+**
+**	Thread 0 is reserved for the tasks which doesn't allow multithreading
+**	(OpenGL), it processes only its own lane in FIFO order.
+*/
 class RenderQueue
 {
 public:
-	typedef std::list<std::thread> ThreadList;
-	typedef std::map<int, Task::Handle> ThreadTaskMap;
-	typedef std::set<Task::Handle> TaskSet;
-	typedef std::list<Task::Handle> TaskQueue;
+	typedef std::vector<std::thread> ThreadList;
+	typedef std::deque<Task::Handle> TaskQueue;
 
 private:
-	static int last_batch_index;
+	struct Lane {
+		std::mutex mutex;
+		TaskQueue tasks;
+	};
 
-	std::mutex mutex;
 	std::mutex threads_mutex;
+	std::atomic<bool> started;
+	int threads_count;
+	ThreadList threads;
+	std::unique_ptr<Lane[]> lanes;
+	std::atomic<unsigned int> next_lane; //!< for tasks enqueued from outside of the threads
+
+	std::mutex sleep_mutex;
 	std::condition_variable cond;
 	std::condition_variable single_cond;
-
-	TaskQueue ready_tasks;
-	TaskQueue single_ready_tasks;
-	TaskSet not_ready_tasks;
-	TaskSet single_not_ready_tasks;
-
-	bool started;
-
-	ThreadList threads;
-	ThreadTaskMap tasks_in_process;
+	std::atomic<int> ready_count;        //!< tasks in lanes of the multithreaded threads
+	std::atomic<int> single_ready_count; //!< tasks in lane 0
+	std::atomic<int> sleeping_count;
+	std::atomic<int> single_sleeping_count;
 
 	void start();
 	void stop();
 
+	//! Runs the task, threads of the queue are marked as busy in ThreadPool while task runs
+	static bool run(int thread_index, Task &task);
 	void process(int thread_index);
 	void done(int thread_index, const Task::Handle &task);
 	Task::Handle get(int thread_index);
+	Task::Handle take(int thread_index);
+	void push(int thread_index, const Task::Handle &task);
+	void wakeup(bool multithreading);
 
 	static void fix_task(const Task &task, const Task::RunParams &params);
-	bool remove_if_orphan(const Task::Handle &task, bool in_queue);
-	void remove_orphans();
-	bool remove_task(const Task::Handle &task);
+	static bool is_orphan(const Task &task);
+	//! marks tasks as cancelled with deps which are not required by other tasks,
+	//! and also all tasks which depends on them if \a with_back_deps is set
+	static void mark_cancelled(const Task::List &list, bool with_back_deps, TaskEvent::List &events);
 
 public:
 	RenderQueue();
@@ -0,0 +1,261 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/blend.cpp
+**	\brief Blend
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#include <synfig/color/colorblendingfunctions.h>
+
+#include "blend.h"
+
+#endif
+
+// SIMD code is selected at runtime, so it is built without special compiler flags,
+// instruction sets are enabled for the particular functions by attributes
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#	define BLEND_X86_SIMD
+#	include <immintrin.h>
+#endif
+
+using namespace synfig;
+using namespace rendering;
+using namespace software;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+typedef int (*RowFunc)(Color *dest, const Color *src, int count, ColorReal amount);
+
+#ifdef BLEND_X86_SIMD
+
+namespace sse2 {
+	typedef __m128 V;
+	const int pixels = 1;
+
+	inline V load(const Color *c) { return _mm_loadu_ps((const float*)c); }
+	inline void store(Color *c, V v) { _mm_storeu_ps((float*)c, v); }
+	inline V set1(float x) { return _mm_set1_ps(x); }
+	inline V zero() { return _mm_setzero_ps(); }
+
+	inline V add(V a, V b) { return _mm_add_ps(a, b); }
+	inline V sub(V a, V b) { return _mm_sub_ps(a, b); }
+	inline V mul(V a, V b) { return _mm_mul_ps(a, b); }
+	inline V div(V a, V b) { return _mm_div_ps(a, b); }
+	inline V abs(V a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+
+	inline V greater(V a, V b) { return _mm_cmpgt_ps(a, b); }
+	inline V equal(V a, V b) { return _mm_cmpeq_ps(a, b); }
+	inline V select(V mask, V a, V b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+	//! alpha of each pixel in all of its channels
+	inline V alpha(V a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)); }
+	//! rgb channels of \a rgb and alpha channel of \a a
+	inline V rgb_alpha(V rgb, V a) { return select(_mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)), rgb, a); }
+
+	#include "blendkernels.h"
+} // end of namespace sse2
+
+#ifdef __clang__
+#	pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+#	pragma GCC push_options
+#	pragma GCC target("avx2")
+#endif
+
+namespace avx2 {
+	typedef __m256 V;
+	const int pixels = 2;
+
+	inline V load(const Color *c) { return _mm256_loadu_ps((const float*)c); }
+	inline void store(Color *c, V v) { _mm256_storeu_ps((float*)c, v); }
+	inline V set1(float x) { return _mm256_set1_ps(x); }
+	inline V zero() { return _mm256_setzero_ps(); }
+
+	inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+	inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	inline V div(V a, V b) { return _mm256_div_ps(a, b); }
+	inline V abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+
+	inline V greater(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	inline V equal(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	inline V select(V mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); }
+
+	inline V alpha(V a) { return _mm256_permute_ps(a, _MM_SHUFFLE(3, 3, 3, 3)); }
+	inline V rgb_alpha(V rgb, V a) { return _mm256_blend_ps(rgb, a, 0x88); }
+
+	#include "blendkernels.h"
+} // end of namespace avx2
+
+#ifdef __clang__
+#	pragma clang attribute pop
+#else
+#	pragma GCC pop_options
+#endif
+
+#endif // BLEND_X86_SIMD
+
+Blend::Implementation
+detect_implementation()
+{
+	#ifdef BLEND_X86_SIMD
+	if (__builtin_cpu_supports("avx2"))
+		return Blend::IMPLEMENTATION_AVX2;
+	return Blend::IMPLEMENTATION_SSE2;
+	#else
+	return Blend::IMPLEMENTATION_GENERIC;
+	#endif
+}
+
+std::atomic<int> current_implementation(-1);
+
+RowFunc
+get_row_func(Blend::Implementation implementation, Color::BlendMethod method)
+{
+	switch(implementation) {
+	#ifdef BLEND_X86_SIMD
+	case Blend::IMPLEMENTATION_SSE2: return sse2::get_row_func(method);
+	case Blend::IMPLEMENTATION_AVX2: return avx2::get_row_func(method);
+	#endif
+	default: break;
+	}
+	return nullptr;
+}
+
+} // end of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+Blend::Implementation
+Blend::get_best_implementation()
+{
+	static const Implementation best = detect_implementation();
+	return best;
+}
+
+Blend::Implementation
+Blend::get_implementation()
+{
+	int implementation = current_implementation;
+	return implementation < 0 ? get_best_implementation() : (Implementation)implementation;
+}
+
+bool
+Blend::set_implementation(Implementation implementation)
+{
+	if (implementation < 0 || implementation > get_best_implementation())
+		return false;
+	#ifndef BLEND_X86_SIMD
+	if (implementation != IMPLEMENTATION_GENERIC)
+		return false;
+	#endif
+	current_implementation = implementation;
+	return true;
+}
+
+const char*
+Blend::get_implementation_name(Implementation implementation)
+{
+	switch(implementation) {
+	case IMPLEMENTATION_GENERIC: return "generic";
+	case IMPLEMENTATION_SSE2:    return "sse2";
+	case IMPLEMENTATION_AVX2:    return "avx2";
+	default: break;
+	}
+	return "unknown";
+}
+
+bool
+Blend::is_optimized(Color::BlendMethod method)
+	{ return get_row_func(get_best_implementation(), method) != nullptr; }
+
+void
+Blend::blend_row(
+	Color *dest,
+	const Color *src,
+	int count,
+	ColorReal amount,
+	Color::BlendMethod method )
+{
+	// see Color::blend()
+	if (std::fabs(amount) <= COLOR_EPSILON)
+		return;
+
+	int processed = 0;
+	if (RowFunc func = get_row_func(get_implementation(), method))
+		processed = func(dest, src, count, amount);
+	for(int i = processed; i < count; ++i)
+		dest[i] = Color::blend(src[i], dest[i], amount, method);
+}
+
+void
+Blend::blend(
+	synfig::Surface &dest,
+	const RectInt &dest_rect,
+	const synfig::Surface &src,
+	const VectorInt &src_offset,
+	ColorReal amount,
+	Color::BlendMethod method )
+{
+	if (!dest_rect.is_valid())
+		return;
+
+	assert( 0 <= dest_rect.minx && dest_rect.maxx <= dest.get_w()
+		 && 0 <= dest_rect.miny && dest_rect.maxy <= dest.get_h() );
+	assert( 0 <= dest_rect.minx + src_offset[0] && dest_rect.maxx + src_offset[0] <= src.get_w()
+		 && 0 <= dest_rect.miny + src_offset[1] && dest_rect.maxy + src_offset[1] <= src.get_h() );
+
+	const int width = dest_rect.maxx - dest_rect.minx;
+
+	// straight blending with full amount is a plain copy, see Surface::blit_to()
+	if (method == Color::BLEND_STRAIGHT && std::fabs(amount - 1.f) < 0.00001f) {
+		for(int y = dest_rect.miny; y < dest_rect.maxy; ++y)
+			memcpy( dest[y] + dest_rect.minx,
+			        src[y + src_offset[1]] + dest_rect.minx + src_offset[0],
+			        width*sizeof(Color) );
+		return;
+	}
+
+	for(int y = dest_rect.miny; y < dest_rect.maxy; ++y)
+		blend_row(
+			dest[y] + dest_rect.minx,
+			src[y + src_offset[1]] + dest_rect.minx + src_offset[0],
+			width,
+			amount,
+			method );
+}
@@ -0,0 +1,99 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/blend.h
+**	\brief Blend Header
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_SOFTWARE_BLEND_H
+#define __SYNFIG_RENDERING_SOFTWARE_BLEND_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/color.h>
+#include <synfig/rect.h>
+#include <synfig/surface.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+namespace software
+{
+
+/*!	\class Blend
+**	\brief Row-wise blending of surfaces.
+**
+**	Gives the same result as Color::blend() called for each pixel,
+**	but the most used blend methods are processed by SIMD code,
+**	selected at runtime by the features of the CPU.
+*/
+class Blend
+{
+public:
+	enum Implementation {
+		IMPLEMENTATION_GENERIC, //!< Color::blend() for each pixel
+		IMPLEMENTATION_SSE2,    //!< one pixel per register
+		IMPLEMENTATION_AVX2,    //!< two pixels per register
+		IMPLEMENTATION_COUNT
+	};
+
+	//! The fastest implementation supported by the CPU
+	static Implementation get_best_implementation();
+	static Implementation get_implementation();
+	//! Selects \a implementation if it is supported by the CPU (for tests and benchmarks)
+	static bool set_implementation(Implementation implementation);
+	static const char* get_implementation_name(Implementation implementation);
+
+	//! Returns true if \a method has SIMD implementation
+	static bool is_optimized(Color::BlendMethod method);
+
+	//! Blends \a count pixels of \a src onto \a dest
+	static void blend_row(
+		Color *dest,
+		const Color *src,
+		int count,
+		ColorReal amount,
+		Color::BlendMethod method );
+
+	//! Blends \a src onto \a dest, \a dest_rect must be inside of the both surfaces
+	static void blend(
+		synfig::Surface &dest,
+		const RectInt &dest_rect,
+		const synfig::Surface &src,
+		const VectorInt &src_offset,
+		ColorReal amount,
+		Color::BlendMethod method );
+};
+
+} /* end namespace software */
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
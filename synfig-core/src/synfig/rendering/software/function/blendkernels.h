@@ -0,0 +1,126 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/software/function/blendkernels.h
+**	\brief SIMD kernels of blend methods
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+// This file has no include guard: blend.cpp includes it once for each
+// instruction set, inside of the namespace which defines vector type V,
+// number of pixels in it and the primitive operations (load, add, alpha,...).
+//
+// Kernels repeat operations of the functions from colorblendingfunctions.h
+// in the same order, so results are the same as of Color::blend().
+
+/* === K E R N E L S ======================================================= */
+
+inline V invert_rgb(V a)
+	{ return rgb_alpha(sub(set1(1.f), a), a); }
+
+inline V blend_composite(V a, V b, V amount)
+{
+	const V one = set1(1.f);
+	V a_src = mul(alpha(a), amount);
+	V a_dest = alpha(b);
+	V inv_a_src = sub(one, a_src);
+	V c = add(mul(a, a_src), mul(mul(b, a_dest), inv_a_src));
+	V a_out = add(a_src, mul(a_dest, inv_a_src));
+	c = rgb_alpha(mul(c, div(one, a_out)), a_out);
+	return select(greater(abs(a_out), set1(COLOR_EPSILON)), c, zero());
+}
+
+inline V blend_straight(V a, V b, V amount)
+{
+	const V one = set1(1.f);
+	V a_src = alpha(a);
+	V a_bg = alpha(b);
+	V a_out = add(mul(sub(a_src, a_bg), amount), a_bg);
+	V b_premult = mul(b, a_bg);
+	V c = add(mul(sub(mul(a, a_src), b_premult), amount), b_premult);
+	c = rgb_alpha(mul(c, div(one, a_out)), a_out);
+	return select(greater(abs(a_out), set1(COLOR_EPSILON)), c, zero());
+}
+
+inline V blend_onto(V a, V b, V amount)
+	{ return rgb_alpha(blend_composite(a, rgb_alpha(b, set1(1.f)), amount), b); }
+
+inline V blend_behind(V a, V b, V amount)
+{
+	V a_src = alpha(a);
+	a_src = select(equal(a_src, zero()), mul(set1(COLOR_EPSILON), amount), mul(a_src, amount));
+	return blend_composite(b, rgb_alpha(a, a_src), set1(1.f));
+}
+
+inline V blend_add(V a, V b, V amount)
+	{ return rgb_alpha(add(mul(b, alpha(b)), mul(a, mul(alpha(a), amount))), b); }
+
+inline V blend_multiply(V a, V b, V amount)
+{
+	V k = mul(amount, alpha(a));
+	return rgb_alpha(add(mul(sub(mul(b, a), b), k), b), b);
+}
+
+inline V blend_screen(V a, V b, V amount)
+{
+	const V one = set1(1.f);
+	a = rgb_alpha(sub(one, mul(sub(one, a), sub(one, b))), a);
+	return blend_onto(a, b, amount);
+}
+
+inline V blend_alpha_over(V a, V b, V amount)
+{
+	V rm = rgb_alpha(b, mul(sub(set1(1.f), alpha(a)), alpha(b)));
+	return blend_straight(rm, b, amount);
+}
+
+/* === R O W S ============================================================= */
+
+//! Returns count of processed pixels, the rest (less than \a pixels) is left for the caller
+template<V (*kernel)(V, V, V), bool invert_negative>
+int blend_row(Color *dest, const Color *src, int count, ColorReal amount)
+{
+	// see blendfunc_MULTIPLY and blendfunc_SCREEN
+	bool invert = invert_negative && amount < 0;
+	if (invert) amount = -amount;
+
+	const V k = set1(amount);
+	int processed = count - count%pixels;
+	for(int i = 0; i < processed; i += pixels) {
+		V a = load(src + i);
+		if (invert) a = invert_rgb(a);
+		store(dest + i, kernel(a, load(dest + i), k));
+	}
+	return processed;
+}
+
+inline RowFunc get_row_func(Color::BlendMethod method)
+{
+	switch(method) {
+	case Color::BLEND_COMPOSITE:  return blend_row<blend_composite, false>;
+	case Color::BLEND_STRAIGHT:   return blend_row<blend_straight, false>;
+	case Color::BLEND_ONTO:       return blend_row<blend_onto, false>;
+	case Color::BLEND_BEHIND:     return blend_row<blend_behind, false>;
+	case Color::BLEND_ADD:        return blend_row<blend_add, false>;
+	case Color::BLEND_MULTIPLY:   return blend_row<blend_multiply, true>;
+	case Color::BLEND_SCREEN:     return blend_row<blend_screen, true>;
+	case Color::BLEND_ALPHA_OVER: return blend_row<blend_alpha_over, false>;
+	default: break;
+	}
+	return nullptr;
+}
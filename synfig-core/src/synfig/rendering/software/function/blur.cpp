@@ -37,6 +37,8 @@
 #include <algorithm>
 #include <functional>
 
+#include <synfig/threadpool.h>
+
 #include "blur.h"
 
 #include "blurtemplates.h"
@@ -309,80 +311,21 @@ software::Blur::blur_fft(const Params &params)
 	const int channels = 4;
 	int rows = FFT::get_valid_count(params.src_rect.get_size()[1]);
 	int cols = FFT::get_valid_count(params.src_rect.get_size()[0]);
-	std::vector<Complex> surface(rows*cols*channels);
-	std::vector<Complex> full_pattern;
-	std::vector<Complex> row_pattern;
-	std::vector<Complex> col_pattern;
+	int stride = FFT::get_real_stride(cols);
+	int spectrum_cols = cols/2 + 1;
 	bool full = false;
 	bool cross = false;
 
-	Array<Real, 4> arr_surface((Real*)&surface.front());
-
-	arr_surface
-		.set_dim(rows, cols*channels*2)
-		.set_dim(cols, channels*2)
-		.set_dim(channels, 2)
-		.set_dim(2, 1);
-	Array<Real, 3> arr_full_pattern;
-	arr_full_pattern
-		.set_dim(rows, 2*cols)
-		.set_dim(cols, 2)
-		.set_dim(2, 1);
-	Array<Real, 2> arr_row_pattern;
-	arr_row_pattern
-		.set_dim(cols, 2)
-		.set_dim(2, 1);
-	Array<Real, 2> arr_col_pattern;
-	arr_col_pattern
-		.set_dim(rows, 2)
-		.set_dim(2, 1);
-
-	// convert surface to complex
-	BlurTemplates::surface_read(arr_surface.reorder(0, 1, 2), *params.src, VectorInt(0, 0), params.src_rect);
-
-	// alloc memory
 	switch(params.type)
 	{
 	case rendering::Blur::BOX:
-	case rendering::Blur::CROSS:
 	case rendering::Blur::GAUSSIAN:
 	case rendering::Blur::FASTGAUSSIAN:
-		row_pattern.resize(cols);
-		col_pattern.resize(rows);
-		arr_row_pattern.pointer = (Real*)&row_pattern.front();
-		arr_col_pattern.pointer = (Real*)&col_pattern.front();
-		break;
-	case rendering::Blur::DISC:
-		full_pattern.resize(rows*cols);
-		arr_full_pattern.pointer = (Real*)&full_pattern.front();
-		break;
-	default:
-		assert(false);
-		return;
-	}
-
-	// create patterns
-	switch(params.type)
-	{
-	case rendering::Blur::BOX:
-		BlurTemplates::fill_pattern_box(arr_row_pattern.reorder(0), params.amplified_size[0]);
-		BlurTemplates::fill_pattern_box(arr_col_pattern.reorder(0), params.amplified_size[1]);
 		break;
 	case rendering::Blur::CROSS:
-		BlurTemplates::fill_pattern_box(arr_row_pattern.reorder(0), params.amplified_size[0]);
-		BlurTemplates::fill_pattern_box(arr_col_pattern.reorder(0), params.amplified_size[1]);
 		cross = true;
 		break;
-	case rendering::Blur::GAUSSIAN:
-	case rendering::Blur::FASTGAUSSIAN:
-		BlurTemplates::fill_pattern_gauss(arr_row_pattern.reorder(0), params.amplified_size[0]);
-		BlurTemplates::fill_pattern_gauss(arr_col_pattern.reorder(0), params.amplified_size[1]);
-		break;
 	case rendering::Blur::DISC:
-		BlurTemplates::fill_pattern_2d_disk(
-			arr_full_pattern.reorder(0, 1),
-			params.amplified_size[0],
-			params.amplified_size[1] );
 		full = true;
 		break;
 	default:
@@ -390,71 +333,128 @@ software::Blur::blur_fft(const Params &params)
 		return;
 	}
 
+	// channels are stored as separate planes of real values,
+	// each plane is transformed in-place into the half of its spectrum,
+	// full pattern is transformed together with channels as one more plane
+	int planes = full ? channels + 1 : channels;
+	std::vector<Real> surface(planes*rows*stride);
+
+	Array<Real, 3> arr_planes(&surface.front());
+	arr_planes
+		.set_dim(planes, rows*stride)
+		.set_dim(rows, stride)
+		.set_dim(cols, 1);
+	Array<Real, 3> arr_surface = arr_planes.get_range(0, 0, channels);
+	Array<Complex, 3> arr_spectrum((Complex*)&surface.front());
+	arr_spectrum
+		.set_dim(channels, rows*stride/2)
+		.set_dim(rows, stride/2)
+		.set_dim(spectrum_cols, 1);
+
+	// convert surface to planes
+	BlurTemplates::surface_read(arr_surface.reorder(1, 2, 0), *params.src, VectorInt(0, 0), params.src_rect);
+
 	// process
 	if (full)
 	{
-		BlurTemplates::mirror_pattern_2d( arr_full_pattern.reorder(0, 1) );
-		BlurTemplates::normalize_full_pattern_2d( arr_full_pattern.reorder(0, 1) );
-
-		FFT::fft2d(arr_full_pattern.group_items<Complex>(), false);
-		for(Array<Complex, 3>::Iterator channel(arr_surface.group_items<Complex>().reorder(2, 0, 1)); channel; ++channel)
-		{
-			FFT::fft2d(*channel, false);
-			channel->process< std::multiplies<Complex> >(arr_full_pattern.group_items<Complex>());
-			FFT::fft2d(*channel, true);
-		}
+		Array<Real, 2> arr_full_pattern = arr_planes[channels];
+		BlurTemplates::fill_pattern_2d_disk(
+			arr_full_pattern,
+			params.amplified_size[0],
+			params.amplified_size[1] );
+		BlurTemplates::mirror_pattern_2d( arr_full_pattern );
+		BlurTemplates::normalize_full_pattern_2d( arr_full_pattern );
+
+		FFT::fft2d_real(arr_planes, false);
+		Array<Complex, 2> arr_full_spectrum = Array<Complex, 3>(
+			(Complex*)&surface.front(), planes, rows*stride/2, arr_spectrum )[channels];
+		for(Array<Complex, 3>::Iterator channel(arr_spectrum); channel; ++channel)
+			channel->process< std::multiplies<Complex> >(arr_full_spectrum);
+		FFT::fft2d_real(arr_surface, true);
 	}
 	else
 	{
+		std::vector<Complex> row_pattern(cols);
+		std::vector<Complex> col_pattern(rows);
+		Array<Real, 2> arr_row_pattern((Real*)&row_pattern.front());
+		arr_row_pattern
+			.set_dim(cols, 2)
+			.set_dim(2, 1);
+		Array<Real, 2> arr_col_pattern((Real*)&col_pattern.front());
+		arr_col_pattern
+			.set_dim(rows, 2)
+			.set_dim(2, 1);
+
+		if (params.type == rendering::Blur::GAUSSIAN || params.type == rendering::Blur::FASTGAUSSIAN)
+		{
+			BlurTemplates::fill_pattern_gauss(arr_row_pattern.reorder(0), params.amplified_size[0]);
+			BlurTemplates::fill_pattern_gauss(arr_col_pattern.reorder(0), params.amplified_size[1]);
+		}
+		else
+		{
+			BlurTemplates::fill_pattern_box(arr_row_pattern.reorder(0), params.amplified_size[0]);
+			BlurTemplates::fill_pattern_box(arr_col_pattern.reorder(0), params.amplified_size[1]);
+		}
+
 		BlurTemplates::mirror_pattern( arr_row_pattern.reorder(0) );
 		BlurTemplates::mirror_pattern( arr_col_pattern.reorder(0) );
 		BlurTemplates::normalize_full_pattern( arr_row_pattern.reorder(0) );
 		BlurTemplates::normalize_full_pattern( arr_col_pattern.reorder(0) );
 
-		std::vector<Complex> surface_copy;
-		Array<Complex, 3> arr_surface_rows(arr_surface.group_items<Complex>().reorder(2, 0, 1));
-		Array<Complex, 3> arr_surface_cols(arr_surface_rows.reorder(0, 2, 1));
-
 		if (cross)
 		{
 			arr_row_pattern.reorder(0).process< std::multiplies<Real> >(0.5);
 			arr_col_pattern.reorder(0).process< std::multiplies<Real> >(0.5);
-			surface_copy = surface;
-			arr_surface_cols.pointer = &surface_copy.front();
 		}
 
+		// patterns are short, so full complex transforms are fine for them
 		FFT::fft(arr_row_pattern.group_items<Complex>(), false);
-		for(Array<Complex, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
+		FFT::fft(arr_col_pattern.group_items<Complex>(), false);
+		Array<Complex, 1> arr_row_spectrum(&row_pattern.front(), spectrum_cols, 1);
+
+		std::vector<Real> surface_copy;
+		Array<Real, 3> arr_surface_cols(arr_surface);
+		Array<Complex, 3> arr_spectrum_cols(arr_spectrum);
+
+		if (cross)
 		{
-			FFT::fft2d(*channel, false, true, false);
-			for(Array<Complex, 2>::Iterator r(*channel); r; ++r)
-				r->process< std::multiplies<Complex> >(arr_row_pattern.group_items<Complex>());
-			FFT::fft2d(*channel, true, true, false);
+			surface_copy = surface;
+			arr_surface_cols.pointer = &surface_copy.front();
+			arr_spectrum_cols.pointer = (Complex*)&surface_copy.front();
+
+			FFT::fft2d_real(arr_surface, false, false);
+			for(Array<Complex, 3>::Iterator channel(arr_spectrum); channel; ++channel)
+				for(Array<Complex, 2>::Iterator r(*channel); r; ++r)
+					r->process< std::multiplies<Complex> >(arr_row_spectrum);
+			FFT::fft2d_real(arr_surface, true, false);
 		}
 
-		FFT::fft(arr_col_pattern.group_items<Complex>(), false);
-		for(Array<Complex, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
+		// rows and columns are convolved at once, when blur is not cross
+		FFT::fft2d_real(arr_surface_cols, false);
+		for(Array<Complex, 3>::Iterator channel(arr_spectrum_cols); channel; ++channel)
 		{
-			FFT::fft2d(*channel, false, true, false);
-			for(Array<Complex, 2>::Iterator c(*channel); c; ++c)
-				c->process< std::multiplies<Complex> >(arr_col_pattern.group_items<Complex>());
-			FFT::fft2d(*channel, true, true, false);
+			std::vector<Complex>::const_iterator c = col_pattern.begin();
+			for(Array<Complex, 2>::Iterator r(*channel); r; ++r, ++c)
+			{
+				if (!cross)
+					r->process< std::multiplies<Complex> >(arr_row_spectrum);
+				r->process< std::multiplies<Complex> >(*c);
+			}
 		}
+		FFT::fft2d_real(arr_surface_cols, true);
 
-		arr_surface_rows.process< BlurTemplates::Abs<Complex> >();
+		arr_surface.process< BlurTemplates::Abs<Real> >();
 		if (cross)
 		{
-			arr_surface_cols.process< BlurTemplates::Abs<Complex> >();
-			arr_surface_rows.split_items<Real>().reorder(0, 1, 2)
-				.process< std::plus<Real> >(
-					arr_surface_cols.split_items<Real>().reorder(0, 2, 1) );
+			arr_surface_cols.process< BlurTemplates::Abs<Real> >();
+			arr_surface.process< std::plus<Real> >(arr_surface_cols);
 		}
 	}
 
-	// convert surface from complex to color
+	// convert surface from planes to color
 	BlurTemplates::surface_write(
 		*params.dest,
-		arr_surface.reorder(0, 1, 2),
+		arr_surface.reorder(1, 2, 0),
 		params.dest_rect,
 		params.src_offset - params.src_rect.get_min(),
 		params.blend,
@@ -465,7 +465,6 @@ software::Blur::blur_fft(const Params &params)
 void
 software::Blur::blur_box(const Params &params)
 {
-	const Real precision(1e-5);
 	const int channels = 4;
 	int rows = params.src_rect.get_size()[1];
 	int cols = params.src_rect.get_size()[0];
@@ -498,44 +497,48 @@ software::Blur::blur_box(const Params &params)
 		return;
 	}
 
-	std::deque<ColorReal> q;
 	std::vector<ColorReal> surface_copy;
-	Array<ColorReal, 3> arr_surface_rows(arr_surface.reorder(2, 0, 1));
-	Array<ColorReal, 3> arr_surface_cols(arr_surface_rows.reorder(0, 2, 1));
+	ColorReal *surface_cols = &surface.front();
 
 	if (cross)
 	{
 		arr_surface.process< std::multiplies<ColorReal> >(0.5);
 		surface_copy = surface;
-		arr_surface_cols.pointer = &surface_copy.front();
+		surface_cols = &surface_copy.front();
 	}
 
-	if (true || fabs(size[0] - round(size[0])) < precision)
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator r(*channel); r; ++r)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_discrete(*r, q, (int)round(size[0]));
-	else
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator r(*channel); r; ++r)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_aa(*r, q, (ColorReal)size[0]);
-
-	if (true || fabs(size[1] - round(size[1])) < precision)
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator c(*channel); c; ++c)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_discrete(*c, q, (int)round(size[1]));
-	else
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator c(*channel); c; ++c)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_aa(*c, q, (ColorReal)size[1]);
+	// rows and blocks of columns are independent, so split them between threads,
+	// but keep enough work for each part
+	const int parts = std::max(1, std::min(
+		ThreadPool::get_thread_budget(),
+		rows*cols/box_min_part_pixels ));
+
+	for(int i = 0; i < count; ++i)
+	{
+		ThreadPool::Group group;
+		for(int j = 0; j < parts; ++j)
+			group.enqueue( sigc::bind( sigc::ptr_fun(&blur_box_rows),
+				&surface.front(), cols, rows*j/parts, rows*(j + 1)/parts, (int)round(size[0]) ));
+		group.run();
+	}
+
+	const int blocks = (cols + box_block_columns - 1)/box_block_columns;
+	for(int i = 0; i < count; ++i)
+	{
+		ThreadPool::Group group;
+		for(int j = 0; j < parts; ++j)
+			group.enqueue( sigc::bind( sigc::ptr_fun(&blur_box_columns),
+				surface_cols, rows, cols,
+				std::min(cols, box_block_columns*(blocks*j/parts)),
+				std::min(cols, box_block_columns*(blocks*(j + 1)/parts)),
+				(int)round(size[1]) ));
+		group.run();
+	}
 
 	if (cross)
-		arr_surface_rows
+		arr_surface
 			.process< std::plus<ColorReal> >(
-				arr_surface_cols.reorder(0, 2, 1) );
+				Array<ColorReal, 3>(surface_cols, arr_surface) );
 
 	BlurTemplates::surface_write(
 		*params.dest,
@@ -546,6 +549,89 @@ software::Blur::blur_box(const Params &params)
 		params.blend_method,
 		params.amount );
 }
+
+void
+software::Blur::blur_box_rows(ColorReal *surface, int cols, int begin, int end, int size)
+{
+	// same as BlurTemplates::blur_box_discrete() for each channel of each row,
+	// but all of the channels are processed together
+	const int s = std::abs(size);
+	const int full_size = 1 + 2*s;
+	if (s == 0 || cols < full_size) return;
+
+	const ColorReal w = ColorReal(1.0)/ColorReal(full_size);
+	std::vector<ColorReal> q(full_size*4);
+
+	for(int r = begin; r < end; ++r)
+	{
+		ColorReal *x = surface + r*cols*4;
+		ColorReal sum[4] = { };
+		for(int i = 0; i < full_size*4; i += 4)
+			for(int c = 0; c < 4; ++c)
+				{ q[i + c] = x[i + c]; sum[c] += x[i + c]; }
+
+		// q is the ring buffer of the source pixels under the box
+		ColorReal *front = &q.front();
+		ColorReal *q_end = front + full_size*4;
+		for(ColorReal *i = x + full_size*4, *j = x + s*4, *row_end = x + cols*4; i < row_end; i += 4, j += 4)
+		{
+			for(int c = 0; c < 4; ++c)
+			{
+				j[c] = w*sum[c];
+				sum[c] += i[c] - front[c];
+				front[c] = i[c];
+			}
+			if ((front += 4) == q_end) front = &q.front();
+		}
+	}
+}
+
+void
+software::Blur::blur_box_columns(ColorReal *surface, int rows, int cols, int begin, int end, int size)
+{
+	// blurs the block of adjacent columns together, so each step
+	// reads and writes the contiguous part of row instead of one pixel,
+	// and the ring buffer of the block stays in cache
+	const int s = std::abs(size);
+	const int full_size = 1 + 2*s;
+	if (s == 0 || rows < full_size || begin >= end) return;
+
+	const ColorReal w = ColorReal(1.0)/ColorReal(full_size);
+	const int stride = cols*4;
+	std::vector<ColorReal> q(full_size*box_block_columns*4);
+	std::vector<ColorReal> sum(box_block_columns*4);
+
+	for(int block = begin; block < end; block += box_block_columns)
+	{
+		const int n = (std::min(end, block + box_block_columns) - block)*4;
+		ColorReal *x = surface + block*4;
+		std::fill(sum.begin(), sum.end(), ColorReal(0.0));
+
+		for(int i = 0; i < full_size; ++i)
+		{
+			const ColorReal *src = x + i*stride;
+			ColorReal *qq = &q[i*n];
+			for(int k = 0; k < n; ++k)
+				{ qq[k] = src[k]; sum[k] += src[k]; }
+		}
+
+		int front = 0;
+		for(int i = full_size, j = s; i < rows; ++i, ++j)
+		{
+			const ColorReal *src = x + i*stride;
+			ColorReal *dst = x + j*stride;
+			ColorReal *qq = &q[front*n];
+			ColorReal *ss = &sum.front();
+			for(int k = 0; k < n; ++k)
+			{
+				dst[k] = w*ss[k];
+				ss[k] += src[k] - qq[k];
+				qq[k] = src[k];
+			}
+			if (++front == full_size) front = 0;
+		}
+	}
+}
 /*
 software::Blur::IIRCoefficients
 software::Blur::get_iir_coefficients(Real radius)
@@ -119,16 +119,25 @@ private:
 	//! Simple blur by pattern
 	static void blur_pattern(const Params &params);
 
-	//! Full-size blur using Furier transform
-	static void blur_fft(const Params &params);
-
 	//! Fast box-blur
 	static void blur_box(const Params &params);
 
+	//! count of adjacent columns blurred together, 16 pixels are 4 cache lines
+	static constexpr int box_block_columns = 16;
+	static constexpr int box_min_part_pixels = 256*256;
+
+	//! Box-blur of rows [begin, end) of the premultiplied surface
+	static void blur_box_rows(ColorReal *surface, int cols, int begin, int end, int size);
+	//! Box-blur of columns [begin, end) of the premultiplied surface, by blocks of box_block_columns
+	static void blur_box_columns(ColorReal *surface, int rows, int cols, int begin, int end, int size);
+
 	//! Blur using infinite impulse response filter (gaussian only)
 	static void blur_iir(const Params &params);
 
 public:
+	//! Full-size blur using Furier transform, \a params should be validated
+	static void blur_fft(const Params &params);
+
 	//! Generic blur function
 	static void blur(Params params);
 };
@@ -33,6 +33,7 @@
 #include <cassert>
 
 #include <algorithm>
+#include <complex>
 #include <deque>
 
 #include "array.h"
@@ -69,7 +70,7 @@ public:
 
 
 	template<typename T>
-	struct Abs { T operator() (const T &x) { return abs(x); } };
+	struct Abs { T operator() (const T &x) { return std::abs(x); } };
 
 	template<typename T>
 	static T gauss(const T &x, const T &r)
@@ -32,6 +32,10 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 #include "contour.h"
 
 #include <synfig/debug/debugsurface.h>
@@ -47,6 +51,22 @@ using namespace rendering;
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+inline int
+first_bit(std::uint64_t x)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(x);
+#else
+	int i = 0;
+	while(!(x & 1)) { x >>= 1; ++i; }
+	return i;
+#endif
+}
+
+} // end of anonymous namespace
+
 /* === M E T H O D S ======================================================= */
 
 void
@@ -278,6 +298,133 @@ software::Contour::render_polyspan(
 	}
 }
 
+void
+software::Contour::render_polyspan_rows(
+	synfig::Surface &target_surface,
+	const Polyspan &polyspan,
+	bool invert,
+	bool antialias,
+	rendering::Contour::WindingStyle winding_style,
+	const Color &color,
+	Color::value_type opacity,
+	Color::BlendMethod blend_method )
+{
+	const RectInt &window = polyspan.get_window();
+	if (!window.is_valid())
+		return;
+
+	bool simple_fill = (Color::BLEND_METHODS_OVERWRITE_ON_ALPHA_ONE & (1 << blend_method))
+			        && fabsf(1.f - opacity*color.get_a()) <= 1e-6;
+
+	synfig::Surface::alpha_pen p(target_surface.begin(), opacity, blend_method);
+	synfig::Surface::pen sp(target_surface.begin());
+	p.set_value(color);
+	sp.set_value(color);
+
+	// fill the span with full alpha
+	auto fill = [&](int y, int x0, int x1) {
+		if (x0 >= x1) return;
+		if (simple_fill)
+			{ sp.move_to(x0, y); sp.put_hline(x1 - x0); }
+		else
+			{ p.move_to(x0, y); p.put_hline(x1 - x0); }
+	};
+
+	const Polyspan::cover_array &covers = polyspan.get_covers();
+	const int width = window.maxx - window.minx;
+	const int height = window.maxy - window.miny;
+
+	// group marks by rows (counting sort), order of marks inside of row is not important
+	std::vector<int> offsets(height + 1, 0);
+	for(const Polyspan::PenMark &mark : covers)
+		if (mark.y >= window.miny && mark.y < window.maxy)
+			++offsets[mark.y - window.miny + 1];
+	for(int i = 0; i < height; ++i)
+		offsets[i + 1] += offsets[i];
+
+	std::vector<int> marks(offsets.back());
+	{
+		std::vector<int> positions(offsets.begin(), offsets.end() - 1);
+		for(int i = 0; i < (int)covers.size(); ++i)
+			if (covers[i].y >= window.miny && covers[i].y < window.maxy)
+				marks[positions[covers[i].y - window.miny]++] = i;
+	}
+
+	// cells of the current row, marks at the right border of window
+	// are possible (clipped lines), they have cover but no area
+	std::vector<Real> row_cover(width + 1, 0.0);
+	std::vector<Real> row_area(width + 1, 0.0);
+	std::vector<std::uint64_t> row_cells(width/64 + 1, 0);
+
+	for(int row = 0; row < height; ++row)
+	{
+		const int y = window.miny + row;
+		int x = window.minx; // first pixel which is not drawn yet
+		Real cover = 0, alpha = 0;
+
+		if (offsets[row] != offsets[row + 1])
+		{
+			int first_word = (int)row_cells.size(), last_word = -1;
+			for(int i = offsets[row]; i < offsets[row + 1]; ++i)
+			{
+				const Polyspan::PenMark &mark = covers[marks[i]];
+				int cx = std::max(0, std::min(width, mark.x - window.minx));
+				row_cover[cx] += mark.cover;
+				row_area[cx] += mark.area;
+				row_cells[cx/64] |= std::uint64_t(1) << (cx%64);
+				first_word = std::min(first_word, cx/64);
+				last_word = std::max(last_word, cx/64);
+			}
+
+			// walk cells from left to right, just like render_polyspan() walks sorted marks
+			for(int word = first_word; word <= last_word; ++word)
+			{
+				while(std::uint64_t bits = row_cells[word])
+				{
+					row_cells[word] = bits & (bits - 1);
+					const int cx = word*64 + first_bit(bits);
+					const int px = window.minx + cx;
+
+					// span to the cell - based on total amount of pixel cover
+					if (x < px)
+					{
+						alpha = polyspan.extract_alpha(cover, winding_style);
+						if (invert) alpha = 1 - alpha;
+						if (alpha >= .5) fill(y, x, px);
+						x = px;
+					}
+
+					cover += row_cover[cx];
+					const Real area = row_area[cx];
+					row_cover[cx] = row_area[cx] = 0;
+
+					// draw pixel - based on covered area
+					if (area && px < window.maxx)
+					{
+						alpha = polyspan.extract_alpha(cover - area, winding_style);
+						if (invert) alpha = 1 - alpha;
+
+						p.move_to(px, y);
+						if (antialias)
+						{
+							if (alpha) p.put_value_alpha(alpha);
+						}
+						else
+						{
+							if (alpha >= .5) p.put_value();
+						}
+						x = px + 1;
+					}
+				}
+			}
+		}
+
+		// fill the area at the end of the line
+		if (invert)
+			fill(y, x, window.maxx);
+	}
+}
+
 void
 software::Contour::build_polyspan(
 	const rendering::Contour::ChunkList &chunks,
@@ -319,6 +466,23 @@ software::Contour::build_polyspan(
 }
 
 
+void
+software::Contour::build_edge_table(
+	const rendering::Contour::ChunkList &chunks,
+	const Matrix &transform_matrix,
+	const RectInt &window,
+	EdgeTable &out_edge_table,
+	Real detail )
+{
+	EdgeTable::PrimitiveList primitives;
+	Polyspan polyspan;
+	polyspan.init_primitives(window, primitives);
+	build_polyspan(chunks, transform_matrix, polyspan, detail);
+	polyspan.close();
+	out_edge_table.init(window, primitives, detail);
+}
+
+
 void
 software::Contour::render_contour(
 	synfig::Surface &target_surface,
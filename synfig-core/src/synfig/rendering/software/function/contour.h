@@ -33,6 +33,7 @@
 #include <synfig/surface.h>
 
 #include "../../primitive/contour.h"
+#include "../../primitive/edgetable.h"
 #include "../../primitive/polyspan.h"
 
 /* === M A C R O S ========================================================= */
@@ -61,12 +62,32 @@ public:
 		Color::value_type opacity,
 		Color::BlendMethod blend_method );
 
+	//! Same as render_polyspan(), but marks may be unsorted (see Polyspan::finish_marks()),
+	//! they are accumulated in the buffer of each row instead of sorting of all marks
+	static void render_polyspan_rows(
+		synfig::Surface &target_surface,
+		const Polyspan &polyspan,
+		bool invert,
+		bool antialias,
+		rendering::Contour::WindingStyle winding_style,
+		const Color &color,
+		Color::value_type opacity,
+		Color::BlendMethod blend_method );
+
 	static void build_polyspan(
 		const rendering::Contour::ChunkList &chunks,
 		const Matrix &transform_matrix,
 		Polyspan &out_polyspan,
 		Real detail = 0.25 );
 
+	//! Prepares contour once, so parts of the window may be rasterized separately
+	static void build_edge_table(
+		const rendering::Contour::ChunkList &chunks,
+		const Matrix &transform_matrix,
+		const RectInt &window,
+		EdgeTable &out_edge_table,
+		Real detail = 0.25 );
+
 	static void render_contour(
 		synfig::Surface &target_surface,
 		const rendering::Contour::ChunkList &chunks,
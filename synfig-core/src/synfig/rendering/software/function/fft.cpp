@@ -36,6 +36,9 @@
 #include <climits>
 //#include <ccomplex>
 
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <mutex>
 
 #include <vector>
@@ -43,6 +46,8 @@
 
 #include <fftw3.h>
 
+#include <synfig/threadpool.h>
+
 #include "fft.h"
 
 #endif
@@ -61,12 +66,169 @@ using namespace rendering;
 class software::FFT::Internal
 {
 public:
+	enum Kind {
+		KIND_FORWARD,
+		KIND_BACKWARD,
+		KIND_REAL_TO_COMPLEX,
+		KIND_COMPLEX_TO_REAL
+	};
+
+	//! FFTW plan, planner is not thread-safe, so plan is destroyed under the mutex
+	class Plan {
+	public:
+		const fftw_plan plan;
+		explicit Plan(fftw_plan plan): plan(plan) { }
+		~Plan() { std::lock_guard<std::mutex> lock(mutex); fftw_destroy_plan(plan); }
+	};
+
+	typedef std::shared_ptr<Plan> PlanPtr;
+	typedef std::vector<long long> Key;
+	typedef std::map<Key, PlanPtr> PlanMap;
+
+	//! Set of 1d-transforms of the same size, see fftw_plan_guru_dft().
+	//! Strides are counted in items of input and output arrays (Real or Complex),
+	//! transforms of loops[0] are split between threads.
+	class Pass {
+	public:
+		Kind kind;
+		fftw_iodim dim;
+		fftw_iodim loops[2];
+		Real *in;
+		Real *out;
+		Real scale;
+
+		Pass(): kind(), dim(), loops(), in(), out(), scale(1.0)
+			{ loops[0].n = loops[1].n = 1; }
+	};
+
 	static std::set<int> counts;
 	static std::mutex mutex;
+	static PlanMap plans;
+
+	static bool is_complex_in(Kind kind)
+		{ return kind != KIND_REAL_TO_COMPLEX; }
+	static bool is_complex_out(Kind kind)
+		{ return kind != KIND_COMPLEX_TO_REAL; }
+
+	static PlanPtr get_plan(const Pass &pass, Real *in, Real *out, int count);
+	static void run_part(const Pass &pass, int begin, int end);
+	static void run(const Pass &pass);
 };
 
 std::set<int> software::FFT::Internal::counts;
 std::mutex software::FFT::Internal::mutex;
+software::FFT::Internal::PlanMap software::FFT::Internal::plans;
+
+software::FFT::Internal::PlanPtr
+software::FFT::Internal::get_plan(const Pass &pass, Real *in, Real *out, int count)
+{
+	fftw_iodim loops[2] = { pass.loops[0], pass.loops[1] };
+	loops[0].n = count;
+
+	// plan may be executed for the other arrays with the same layout and alignment
+	const Key key = {
+		pass.kind,
+		pass.dim.n, pass.dim.is, pass.dim.os,
+		loops[0].n, loops[0].is, loops[0].os,
+		loops[1].n, loops[1].is, loops[1].os,
+		fftw_alignment_of(in), fftw_alignment_of(out), in == out };
+
+	// evicted plans are destroyed after unlock, when they are not executed anymore
+	PlanMap evicted;
+	std::lock_guard<std::mutex> lock(mutex);
+
+	PlanMap::const_iterator i = plans.find(key);
+	if (i != plans.end())
+		return i->second;
+
+	if ((int)plans.size() >= max_plans)
+		plans.swap(evicted);
+
+	// FFTW_ESTIMATE does not touch the arrays while planning
+	fftw_plan plan = nullptr;
+	switch(pass.kind)
+	{
+	case KIND_FORWARD:
+	case KIND_BACKWARD:
+		plan = fftw_plan_guru_dft(
+			1, &pass.dim, 2, loops,
+			(fftw_complex*)in, (fftw_complex*)out,
+			pass.kind == KIND_BACKWARD ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
+		break;
+	case KIND_REAL_TO_COMPLEX:
+		plan = fftw_plan_guru_dft_r2c(
+			1, &pass.dim, 2, loops,
+			in, (fftw_complex*)out, FFTW_ESTIMATE );
+		break;
+	case KIND_COMPLEX_TO_REAL:
+		plan = fftw_plan_guru_dft_c2r(
+			1, &pass.dim, 2, loops,
+			(fftw_complex*)in, out, FFTW_ESTIMATE );
+		break;
+	}
+	assert(plan);
+
+	PlanPtr &p = plans[key];
+	p = std::make_shared<Plan>(plan);
+	return p;
+}
+
+void
+software::FFT::Internal::run_part(const Pass &pass, int begin, int end)
+{
+	if (begin >= end) return;
+
+	const int in_item = is_complex_in(pass.kind) ? 2 : 1;
+	const int out_item = is_complex_out(pass.kind) ? 2 : 1;
+	Real *in = pass.in + in_item*begin*pass.loops[0].is;
+	Real *out = pass.out + out_item*begin*pass.loops[0].os;
+
+	// execution of plan for the new arrays is thread-safe
+	PlanPtr plan = get_plan(pass, in, out, end - begin);
+	switch(pass.kind)
+	{
+	case KIND_FORWARD:
+	case KIND_BACKWARD:
+		fftw_execute_dft(plan->plan, (fftw_complex*)in, (fftw_complex*)out);
+		break;
+	case KIND_REAL_TO_COMPLEX:
+		fftw_execute_dft_r2c(plan->plan, in, (fftw_complex*)out);
+		break;
+	case KIND_COMPLEX_TO_REAL:
+		fftw_execute_dft_c2r(plan->plan, (fftw_complex*)in, out);
+		break;
+	}
+
+	// scale the same part of output while it is in cache
+	if (pass.scale != 1.0)
+		for(int i = 0; i < pass.loops[1].n; ++i)
+			for(int j = 0; j < end - begin; ++j)
+			{
+				Real *x = out + out_item*(i*pass.loops[1].os + j*pass.loops[0].os);
+				for(int k = 0; k < pass.dim.n; ++k)
+					for(int l = 0; l < out_item; ++l)
+						x[out_item*k*pass.dim.os + l] *= pass.scale;
+			}
+}
+
+void
+software::FFT::Internal::run(const Pass &pass)
+{
+	const int count = pass.loops[0].n;
+	const long long values = (long long)pass.dim.n*count*pass.loops[1].n;
+	const int parts = (int)std::max(1ll, std::min(
+		(long long)std::min(ThreadPool::get_thread_budget(), count),
+		values/min_part_values ));
+
+	if (parts == 1)
+		{ run_part(pass, 0, count); return; }
+
+	ThreadPool::Group group;
+	for(int i = 0; i < parts; ++i)
+		group.enqueue( sigc::bind( sigc::ptr_fun(&run_part),
+			pass, count*i/parts, count*(i + 1)/parts ));
+	group.run();
+}
 
 void
 software::FFT::initialize()
@@ -87,6 +249,12 @@ void
 software::FFT::deinitialize()
 {
 	Internal::counts.clear();
+
+	Internal::PlanMap plans;
+	{
+		std::lock_guard<std::mutex> lock(Internal::mutex);
+		Internal::plans.swap(plans);
+	}
 }
 
 int
@@ -115,24 +283,15 @@ software::FFT::fft(const Array<Complex, 1> &x, bool invert)
 
 	assert(is_valid_count(x.count));
 
-	fftw_iodim iodim;
-	iodim.n  = x.count;
-	iodim.is = x.stride;
-	iodim.os = x.stride;
-
-	{
-		std::lock_guard<std::mutex> lock(Internal::mutex);
-		fftw_plan plan = fftw_plan_guru_dft(
-			1, &iodim, 0, nullptr,
-			(fftw_complex*)x.pointer, (fftw_complex*)x.pointer,
-			invert ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
-		fftw_execute(plan);
-		fftw_destroy_plan(plan);
-	}
-
+	Internal::Pass pass;
+	pass.kind = invert ? Internal::KIND_BACKWARD : Internal::KIND_FORWARD;
+	pass.dim.n  = x.count;
+	pass.dim.is = x.stride;
+	pass.dim.os = x.stride;
+	pass.in = pass.out = (Real*)x.pointer;
 	// divide by count to complete back-FFT
-	if (invert)
-		x.process< std::multiplies<Complex> >( Complex(1.0/(Real)x.count) );
+	if (invert) pass.scale = 1.0/(Real)x.count;
+	Internal::run_part(pass, 0, 1);
 }
 
 void
@@ -147,6 +306,8 @@ software::FFT::fft2d(const Array<Complex, 2> &x, bool invert, bool do_rows, bool
 
 	if (!do_rows && !do_cols) return;
 
+	// 2d-transform is done by separate passes for rows and for columns,
+	// each of them is split between threads
 	fftw_iodim iodim[2];
 	iodim[0].n  = x.sub().count;
 	iodim[0].is = x.sub().stride;
@@ -155,34 +316,84 @@ software::FFT::fft2d(const Array<Complex, 2> &x, bool invert, bool do_rows, bool
 	iodim[1].is = x.stride;
 	iodim[1].os = x.stride;
 
+	// divide by count to complete back-FFT
+	Real scale = 1.0/(Real)( (do_cols ? x.count : 1)
+			               * (do_rows ? x.sub().count : 1) );
+
+	Internal::Pass pass;
+	pass.kind = invert ? Internal::KIND_BACKWARD : Internal::KIND_FORWARD;
+	pass.in = pass.out = (Real*)x.pointer;
+
+	if (do_rows)
 	{
-		std::lock_guard<std::mutex> lock(Internal::mutex);
+		pass.dim = iodim[0];
+		pass.loops[0] = iodim[1];
+		if (invert && !do_cols) pass.scale = scale;
+		Internal::run(pass);
+	}
 
-		fftw_plan plan;
-		if (do_rows && do_cols)
-		{
-			plan = fftw_plan_guru_dft(
-				2, iodim, 0, nullptr,
-				(fftw_complex*)x.pointer, (fftw_complex*)x.pointer,
-				invert ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
-		}
-		else
-		{
-			plan = fftw_plan_guru_dft(
-				1, &iodim[do_rows ? 0 : 1], 1, &iodim[do_rows ? 1 : 0],
-				(fftw_complex*)x.pointer, (fftw_complex*)x.pointer,
-				invert ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE );
-		}
-		fftw_execute(plan);
-		fftw_destroy_plan(plan);
+	if (do_cols)
+	{
+		pass.dim = iodim[1];
+		pass.loops[0] = iodim[0];
+		if (invert) pass.scale = scale;
+		Internal::run(pass);
 	}
+}
+
+void
+software::FFT::fft2d_real(const Array<Real, 3> &x, bool invert, bool do_cols)
+{
+	const int planes = x.count;
+	const int rows = x.sub().count;
+	const int cols = x.sub().sub().count;
+	const int row_stride = x.sub().stride;
+	const int plane_stride = x.stride;
+	if (planes == 0 || rows == 0 || cols == 0) return;
+
+	assert(x.sub().sub().stride == 1);
+	assert(row_stride >= get_real_stride(cols) && row_stride % 2 == 0);
+	assert(plane_stride % 2 == 0);
+	assert(is_valid_count(rows) && is_valid_count(cols));
+
+	const int spectrum_cols = cols/2 + 1;
+
+	// each row of plane takes place of its own spectrum,
+	// strides of complex spectrum are a half of strides of real values
+	Internal::Pass rows_pass;
+	rows_pass.kind = invert ? Internal::KIND_COMPLEX_TO_REAL : Internal::KIND_REAL_TO_COMPLEX;
+	rows_pass.dim.n = cols;
+	rows_pass.dim.is = rows_pass.dim.os = 1;
+	rows_pass.loops[0].n = rows;
+	rows_pass.loops[0].is = invert ? row_stride/2 : row_stride;
+	rows_pass.loops[0].os = invert ? row_stride : row_stride/2;
+	rows_pass.loops[1].n = planes;
+	rows_pass.loops[1].is = invert ? plane_stride/2 : plane_stride;
+	rows_pass.loops[1].os = invert ? plane_stride : plane_stride/2;
+	rows_pass.in = rows_pass.out = x.pointer;
+
+	// columns of the half of spectrum are transformed as complex values
+	Internal::Pass cols_pass;
+	cols_pass.kind = invert ? Internal::KIND_BACKWARD : Internal::KIND_FORWARD;
+	cols_pass.dim.n = rows;
+	cols_pass.dim.is = cols_pass.dim.os = row_stride/2;
+	cols_pass.loops[0].n = spectrum_cols;
+	cols_pass.loops[0].is = cols_pass.loops[0].os = 1;
+	cols_pass.loops[1].n = planes;
+	cols_pass.loops[1].is = cols_pass.loops[1].os = plane_stride/2;
+	cols_pass.in = cols_pass.out = x.pointer;
 
-	// divide by count to complete back-FFT
 	if (invert)
 	{
-		int count = (do_cols ? x.count : 1)
-			      * (do_rows ? x.sub().count : 1);
-		x.process< std::multiplies<Complex> >( Complex(1.0/(Real)count) );
+		// divide by count to complete back-FFT
+		rows_pass.scale = 1.0/(Real)(do_cols ? rows*cols : cols);
+		if (do_cols) Internal::run(cols_pass);
+		Internal::run(rows_pass);
+	}
+	else
+	{
+		Internal::run(rows_pass);
+		if (do_cols) Internal::run(cols_pass);
 	}
 }
 
@@ -46,18 +46,35 @@ namespace rendering
 namespace software
 {
 
+//! Fourier transforms by FFTW.
+//! Plans are cached, so they are built once for each size and layout of arrays,
+//! and rows and columns of the big arrays are transformed in parallel by ThreadPool.
 class FFT
 {
 private:
 	class Internal;
 
 public:
+	//! minimal count of values transformed by one thread
+	static constexpr int min_part_values = 64*1024;
+	//! count of cached plans, cache is cleared when it grows bigger
+	static constexpr int max_plans = 256;
+
 	static int get_valid_count(int x);
 	static bool is_valid_count(int x);
 
+	//! count of Real values in the row of array for the in-place real transform of \a cols values
+	static int get_real_stride(int cols) { return 2*(cols/2 + 1); }
+
 	static void fft(const Array<Complex, 1> &x, bool invert);
 	static void fft2d(const Array<Complex, 2> &x, bool invert, bool do_rows = true, bool do_cols = true);
 
+	//! In-place transform of real planes, \a x is [plane][row][col].
+	//! Stride of rows must be get_real_stride(cols) or bigger and stride of cols must be 1.
+	//! Forward transform turns each plane into rows x (cols/2 + 1) Complex values
+	//! (the other half of spectrum is conjugate), invert transform turns it back.
+	static void fft2d_real(const Array<Real, 3> &x, bool invert, bool do_cols = true);
+
 	static void initialize();
 	static void deinitialize();
 };
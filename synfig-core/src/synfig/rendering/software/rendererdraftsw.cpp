@@ -41,6 +41,7 @@
 #include "../common/optimizer/optimizerblendassociative.h"
 #include "../common/optimizer/optimizerblendmerge.h"
 #include "../common/optimizer/optimizerblendtotarget.h"
+#include "../common/optimizer/optimizercontour.h"
 #include "../common/optimizer/optimizerdraft.h"
 #include "../common/optimizer/optimizerlist.h"
 #include "../common/optimizer/optimizersplit.h"
@@ -66,6 +67,7 @@ RendererDraftSW::RendererDraftSW()
 
 	// register optimizers
 	register_optimizer(new OptimizerDraftContour(2.0, true));
+	register_optimizer(new OptimizerContourRasterizer(TaskContour::RASTERIZER_ROWS));
 	register_optimizer(new OptimizerDraftBlur());
 	register_optimizer(new OptimizerDraftLayerSkip("motion_blur"));
 	register_optimizer(new OptimizerDraftLayerSkip("radial_blur"));
@@ -101,7 +103,7 @@ RendererDraftSW::RendererDraftSW()
 	register_optimizer(new OptimizerBlendToTarget());
 	register_optimizer(new OptimizerList());
 	register_optimizer(new OptimizerBlendAssociative());
-	//register_optimizer(new OptimizerSplit());
+	register_optimizer(new OptimizerSplit());
 }
 
 String RendererDraftSW::get_name() const
@@ -41,6 +41,7 @@
 #include "../common/optimizer/optimizerblendassociative.h"
 #include "../common/optimizer/optimizerblendmerge.h"
 #include "../common/optimizer/optimizerblendtotarget.h"
+#include "../common/optimizer/optimizercontour.h"
 #include "../common/optimizer/optimizerdraft.h"
 #include "../common/optimizer/optimizerlist.h"
 #include "../common/optimizer/optimizersplit.h"
@@ -67,6 +68,7 @@ RendererLowResSW::RendererLowResSW(int level):
 
 	// register optimizers
 	register_optimizer(new OptimizerDraftLowRes(level));
+	register_optimizer(new OptimizerContourRasterizer(TaskContour::RASTERIZER_ROWS));
 	register_optimizer(new OptimizerTransformation());
 	register_optimizer(new OptimizerDraftTransformation());
 
@@ -76,7 +78,7 @@ RendererLowResSW::RendererLowResSW(int level):
 	register_optimizer(new OptimizerBlendToTarget());
 	register_optimizer(new OptimizerList());
 	register_optimizer(new OptimizerBlendAssociative());
-	//register_optimizer(new OptimizerSplit());
+	register_optimizer(new OptimizerSplit());
 }
 
 String RendererLowResSW::get_name() const
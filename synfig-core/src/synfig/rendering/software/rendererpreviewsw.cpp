@@ -41,6 +41,7 @@
 #include "../common/optimizer/optimizerblendassociative.h"
 #include "../common/optimizer/optimizerblendmerge.h"
 #include "../common/optimizer/optimizerblendtotarget.h"
+#include "../common/optimizer/optimizercontour.h"
 #include "../common/optimizer/optimizerlist.h"
 #include "../common/optimizer/optimizersplit.h"
 #include "../common/optimizer/optimizertransformation.h"
@@ -67,6 +68,7 @@ RendererPreviewSW::RendererPreviewSW()
 	register_mode(TaskSW::mode_token.handle());
 
 	// register optimizers
+	register_optimizer(new OptimizerContourRasterizer(TaskContour::RASTERIZER_ROWS));
 	register_optimizer(new OptimizerTransformation());
 	register_optimizer(new OptimizerDraftTransformation());
 	register_optimizer(new OptimizerPass(false));
@@ -75,7 +77,7 @@ RendererPreviewSW::RendererPreviewSW()
 	register_optimizer(new OptimizerList());
 	register_optimizer(new OptimizerBlendToTarget());
 	register_optimizer(new OptimizerBlendAssociative());
-	//register_optimizer(new OptimizerSplit());
+	register_optimizer(new OptimizerSplit());
 }
 
 String RendererPreviewSW::get_name() const
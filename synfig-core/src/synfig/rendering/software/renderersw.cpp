@@ -41,6 +41,7 @@
 #include "../common/optimizer/optimizerblendassociative.h"
 #include "../common/optimizer/optimizerblendmerge.h"
 #include "../common/optimizer/optimizerblendtotarget.h"
+#include "../common/optimizer/optimizercontour.h"
 #include "../common/optimizer/optimizerlist.h"
 #include "../common/optimizer/optimizersplit.h"
 #include "../common/optimizer/optimizertransformation.h"
@@ -66,6 +67,7 @@ RendererSW::RendererSW()
 	register_mode(TaskSW::mode_token.handle());
 
 	// register optimizers
+	register_optimizer(new OptimizerContourRasterizer(TaskContour::RASTERIZER_ROWS));
 	register_optimizer(new OptimizerTransformation());
 
 	register_optimizer(new OptimizerPass(false));
@@ -74,7 +76,7 @@ RendererSW::RendererSW()
 	register_optimizer(new OptimizerList());
 	register_optimizer(new OptimizerBlendToTarget());
 	register_optimizer(new OptimizerBlendAssociative());
-	//register_optimizer(new OptimizerSplit());
+	register_optimizer(new OptimizerSplit());
 }
 
 RendererSW::~RendererSW() { }
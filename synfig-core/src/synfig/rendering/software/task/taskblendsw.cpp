@@ -35,6 +35,7 @@
 #include <synfig/debug/debugsurface.h>
 
 #include "../../common/task/taskblend.h"
+#include "../function/blend.h"
 #include "tasksw.h"
 
 #endif
@@ -72,6 +73,9 @@ public:
 		}
 	}
 
+	virtual Real get_split_pixel_cost() const
+		{ return software::Blend::is_optimized(blend_method) ? 1.0 : 3.0; }
+
 	virtual bool run(RunParams&) const {
 		if (!is_valid()) return true;
 
@@ -131,15 +135,7 @@ public:
 					assert( 0 <= rb.minx + ob[0] && rb.maxx + ob[0] <= b.get_w()
 						 && 0 <= rb.miny + ob[1] && rb.maxy + ob[1] <= b.get_h() );
 
-					synfig::Surface::alpha_pen ap(c.get_pen(rb.minx, rb.miny));
-					ap.set_blend_method(blend_method);
-					ap.set_alpha(amount);
-					b.blit_to(
-						ap,
-						rb.minx + ob[0],
-						rb.miny + ob[1],
-						rb.maxx - rb.minx,
-						rb.maxy - rb.miny );
+					software::Blend::blend(c, rb, b, ob, amount, blend_method);
 
 					if (ra.is_valid())
 					{
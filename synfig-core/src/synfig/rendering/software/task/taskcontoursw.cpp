@@ -32,6 +32,10 @@
 #	include <config.h>
 #endif
 
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include <synfig/debug/debugsurface.h>
 
 #include "../../primitive/polyspan.h"
@@ -55,6 +59,60 @@ using namespace rendering;
 
 namespace {
 
+//! Edge table of the split task, shared by all of its parts
+class SharedEdges
+{
+public:
+	struct Entry {
+		std::mutex mutex;
+		bool built;
+		int users; //!< parts which didn't release the entry yet, guarded by SharedEdges::mutex
+		EdgeTable edge_table;
+		explicit Entry(int users): built(), users(users) { }
+	};
+
+private:
+	// optimized task lists are reused by the next renders,
+	// so keep the separate entry for each batch of tasks
+	enum { MAX_ENTRIES = 8 };
+
+	std::mutex mutex;
+	std::map<int, std::shared_ptr<Entry>> entries;
+
+public:
+	const RectInt window;
+	const int users;
+
+	SharedEdges(const RectInt &window, int users): window(window), users(users) { }
+
+	std::shared_ptr<Entry> acquire(int batch_index)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::shared_ptr<Entry> &entry = entries[batch_index];
+		if (entry)
+			return entry;
+		std::shared_ptr<Entry> result = entry = std::make_shared<Entry>(users);
+
+		// parts of cancelled batches never release their entries,
+		// remove the oldest of them, but not the entries held by running parts
+		for(std::map<int, std::shared_ptr<Entry>>::iterator i = entries.begin(); i != entries.end() && entries.size() > MAX_ENTRIES; )
+			if (i->second.use_count() == 1)
+				i = entries.erase(i);
+			else
+				++i;
+		return result;
+	}
+
+	void release(int batch_index, Entry &entry)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--entry.users > 0) return;
+		std::map<int, std::shared_ptr<Entry>>::iterator i = entries.find(batch_index);
+		if (i != entries.end() && i->second.get() == &entry)
+			entries.erase(i);
+	}
+};
+
 class TaskContourSW: public TaskContour, public TaskSW,
 	public TaskInterfaceBlendToTarget,
 	public TaskInterfaceSplit
@@ -79,6 +137,21 @@ public:
 	virtual Color::BlendMethodFlags get_supported_blend_methods() const
 		{ return Color::BLEND_METHODS_ALL & ~Color::BLEND_METHODS_STRAIGHT; }
 
+	// parts of the split task share the contour prepared once, see run()
+	std::shared_ptr<SharedEdges> shared_edges;
+
+	// each part walks the whole contour (chunks are flattened into several lines),
+	// and then renders the whole rows of its target rect
+	virtual Real get_split_part_cost() const
+		{ return contour ? 20.0*contour->get_chunks().size() : 0.0; }
+	virtual bool is_split_by_rows() const
+		{ return true; }
+
+	// called for the private copy of the task, so the table
+	// of the previous split (if this task is a part itself) is not touched
+	virtual void on_split(int count)
+		{ shared_edges = std::make_shared<SharedEdges>(target_rect, count); }
+
 	virtual bool run(RunParams&) const {
 		if (!is_valid())
 			return true;
@@ -97,15 +170,40 @@ public:
 
 		Polyspan polyspan;
 		polyspan.init(target_rect);
-		software::Contour::build_polyspan(contour->get_chunks(), matrix, polyspan, detail);
-		polyspan.close();
-		polyspan.sort_marks();
+		if ( shared_edges
+		  && shared_edges->window.minx <= target_rect.minx
+		  && shared_edges->window.maxx >= target_rect.maxx
+		  && shared_edges->window.miny <= target_rect.miny
+		  && shared_edges->window.maxy >= target_rect.maxy )
+		{
+			int batch_index = renderer_data.batch_index;
+			std::shared_ptr<SharedEdges::Entry> entry = shared_edges->acquire(batch_index);
+			{
+				// first part builds the table, other parts wait for it
+				std::lock_guard<std::mutex> lock(entry->mutex);
+				if (!entry->built) {
+					software::Contour::build_edge_table(
+						contour->get_chunks(), matrix, shared_edges->window, entry->edge_table, detail );
+					entry->built = true;
+				}
+			}
+			entry->edge_table.add_to(polyspan);
+			shared_edges->release(batch_index, *entry);
+		} else {
+			software::Contour::build_polyspan(contour->get_chunks(), matrix, polyspan, detail);
+			polyspan.close();
+		}
+		const bool rows = rasterizer == RASTERIZER_ROWS;
+		if (rows)
+			polyspan.finish_marks();
+		else
+			polyspan.sort_marks();
 
 		LockWrite la(this);
 		if (!la)
 			return false;
 
-		software::Contour::render_polyspan(
+		(rows ? software::Contour::render_polyspan_rows : software::Contour::render_polyspan)(
 			la->get_surface(),
 			polyspan,
 			contour->invert,
@@ -33,8 +33,12 @@
 #	include <config.h>
 #endif
 
+#include <vector>
+
 #include "taskpaintpixelsw.h"
 
+#include "../function/blend.h"
+
 #include <synfig/general.h>
 #include <synfig/localization.h>
 
@@ -65,6 +69,14 @@ rendering::TaskPaintPixelSW::on_target_set_as_source() {
 	}
 }
 
+void
+synfig::rendering::TaskPaintPixelSW::get_colors(const Vector& p, const Vector& dx, int count, Color* out) const
+{
+	Vector pp = p;
+	for(Color *end = out + count; out < end; ++out, pp += dx)
+		*out = get_color(pp);
+}
+
 synfig::Color::BlendMethodFlags
 synfig::rendering::TaskPaintPixelSW::get_supported_blend_methods() const
 {
@@ -91,18 +103,21 @@ synfig::rendering::TaskPaintPixelSW::run_task() const
 		world_to_raster.m21 = target_rect.miny - ppu[1] * task->source_rect.miny;
 	}
 
+	// task may have no transformation, if it is not able to absorb it now
 	if (auto interface_transformation = dynamic_cast<const TaskInterfaceTransformation*>(this)) {
-		if (auto affine = TransformationAffine::Handle::cast_dynamic(interface_transformation->get_transformation()))
-			world_to_raster *= affine->matrix;
-		else
-			synfig::error(_("Internal Error: unsupported transformation for %s. It should be TransformationAffine."), task->get_token()->name.c_str());
+		if (auto transformation = interface_transformation->get_transformation()) {
+			if (auto affine = TransformationAffine::Handle::cast_dynamic(transformation))
+				world_to_raster *= affine->matrix;
+			else
+				synfig::error(_("Internal Error: unsupported transformation for %s. It should be TransformationAffine."), task->get_token()->name.c_str());
+		}
 	}
 
 	const Matrix raster_to_world = world_to_raster.get_inverted();
 
 	const int tw = target_rect.get_width();
 	const Vector dx = raster_to_world.axis_x();
-	const Vector dy = raster_to_world.axis_y() - dx * (Real)tw;
+	const Vector dy = raster_to_world.axis_y();
 	Vector p = raster_to_world.get_transformed( Vector((Real)target_rect.minx, (Real)target_rect.miny) );
 
 	pre_run(world_to_raster, raster_to_world);
@@ -111,19 +126,28 @@ synfig::rendering::TaskPaintPixelSW::run_task() const
 	if (!la)
 		return false;
 
-	synfig::Surface::alpha_pen apen(la->get_surface().get_pen(target_rect.minx, target_rect.miny));
+	synfig::Surface &surface = la->get_surface();
 	const ColorReal amount = blend ? this->amount : ColorReal(1.0);
-	apen.set_blend_method(blend ? blend_method : Color::BLEND_COMPOSITE);
+	const Color::BlendMethod method = blend ? blend_method : Color::BLEND_COMPOSITE;
 
-	for (int iy = target_rect.miny; iy < target_rect.maxy; ++iy, p += dy, apen.inc_y(), apen.dec_x(tw)) {
-		for (int ix = target_rect.minx; ix < target_rect.maxx; ++ix, p += dx, apen.inc_x()) {
-			apen.put_value(get_color(p), amount);
-		}
+	// colors of the whole row are calculated at once and then blended onto the target
+	std::vector<Color> row(tw);
+	for (int iy = target_rect.miny; iy < target_rect.maxy; ++iy, p += dy) {
+		get_colors(p, dx, tw, &row.front());
+		software::Blend::blend_row(&surface[iy][target_rect.minx], &row.front(), tw, amount, method);
 	}
 
 	return true;
 }
 
+void
+synfig::rendering::TaskFilterPixelSW::get_colors(const Vector& p, const Vector& dx, int count, const Color* src, Color* out) const
+{
+	Vector pp = p;
+	for(Color *end = out + count; out < end; ++out, ++src, pp += dx)
+		*out = get_color(pp, *src);
+}
+
 bool
 synfig::rendering::TaskFilterPixelSW::run_task() const
 {
@@ -176,14 +200,12 @@ synfig::rendering::TaskFilterPixelSW::run_task() const
 
 				const synfig::Surface &a = lsrc->get_surface();
 
+				const Vector dx(upp[0], 0.0);
 				for (int y = ra.miny; y < ra.maxy; ++y) {
 					const Color *ca = &a[y - r.miny + offset[1]][ra.minx - r.minx + offset[0]];
 					Color *cc = &c[y][ra.minx];
-					Real v = upp[1] * y + constant[1];
-					for (int x = ra.minx; x < ra.maxx; ++x, ++ca, ++cc) {
-						Real u = upp[0] * x + constant[0];
-						*cc = get_color(Vector(u, v), *ca);
-					}
+					const Vector p(upp[0] * ra.minx + constant[0], upp[1] * y + constant[1]);
+					get_colors(p, dx, ra.maxx - ra.minx, ca, cc);
 				}
 			}
 		}
@@ -71,12 +71,21 @@ public:
 	//! Fetch color at position p (in synfig units) when antialias is false
 	virtual Color get_color(const Vector& p) const = 0;
 
+	//! Fetch colors of \a count pixels of row, starting at position \a p with step \a dx.
+	//! By default calls get_color() for each pixel,
+	//! override it to calculate the whole row at once
+	virtual void get_colors(const Vector& p, const Vector& dx, int count, Color* out) const;
+
 	//! Call this method from run() method of the real task implementation
 	virtual bool run_task() const;
 
 	void on_target_set_as_source() override;
 
 	Color::BlendMethodFlags get_supported_blend_methods() const override;
+
+	//! virtual call of get_color() and blending for each pixel, CostModel learns the rest
+	Real get_split_pixel_cost() const override
+		{ return 4.0; }
 };
 
 /**
@@ -100,6 +109,11 @@ public:
 	/** Fetch color at position @a p (in synfig units) given a previous Color @a c at same point */
 	virtual Color get_color(const Vector& /*p*/, const Color& c) const = 0;
 
+	//! Fetch colors of \a count pixels of row, starting at position \a p with step \a dx,
+	//! given the previous colors \a src, which may be the same array as \a out.
+	//! By default calls get_color() for each pixel
+	virtual void get_colors(const Vector& p, const Vector& dx, int count, const Color* src, Color* out) const;
+
 	//! Call this method from run() method of the real task implementation
 	virtual bool run_task() const;
 };
@@ -32,6 +32,7 @@
 #	include <config.h>
 #endif
 
+#include <synfig/color/gamma.h>
 #include <synfig/debug/debugsurface.h>
 #include <synfig/general.h>
 
@@ -181,7 +182,33 @@ private:
 				                                              process_rg<fr, func_copy>(p);
 	}
 
+	//! pow() for rows by Gamma::apply_row(), it is vectorized
+	static void process_pow_rows(const Params &p) {
+		Gamma gamma;
+		for(int i = 0; i < 3; ++i)
+			gamma.set(i, approximate_equal_lp(p.gamma[i], ColorReal(1.0)) ? ColorReal(1.0) : p.gamma[i]);
+
+		for(int y = 0; y < p.height; ++y) {
+			Color *dst = (Color*)(p.dst + 4*p.dst_stride*y);
+			const Color *src = (const Color*)(p.src + 4*p.src_stride*y);
+			gamma.apply_row(dst, src, p.width);
+			for(Color *dst_end = dst + p.width; dst != dst_end; ++dst) {
+				dst->set_r(clamp(dst->get_r()));
+				dst->set_g(clamp(dst->get_g()));
+				dst->set_b(clamp(dst->get_b()));
+			}
+		}
+	}
+
 	static void process(const Params &p) {
+		if ( !approximate_equal_lp(p.gamma_r, ColorReal(0.0))
+		  && !approximate_equal_lp(p.gamma_g, ColorReal(0.0))
+		  && !approximate_equal_lp(p.gamma_b, ColorReal(0.0))
+		  && ( !approximate_equal_lp(p.gamma_r, ColorReal(1.0))
+		    || !approximate_equal_lp(p.gamma_g, ColorReal(1.0))
+		    || !approximate_equal_lp(p.gamma_b, ColorReal(1.0)) ))
+			{ process_pow_rows(p); return; }
+
 		if ( approximate_equal_lp(p.gamma_r, ColorReal(0.0))) process_r<func_one >(p); else
 		if (!approximate_equal_lp(p.gamma_r, ColorReal(1.0))) process_r<func_pow >(p); else
 		if (p.src == p.dst)                                   process_r<func_none>(p); else
@@ -189,6 +216,10 @@ private:
 	}
 
 public:
+	// vectorized pow() for each channel
+	virtual Real get_split_pixel_cost() const
+		{ return 2.0; }
+
 	virtual bool run(RunParams&) const {
 		if (!is_valid() || !sub_task() || !sub_task()->is_valid())
 			return true;
@@ -0,0 +1,95 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/statistics.cpp
+**	\brief Statistics
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "statistics.h"
+#include "task.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+std::atomic<bool> Statistics::enabled(false);
+std::mutex Statistics::mutex;
+Statistics::Map Statistics::entries;
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+Statistics::Timer::Timer(const char *name):
+	name(name), task(), enabled(Statistics::is_enabled())
+{
+	if (enabled) begin = Clock::now();
+}
+
+Statistics::Timer::Timer(const Task &task):
+	name(), task(&task), enabled(Statistics::is_enabled())
+{
+	if (enabled) begin = Clock::now();
+}
+
+Statistics::Timer::~Timer()
+{
+	if (!enabled) return;
+	long long time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+	add(task ? "task " + task->get_token()->name : String(name), time);
+}
+
+void
+Statistics::add(const String &name, long long time)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Entry &entry = entries[name];
+	++entry.count;
+	entry.time += time;
+}
+
+Statistics::Map
+Statistics::get()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return entries;
+}
+
+void
+Statistics::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+}
+
+/* === E N T R Y P O I N T ================================================= */
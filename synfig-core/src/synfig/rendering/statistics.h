@@ -0,0 +1,111 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/statistics.h
+**	\brief Statistics Header
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_STATISTICS_H
+#define __SYNFIG_RENDERING_STATISTICS_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#include <synfig/string.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+class Task;
+
+/*!	\class Statistics
+**	\brief Accumulates time spent in the phases of rendering.
+**
+**	Renderer measures the phases "optimize" and "linearize" (search of
+**	dependencies), RenderQueue measures each performed task by the name
+**	of its token with prefix "task ". Time of tasks is summed over
+**	all threads, so it may be greater than the real time of rendering.
+**
+**	Disabled by default, then timers cost one check of atomic flag.
+*/
+class Statistics
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Entry {
+		long long count;
+		long long time; //!< nanoseconds
+		Entry(): count(), time() { }
+	};
+
+	typedef std::map<String, Entry> Map;
+
+	//! Adds time of its life to the entry
+	class Timer {
+	private:
+		const char *name;
+		const Task *task;
+		bool enabled;
+		Clock::time_point begin;
+
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+
+	public:
+		explicit Timer(const char *name);
+		//! Uses name of the task token
+		explicit Timer(const Task &task);
+		~Timer();
+	};
+
+private:
+	static std::atomic<bool> enabled;
+	static std::mutex mutex;
+	static Map entries;
+
+public:
+	static bool is_enabled() { return enabled; }
+	static void set_enabled(bool x) { enabled = x; }
+
+	static void add(const String &name, long long time);
+	static Map get();
+	static void reset();
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
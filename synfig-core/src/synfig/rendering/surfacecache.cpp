@@ -0,0 +1,179 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/surfacecache.cpp
+**	\brief SurfaceCache
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <synfig/color.h>
+
+#include "surfacecache.h"
+
+#endif
+
+using namespace synfig;
+using namespace rendering;
+
+/* === M A C R O S ========================================================= */
+
+// how many keys are remembered while waiting for the second request
+#define MAX_REQUESTED_KEYS 4096
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+SurfaceCache::SurfaceCache(size_t max_size):
+	max_size(max_size)
+{ }
+
+SurfaceCache::Key
+SurfaceCache::get_key(const Task &task, const VectorInt &surface_size)
+{
+	Key key;
+	TaskHash hash(&key.data);
+	if (!task.add_to_hash(hash))
+		return Key();
+	hash.add(surface_size);
+	key.hash = hash.get() ? hash.get() : 1;
+	return key;
+}
+
+size_t
+SurfaceCache::get_surface_size(const SurfaceResource::Handle &surface)
+{
+	return surface && surface->is_exists()
+	     ? (size_t)surface->get_width()*(size_t)surface->get_height()*sizeof(Color)
+	     : 0;
+}
+
+void
+SurfaceCache::evict(size_t max_size)
+{
+	while(!entries.empty() && stats.size > max_size) {
+		stats.size -= get_surface_size(entries.back().surface);
+		--stats.count;
+		++stats.evictions;
+		entries_map.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
+
+void
+SurfaceCache::set_max_size(size_t max_size)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	this->max_size = max_size;
+	evict(max_size);
+}
+
+size_t
+SurfaceCache::get_max_size() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return max_size;
+}
+
+SurfaceResource::Handle
+SurfaceCache::get(const Key &key)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Map::iterator i = entries_map.find(key);
+	if (i == entries_map.end()) {
+		++stats.misses;
+		return SurfaceResource::Handle();
+	}
+	++stats.hits;
+	entries.splice(entries.begin(), entries, i->second);
+	return i->second->surface;
+}
+
+bool
+SurfaceCache::admit(const Key &key)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (requested_keys.erase(key.hash))
+		return true;
+	if (requested_keys.size() >= MAX_REQUESTED_KEYS)
+		requested_keys.clear();
+	requested_keys.insert(key.hash);
+	return false;
+}
+
+void
+SurfaceCache::put(const Key &key, const SurfaceResource::Handle &surface)
+{
+	size_t size = get_surface_size(surface);
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!size || size > max_size || entries_map.count(key))
+		return;
+
+	evict(max_size - size);
+	entries.push_front(Entry(key, surface));
+	entries_map[key] = entries.begin();
+	stats.size += size;
+	++stats.count;
+}
+
+void
+SurfaceCache::put(const EntryList &list)
+{
+	for(EntryList::const_iterator i = list.begin(); i != list.end(); ++i)
+		put(i->key, i->surface);
+}
+
+void
+SurfaceCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	entries_map.clear();
+	requested_keys.clear();
+	stats.count = 0;
+	stats.size = 0;
+}
+
+SurfaceCache::Stats
+SurfaceCache::get_stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Stats s = stats;
+	s.max_size = max_size;
+	return s;
+}
+
+void
+SurfaceCache::reset_stats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.hits = 0;
+	stats.misses = 0;
+	stats.evictions = 0;
+}
@@ -0,0 +1,146 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file synfig/rendering/surfacecache.h
+**	\brief SurfaceCache Header
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_RENDERING_SURFACECACHE_H
+#define __SYNFIG_RENDERING_SURFACECACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "surface.h"
+#include "task.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig
+{
+namespace rendering
+{
+
+/*!	\class SurfaceCache
+**	\brief Memory-bounded LRU cache of rendered surfaces.
+**
+**	Surfaces are identified by a key built from the structural hash of the task
+**	which rendered them (see Task::get_hash()) and the size of the surface.
+**	The key keeps all of the hashed data too, so surfaces of different tasks
+**	with the same hash are never mixed up.
+**	Cached surfaces are complete and never written again, renderer uses them
+**	as prerendered sources (TaskSurface) instead of running the task.
+**
+**	Key is admitted into the cache only when it was requested before,
+**	so content which changes every frame doesn't push static content out.
+*/
+class SurfaceCache
+{
+public:
+	struct Key {
+		TaskHash::Type hash;
+		//! all of the hashed data, compared only when hashes are equal
+		std::string data;
+		Key(): hash() { }
+		Key(TaskHash::Type hash, const std::string &data = std::string()): hash(hash), data(data) { }
+		bool operator<(const Key &other) const
+			{ return hash < other.hash || (hash == other.hash && data < other.data); }
+		bool operator==(const Key &other) const
+			{ return hash == other.hash && data == other.data; }
+		bool operator!=(const Key &other) const
+			{ return !(*this == other); }
+	};
+
+	struct Entry {
+		Key key;
+		SurfaceResource::Handle surface;
+		Entry() { }
+		Entry(const Key &key, const SurfaceResource::Handle &surface): key(key), surface(surface) { }
+	};
+	typedef std::vector<Entry> EntryList;
+
+	struct Stats {
+		long long hits;
+		long long misses;
+		long long evictions;
+		size_t count;
+		size_t size;
+		size_t max_size;
+		Stats(): hits(), misses(), evictions(), count(), size(), max_size() { }
+	};
+
+private:
+	typedef std::list<Entry> List;
+	typedef std::map<Key, List::iterator> Map;
+
+	mutable std::mutex mutex;
+	size_t max_size;
+	List entries; //!< most recently used first
+	Map entries_map;
+	//! only hashes are remembered, false admission of the other key does no harm
+	std::set<TaskHash::Type> requested_keys;
+	Stats stats;
+
+	void evict(size_t max_size);
+
+public:
+	explicit SurfaceCache(size_t max_size = 0);
+
+	//! Key of the surface rendered by \a task, key with zero hash if the task can't be hashed
+	static Key get_key(const Task &task, const VectorInt &surface_size);
+	static size_t get_surface_size(const SurfaceResource::Handle &surface);
+
+	//! Limit of memory used by surfaces in bytes, zero disables the cache
+	void set_max_size(size_t max_size);
+	size_t get_max_size() const;
+	bool is_enabled() const
+		{ return get_max_size() > 0; }
+
+	//! Returns cached surface or null handle, counts hits and misses
+	SurfaceResource::Handle get(const Key &key);
+	//! Returns true if \a key was already requested and should be cached now
+	bool admit(const Key &key);
+	//! Adds rendered surface, less recently used surfaces are evicted to fit the limit
+	void put(const Key &key, const SurfaceResource::Handle &surface);
+	void put(const EntryList &list);
+
+	void clear();
+	Stats get_stats() const;
+	void reset_stats();
+};
+
+} /* end namespace rendering */
+} /* end namespace synfig */
+
+/* -- E N D ----------------------------------------------------------------- */
+
+#endif
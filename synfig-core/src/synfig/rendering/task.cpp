@@ -66,6 +66,19 @@ SYNFIG_EXPORT Task::Token TaskEvent::token(
 	DescSpecial<TaskEvent>("Event") );
 
 
+// TaskHash
+
+void
+TaskHash::add_data(const void *data, size_t size)
+{
+	const unsigned char *c = (const unsigned char*)data;
+	if (key)
+		key->append((const char*)c, size);
+	for(const unsigned char *end = c + size; c != end; ++c)
+		value = (value ^ *c)*1099511628211ull;
+}
+
+
 // Task
 
 void Task::Token::unprepare_vfunc()
@@ -182,6 +195,51 @@ Task::clone_recursive() const
 	return task;
 }
 
+TaskHash::Type
+Task::get_hash() const
+{
+	TaskHash hash;
+	if (!add_to_hash(hash))
+		return 0;
+	return hash.get() ? hash.get() : 1;
+}
+
+TaskHash::Type
+Task::get_hash(std::string &key) const
+{
+	key.clear();
+	TaskHash hash(&key);
+	if (!add_to_hash(hash))
+		{ key.clear(); return 0; }
+	return hash.get() ? hash.get() : 1;
+}
+
+bool
+Task::add_to_hash(TaskHash &hash) const
+{
+	// all of the variable-length data is prefixed by the size,
+	// so different tasks never produce the same data
+	const String &name = get_token()->name;
+	hash.add(name.size());
+	hash.add_data(name.c_str(), name.size());
+	hash.add(source_rect);
+	hash.add(target_rect);
+	if (!hash_params(hash))
+		return false;
+
+	hash.add(sub_tasks.size());
+	for(List::const_iterator i = sub_tasks.begin(); i != sub_tasks.end(); ++i) {
+		hash.add(bool(*i));
+		if (*i && !(*i)->add_to_hash(hash))
+			return false;
+	}
+	return true;
+}
+
+bool
+Task::hash_params(TaskHash&) const
+	{ return false; }
+
 Vector
 Task::get_pixels_per_unit() const
 {
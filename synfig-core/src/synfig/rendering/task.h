@@ -35,6 +35,10 @@
 #include <map>
 #include <atomic>
 #include <condition_variable>
+#include <mutex>
+#include <cstdint>
+#include <string>
+#include <type_traits>
 
 #include <synfig/rect.h>
 #include <synfig/vector.h>
@@ -127,6 +131,45 @@ public:
 typedef std::vector<ModeToken::Handle> ModeList;
 
 
+// TaskHash
+
+//! Accumulates the structural hash of tasks, see Task::get_hash()
+class TaskHash
+{
+public:
+	typedef std::uint64_t Type;
+
+private:
+	Type value;
+	//! when set, all of the hashed data is collected here,
+	//! so equal hashes can be verified by comparison of the data
+	std::string *key;
+
+public:
+	explicit TaskHash(std::string *key = nullptr): value(14695981039346656037ull), key(key) { }
+
+	Type get() const
+		{ return value; }
+
+	//! FNV-1a over raw bytes, \a data should not contain padding
+	void add_data(const void *data, size_t size);
+
+	template<typename T>
+	void add(const T &x) {
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "only plain values may be hashed as raw data");
+		add_data(&x, sizeof(x));
+	}
+	void add(const Vector &x)
+		{ add(x[0]); add(x[1]); }
+	void add(const VectorInt &x)
+		{ add(x[0]); add(x[1]); }
+	void add(const Rect &x)
+		{ add(x.minx); add(x.miny); add(x.maxx); add(x.maxy); }
+	void add(const RectInt &x)
+		{ add(x.minx); add(x.miny); add(x.maxx); add(x.maxy); }
+};
+
+
 // Task
 
 
@@ -295,7 +338,29 @@ public:
 		RunParams params;
 		bool success;
 
-		RendererData(): batch_index(), index(), success() { }
+		//! count of deps which are not done yet, see RenderQueue
+		std::atomic<int> deps_count;
+		std::atomic<bool> cancelled;
+		//! protects deps and back_deps while task is in RenderQueue
+		std::mutex deps_mutex;
+
+		RendererData(): batch_index(), index(), success(), deps_count(), cancelled() { }
+		RendererData(const RendererData &other):
+			batch_index(), index(), success(), deps_count(), cancelled()
+			{ *this = other; }
+
+		// counters and mutex are not copied, they belong to the queued task
+		RendererData& operator=(const RendererData &other) {
+			batch_index   = other.batch_index;
+			index         = other.index;
+			deps          = other.deps;
+			back_deps     = other.back_deps;
+			tmp_deps      = other.tmp_deps;
+			tmp_back_deps = other.tmp_back_deps;
+			params        = other.params;
+			success       = other.success;
+			return *this;
+		}
 	};
 
 	class LockReadBase: public SurfaceResource::LockReadBase
@@ -424,6 +489,15 @@ public:
 	Task::Handle clone() const;
 	Task::Handle clone_recursive() const;
 
+	//! Structural hash of the task: type, coordinates, parameters and sub-tasks.
+	//! Target surfaces are not included. Returns zero if task or any of its sub-tasks
+	//! can not be described by hash, see hash_params().
+	TaskHash::Type get_hash() const;
+	//! The same as get_hash(), and \a key receives all of the hashed data
+	TaskHash::Type get_hash(std::string &key) const;
+	//! Adds the task and its sub-tasks into \a hash, returns false if it is not possible
+	bool add_to_hash(TaskHash &hash) const;
+
 	virtual Rect calc_bounds() const;
 	void reset_bounds()
 		{ bounds_calculated = false; }
@@ -472,6 +546,17 @@ public:
 	void set_coords_zero();
 	virtual void set_coords_sub_tasks();
 	virtual bool run(RunParams &params) const;
+
+protected:
+	//! Adds all of the parameters which affect the result of the task into the \a hash.
+	//! Tasks which are not able to do it should return false (default behavior).
+	virtual bool hash_params(TaskHash &hash) const;
+
+	//! Returns true if the task is an instance of \a task_token, or one of its
+	//! specializations (like software implementation), which have no own parameters.
+	//! Used by hash_params() to avoid hashing of unknown descendant tasks.
+	bool is_hashable_as(const Token &task_token) const
+		{ return get_token() == task_token.handle() || get_token()->abstract_task == task_token.handle(); }
 };
 
 
@@ -492,6 +577,25 @@ class TaskInterfaceSplit
 public:
 	virtual bool is_splittable() const
 		{ return true; }
+	//! Called by OptimizerSplit for the private copy of the task before it will be cloned
+	//! into the given count of parts, so the parts may share the data prepared for
+	//! the whole target rect
+	virtual void on_split(int)
+		{ }
+
+	// Cost model of the task for OptimizerSplit (see CostModel), in units of simple
+	// processing of one pixel: each part costs get_split_part_cost() plus
+	// get_split_pixel_cost() for each pixel of its target rect
+
+	virtual Real get_split_pixel_cost() const
+		{ return 1.0; }
+	//! Work which each part repeats regardless of its size (walk of the whole contour, for example)
+	virtual Real get_split_part_cost() const
+		{ return 0.0; }
+	//! Parts which process the whole rows are better than 2D tiles
+	virtual bool is_split_by_rows() const
+		{ return false; }
+
 	virtual ~TaskInterfaceSplit() { }
 };
 
@@ -571,6 +675,10 @@ public:
 	virtual bool run(RunParams&) const
 		{ return true; }
 	static VectorInt calc_target_offset(const Task &a, const Task &b);
+
+protected:
+	virtual bool hash_params(TaskHash&) const
+		{ return is_hashable_as(token); }
 };
 
 //! Significant task for RenderQueue.
@@ -30,6 +30,8 @@
 # include <config.h>
 #endif
 
+#include <algorithm>
+
 #include "target.h"
 #include "string.h"
 #include "canvas.h"
@@ -115,6 +117,29 @@ Target::get_filename() const
 	return {};
 }
 
+filesystem::Path
+Target::get_frame_filename(int) const
+{
+	return get_filename();
+}
+
+int
+Target::get_frame_count() const
+{
+	if (!frame_list_.empty())
+		return (int)frame_list_.size();
+	return std::max(1, desc.get_frame_end() - desc.get_frame_start() + 1);
+}
+
+int
+Target::get_frame() const
+{
+	const int index = std::max(0, curr_frame_ - 1);
+	if (frame_list_.empty())
+		return desc.get_frame_start() + index;
+	return frame_list_[std::min(index, (int)frame_list_.size() - 1)];
+}
+
 Target::Handle
 Target::create(const String& name, const filesystem::Path& filename,
 			   const synfig::TargetParam& params)
@@ -149,13 +174,18 @@ Target::next_frame(Time& time)
 	total_frames=frame_end-frame_start+(exclude_last_frame?0:1);
 	if(total_frames<=0)total_frames=1;
 
+	// index of the frame in the whole range
+	int index = curr_frame_;
+	if (!frame_list_.empty())
+		index = frame_list_[std::min(curr_frame_, (int)frame_list_.size() - 1)] - frame_start;
+
 	if(total_frames == 1)
 	{
 		time=time_start;
 	}
 	else
 	{
-		time=(time_end-time_start)*curr_frame_/(total_frames-(exclude_last_frame?0:1))+time_start;
+		time=(time_end-time_start)*index/(total_frames-(exclude_last_frame?0:1))+time_start;
 	}
 
 //	synfig::info("before curr_frame_: %d",curr_frame_);
@@ -168,6 +198,6 @@ Target::next_frame(Time& time)
 //	synfig::info("time: %s",time.get_string().c_str());
 //	synfig::info("remaining frames %d", total_frames-curr_frame_);
 
-	return total_frames- curr_frame_;
+	return get_frame_count() - curr_frame_;
 }
 
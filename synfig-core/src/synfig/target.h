@@ -34,6 +34,7 @@
 
 #include <map>
 #include <utility>
+#include <vector>
 
 #include <sigc++/signal.h>
 
@@ -109,6 +110,7 @@ public:
 private:
 
 	sigc::signal<void> signal_progress_;
+	sigc::signal<void, int> signal_frame_done_;
 
 	/*
  -- ** -- S I G N A L   I N T E R F A C E -------------------------------------
@@ -118,6 +120,9 @@ public:
 
 	sigc::signal<void>& signal_progress() { return signal_progress_; }
 
+	//! Emitted with the number of frame when the frame was passed to the target by render()
+	sigc::signal<void, int>& signal_frame_done() { return signal_frame_done_; }
+
 	/*
  --	** -- C O N S T R U C T O R S ---------------------------------------------
 	*/
@@ -177,6 +182,12 @@ public:
 	//! The current frame being rendered
 	int curr_frame_;
 
+	//! Frames to render in this order, all frames of the range of \a desc if it is empty
+	/*!
+	 ** \sa set_frame_list()
+	 */
+	std::vector<int> frame_list_;
+
 protected:
 	//! Default constructor
 	Target();
@@ -228,6 +239,27 @@ public:
 	 */
 	virtual filesystem::Path get_filename() const;
 
+	/**
+	 * The file path of the given frame.
+	 *
+	 * Targets which write each frame into a separate file return the name of the file of \a frame,
+	 * others return get_filename().
+	 */
+	virtual filesystem::Path get_frame_filename(int frame) const;
+
+	//! Renders only the \a frames of the range of the render description, in the given order
+	/*! Empty list means all frames of the range
+	 */
+	void set_frame_list(const std::vector<int> &frames) { frame_list_ = frames; }
+	//! Gets the frames to render, empty list means all frames
+	const std::vector<int>& get_frame_list()const { return frame_list_; }
+	//! Gets the count of frames to render
+	int get_frame_count()const;
+	//! Gets the number of the frame chosen by the last call of next_frame()
+	/*! Before the first call it is the first frame to render
+	 */
+	int get_frame()const;
+
 	//! Renders the canvas to the target
 	virtual bool render(ProgressCallback* cb = nullptr) = 0;
 	//! Initialization tasks of the derived target.
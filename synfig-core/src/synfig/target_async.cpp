@@ -0,0 +1,237 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file target_async.cpp
+**	\brief Target which encodes frames of image sequence in background threads
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+
+#include "target_async.h"
+
+#include "canvas.h"
+#include "general.h"
+#include "localization.h"
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+Target_Async::Target_Async(const Factory &factory, int encoders):
+	factory(factory),
+	target(factory()),
+	encoders(std::max(1, encoders)),
+	stopping(),
+	failed()
+{ }
+
+Target_Async::~Target_Async()
+	{ stop_threads(); }
+
+void
+Target_Async::set_canvas(Canvas::Handle c)
+{
+	if (target)
+		target->set_canvas(c);
+	Target_Scanline::set_canvas(c);
+}
+
+bool
+Target_Async::set_rend_desc(RendDesc *d)
+{
+	desc = *d;
+	return !target || target->set_rend_desc(d);
+}
+
+bool
+Target_Async::init(ProgressCallback *cb)
+{
+	if (!target || !target->init(cb))
+		return false;
+	failed = false;
+	start_threads();
+	return true;
+}
+
+bool
+Target_Async::is_multiple_files() const
+	{ return target && target->is_multiple_files(); }
+
+filesystem::Path
+Target_Async::get_filename() const
+	{ return target ? target->get_filename() : filesystem::Path(); }
+
+filesystem::Path
+Target_Async::get_frame_filename(int frame) const
+	{ return target ? target->get_frame_filename(frame) : filesystem::Path(); }
+
+bool
+Target_Async::render(ProgressCallback *cb)
+{
+	bool success = Target_Scanline::render(cb);
+	if (!stop_threads())
+	{
+		if (cb) cb->error(_("Unable to write some frames"));
+		success = false;
+	}
+	report();
+	return success;
+}
+
+bool
+Target_Async::start_frame(ProgressCallback*)
+{
+	report();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (failed)
+			return false;
+	}
+
+	const int frame_number = get_frame();
+	frame.reset(new Frame());
+	frame->number = frame_number;
+	frame->target = factory();
+	if (!frame->target)
+		return false;
+
+	// the target keeps the range of the whole sequence to name the file in the same way,
+	// but it writes only this frame
+	RendDesc frame_desc = desc;
+	frame->target->set_canvas(canvas);
+	if (!frame->target->set_rend_desc(&frame_desc))
+		return false;
+	frame->target->set_frame_list(std::vector<int>(1, frame_number));
+
+	frame->surface.set_wh(desc.get_w(), desc.get_h());
+	return true;
+}
+
+Color*
+Target_Async::start_scanline(int scanline)
+	{ return frame ? frame->surface[scanline] : nullptr; }
+
+bool
+Target_Async::end_scanline()
+	{ return true; }
+
+void
+Target_Async::end_frame()
+{
+	if (!frame)
+		return;
+
+	// wait for the free encoder, so count of frames in memory is limited
+	std::unique_lock<std::mutex> lock(mutex);
+	queue.push_back(std::move(frame));
+	cond.notify_all();
+	cond.wait(lock, [this] { return queue.empty() || threads.empty(); });
+}
+
+void
+Target_Async::start_threads()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stopping = false;
+	while((int)threads.size() < encoders)
+		threads.push_back(std::thread(&Target_Async::worker, this));
+}
+
+bool
+Target_Async::stop_threads()
+{
+	std::vector<std::thread> stopped;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		stopped.swap(threads);
+		cond.notify_all();
+	}
+	// encoders write all queued frames before exit
+	for(std::thread &thread : stopped)
+		thread.join();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	return !failed;
+}
+
+void
+Target_Async::worker()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true)
+	{
+		cond.wait(lock, [this] { return stopping || !queue.empty(); });
+		if (queue.empty())
+			break;
+
+		std::unique_ptr<Frame> f = std::move(queue.front());
+		queue.pop_front();
+		cond.notify_all();
+		lock.unlock();
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		bool success = f->target->init() && f->target->add_frame(&f->surface, nullptr);
+		if (!success)
+			synfig::error(_("Unable to write frame %d"), f->number);
+		const int number = f->number;
+		f.reset();
+		std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+
+		lock.lock();
+		encoded.push_back(Encoded{number, duration.count(), success});
+		if (!success)
+			failed = true;
+		cond.notify_all();
+	}
+}
+
+void
+Target_Async::report()
+{
+	std::vector<Encoded> list;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		list.swap(encoded);
+	}
+	for(const Encoded &e : list)
+		if (e.success)
+			signal_frame_encoded_(e.number, e.milliseconds);
+}
@@ -0,0 +1,135 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file target_async.h
+**	\brief Target which encodes frames of image sequence in background threads
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_TARGET_ASYNC_H
+#define __SYNFIG_TARGET_ASYNC_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "surface.h"
+#include "target_scanline.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+/*!	\class Target_Async
+**	\brief Passes rendered frames of image sequence to encoder threads,
+**	so frame N is encoded while frame N+1 is rendering.
+**
+**	Each frame is written by its own target created by the factory,
+**	so several frames may be encoded simultaneously.
+**	The created target gets the range of the whole sequence and the only frame
+**	in its frame list, so the file is named in the same way
+**	as if the whole sequence was written by one target.
+*/
+class Target_Async : public Target_Scanline
+{
+public:
+	typedef etl::handle<Target_Async> Handle;
+
+	//! Creates the target with the settings of sequence,
+	//! it is called from the thread of rendering only
+	typedef std::function<Target_Scanline::Handle()> Factory;
+
+private:
+	struct Frame
+	{
+		int number;
+		Target_Scanline::Handle target;
+		Surface surface;
+		Frame(): number() { }
+	};
+
+	struct Encoded
+	{
+		int number;
+		double milliseconds;
+		bool success;
+	};
+
+	Factory factory;
+	//! target of the whole sequence, it is not used for writing
+	Target_Scanline::Handle target;
+	int encoders;
+
+	std::unique_ptr<Frame> frame;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<std::unique_ptr<Frame> > queue;
+	std::vector<Encoded> encoded;
+	std::vector<std::thread> threads;
+	bool stopping;
+	bool failed;
+
+	sigc::signal<void, int, double> signal_frame_encoded_;
+
+	void worker();
+	void start_threads();
+	//! Waits for frames in queue and stops encoder threads, returns false if some frame was not written
+	bool stop_threads();
+	//! Emits signal_frame_encoded() for the frames finished since the previous call
+	void report();
+
+public:
+	//! \param encoders count of encoder threads
+	Target_Async(const Factory &factory, int encoders);
+	virtual ~Target_Async();
+
+	//! Emitted from the thread of rendering with frame number and time of encoding in milliseconds
+	sigc::signal<void, int, double>& signal_frame_encoded() { return signal_frame_encoded_; }
+
+	bool render(ProgressCallback *cb = nullptr) override;
+	bool start_frame(ProgressCallback *cb = nullptr) override;
+	void end_frame() override;
+	Color* start_scanline(int scanline) override;
+	bool end_scanline() override;
+
+	void set_canvas(Canvas::Handle c) override;
+	bool set_rend_desc(RendDesc *d) override;
+	bool init(ProgressCallback *cb = nullptr) override;
+	bool is_multiple_files() const override;
+	filesystem::Path get_filename() const override;
+	filesystem::Path get_frame_filename(int frame) const override;
+}; // END of class Target_Async
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
@@ -87,15 +87,26 @@ Target_Multi::init(ProgressCallback*)
 	return a->init() && b->init();
 }
 
+void
+Target_Multi::sync_frame()
+{
+	// targets may name files by the number of frame
+	a->set_frame_list(frame_list_);
+	b->set_frame_list(frame_list_);
+	a->curr_frame_ = b->curr_frame_ = curr_frame_;
+}
+
 bool
 Target_Multi::add_frame(const synfig::Surface *surface, ProgressCallback *cb)
 {
+	sync_frame();
 	return a->add_frame(surface, cb) && b->add_frame(surface, cb);
 }
 
 bool
 Target_Multi::start_frame(ProgressCallback *cb)
 {
+	sync_frame();
 	return a->start_frame(cb) && b->start_frame(cb);
 }
 
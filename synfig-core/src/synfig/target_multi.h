@@ -49,6 +49,9 @@ class Target_Multi : public Target_Scanline
 	Target_Scanline::Handle a,b;
 	Color *buffer_a;
 	Color *buffer_b;
+
+	//! Passes the frame being rendered to the both targets
+	void sync_frame();
 public:
 
 	Target_Multi(Target_Scanline::Handle a,Target_Scanline::Handle b);
@@ -36,6 +36,8 @@
 
 #include "target_scanline.h"
 
+#include <deque>
+
 #include "general.h"
 #include <synfig/localization.h>
 
@@ -46,6 +48,7 @@
 #include "rendering/renderer.h"
 #include "rendering/surface.h"
 #include "rendering/software/surfacesw.h"
+#include "rendering/common/task/tasklayer.h"
 #include "rendering/common/task/tasktransformation.h"
 
 #endif
@@ -63,15 +66,47 @@ using namespace rendering;
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+//! Frame enqueued to the render queue, but not yet passed to the target
+struct PendingFrame
+{
+	int curr_frame;
+	SurfaceResource::Handle surface;
+	TaskEvent::Handle event;
+
+	PendingFrame(): curr_frame() { }
+};
+
+//! TaskLayer renders the legacy layer, which reads the canvas while task is running
+bool
+depends_on_canvas(const Task::Handle &task)
+{
+	if (!task)
+		return false;
+	if (task.type_is<TaskLayer>())
+		return true;
+	for(Task::List::const_iterator i = task->sub_tasks.begin(); i != task->sub_tasks.end(); ++i)
+		if (depends_on_canvas(*i))
+			return true;
+	return false;
+}
+
+} // end of anonymous namespace
+
 /* === M E T H O D S ======================================================= */
 
 Target_Scanline::Target_Scanline()
 	: threads_(2),
-	  pixel_rendering_limit_(DEFAULT_PIXEL_RENDERING_LIMIT)
+	  pixel_rendering_limit_(DEFAULT_PIXEL_RENDERING_LIMIT),
+	  frames_in_flight_(1),
+	  frame_failed_(false)
 {
 	curr_frame_=0;
 	if (const char *s = getenv("SYNFIG_TARGET_DEFAULT_ENGINE"))
 		set_engine(s);
+	if (const char *s = getenv("SYNFIG_TARGET_FRAMES_IN_FLIGHT"))
+		set_frames_in_flight(atoi(s));
 }
 
 int
@@ -80,8 +115,8 @@ Target_Scanline::next_frame(Time& time)
 	return Target::next_frame(time);
 }
 
-bool
-synfig::Target_Scanline::call_renderer(
+rendering::Task::Handle
+synfig::Target_Scanline::build_frame_task(
 	const etl::handle<rendering::SurfaceResource> &surface,
 	Canvas &canvas,
 	const ContextParams &context_params,
@@ -89,6 +124,35 @@ synfig::Target_Scanline::call_renderer(
 {
 	surface->create(renddesc.get_w(), renddesc.get_h());
 	rendering::Task::Handle task = canvas.build_rendering_task(context_params);
+	if (!task)
+		return task;
+
+	Vector p0 = renddesc.get_tl();
+	Vector p1 = renddesc.get_br();
+	if (p0[0] > p1[0] || p0[1] > p1[1]) {
+		Matrix m;
+		if (p0[0] > p1[0]) { m.m00 = -1.0; m.m20 = p0[0] + p1[0]; std::swap(p0[0], p1[0]); }
+		if (p0[1] > p1[1]) { m.m11 = -1.0; m.m21 = p0[1] + p1[1]; std::swap(p0[1], p1[1]); }
+		TaskTransformationAffine::Handle t = new TaskTransformationAffine();
+		t->transformation->matrix = m;
+		t->sub_task() = task;
+		task = t;
+	}
+
+	task->target_surface = surface;
+	task->target_rect = RectInt( VectorInt(), surface->get_size() );
+	task->source_rect = Rect(p0, p1);
+	return task;
+}
+
+bool
+synfig::Target_Scanline::call_renderer(
+	const etl::handle<rendering::SurfaceResource> &surface,
+	Canvas &canvas,
+	const ContextParams &context_params,
+	const RendDesc &renddesc )
+{
+	rendering::Task::Handle task = build_frame_task(surface, canvas, context_params, renddesc);
 
 	if (task)
 	{
@@ -96,22 +160,6 @@ synfig::Target_Scanline::call_renderer(
 		if (!renderer)
 			throw strprintf(_("Renderer '%s' not found"), get_engine().c_str());
 
-		Vector p0 = renddesc.get_tl();
-		Vector p1 = renddesc.get_br();
-		if (p0[0] > p1[0] || p0[1] > p1[1]) {
-			Matrix m;
-			if (p0[0] > p1[0]) { m.m00 = -1.0; m.m20 = p0[0] + p1[0]; std::swap(p0[0], p1[0]); }
-			if (p0[1] > p1[1]) { m.m11 = -1.0; m.m21 = p0[1] + p1[1]; std::swap(p0[1], p1[1]); }
-			TaskTransformationAffine::Handle t = new TaskTransformationAffine();
-			t->transformation->matrix = m;
-			t->sub_task() = task;
-			task = t;
-		}
-
-		task->target_surface = surface;
-		task->target_rect = RectInt( VectorInt(), surface->get_size() );
-		task->source_rect = Rect(p0, p1);
-
 		rendering::Task::List list;
 		list.push_back(task);
 		renderer->run(list);
@@ -119,6 +167,108 @@ synfig::Target_Scanline::call_renderer(
 	return true;
 }
 
+bool
+synfig::Target_Scanline::render_frames_in_flight(
+	const ContextParams &context_params,
+	int total_frames,
+	ProgressCallback *cb )
+{
+	rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(get_engine());
+	if (!renderer)
+		throw strprintf(_("Renderer '%s' not found"), get_engine().c_str());
+
+	// Task tree of the frame does not depend on the canvas after it was built
+	// (except of legacy TaskLayer), so the next frame may be evaluated while previous frames are rendering.
+	// The queue keeps frames in the order of enqueueing, so target receives them sequentially.
+	std::deque<PendingFrame> pending;
+	bool success = true;
+	int done_frames = 0;
+	// the last enqueued frame must be finished before the canvas will be changed
+	bool wait_all = false;
+
+	try {
+		Time t = 0;
+		int frames = 0;
+		do{
+			frames=next_frame(t);
+
+			// progress is the count of frames passed to the target
+			if(cb && !cb->amount_complete(done_frames,total_frames))
+				{ success = false; break; }
+
+			if(!get_avoid_time_sync() || canvas->get_time()!=t) {
+				canvas->set_time(t);
+				canvas->load_resources(t);
+			}
+			canvas->set_outline_grow(desc.get_outline_grow());
+
+			PendingFrame frame;
+			frame.curr_frame = curr_frame_;
+			frame.surface = new SurfaceResource();
+			frame.event = new TaskEvent();
+			if (Task::Handle task = build_frame_task(frame.surface, *canvas, context_params, desc)) {
+				wait_all = depends_on_canvas(task);
+				renderer->enqueue(task, frame.event);
+			} else {
+				wait_all = false;
+				frame.event->finish(true);
+			}
+			pending.push_back(frame);
+
+			// pass finished frames to the target, wait for the oldest one if queue is full
+			while(success && !pending.empty() && (!frames || wait_all || (int)pending.size() >= frames_in_flight_))
+			{
+				const PendingFrame &front = pending.front();
+				front.event->wait();
+
+				// target may use the frame counter in start_frame()
+				const int next_curr_frame = curr_frame_;
+				curr_frame_ = front.curr_frame;
+
+				if (!front.event->is_done())
+				{
+					if(cb)cb->error(_("Accelerated Renderer Failure"));
+					success = false;
+				}
+				else
+				{
+					SurfaceResource::LockRead<SurfaceSW> lock(front.surface);
+					if(!lock)
+					{
+						if(cb)cb->error(_("Bad surface"));
+						success = false;
+					}
+					else
+					if(!add_frame(&lock->get_surface(), cb))
+					{
+						if(cb)cb->error(_("Unable to put surface on target"));
+						success = false;
+					}
+					else
+						signal_frame_done()(get_frame());
+				}
+
+				curr_frame_ = next_curr_frame;
+				pending.pop_front();
+
+				if (success && cb && !cb->amount_complete(++done_frames,total_frames))
+					success = false;
+			}
+		} while(frames && success);
+	}
+	catch(...)
+	{
+		for(std::deque<PendingFrame>::const_iterator i = pending.begin(); i != pending.end(); ++i)
+			Renderer::cancel(i->event);
+		throw;
+	}
+
+	// frames which are still in queue are not needed anymore
+	for(std::deque<PendingFrame>::const_iterator i = pending.begin(); i != pending.end(); ++i)
+		Renderer::cancel(i->event);
+	return success;
+}
+
 bool
 synfig::Target_Scanline::render(ProgressCallback *cb)
 {
@@ -130,13 +280,10 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 		return false;
 	}
 
-	const int frame_start = desc.get_frame_start();
-	const int frame_end = desc.get_frame_end();
-
 	ContextParams context_params(desc.get_render_excluded_contexts());
 
 	// Calculate the number of frames
-	const int total_frames = frame_end >= frame_start ? (frame_end - frame_start + 1) : 1;
+	const int total_frames = get_frame_count();
 
 	// Stuff related to render split if image is too large
 	const int total_pixels = desc.get_w() * desc.get_h();
@@ -146,6 +293,28 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 	const int rows = 1 + desc.get_h() / rowheight;
 	const int lastrowheight = desc.get_h() - (rows - 1) * rowheight;
 
+	if (!is_rendering_split && frames_in_flight_ > 1 && total_frames > 1)
+	{
+		try {
+			return render_frames_in_flight(context_params, total_frames, cb);
+		}
+		catch(const String& str)
+		{
+			if (cb) cb->error(_("Caught string: ")+str);
+			return false;
+		}
+		catch (std::bad_alloc&)
+		{
+			if (cb) cb->error(_("Ran out of memory (Probably a bug)"));
+			return false;
+		}
+		catch (...)
+		{
+			if(cb)cb->error(_("Caught unknown error, rethrowing..."));
+			throw;
+		}
+	}
+
 	try {
 		Time t = 0;
 		int frames = 0;
@@ -173,6 +342,7 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 								 rows-1, rowheight, lastrowheight);
 
 					// loop through all the full rows
+					frame_failed_ = false;
 					if(!start_frame())
 					{
 //						throw(string("render(): target panic on start_frame()"));
@@ -220,6 +390,12 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 					surface->reset();
 
 					end_frame();
+					if (frame_failed_)
+					{
+						if(cb)cb->error(_("Unable to put surface on target"));
+						return false;
+					}
+					signal_frame_done()(get_frame());
 
 				}else //use normal rendering...
 				{
@@ -246,6 +422,7 @@ synfig::Target_Scanline::render(ProgressCallback *cb)
 						if(cb)cb->error(_("Unable to put surface on target"));
 						return false;
 					}
+					signal_frame_done()(get_frame());
 				}
 			}
 		} while(frames);
@@ -273,6 +450,7 @@ Target_Scanline::add_frame(const synfig::Surface *surface, ProgressCallback *cb)
 {
 	assert(surface);
 
+	frame_failed_ = false;
 	if(!start_frame(cb))
 	{
 //		throw(string("add_frame(): target panic on start_frame()"));
@@ -283,6 +461,12 @@ Target_Scanline::add_frame(const synfig::Surface *surface, ProgressCallback *cb)
 
 	if(!process_block_alpha(*surface, surface->get_w(), surface->get_h(), 0, cb)) return false;
 	end_frame();
+	if (frame_failed_)
+	{
+		if (cb)
+			cb->error(_("add_frame(): target failed on end_frame()"));
+		return false;
+	}
 	return true;
 }
 
@@ -41,7 +41,7 @@
 
 namespace synfig {
 
-namespace rendering { class SurfaceResource; }
+namespace rendering { class SurfaceResource; class Task; }
 
 /*!	\class Target_Scanline
 **	\brief This is a Target class that implements the render function
@@ -56,12 +56,28 @@ class Target_Scanline : public Target
 
 	int pixel_rendering_limit_;
 
+	//! Number of frames which may be rendered simultaneously
+	int frames_in_flight_;
+
+	//! Set by end_frame() of the derived target if the frame was not written
+	bool frame_failed_;
+
 	bool call_renderer(
 		const etl::handle<rendering::SurfaceResource> &surface,
 		Canvas &canvas,
 		const ContextParams &context_params,
 		const RendDesc &renddesc );
 
+	bool render_frames_in_flight(
+		const ContextParams &context_params,
+		int total_frames,
+		ProgressCallback *cb );
+
+protected:
+	//! Tells that the current frame was not written,
+	//! end_frame() calls it, and then add_frame() and render() fail
+	void set_frame_failed() { frame_failed_ = true; }
+
 public:
 	typedef etl::handle<Target_Scanline> Handle;
 	typedef etl::loose_handle<Target_Scanline> LooseHandle;
@@ -72,6 +88,14 @@ public:
 	//! Renders the canvas to the target
 	virtual bool render(ProgressCallback* cb = nullptr);
 
+	//! Builds the rendering task of the current frame of \a canvas,
+	//! \a surface is created with the size of \a renddesc and becomes the target of the task
+	static etl::handle<rendering::Task> build_frame_task(
+		const etl::handle<rendering::SurfaceResource> &surface,
+		Canvas &canvas,
+		const ContextParams &context_params,
+		const RendDesc &renddesc );
+
 	//! Marks the start of a frame
 	/*! \return \c true on success, \c false upon an error.
 	**	\see end_frame(), start_scanline()
@@ -121,6 +145,19 @@ public:
 	/** Get the loose limit of pixels to render. @see set_pixel_rendering_limit() */
 	int get_pixel_rendering_limit() const { return pixel_rendering_limit_; }
 
+	/**
+	 * Sets how many frames may be rendered at the same time.
+	 *
+	 * Tasks of each frame are built sequentially (canvas time is shared),
+	 * but then they are rendered concurrently by the rendering queue.
+	 * Frames are still passed to start_frame()/end_scanline() in order.
+	 * Values less than 2 disable concurrent rendering of frames.
+	 * It's ignored when frame is split by pixel rendering limit.
+	 */
+	void set_frames_in_flight(int x) { frames_in_flight_ = x; }
+	/** Get the number of frames rendered simultaneously. @see set_frames_in_flight() */
+	int get_frames_in_flight() const { return frames_in_flight_; }
+
 	//! Puts the rendered surface onto the target.
 	bool add_frame(const synfig::Surface *surface, ProgressCallback* cb);
 private:
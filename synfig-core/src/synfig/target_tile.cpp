@@ -298,9 +298,7 @@ synfig::Target_Tile::render(ProgressCallback *cb)
 	SuperCallback super_cb;
 	int
 		frames=0,
-		total_frames,
-		frame_start,
-		frame_end;
+		total_frames;
 	Time
 		t=0;
 
@@ -312,14 +310,10 @@ synfig::Target_Tile::render(ProgressCallback *cb)
 		return false;
 	}
 
-	frame_start=desc.get_frame_start();
-	frame_end=desc.get_frame_end();
-
 	ContextParams context_params(desc.get_render_excluded_contexts());
 
 	// Calculate the number of frames
-	total_frames=frame_end-frame_start+1;
-	if(total_frames<=0)total_frames=1;
+	total_frames=get_frame_count();
 
 	try {
 
@@ -347,6 +341,7 @@ synfig::Target_Tile::render(ProgressCallback *cb)
 				if(!render_frame_(canvas, context_params, 0))
 					return false;
 				end_frame();
+				signal_frame_done()(get_frame());
 			}while(frames);
 			//synfig::info("tilerenderer: i=%d, t=%s",i,t.get_string().c_str());
 		}
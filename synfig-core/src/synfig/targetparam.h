@@ -48,12 +48,28 @@ struct TargetParam
 	 *  its own valid default settings.
 	 */
 	TargetParam (const std::string& Video_codec = "none", int Bitrate = -1):
-		video_codec(Video_codec), bitrate(Bitrate), sequence_separator("."), offset_x(0), offset_y(0),rows(0),columns(0),append(true),dir(HR)
+		video_codec(Video_codec), bitrate(Bitrate), sequence_separator("."), png_compression_level(-1), exr_tile_size(0), exr_threads(-1), exr_data_window(false), offset_x(0), offset_y(0),rows(0),columns(0),append(true),dir(HR)
 	{ }
 
 	std::string video_codec;
 	int bitrate;
+	//! Pixel format of raw frames passed to video encoder, empty for default
+	std::string pixel_format;
 	std::string sequence_separator;
+	//! zlib compression level of PNG files (0..9), -1 for default
+	int png_compression_level;
+	//! Row filters of PNG files: "none", "sub", "up", "average", "paeth" or "all", empty for default
+	std::string png_filter;
+	//! Type of channels of OpenEXR files: "half" or "float", empty for default (half)
+	std::string exr_pixel_type;
+	//! Compression of OpenEXR files: "none", "rle", "zips", "zip", "piz", "pxr24", "b44", "b44a", "dwaa" or "dwab", empty for default (zip)
+	std::string exr_compression;
+	//! Size of tiles of OpenEXR files, 0 to write scanlines
+	int exr_tile_size;
+	//! Count of threads of OpenEXR library used for compression, -1 for count of CPU cores
+	int exr_threads;
+	//! Write only bounding box of non-transparent pixels to OpenEXR files
+	bool exr_data_window;
 	//TODO: It is a spike. Need to separate this class.
 	int offset_x;
 	int offset_y;
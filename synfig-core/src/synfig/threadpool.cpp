@@ -40,9 +40,15 @@
 #include <time.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
 #include <sigc++/bind.h>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <synfig/localization.h>
 #include <synfig/general.h>
 
@@ -58,15 +64,39 @@ using namespace synfig;
 
 /* === G L O B A L S ======================================================= */
 
+namespace {
+	//! count of BusyLocks of current thread
+	thread_local int busy_locks = 0;
+	//! current thread runs IO slot
+	thread_local bool io_slot = false;
+}
+
 /* === M E T H O D S ======================================================= */
 
 ThreadPool* ThreadPool::instance_ = 0;
+std::atomic<int> ThreadPool::thread_budget(0);
+std::atomic<int> ThreadPool::busy_external_threads(0);
+std::atomic<bool> ThreadPool::pinning(false);
+
+
+// ThreadPool::BusyLock
+
+ThreadPool::BusyLock::BusyLock()
+	{ ++busy_locks; ++busy_external_threads; }
+
+ThreadPool::BusyLock::~BusyLock() {
+	--busy_external_threads;
+	--busy_locks;
+	// queued slots may wait for this place in the budget
+	if (instance_)
+		instance_->budget_released();
+}
 
 
 // ThreadPool::Group
 
-ThreadPool::Group::Group():
-	multithreading(), running_threads(0), sum_weight() { }
+ThreadPool::Group::Group(Priority priority):
+	priority(priority), multithreading(), running_threads(0), sum_weight() { }
 
 ThreadPool::Group::~Group()
 	{ run(); }
@@ -100,7 +130,7 @@ ThreadPool::Group::run(bool force_thread) {
 		if (sum >= 0.75) {
 			multithreading = true;
 			++running_threads;
-			instance().enqueue( sigc::bind( sigc::mem_fun(this, &Group::process), begin, end ));
+			instance().enqueue( sigc::bind( sigc::mem_fun(this, &Group::process), begin, end ), priority );
 			sum_weight -= sum;
 			sum = 0.0;
 			begin = end;
@@ -113,7 +143,7 @@ ThreadPool::Group::run(bool force_thread) {
 		if (force_thread) {
 			multithreading = true;
 			++running_threads;
-			instance().enqueue( sigc::bind( sigc::mem_fun(this, &Group::process), begin, end ));
+			instance().enqueue( sigc::bind( sigc::mem_fun(this, &Group::process), begin, end ), priority );
 		} else {
 			for(int i = begin; i < end; ++i)
 				tasks[i].second();
@@ -137,13 +167,15 @@ ThreadPool::Group::run(bool force_thread) {
 
 ThreadPool::ThreadPool():
 	max_running_threads(0),
+	max_io_threads(2),
 	last_thread_id(0),
 	running_threads(0),
+	running_io_threads(0),
 	ready_threads(0),
 	queue_size(0),
 	stopped(false)
 {
-	max_running_threads = std::thread::hardware_concurrency();
+	max_running_threads = get_thread_budget();
 
 	if (const char *s = getenv("SYNFIG_GENERIC_THREADS"))
 		max_running_threads = atoi(s) + 1;
@@ -185,7 +217,7 @@ ThreadPool::~ThreadPool() {
 	{
 		#ifdef DEBUG_PTHREAD_MEASURE
 		std::lock_guard<std::mutex> lock(mutex);
-		info("ThreadPool destroyed with unprocessed tasks in queue: %d", queue.size());
+		info("ThreadPool destroyed with unprocessed tasks in queue: %d", (int)queue_size);
 		#endif
 	}
 }
@@ -209,17 +241,24 @@ ThreadPool::thread_loop(int
 		Slot slot;
 		{
 			std::unique_lock<std::mutex> lock(mutex);
-			while(!stopped && (queue.empty() || running_threads > max_running_threads)) {
+			int priority = PRIORITY_COUNT;
+			while(!stopped && (priority = get_ready_priority()) == PRIORITY_COUNT) {
 				++ready_threads;
 				--running_threads;
+				// busy rendering threads notify the pool when they release the budget,
+				// see BusyLock and budget_released()
 				cond.wait(lock);
 				++running_threads;
 				--ready_threads;
 			}
 			if (stopped) break;
-			slot = queue.front();
-			queue.pop();
+			slot = queue[priority].front();
+			queue[priority].pop();
 			--queue_size;
+			// IO slot takes its own place instead of the place in the budget
+			io_slot = priority == PRIORITY_IO;
+			if (io_slot)
+				{ --running_threads; ++running_io_threads; }
 		}
 
 		#ifdef DEBUG_PTHREAD_MEASURE
@@ -237,6 +276,12 @@ ThreadPool::thread_loop(int
 
 		slot();
 
+		if (io_slot) {
+			io_slot = false;
+			++running_threads;
+			--running_io_threads;
+		}
+
 		#ifdef DEBUG_PTHREAD_MEASURE
 		clock_gettime(clock_id, &spec);
 		long long time1 = spec.tv_sec*1000000000ll + spec.tv_nsec;
@@ -256,9 +301,24 @@ ThreadPool::thread_loop(int
 	--running_threads;
 }
 
+int
+ThreadPool::get_ready_priority() const {
+	if (!queue[PRIORITY_OPTIMIZE].empty() && running_threads <= max_running_threads)
+		return PRIORITY_OPTIMIZE;
+	// the common budget is shared with the busy rendering threads
+	if (!queue[PRIORITY_RENDER].empty() && running_threads + busy_external_threads <= max_running_threads)
+		return PRIORITY_RENDER;
+	// IO doesn't wait for the budget, but has a few places only
+	if (!queue[PRIORITY_IO].empty() && running_io_threads < max_io_threads)
+		return PRIORITY_IO;
+	return PRIORITY_COUNT;
+}
+
 void
 ThreadPool::wakeup() {
-	int to_wakeup = synfig::clamp(max_running_threads - (int)running_threads, 0, (int)queue_size);
+	const int io_queue_size = (int)queue[PRIORITY_IO].size();
+	int to_wakeup = synfig::clamp(max_running_threads - (int)running_threads, 0, (int)queue_size - io_queue_size)
+	              + synfig::clamp(max_io_threads - (int)running_io_threads, 0, io_queue_size);
 	int to_create = std::max(0, to_wakeup - (int)ready_threads);
 	to_wakeup     = std::max(0, to_wakeup - to_create);
 	while(to_create-- > 0)
@@ -270,20 +330,28 @@ ThreadPool::wakeup() {
 }
 
 void
-ThreadPool::enqueue(const Slot &slot) {
+ThreadPool::budget_released() {
+	if (!queue_size)
+		return;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (get_ready_priority() != PRIORITY_COUNT)
+		wakeup();
+}
+
+void
+ThreadPool::enqueue(const Slot &slot, Priority priority) {
+	assert(priority >= 0 && priority < PRIORITY_COUNT);
 	std::lock_guard<std::mutex> lock(mutex);
 	++queue_size;
-	queue.push(slot);
+	queue[priority].push(slot);
 	wakeup();
 }
 
 
 void 
 ThreadPool::set_num_threads(int num_threads){
-	max_running_threads = std::thread::hardware_concurrency();
-	if(num_threads!=0){
-		max_running_threads = num_threads;
-	}
+	set_thread_budget(num_threads);
+	max_running_threads = get_thread_budget();
 	if (const char *s = getenv("SYNFIG_GENERIC_THREADS"))
 		max_running_threads = atoi(s) + 1;
 
@@ -292,11 +360,15 @@ ThreadPool::set_num_threads(int num_threads){
 
 void
 ThreadPool::wait(std::condition_variable &cond, std::unique_lock<std::mutex> &lock) {
-	if (--running_threads < max_running_threads)
-		if (queue_size) // wakeup or create ready thread if we have tasks in queue
-			{ std::lock_guard<std::mutex> lock(this->mutex); wakeup(); }
+	// waiting rendering thread is not busy too, so release its place in the budget,
+	// and run one of queued slots instead, if the budget allows it now
+	std::atomic<int> &counter = busy_locks ? busy_external_threads
+	                          : io_slot    ? running_io_threads
+	                          :              running_threads;
+	--counter;
+	budget_released();
 	cond.wait(lock);
-	++running_threads;
+	++counter;
 }
 
 ThreadPool&
@@ -319,3 +391,66 @@ ThreadPool::subsys_stop() {
 	instance_ = 0;
 	return true;
 }
+
+int
+ThreadPool::get_thread_budget() {
+	int count = thread_budget;
+	if (count > 0)
+		return count;
+	if (const char *s = getenv("SYNFIG_THREADS"))
+		count = atoi(s);
+	if (count <= 0)
+		count = std::thread::hardware_concurrency();
+	return std::max(1, count);
+}
+
+void
+ThreadPool::set_thread_budget(int num_threads)
+	{ thread_budget = std::max(0, num_threads); }
+
+bool
+ThreadPool::get_pinning() {
+	if (pinning)
+		return true;
+	const char *s = getenv("SYNFIG_THREADS_PINNING");
+	return s && atoi(s);
+}
+
+void
+ThreadPool::set_pinning(bool enable)
+	{ pinning = enable; }
+
+void
+ThreadPool::pin_current_thread(int
+	#ifdef __linux__
+	index
+	#endif
+) {
+	if (!get_pinning())
+		return;
+	#ifdef __linux__
+	// only the cores allowed for the process (taskset, cgroups) are used,
+	// threads are distributed over them in the order of their numbers
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed))
+		return;
+	int count = CPU_COUNT(&allowed);
+	if (count <= 0)
+		return;
+
+	int nth = index % count;
+	int core = 0;
+	for(; core < CPU_SETSIZE; ++core)
+		if (CPU_ISSET(core, &allowed) && !nth--)
+			break;
+	if (core >= CPU_SETSIZE)
+		return;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+		warning("ThreadPool: cannot bind thread to core %d", core);
+	#endif
+}
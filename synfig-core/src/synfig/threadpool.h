@@ -52,12 +52,32 @@ class ThreadPool {
 public:
 	typedef sigc::slot<void> Slot;
 
+	//! Classes of work, slots of the earlier classes are processed first.
+	//! OPTIMIZE and RENDER share the common budget (see get_thread_budget()),
+	//! IO has its own places out of it (see get_max_io_threads())
+	enum Priority {
+		PRIORITY_OPTIMIZE, //!< preparation of task lists, renderer waits for it, ignores busy rendering threads
+		PRIORITY_RENDER,
+		PRIORITY_IO,       //!< reading and writing of files, mostly waits for the disk or pipes,
+		                   //!< so it runs even when rendering threads take the whole budget
+		PRIORITY_COUNT
+	};
+
+	//! Counts current thread of another executor (rendering::RenderQueue) as busy
+	//! in the common thread budget while the lock exists
+	class BusyLock {
+	public:
+		BusyLock();
+		~BusyLock();
+	};
+
 	class Group {
 	public:
 	typedef std::pair<Real, Slot> Entry;
 	typedef std::vector<Entry> List;
 
 	private:
+		Priority priority;
 		bool multithreading;
 		std::atomic<int> running_threads;
 		std::mutex mutex;
@@ -68,7 +88,7 @@ public:
 
 		void process(int begin, int end);
 	public:
-		Group();
+		explicit Group(Priority priority = PRIORITY_RENDER);
 		~Group();
 
 		void enqueue(const Slot &slot, Real weight = 1.0);
@@ -79,18 +99,29 @@ private:
 	std::mutex mutex;
 	std::condition_variable cond;
 	int max_running_threads;
+	int max_io_threads;
 	int last_thread_id;
 	std::atomic<int> running_threads;
+	//! threads running IO slots, they are not counted in running_threads
+	std::atomic<int> running_io_threads;
 	std::atomic<int> ready_threads;
 	std::atomic<int> queue_size;
-	std::queue<Slot> queue;
+	std::queue<Slot> queue[PRIORITY_COUNT];
 	std::vector<std::thread*> threads;
 	bool stopped;
 
 	static ThreadPool *instance_;
 
+	static std::atomic<int> thread_budget;
+	static std::atomic<int> busy_external_threads;
+	static std::atomic<bool> pinning;
+
 	void thread_loop(int id);
 	void wakeup();
+	//! Wakes up threads if one of queued slots may run in the released place of the budget
+	void budget_released();
+	//! returns priority of the slot to run next, or PRIORITY_COUNT, mutex must be locked
+	int get_ready_priority() const;
 
 	ThreadPool();
 	ThreadPool(const ThreadPool&) = delete;
@@ -98,7 +129,7 @@ private:
 public:
 	~ThreadPool();
 
-	void enqueue(const Slot &slot);
+	void enqueue(const Slot &slot, Priority priority = PRIORITY_RENDER);
 	void wait(std::condition_variable &cond, std::unique_lock<std::mutex>& lock);
 
 	void set_num_threads(int num_threads);
@@ -107,12 +138,29 @@ public:
 		{ return max_running_threads; }
 	int get_running_threads() const
 		{ return running_threads; }
+	//! Count of IO slots which may run at the same time regardless of the common budget
+	int get_max_io_threads() const
+		{ return max_io_threads; }
 	int get_queue_size() const
 		{ return queue_size + running_threads; }
 
 	static ThreadPool& instance();
 	static bool subsys_init();
 	static bool subsys_stop();
+
+	//! Count of threads which may be busy at the same time in ThreadPool and
+	//! in rendering::RenderQueue together, 0 means count of CPU cores.
+	//! Set it before synfig::Main to use for the rendering threads too,
+	//! so --threads of the command line tool sets the count of the rendering threads
+	//! and the limit of the generic threads at once.
+	static int get_thread_budget();
+	static void set_thread_budget(int num_threads);
+
+	//! Binds rendering threads to the CPU cores allowed for the process, one core per thread
+	static bool get_pinning();
+	static void set_pinning(bool enable);
+	//! Binds current thread to the core \a index if pinning is enabled
+	static void pin_current_thread(int index);
 };
 
 }; // END of namespace synfig
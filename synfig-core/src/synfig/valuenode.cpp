@@ -42,6 +42,9 @@
 #include "canvas.h"
 #include "layer.h"
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
 
 #endif
 
@@ -51,10 +54,26 @@ using namespace synfig;
 
 /* === M A C R O S ========================================================= */
 
+// values for so many different times are kept by each node,
+// enough for the motion blur samples of a frame,
+// the least recently used value is dropped first
+#define VALUE_CACHE_MAX_SIZE 64
+
 /* === G L O B A L S ======================================================= */
 
 static int value_node_count(0);
 
+namespace {
+	std::atomic<long long> value_cache_hits(0);
+	std::atomic<long long> value_cache_misses(0);
+
+	bool value_cache_enabled_by_default()
+	{
+		static const bool enabled = getenv("SYNFIG_VALUENODE_CACHE") != nullptr;
+		return enabled;
+	}
+}
+
 /* === P R O C E D U R E S ================================================= */
 
 ValueNode::LooseHandle
@@ -71,7 +90,11 @@ ValueNode::breakpoint()
 	return;
 }
 
-ValueNode::ValueNode(Type &type):type(&type)
+ValueNode::ValueNode(Type &type):
+	type(&type),
+	value_cache_enabled_(value_cache_enabled_by_default()),
+	value_cache_version_(0),
+	value_cache_values_version_(0)
 {
 	value_node_count++;
 }
@@ -150,9 +173,109 @@ ValueNode::on_changed()
 	else if(get_root_canvas())
 		get_root_canvas()->signal_value_node_changed()(this);
 
+	// nodes which refer to this one are notified by Node::on_changed()
+	// through child_changed(), and drop their own caches in the same way
+	++value_cache_version_;
+
 	Node::on_changed();
 }
 
+void
+ValueNode::set_value_cache_enabled(bool x)
+{
+	std::lock_guard<std::mutex> lock(value_cache_mutex_);
+	value_cache_enabled_ = x;
+	value_cache_.clear();
+	value_cache_lru_.clear();
+}
+
+void
+ValueNode::invalidate_value_cache()const
+{
+	// the same as the chain of changed() signals, but without signals
+	std::set<const ValueNode*> visited;
+	std::vector<const ValueNode*> queue(1, this);
+	while(!queue.empty()) {
+		const ValueNode *node = queue.back();
+		queue.pop_back();
+		if (!visited.insert(node).second)
+			continue;
+		++node->value_cache_version_;
+		node->foreach_parent([&queue](const Node *parent) -> bool {
+			if (const ValueNode *value_node = dynamic_cast<const ValueNode*>(parent))
+				queue.push_back(value_node);
+			return false;
+		});
+	}
+}
+
+void
+ValueNode::get_value_cache_stats(long long &hits, long long &misses)
+{
+	hits = value_cache_hits;
+	misses = value_cache_misses;
+}
+
+void
+ValueNode::reset_value_cache_stats()
+{
+	value_cache_hits = 0;
+	value_cache_misses = 0;
+}
+
+bool
+ValueNode::value_cache_find(Time t, ValueBase &x, unsigned long &version)const
+{
+	version = value_cache_version_;
+	if (!value_cache_enabled_)
+		return false;
+
+	std::lock_guard<std::mutex> lock(value_cache_mutex_);
+	if (value_cache_values_version_ != version) {
+		value_cache_.clear();
+		value_cache_lru_.clear();
+		value_cache_values_version_ = version;
+	}
+
+	auto i = value_cache_.find(t);
+	if (i == value_cache_.end()) {
+		++value_cache_misses;
+		return false;
+	}
+	x = i->second.first;
+	value_cache_lru_.splice(value_cache_lru_.begin(), value_cache_lru_, i->second.second);
+	++value_cache_hits;
+	return true;
+}
+
+void
+ValueNode::value_cache_store(Time t, const ValueBase &x, unsigned long version)const
+{
+	if (!value_cache_enabled_ || version != value_cache_version_)
+		return;
+
+	std::lock_guard<std::mutex> lock(value_cache_mutex_);
+	if (value_cache_values_version_ != version) {
+		value_cache_.clear();
+		value_cache_lru_.clear();
+		value_cache_values_version_ = version;
+	}
+
+	auto i = value_cache_.find(t);
+	if (i != value_cache_.end()) {
+		i->second.first = x;
+		value_cache_lru_.splice(value_cache_lru_.begin(), value_cache_lru_, i->second.second);
+		return;
+	}
+
+	if (value_cache_.size() >= VALUE_CACHE_MAX_SIZE) {
+		value_cache_.erase(value_cache_lru_.back());
+		value_cache_lru_.pop_back();
+	}
+	value_cache_lru_.push_front(t);
+	value_cache_[t] = std::make_pair(x, value_cache_lru_.begin());
+}
+
 int
 ValueNode::replace(ValueNode::Handle x)
 {
@@ -33,8 +33,11 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <atomic>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 
 #include <sigc++/signal.h>
@@ -130,6 +133,17 @@ private:
 	//! The root canvas this Value Node belongs to
 	etl::loose_handle<Canvas> root_canvas_;
 
+	//! Values returned by operator(), see set_value_cache_enabled()
+	bool value_cache_enabled_;
+	mutable std::mutex value_cache_mutex_;
+	//! Incremented when this node or any of its children is changed
+	mutable std::atomic<unsigned long> value_cache_version_;
+	//! Version of the node when the cached values were evaluated
+	mutable unsigned long value_cache_values_version_;
+	//! Times of cached values, the most recently used first
+	mutable std::list<Time> value_cache_lru_;
+	mutable std::map<Time, std::pair<ValueBase, std::list<Time>::iterator> > value_cache_;
+
 	/*
  -- ** -- S I G N A L S -------------------------------------------------------
 	*/
@@ -261,7 +275,23 @@ public:
 	//! Set the default interpolation for Value Nodes
 	virtual void set_interpolation(Interpolation /* i*/) { }
 
-	// TODO: cache of values (we need to fix chain of signals 'changed' in LinkableValueNodes
+	//! Enables cache of the values returned by operator() for this node
+	/*!	Only nodes which are expensive to evaluate and referenced many times
+	**	(bones, bone influences, composites) look into the cache.
+	**	Disabled by default, unless SYNFIG_VALUENODE_CACHE is set */
+	void set_value_cache_enabled(bool x);
+	bool get_value_cache_enabled()const { return value_cache_enabled_; }
+
+	//! Drops the values cached by this node and by all the nodes which depend on it.
+	/*!	changed() drops the cache of the node itself, the parents are notified
+	**	by child_changed(). Nodes which change their value in other way
+	**	(like ValueNode_Duplicate does) should call it explicitly */
+	void invalidate_value_cache()const;
+
+	//! Returns the count of cache hits and misses since start or last reset
+	static void get_value_cache_stats(long long &hits, long long &misses);
+	static void reset_value_cache_stats();
+
 	void get_values(std::set<ValueBase> &x) const;
 	void get_value_change_times(std::set<Time> &x) const;
 	void get_values(std::map<Time, ValueBase> &x) const;
@@ -283,6 +313,13 @@ protected:
 	//! Sets the type of the ValueNode
 	void set_type(Type &t) { type=&t; }
 
+	//! Looks for the value cached for time \a t.
+	/*!	\a version receives the state of the cache, it should be passed
+	**	to value_cache_store() with the value evaluated on miss */
+	bool value_cache_find(Time t, ValueBase &x, unsigned long &version)const;
+	//! Stores the value unless the node was changed since value_cache_find()
+	void value_cache_store(Time t, const ValueBase &x, unsigned long version)const;
+
 	virtual void on_changed();
 
 	virtual void get_values_vfunc(std::map<Time, ValueBase> &x) const;
@@ -435,6 +435,18 @@ ValueNode_Bone::operator()(Time t)const
 	DEBUG_LOG("SYNFIG_DEBUG_VALUENODE_OPERATORS",
 		"%s:%d operator()\n", __FILE__, __LINE__);
 
+	ValueBase ret;
+	unsigned long version;
+	if (!value_cache_find(t, ret, version)) {
+		ret = evaluate(t);
+		value_cache_store(t, ret, version);
+	}
+	return ret;
+}
+
+ValueBase
+ValueNode_Bone::evaluate(Time t)const
+{
 //	show_bone_map(get_root_canvas(), __FILE__, __LINE__, strprintf("in op() at %s", t.get_string().c_str()), t);
 
 	String bone_name			((*name_	)(t).get(String()));
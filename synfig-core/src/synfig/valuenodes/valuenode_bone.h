@@ -53,6 +53,9 @@ class ValueNode_Bone : public LinkableValueNode
 	ValueNode::RHandle depth_;
 	ValueNode::RHandle parent_;
 
+	//! Calculates the value, operator() caches it
+	ValueBase evaluate(Time t) const;
+
 protected:
 	ValueNode_Bone();
 	ValueNode_Bone(const ValueBase &value, etl::loose_handle<Canvas> canvas = nullptr);
@@ -121,6 +121,18 @@ ValueNode_BoneInfluence::operator()(Time t)const
 	DEBUG_LOG("SYNFIG_DEBUG_VALUENODE_OPERATORS",
 		"%s:%d operator()\n", __FILE__, __LINE__);
 
+	ValueBase ret;
+	unsigned long version;
+	if (!value_cache_find(t, ret, version)) {
+		ret = evaluate(t);
+		value_cache_store(t, ret, version);
+	}
+	return ret;
+}
+
+ValueBase
+ValueNode_BoneInfluence::evaluate(Time t)const
+{
 	Matrix transform(get_transform(true, t));
 	Type &type(link_->get_type());
 	if (type == type_vector)
@@ -50,6 +50,9 @@ class ValueNode_BoneInfluence : public LinkableValueNode
 	ValueNode_BoneInfluence(Type &x);
 	ValueNode_BoneInfluence(const ValueNode::Handle &x, etl::loose_handle<Canvas> canvas);
 
+	//! Calculates the value, operator() caches it
+	ValueBase evaluate(Time t) const;
+
 public:
 	typedef etl::handle<ValueNode_BoneInfluence> Handle;
 	typedef etl::handle<const ValueNode_BoneInfluence> ConstHandle;
@@ -220,6 +220,18 @@ synfig::ValueNode_Composite::operator()(Time t)const
 	DEBUG_LOG("SYNFIG_DEBUG_VALUENODE_OPERATORS",
 		"%s:%d operator()\n", __FILE__, __LINE__);
 
+	ValueBase ret;
+	unsigned long version;
+	if (!value_cache_find(t, ret, version)) {
+		ret = evaluate(t);
+		value_cache_store(t, ret, version);
+	}
+	return ret;
+}
+
+ValueBase
+synfig::ValueNode_Composite::evaluate(Time t)const
+{
 	Type &type(get_type());
 	if (type == type_vector)
 	{
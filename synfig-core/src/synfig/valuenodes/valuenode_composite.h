@@ -46,6 +46,9 @@ class ValueNode_Composite : public LinkableValueNode
 
 	ValueNode_Composite(const ValueBase &value, etl::loose_handle<Canvas> canvas = 0);
 
+	//! Calculates the value, operator() caches it
+	ValueBase evaluate(Time t) const;
+
 public:
 	typedef etl::handle<ValueNode_Composite> Handle;
 	typedef etl::handle<const ValueNode_Composite> ConstHandle;
@@ -121,6 +121,8 @@ ValueNode_Duplicate::reset_index(Time t)const
 {
 	Real from = (*from_)(t).get(Real());
 	index = from;
+	// index is changed without changed() signal
+	invalidate_value_cache();
 }
 
 bool
@@ -134,6 +136,7 @@ ValueNode_Duplicate::step(Time t)const
 	if (step == 0) return false;
 
 	step = std::fabs(step);
+	invalidate_value_cache();
 
 	if (from < to)
 	{
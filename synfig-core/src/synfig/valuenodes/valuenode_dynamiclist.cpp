@@ -548,6 +548,7 @@ ValueNode_DynamicList::add(const ListEntry &list_entry, int index)
 
 	reindex();
 	//changed();
+	invalidate_value_cache();
 
 	if(get_parent_canvas())
 		get_parent_canvas()->signal_value_node_child_added()(this,list_entry.value_node);
@@ -590,6 +591,8 @@ ValueNode_DynamicList::erase(const ValueNode::Handle &value_node_)
 			break;
 		}
 	reindex();
+	// list is changed without changed() signal
+	invalidate_value_cache();
 }
 
 
@@ -0,0 +1,435 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/bench.cpp
+**	\brief Rendering benchmark
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __unix__
+#include <sys/utsname.h>
+#endif
+
+#include <glibmm.h>
+
+#include <synfig/canvas.h>
+#include <synfig/canvasfilenaming.h>
+#include <synfig/context.h>
+#include <synfig/loadcanvas.h>
+#include <synfig/main.h>
+#include <synfig/os.h>
+#include <synfig/target_scanline.h>
+#include <synfig/threadpool.h>
+#include <synfig/version.h>
+#include <synfig/rendering/renderer.h>
+#include <synfig/rendering/statistics.h>
+#include <synfig/rendering/software/function/blend.h>
+
+#endif
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#ifndef SYNFIG_BENCH_SCENES_DIR
+#define SYNFIG_BENCH_SCENES_DIR "bench"
+#endif
+
+#ifndef SYNFIG_BENCH_BUILD_TYPE
+#	ifdef NDEBUG
+#		define SYNFIG_BENCH_BUILD_TYPE "release"
+#	else
+#		define SYNFIG_BENCH_BUILD_TYPE "debug"
+#	endif
+#endif
+
+/* === G L O B A L S ======================================================= */
+
+//! scenes bundled with the benchmark, see SYNFIG_BENCH_SCENES_DIR
+static const char *default_scenes[] = {
+	"blend_stack.sif", //!< deep stack of layers with various blend methods
+	"outlines.sif",    //!< many outlines
+	"blur.sif",        //!< big blurs of all types
+	"bitmaps.sif",     //!< imported and rotated images
+	"text.sif",        //!< text layers
+};
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+	int repeats;
+	int warmup;
+	String renderer;
+	String output;
+	std::vector<String> scenes;
+	Options(): repeats(5), warmup(1), renderer("software") { }
+};
+
+struct SceneResult {
+	String name;
+	String error;
+	int width, height;
+	double load_ms;
+	std::vector<double> render_ms;
+	rendering::Statistics::Map statistics;
+	SceneResult(): width(), height(), load_ms() { }
+};
+
+double
+milliseconds(Clock::time_point begin)
+	{ return std::chrono::duration<double, std::milli>(Clock::now() - begin).count(); }
+
+String
+json_string(const String &s)
+{
+	String result = "\"";
+	for(char c : s) {
+		switch(c) {
+		case '"':  result += "\\\""; break;
+		case '\\': result += "\\\\"; break;
+		case '\n': result += "\\n"; break;
+		case '\t': result += "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20)
+				result += strprintf("\\u%04x", (int)(unsigned char)c);
+			else
+				result += c;
+		}
+	}
+	return result + "\"";
+}
+
+String
+get_cpu_name()
+{
+	#ifdef __linux__
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	String line;
+	while(std::getline(cpuinfo, line))
+		if (line.compare(0, 10, "model name") == 0) {
+			String::size_type pos = line.find(':');
+			if (pos != String::npos)
+				return line.substr(line.find_first_not_of(" \t", pos + 1));
+		}
+	#endif
+	return "unknown";
+}
+
+String
+get_os_name()
+{
+	#ifdef __unix__
+	struct utsname name;
+	if (uname(&name) == 0)
+		return strprintf("%s %s %s", name.sysname, name.release, name.machine);
+	#elif defined(_WIN32)
+	return "Windows";
+	#elif defined(__APPLE__)
+	return "macOS";
+	#endif
+	return "unknown";
+}
+
+String
+get_compiler_name()
+{
+	#if defined(__clang__)
+	return "clang " __clang_version__;
+	#elif defined(__GNUC__)
+	return "gcc " __VERSION__;
+	#elif defined(_MSC_VER)
+	return strprintf("msvc %d", _MSC_VER);
+	#else
+	return "unknown";
+	#endif
+}
+
+String
+get_date()
+{
+	char buffer[32] = {};
+	std::time_t t = std::time(nullptr);
+	std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&t));
+	return buffer;
+}
+
+Canvas::Handle
+load_scene(const String &filename, String &errors)
+{
+	String warnings;
+	FileSystem::Handle file_system = CanvasFileNaming::make_filesystem(filename);
+	if (!file_system) {
+		errors = "cannot open container " + filename;
+		return Canvas::Handle();
+	}
+	FileSystem::Identifier identifier = file_system->get_identifier(CanvasFileNaming::project_file(filename));
+	return open_canvas_as(identifier, filesystem::absolute(filesystem::Path(filename)).u8string(), errors, warnings);
+}
+
+bool
+render_frame(const rendering::Renderer::Handle &renderer, Canvas &canvas)
+{
+	canvas.set_time(0);
+	canvas.load_resources(0);
+	rendering::Task::Handle task;
+	{
+		rendering::Statistics::Timer timer("build task");
+		task = Target_Scanline::build_frame_task(
+			new rendering::SurfaceResource(), canvas, ContextParams(), canvas.rend_desc() );
+	}
+	if (!task)
+		return false;
+	rendering::Task::List list;
+	list.push_back(task);
+	return renderer->run(list, true);
+}
+
+SceneResult
+run_scene(const Options &options, const rendering::Renderer::Handle &renderer, const String &filename)
+{
+	SceneResult result;
+	result.name = filesystem::Path(filename).stem().u8string();
+
+	Clock::time_point begin = Clock::now();
+	Canvas::Handle canvas = load_scene(filename, result.error);
+	result.load_ms = milliseconds(begin);
+	if (!canvas) {
+		if (result.error.empty()) result.error = "cannot load " + filename;
+		return result;
+	}
+	result.width = canvas->rend_desc().get_w();
+	result.height = canvas->rend_desc().get_h();
+
+	// each frame is rendered from scratch, optimized lists and surfaces
+	// of the previous frames would turn the benchmark into a cache test
+	for(int i = 0; i < options.warmup; ++i) {
+		renderer->clear_caches();
+		render_frame(renderer, *canvas);
+	}
+
+	rendering::Statistics::reset();
+	rendering::Statistics::set_enabled(true);
+	for(int i = 0; i < options.repeats; ++i) {
+		renderer->clear_caches();
+		begin = Clock::now();
+		if (!render_frame(renderer, *canvas)) {
+			result.error = "rendering failed";
+			break;
+		}
+		result.render_ms.push_back(milliseconds(begin));
+	}
+	rendering::Statistics::set_enabled(false);
+	result.statistics = rendering::Statistics::get();
+	return result;
+}
+
+void
+write_json(std::ostream &out, const Options &options, const std::vector<SceneResult> &results)
+{
+	using rendering::software::Blend;
+
+	out << "{\n";
+	out << "  \"metadata\": {\n";
+	out << "    \"synfig_version\": " << json_string(get_version()) << ",\n";
+	out << "    \"compiler\": " << json_string(get_compiler_name()) << ",\n";
+	out << "    \"build_type\": " << json_string(SYNFIG_BENCH_BUILD_TYPE) << ",\n";
+	out << "    \"os\": " << json_string(get_os_name()) << ",\n";
+	out << "    \"cpu\": " << json_string(get_cpu_name()) << ",\n";
+	out << "    \"cpu_cores\": " << std::thread::hardware_concurrency() << ",\n";
+	out << "    \"threads\": " << ThreadPool::get_thread_budget() << ",\n";
+	out << "    \"blend_implementation\": " << json_string(Blend::get_implementation_name(Blend::get_implementation())) << ",\n";
+	out << "    \"renderer\": " << json_string(options.renderer) << ",\n";
+	out << "    \"repeats\": " << options.repeats << ",\n";
+	out << "    \"warmup\": " << options.warmup << ",\n";
+	out << "    \"date\": " << json_string(get_date()) << "\n";
+	out << "  },\n";
+	out << "  \"scenes\": [";
+
+	for(std::vector<SceneResult>::const_iterator r = results.begin(); r != results.end(); ++r) {
+		out << (r == results.begin() ? "\n" : ",\n");
+		out << "    {\n";
+		out << "      \"name\": " << json_string(r->name) << ",\n";
+		if (!r->error.empty())
+			out << "      \"error\": " << json_string(r->error) << ",\n";
+		out << "      \"width\": " << r->width << ",\n";
+		out << "      \"height\": " << r->height << ",\n";
+		out << "      \"load_ms\": " << r->load_ms << ",\n";
+
+		// all values below are per frame
+		std::vector<double> runs = r->render_ms;
+		std::sort(runs.begin(), runs.end());
+		double sum = 0.0;
+		for(double ms : runs) sum += ms;
+		const double frames = std::max<size_t>(1, runs.size());
+
+		out << "      \"render_ms\": {";
+		if (!runs.empty())
+			out << " \"min\": " << runs.front()
+				<< ", \"median\": " << runs[runs.size()/2]
+				<< ", \"mean\": " << sum/frames
+				<< ", \"max\": " << runs.back() << " ";
+		out << "},\n";
+
+		out << "      \"phases_ms\": {";
+		bool first = true;
+		for(const auto &e : r->statistics)
+			if (e.first.compare(0, 5, "task ") != 0) {
+				out << (first ? " " : ", ") << json_string(e.first) << ": " << e.second.time*1e-6/frames;
+				first = false;
+			}
+		out << (first ? "},\n" : " },\n");
+
+		out << "      \"tasks\": {";
+		first = true;
+		for(const auto &e : r->statistics)
+			if (e.first.compare(0, 5, "task ") == 0) {
+				out << (first ? "\n" : ",\n")
+					<< "        " << json_string(e.first.substr(5))
+					<< ": { \"count\": " << e.second.count/frames
+					<< ", \"ms\": " << e.second.time*1e-6/frames << " }";
+				first = false;
+			}
+		out << (first ? "}\n" : "\n      }\n");
+		out << "    }";
+	}
+
+	out << "\n  ]\n";
+	out << "}\n";
+}
+
+void
+print_usage(const char *binary)
+{
+	std::cerr
+		<< "Usage: " << binary << " [options] [scene.sif ...]\n"
+		<< "Renders the scenes (bundled ones by default) and prints timings as JSON.\n"
+		<< "\n"
+		<< "  -r, --repeats NUM    measured renders of each scene (default 5)\n"
+		<< "  -w, --warmup NUM     renders before the measurement (default 1)\n"
+		<< "  -T, --threads NUM    thread budget for rendering\n"
+		<< "      --renderer NAME  rendering engine (default software)\n"
+		<< "  -o, --output FILE    write JSON to the file instead of stdout\n";
+}
+
+bool
+parse_options(int argc, char *argv[], Options &options)
+{
+	for(int i = 1; i < argc; ++i) {
+		const String arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if ((arg == "-r" || arg == "--repeats") && has_value)
+			options.repeats = std::max(1, atoi(argv[++i]));
+		else
+		if ((arg == "-w" || arg == "--warmup") && has_value)
+			options.warmup = std::max(0, atoi(argv[++i]));
+		else
+		if ((arg == "-T" || arg == "--threads") && has_value)
+			ThreadPool::set_thread_budget(atoi(argv[++i]));
+		else
+		if (arg == "--renderer" && has_value)
+			options.renderer = argv[++i];
+		else
+		if ((arg == "-o" || arg == "--output") && has_value)
+			options.output = argv[++i];
+		else
+		if (!arg.empty() && arg[0] == '-')
+			return false;
+		else
+			options.scenes.push_back(arg);
+	}
+
+	if (options.scenes.empty())
+		for(const char *scene : default_scenes)
+			options.scenes.push_back((filesystem::Path(SYNFIG_BENCH_SCENES_DIR) / filesystem::Path(scene)).u8string());
+	return true;
+}
+
+} // end of anonymous namespace
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main(int argc, char* argv[])
+{
+	setlocale(LC_ALL, "");
+	Glib::init();
+
+	Options options;
+	if (!parse_options(argc, argv, options)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	OS::fallback_binary_path = String(argv[0]);
+	const String root_path = OS::get_binary_path().parent_path().parent_path().u8string();
+	synfig::Main synfig_main(root_path);
+
+	rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(options.renderer);
+	if (!renderer) {
+		std::cerr << "Renderer '" << options.renderer << "' not found" << std::endl;
+		return 1;
+	}
+
+	int errors = 0;
+	std::vector<SceneResult> results;
+	for(const String &scene : options.scenes) {
+		std::cerr << "rendering " << scene << std::endl;
+		results.push_back(run_scene(options, renderer, scene));
+		if (!results.back().error.empty()) {
+			std::cerr << "  " << results.back().error << std::endl;
+			++errors;
+		}
+	}
+
+	if (options.output.empty()) {
+		write_json(std::cout, options, results);
+	} else {
+		std::ofstream file(options.output.c_str());
+		write_json(file, options, results);
+		if (!file) {
+			std::cerr << "Cannot write " << options.output << std::endl;
+			return 1;
+		}
+	}
+
+	return errors ? 1 : 0;
+}
@@ -36,6 +36,8 @@ SynfigToolGeneralOptions* SynfigToolGeneralOptions::instance() {
 SynfigToolGeneralOptions::SynfigToolGeneralOptions()
 	: _verbosity(0),
 	  _threads(1),
+	  _frames_in_flight(1),
+	  _encoder_threads(0),
 	  _should_be_quiet(false),
 	  _should_print_benchmarks(false),
 	  _repeats(1)
@@ -63,6 +65,26 @@ void SynfigToolGeneralOptions::set_threads(size_t threads)
 	_threads = threads;
 }
 
+int SynfigToolGeneralOptions::get_frames_in_flight() const
+{
+	return _frames_in_flight;
+}
+
+void SynfigToolGeneralOptions::set_frames_in_flight(int frames)
+{
+	_frames_in_flight = frames;
+}
+
+int SynfigToolGeneralOptions::get_encoder_threads() const
+{
+	return _encoder_threads;
+}
+
+void SynfigToolGeneralOptions::set_encoder_threads(int threads)
+{
+	_encoder_threads = threads;
+}
+
 int SynfigToolGeneralOptions::get_verbosity() const
 {
 	return _verbosity;
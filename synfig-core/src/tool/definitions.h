@@ -98,6 +98,14 @@ public:
 
 	void set_threads(size_t threads);
 
+	int get_frames_in_flight() const;
+
+	void set_frames_in_flight(int frames);
+
+	int get_encoder_threads() const;
+
+	void set_encoder_threads(int threads);
+
 	int get_verbosity() const;
 
 	void set_verbosity(int verbosity);
@@ -119,6 +127,8 @@ private:
 	std::string _binary_path;
 	int _verbosity;
 	size_t _threads;
+	int _frames_in_flight;
+	int _encoder_threads;
 	bool _should_be_quiet,
 		 _should_print_benchmarks;
 
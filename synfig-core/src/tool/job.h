@@ -44,6 +44,17 @@ struct Job
 	synfig::Target::Handle target;
 
 	int quality;
+
+	//! Renders only frames of the shard with 1-based index (out of shard_count shards)
+	int shard_index;
+	int shard_count;
+	//! Shard takes every shard_count-th frame instead of contiguous range of frames
+	bool shard_interleaved;
+	//! Frames of image sequence which are already on disk are not rendered again
+	bool skip_existing;
+	//! File to record rendered frames and their render time
+	synfig::filesystem::Path manifest;
+
 	bool sifout;
 	bool list_canvases;
 	bool extract_alpha;
@@ -80,6 +91,10 @@ struct Job
     Job():
 		alpha_mode(synfig::TARGET_ALPHA_MODE_KEEP),
 		quality(DEFAULT_QUALITY),
+		shard_index(),
+		shard_count(),
+		shard_interleaved(),
+		skip_existing(),
 		sifout(false),
 		list_canvases(),
 		extract_alpha(false),
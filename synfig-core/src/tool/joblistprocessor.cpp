@@ -32,18 +32,25 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
 
 #include <synfig/general.h>
 #include <synfig/localization.h>
 #include <synfig/target.h>
+#include <synfig/target_async.h>
 #include <synfig/target_scanline.h>
 #include <synfig/target_tile.h>
 #include <synfig/savecanvas.h>
 #include <synfig/filesystemnative.h>
+#include <synfig/smartfile.h>
 
 #include "definitions.h"
 #include "synfigtoolexception.h"
@@ -69,8 +76,12 @@ void process_job_list(std::list<Job>& job_list, const TargetParam& target_params
 
 	for(; !job_list.empty(); job_list.pop_front())
 	{
-		if (setup_job(job_list.front(), target_params))
-			process_job(job_list.front());
+		Job& job = job_list.front();
+		if (job.shard_count > 0 || job.skip_existing || !job.manifest.empty())
+			process_job_frames(job, target_params);
+		else
+		if (setup_job(job, target_params))
+			process_job(job);
 	}
 }
 
@@ -184,6 +195,8 @@ static void set_target_engine_and_threads(Job& job)
 	{
 		scanline_target->set_threads(SynfigToolGeneralOptions::instance()->get_threads());
 		scanline_target->set_engine(job.render_engine);
+		if (SynfigToolGeneralOptions::instance()->get_frames_in_flight() > 1)
+			scanline_target->set_frames_in_flight(SynfigToolGeneralOptions::instance()->get_frames_in_flight());
 	} else if(auto tile_target = Target_Tile::Handle::cast_dynamic(job.target))
 	{
 		tile_target->set_threads(SynfigToolGeneralOptions::instance()->get_threads());
@@ -191,6 +204,44 @@ static void set_target_engine_and_threads(Job& job)
 	}
 }
 
+//! Frames of image sequence are written by background threads if it was asked
+static void set_async_encoding(Job& job, const TargetParam& target_parameters)
+{
+	const int encoders = SynfigToolGeneralOptions::instance()->get_encoder_threads();
+	if (encoders <= 0 || job.sifout || !job.target->is_multiple_files()
+	 || !Target_Scanline::Handle::cast_dynamic(job.target))
+		return;
+
+	// encoders already write several files at once, and the global thread pool
+	// of OpenEXR is shared by them, so by default it gets only the part of cores
+	TargetParam params = target_parameters;
+	if (params.exr_threads < 0)
+		params.exr_threads = std::max(1, (int)std::thread::hardware_concurrency()/encoders);
+
+	// each frame gets its own target with the same settings
+	const std::string target_name = job.target_name;
+	const filesystem::Path outfilename = job.outfilename;
+	const int quality = job.quality;
+	const TargetAlphaMode alpha_mode = job.alpha_mode;
+	Target_Async::Factory factory = [=]() {
+		Target::Handle target = Target::create(target_name, outfilename, params);
+		if (target)
+		{
+			target->set_quality(quality);
+			if (alpha_mode != TARGET_ALPHA_MODE_KEEP)
+				target->set_alpha_mode(alpha_mode);
+		}
+		return Target_Scanline::Handle::cast_dynamic(target);
+	};
+
+	VERBOSE_OUT(4) << _("Writing frames by background threads...") << std::endl;
+	// the wrapper passes colors to the frame targets as is, so its alpha mode is not changed
+	job.target = new Target_Async(factory, encoders);
+	job.target->set_canvas(job.canvas);
+	job.target->set_quality(job.quality);
+	set_target_engine_and_threads(job);
+}
+
 bool setup_job(Job& job, const TargetParam& target_parameters)
 {
 	VERBOSE_OUT(4) << _("Attempting to determine target/outfile...") << std::endl;
@@ -224,6 +275,8 @@ bool setup_job(Job& job, const TargetParam& target_parameters)
 	// Set the threads and render engine for the target
 	set_target_engine_and_threads(job);
 
+	set_async_encoding(job, target_parameters);
+
 	return true;
 }
 
@@ -289,6 +342,9 @@ void process_job (Job& job)
 	RenderProgress p;
 	p.task(job.filename.u8string() + " ==> " + job.outfilename.u8string());
 
+	if (Target_Async::Handle async_target = Target_Async::Handle::cast_dynamic(job.target))
+		async_target->signal_frame_encoded().connect(sigc::mem_fun(p, &RenderProgress::frame_encoded));
+
 	if(job.sifout)
 	{
 		save_canvas_to_file(job.outfilename.u8string(), job.canvas);
@@ -306,3 +362,134 @@ void process_job (Job& job)
 	VERBOSE_OUT(1) << _("Done.") << std::endl;
 }
 
+
+//! Frames of the shard of job, all frames if job is not sharded
+static std::vector<int> get_shard_frames(const Job& job, int frame_start, int frame_end)
+{
+	std::vector<int> frames;
+	const int total = frame_end - frame_start + 1;
+	const int count = std::max(1, job.shard_count);
+	const int index = std::max(1, job.shard_index) - 1;
+
+	if (job.shard_interleaved)
+	{
+		for(int i = index; i < total; i += count)
+			frames.push_back(frame_start + i);
+	}
+	else
+	{
+		const int begin = (int)((long long)total*index/count);
+		const int end = (int)((long long)total*(index + 1)/count);
+		for(int i = begin; i < end; ++i)
+			frames.push_back(frame_start + i);
+	}
+	return frames;
+}
+
+//! Frames recorded in the manifest, each line is "<frame>\t<render time in ms>\t<filename>"
+static std::set<int> read_manifest(const filesystem::Path& manifest)
+{
+	std::set<int> frames;
+	SmartFILE file(manifest, "r");
+	if (!file)
+		return frames;
+
+	char line[4096];
+	while(fgets(line, sizeof(line), file.get()))
+	{
+		int frame;
+		if (sscanf(line, "%d\t", &frame) == 1)
+			frames.insert(frame);
+	}
+	return frames;
+}
+
+//! Appends the frames written by the target to the manifest
+class ManifestWriter
+{
+	SmartFILE file;
+	Target::Handle target;
+	std::chrono::steady_clock::time_point last_timepoint;
+
+public:
+	ManifestWriter(const SmartFILE& file, const Target::Handle& target):
+		file(file), target(target), last_timepoint(std::chrono::steady_clock::now()) { }
+
+	//! Frames of synchronous targets take the time since the previous frame
+	void frame_done(int frame)
+	{
+		std::chrono::steady_clock::time_point timepoint = std::chrono::steady_clock::now();
+		std::chrono::duration<double, std::milli> duration = timepoint - last_timepoint;
+		last_timepoint = timepoint;
+		write(frame, duration.count());
+	}
+
+	// shards may append to the same manifest, each line is written by a single call
+	void write(int frame, double milliseconds)
+	{
+		std::string line = strprintf("%d\t%.3f\t%s\n", frame, milliseconds, target->get_frame_filename(frame).u8_str());
+		fwrite(line.c_str(), 1, line.size(), file.get());
+		fflush(file.get());
+	}
+};
+
+void process_job_frames(Job& job, const TargetParam& target_parameters)
+{
+	if (!setup_job(job, target_parameters))
+		return;
+
+	if (job.sifout || !job.target->is_multiple_files())
+		throw SynfigToolException(SYNFIGTOOL_INVALIDTARGET,
+			_("Shards, skipping of existing frames and manifest are supported only for image sequences."));
+
+	const std::vector<int> shard_frames = get_shard_frames(job,
+		job.canvas->rend_desc().get_frame_start(), job.canvas->rend_desc().get_frame_end() );
+
+	std::set<int> completed;
+	if (job.skip_existing && !job.manifest.empty())
+		completed = read_manifest(job.manifest);
+
+	// frame files are named by the target in the same way as in the whole sequence
+	std::vector<int> frames;
+	for(int frame : shard_frames)
+	{
+		const filesystem::Path filename = job.target->get_frame_filename(frame);
+		if ( job.skip_existing
+		  && FileSystemNative::instance()->is_file(filename.u8string())
+		  && (job.manifest.empty() || completed.count(frame)) )
+		{
+			VERBOSE_OUT(2) << strprintf(_("Skipping frame %d, \"%s\" exists"), frame, filename.u8_str()) << std::endl;
+			continue;
+		}
+		frames.push_back(frame);
+	}
+	if (frames.size() < shard_frames.size())
+		VERBOSE_OUT(1) << strprintf(_("Skipped %d existing frames"), (int)(shard_frames.size() - frames.size())) << std::endl;
+
+	if (frames.empty())
+	{
+		VERBOSE_OUT(1) << _("Done.") << std::endl;
+		return;
+	}
+
+	std::unique_ptr<ManifestWriter> manifest;
+	if (!job.manifest.empty())
+	{
+		SmartFILE file(job.manifest, "a");
+		if (!file)
+			throw SynfigToolException(SYNFIGTOOL_INVALIDOUTPUT,
+				strprintf(_("Unable to open manifest \"%s\": %s"), job.manifest.u8_str(), strerror(errno)));
+		manifest.reset(new ManifestWriter(file, job.target));
+
+		// frames encoded in background are recorded when they are written
+		if (Target_Async::Handle async_target = Target_Async::Handle::cast_dynamic(job.target))
+			async_target->signal_frame_encoded().connect(sigc::mem_fun(*manifest, &ManifestWriter::write));
+		else
+			job.target->signal_frame_done().connect(sigc::mem_fun(*manifest, &ManifestWriter::frame_done));
+	}
+
+	// the only target renders all frames of the shard,
+	// so frames are rendered in flight and encoded in background as for the whole sequence
+	job.target->set_frame_list(frames);
+	process_job(job);
+}
@@ -43,6 +43,10 @@ bool setup_job(Job& job, const synfig::TargetParam& target_parameters);
 /// Process an individual job
 void process_job(Job& job);
 
+/// Process a job frame by frame, rendering only the frames of its shard
+/// and skipping already rendered frames if requested
+void process_job_frames(Job& job, const synfig::TargetParam& target_parameters);
+
 std::string get_absolute_path(const std::string& relative_path);
 
 #endif // __SYNFIG_JOBLISTPROCESSOR_H
@@ -0,0 +1,426 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/jobserver.cpp
+**	\brief Synfig Tool Batch Rendering Server
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <synfig/canvasfilenaming.h>
+#include <synfig/general.h>
+#include <synfig/loadcanvas.h>
+#include <synfig/localization.h>
+#include <synfig/rendering/renderer.h>
+#include <synfig/savecanvas.h>
+#include <synfig/filesystemnative.h>
+#include <synfig/layers/layer_pastecanvas.h>
+
+#include "definitions.h"
+#include "job.h"
+#include "joblistprocessor.h"
+#include "synfigtoolexception.h"
+#include "jobserver.h"
+#include "jsonparser.h"
+
+#include <glib/gstdio.h>
+
+#endif
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double
+milliseconds_since(const Clock::time_point& start)
+	{ return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); }
+
+std::time_t
+get_mtime(const std::string& filename)
+{
+	GStatBuf buf;
+	return g_stat(filename.c_str(), &buf) ? 0 : buf.st_mtime;
+}
+
+} // end of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+/// Sends the progress of job, when percentage is changed
+class JobServer::Progress : public synfig::ProgressCallback
+{
+	JobServer& server;
+	std::string id;
+	int last_percent;
+
+public:
+	std::string last_error;
+
+	Progress(JobServer& server, const std::string& id):
+		server(server), id(id), last_percent(-1) { }
+
+	virtual bool error(const std::string& task)
+		{ last_error = task; return true; }
+
+	virtual bool amount_complete(int current, int total)
+	{
+		if (total <= 0)
+			return true;
+		int percent = (int)((long long)current*100/total);
+		if (percent != last_percent) {
+			last_percent = percent;
+			server.send(id, "progress", strprintf("\"current\":%d,\"total\":%d", current, total));
+		}
+		return true;
+	}
+};
+
+JobServer::JobServer(const TargetParam& target_parameters, int jobs):
+	target_parameters(target_parameters),
+	jobs(std::max(1, jobs)),
+	finished(),
+	failed(),
+	out()
+{ }
+
+void
+JobServer::send(const std::string& id, const std::string& event, const std::string& details)
+{
+	std::lock_guard<std::mutex> lock(out_mutex);
+	*out << "{\"id\":" << JsonParser::quote(id)
+	     << ",\"event\":" << JsonParser::quote(event)
+	     << (details.empty() ? "" : ",") << details
+	     << "}" << std::endl;
+}
+
+void
+JobServer::collect_files(const Canvas::Handle& canvas, FileTimes& files, std::set<Canvas::Handle>& visited)
+{
+	if (!canvas || !visited.insert(canvas).second)
+		return;
+
+	// external compositions are pasted by their canvases, inline canvases have the file name of parent
+	const std::string canvas_filename = canvas->get_file_name();
+	if (!canvas_filename.empty()) {
+		const std::string path = filesystem::absolute(canvas_filename).u8string();
+		if (!files.count(path))
+			files[path] = get_mtime(path);
+	}
+
+	for(Canvas::const_iterator i = canvas->begin(); i != canvas->end(); ++i) {
+		const Layer::Handle& layer = *i;
+		for(const ParamDesc& desc : layer->get_param_vocab()) {
+			if (desc.get_hint() != "filename")
+				continue;
+			ValueBase value = layer->get_param(desc.get_name());
+			if (value.get_type() != type_string || value.get(String()).empty())
+				continue;
+			// files embedded into container are changed only with the container
+			const std::string path = CanvasFileNaming::make_full_filename(canvas_filename, value.get(String()));
+			if (!path.empty() && !CanvasFileNaming::is_embeded(path) && !files.count(path))
+				files[path] = get_mtime(path);
+		}
+		if (Layer_PasteCanvas::Handle paste = Layer_PasteCanvas::Handle::cast_dynamic(layer))
+			collect_files(paste->get_sub_canvas(), files, visited);
+	}
+}
+
+bool
+JobServer::is_up_to_date(const FileTimes& files)
+{
+	for(FileTimes::const_iterator i = files.begin(); i != files.end(); ++i)
+		if (get_mtime(i->first) != i->second)
+			return false;
+	return true;
+}
+
+Canvas::Handle
+JobServer::acquire_canvas(const std::string& filename, FileTimes& files, bool& cached, std::string& error)
+{
+	const std::string path = filesystem::absolute(filename).u8string();
+
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		for(FileCache::iterator i = cache.begin(); i != cache.end(); ++i) {
+			if (i->first != path)
+				continue;
+			// some of the files were changed, so all of the canvases are outdated
+			if (!is_up_to_date(i->second.files)) {
+				cache.erase(i);
+				break;
+			}
+			if (i->second.idle.empty())
+				break;
+			Canvas::Handle canvas = i->second.idle.back();
+			i->second.idle.pop_back();
+			files = i->second.files;
+			cache.splice(cache.begin(), cache, i);
+			cached = true;
+			return canvas;
+		}
+	}
+
+	// time of the main file is taken before loading,
+	// so changes made while it is loaded are not missed
+	cached = false;
+	files.clear();
+	files[path] = get_mtime(path);
+
+	std::string errors, warnings;
+	Canvas::Handle canvas;
+	try
+	{
+		std::lock_guard<std::mutex> lock(load_mutex);
+		if (FileSystem::Handle file_system = CanvasFileNaming::make_filesystem(filename))
+		{
+			FileSystem::Identifier identifier = file_system->get_identifier(CanvasFileNaming::project_file(filename));
+			canvas = open_canvas_as(identifier, path, errors, warnings);
+			if (canvas) {
+				std::set<Canvas::Handle> visited;
+				collect_files(canvas, files, visited);
+			}
+		}
+		else
+		{
+			errors.append("Cannot open container " + filename + "\n");
+		}
+	}
+	catch(std::runtime_error& x)
+	{
+		errors.append(x.what());
+		canvas = nullptr;
+	}
+
+	if (!canvas)
+		error = errors.empty() ? strprintf(_("Unable to load file '%s'."), filename.c_str()) : errors;
+	return canvas;
+}
+
+void
+JobServer::release_canvas(const std::string& filename, const Canvas::Handle& canvas, const FileTimes& files)
+{
+	const std::string path = filesystem::absolute(filename).u8string();
+	if (!is_up_to_date(files))
+		return;
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	FileCache::iterator i = cache.begin();
+	while(i != cache.end() && i->first != path) ++i;
+	if (i == cache.end()) {
+		cache.push_front(std::make_pair(path, CachedFile()));
+		i = cache.begin();
+		i->second.files = files;
+	}
+	// canvases of the other version of files are outdated
+	if (i->second.files != files) {
+		i->second.files = files;
+		i->second.idle.clear();
+	}
+	i->second.idle.push_back(canvas);
+	cache.splice(cache.begin(), cache, i);
+
+	// forget the least recently used files
+	while(cache.size() > max_cached_files)
+		cache.pop_back();
+}
+
+bool
+JobServer::process(const std::string& line)
+{
+	Fields fields;
+	std::string error;
+	if (!JsonParser::parse_object(line, fields, error)) {
+		send(std::string(), "error", "\"message\":" + JsonParser::quote(error));
+		return false;
+	}
+
+	const std::string id = fields["id"];
+	const std::string filename = fields["file"];
+	if (filename.empty()) {
+		send(id, "error", "\"message\":" + JsonParser::quote(_("No input file provided.")));
+		return false;
+	}
+	send(id, "started");
+
+	Clock::time_point start = Clock::now();
+	bool cached = false;
+	FileTimes files;
+	Job job;
+	job.filename = filesystem::Path(filename);
+	job.root = acquire_canvas(filename, files, cached, error);
+	if (!job.root) {
+		send(id, "error", "\"message\":" + JsonParser::quote(error));
+		return false;
+	}
+	double load_time = milliseconds_since(start);
+
+	// canvas is returned to the cache only when job is succeeded
+	bool success = false;
+	RendDesc original_desc;
+	try
+	{
+		job.root->set_time(0);
+		job.canvas = job.root;
+		if (!fields["canvas"].empty()) {
+			std::string warnings;
+			job.canvas = job.root->find_canvas(fields["canvas"], warnings);
+		}
+		original_desc = job.canvas->rend_desc();
+
+		RendDesc desc = original_desc;
+		double x;
+		if (JsonParser::parse_number(fields["fps"], x) && x > 0)
+			desc.set_frame_rate(x);
+		if (!fields["begin-time"].empty())
+			desc.set_time_start(Time(fields["begin-time"].c_str(), desc.get_frame_rate()));
+		if (!fields["end-time"].empty())
+			desc.set_time_end(Time(fields["end-time"].c_str(), desc.get_frame_rate()));
+		if (!fields["time"].empty())
+			desc.set_time(Time(fields["time"].c_str(), desc.get_frame_rate()));
+
+		int w = JsonParser::parse_number(fields["width"], x) && x > 0 ? (int)x : 0;
+		int h = JsonParser::parse_number(fields["height"], x) && x > 0 ? (int)x : 0;
+		if (w || h) {
+			// scale properly
+			if (!w)
+				w = desc.get_w() * h / desc.get_h();
+			else if (!h)
+				h = desc.get_h() * w / desc.get_w();
+			desc.set_wh(w, h);
+		}
+		job.desc = job.canvas->rend_desc() = desc;
+
+		job.target_name = fields["target"];
+		job.outfilename = filesystem::Path(fields["output"]);
+		job.quality = JsonParser::parse_number(fields["quality"], x) && x > 0 ? (int)x : DEFAULT_QUALITY;
+
+		const std::string renderer = fields["renderer"];
+		if (!renderer.empty()) {
+			if (!rendering::Renderer::get_renderers().count(renderer))
+				throw SynfigToolException(SYNFIGTOOL_INVALIDJOB, strprintf(_("Invalid renderer: %s"), renderer.c_str()));
+			job.render_engine = renderer;
+		}
+
+		if (!setup_job(job, target_parameters))
+			throw SynfigToolException(SYNFIGTOOL_INVALIDJOB, strprintf(_("Unable to create output for \"%s\""), job.outfilename.u8_str()));
+
+		start = Clock::now();
+		Progress progress(*this, id);
+		if (job.sifout) {
+			if (!save_canvas(FileSystemNative::instance()->get_identifier(job.outfilename.u8string()), job.canvas))
+				throw SynfigToolException(SYNFIGTOOL_RENDERFAILURE, _("Render Failure."));
+		} else
+		if (!job.target->render(&progress)) {
+			throw SynfigToolException(SYNFIGTOOL_RENDERFAILURE,
+				progress.last_error.empty() ? std::string(_("Render Failure.")) : progress.last_error);
+		}
+		double render_time = milliseconds_since(start);
+
+		send(id, "done",
+			"\"output\":" + JsonParser::quote(job.outfilename.u8string())
+			+ ",\"cached\":" + (cached ? "true" : "false")
+			+ ",\"load_ms\":" + JsonParser::number(load_time)
+			+ ",\"render_ms\":" + JsonParser::number(render_time) );
+		success = true;
+	}
+	catch(SynfigToolException& e)
+		{ error = e.get_message(); }
+	catch(Exception::IDNotFound&)
+		{ error = strprintf(_("Unable to find canvas with ID \"%s\" in %s."), fields["canvas"].c_str(), filename.c_str()); }
+	catch(Exception::BadLinkName&)
+		{ error = strprintf(_("Invalid canvas name \"%s\" in %s."), fields["canvas"].c_str(), filename.c_str()); }
+	catch(std::exception& e)
+		{ error = e.what(); }
+
+	job.target = nullptr;
+	if (success) {
+		job.canvas->rend_desc() = original_desc;
+		release_canvas(filename, job.root, files);
+	} else {
+		send(id, "error", "\"message\":" + JsonParser::quote(error));
+	}
+	return success;
+}
+
+void
+JobServer::worker()
+{
+	while(true) {
+		std::string line;
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			while(queue.empty() && !finished)
+				queue_cond.wait(lock);
+			if (queue.empty())
+				return;
+			line = queue.front();
+			queue.pop_front();
+		}
+		if (!process(line)) {
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			++failed;
+		}
+	}
+}
+
+int
+JobServer::run(std::istream& in, std::ostream& out)
+{
+	this->out = &out;
+	finished = false;
+	failed = 0;
+
+	std::vector<std::thread> threads;
+	for(int i = 0; i < jobs; ++i)
+		threads.push_back(std::thread(&JobServer::worker, this));
+
+	std::string line;
+	while(std::getline(in, line)) {
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		queue.push_back(line);
+		queue_cond.notify_one();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		finished = true;
+		queue_cond.notify_all();
+	}
+	for(std::thread& thread : threads)
+		thread.join();
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	cache.clear();
+	return failed;
+}
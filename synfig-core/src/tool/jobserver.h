@@ -0,0 +1,111 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/jobserver.h
+**	\brief Synfig Tool Batch Rendering Server
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifndef __SYNFIG_JOBSERVER_H
+#define __SYNFIG_JOBSERVER_H
+
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <synfig/canvas.h>
+#include <synfig/targetparam.h>
+
+#include "jsonparser.h"
+
+/// Renders jobs read as JSON lines from one process, so modules stay
+/// loaded and parsed compositions are reused by the next jobs.
+///
+/// Each input line is an object with the fields of job:
+/// "id", "file" (required), "canvas", "target", "output", "renderer",
+/// "time", "begin-time", "end-time" (in synfig format, e.g. "1s 6f"),
+/// "fps", "width", "height", "quality".
+/// Each output line is an event of job: "started", "progress", "done" or "error"
+class JobServer
+{
+public:
+	typedef JsonParser::Fields Fields;
+
+	/// \param jobs count of jobs rendered simultaneously
+	JobServer(const synfig::TargetParam& target_parameters, int jobs);
+
+	/// Processes the jobs until the end of \a in, returns the count of failed jobs
+	int run(std::istream& in, std::ostream& out);
+
+private:
+	class Progress;
+
+	/// modification times of the composition file, of external compositions
+	/// and of imported files, canvas is outdated when any of them is changed
+	typedef std::map<std::string, std::time_t> FileTimes;
+
+	struct CachedFile
+	{
+		FileTimes files;
+		std::vector<synfig::Canvas::Handle> idle;
+	};
+
+	/// files with root canvases which are not used now by jobs,
+	/// the most recently used is the first
+	typedef std::list<std::pair<std::string, CachedFile> > FileCache;
+
+	static const size_t max_cached_files = 32;
+
+	synfig::TargetParam target_parameters;
+	int jobs;
+
+	std::mutex queue_mutex;
+	std::condition_variable queue_cond;
+	std::deque<std::string> queue;
+	bool finished;
+	int failed;
+
+	std::mutex cache_mutex;
+	FileCache cache;
+
+	//! loading of compositions is not thread-safe
+	std::mutex load_mutex;
+
+	std::mutex out_mutex;
+	std::ostream* out;
+
+	void worker();
+	bool process(const std::string& line);
+
+	static void collect_files(const synfig::Canvas::Handle& canvas, FileTimes& files, std::set<synfig::Canvas::Handle>& visited);
+	static bool is_up_to_date(const FileTimes& files);
+
+	synfig::Canvas::Handle acquire_canvas(const std::string& filename, FileTimes& files, bool& cached, std::string& error);
+	void release_canvas(const std::string& filename, const synfig::Canvas::Handle& canvas, const FileTimes& files);
+
+	void send(const std::string& id, const std::string& event, const std::string& details = std::string());
+};
+
+#endif // __SYNFIG_JOBSERVER_H
@@ -0,0 +1,264 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/jsonparser.cpp
+**	\brief JSON lines of Synfig Tool Batch Rendering Server
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cctype>
+#include <cstring>
+#include <locale>
+#include <sstream>
+
+#include <synfig/general.h>
+#include <synfig/localization.h>
+
+#include "jsonparser.h"
+
+#endif
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+void
+append_utf8(std::string& str, unsigned int code)
+{
+	if (code < 0x80) {
+		str += (char)code;
+	} else
+	if (code < 0x800) {
+		str += (char)(0xC0 | (code >> 6));
+		str += (char)(0x80 | (code & 0x3F));
+	} else
+	if (code < 0x10000) {
+		str += (char)(0xE0 | (code >> 12));
+		str += (char)(0x80 | ((code >> 6) & 0x3F));
+		str += (char)(0x80 | (code & 0x3F));
+	} else {
+		str += (char)(0xF0 | (code >> 18));
+		str += (char)(0x80 | ((code >> 12) & 0x3F));
+		str += (char)(0x80 | ((code >> 6) & 0x3F));
+		str += (char)(0x80 | (code & 0x3F));
+	}
+}
+
+} // end of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+// JSON must not depend on the locale set by main()
+std::string
+JsonParser::number(double x)
+{
+	std::ostringstream stream;
+	stream.imbue(std::locale::classic());
+	stream << x;
+	return stream.str();
+}
+
+bool
+JsonParser::parse_number(const std::string& str, double& x)
+{
+	std::istringstream stream(str);
+	stream.imbue(std::locale::classic());
+	stream >> x;
+	return !stream.fail() && stream.eof();
+}
+
+std::string
+JsonParser::quote(const std::string& str)
+{
+	std::string res = "\"";
+	for(char c : str) {
+		switch(c) {
+		case '"':  res += "\\\""; break;
+		case '\\': res += "\\\\"; break;
+		case '\n': res += "\\n"; break;
+		case '\r': res += "\\r"; break;
+		case '\t': res += "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20)
+				res += strprintf("\\u%04x", (int)c);
+			else
+				res += c;
+		}
+	}
+	return res + "\"";
+}
+
+bool
+JsonParser::parse_object(const std::string& line, Fields& fields, std::string& error)
+{
+	JsonParser parser(line);
+	if (parser.parse(fields))
+		return true;
+	error = parser.error;
+	return false;
+}
+
+void
+JsonParser::skip_spaces()
+	{ while(pos < str.size() && isspace((unsigned char)str[pos])) ++pos; }
+
+bool
+JsonParser::fail(const std::string& message)
+{
+	if (error.empty())
+		error = strprintf(_("%s at position %d"), message.c_str(), (int)pos);
+	return false;
+}
+
+bool
+JsonParser::expect(char c)
+{
+	skip_spaces();
+	if (pos >= str.size() || str[pos] != c)
+		return fail(strprintf(_("'%c' expected"), c));
+	++pos;
+	return true;
+}
+
+bool
+JsonParser::hex4(unsigned int& code)
+{
+	if (pos + 4 > str.size())
+		return fail(_("Unexpected end of string"));
+	code = 0;
+	for(int i = 0; i < 4; ++i) {
+		char c = str[pos++];
+		code <<= 4;
+		if (c >= '0' && c <= '9') code |= c - '0'; else
+		if (c >= 'a' && c <= 'f') code |= c - 'a' + 10; else
+		if (c >= 'A' && c <= 'F') code |= c - 'A' + 10; else
+			return fail(_("Invalid escape sequence"));
+	}
+	return true;
+}
+
+bool
+JsonParser::parse_string(std::string& value)
+{
+	if (!expect('"'))
+		return false;
+	value.clear();
+	while(pos < str.size()) {
+		char c = str[pos++];
+		if (c == '"')
+			return true;
+		if (c != '\\')
+			{ value += c; continue; }
+		if (pos >= str.size())
+			break;
+		switch(c = str[pos++]) {
+		case 'b': value += '\b'; break;
+		case 'f': value += '\f'; break;
+		case 'n': value += '\n'; break;
+		case 'r': value += '\r'; break;
+		case 't': value += '\t'; break;
+		case 'u': {
+			unsigned int code;
+			if (!hex4(code))
+				return false;
+			// surrogate pair, each half is not a valid character alone
+			if (code >= 0xDC00 && code < 0xE000)
+				return fail(_("Invalid surrogate pair"));
+			if (code >= 0xD800 && code < 0xDC00) {
+				unsigned int low;
+				if (str.compare(pos, 2, "\\u") != 0)
+					return fail(_("Invalid surrogate pair"));
+				pos += 2;
+				if (!hex4(low))
+					return false;
+				if (low < 0xDC00 || low >= 0xE000)
+					return fail(_("Invalid surrogate pair"));
+				code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+			}
+			append_utf8(value, code);
+			break;
+		}
+		default: value += c; break;
+		}
+	}
+	return fail(_("Unterminated string"));
+}
+
+bool
+JsonParser::parse_value(std::string& value)
+{
+	skip_spaces();
+	if (pos < str.size() && str[pos] == '"')
+		return parse_string(value);
+
+	// numbers and literals are kept as they are written
+	size_t end = pos;
+	while(end < str.size() && (isalnum((unsigned char)str[end]) || strchr("+-.", str[end])))
+		++end;
+	value = str.substr(pos, end - pos);
+	if (value.empty() || value == "true" || value == "false" || value == "null") {
+		if (value.empty())
+			return fail(_("Value expected"));
+	} else {
+		double x;
+		if (!parse_number(value, x))
+			return fail(_("Invalid value"));
+	}
+	if (value == "null")
+		value.clear();
+	pos = end;
+	return true;
+}
+
+bool
+JsonParser::parse_object(Fields& fields)
+{
+	if (!expect('{'))
+		return false;
+	skip_spaces();
+	if (pos < str.size() && str[pos] == '}')
+		{ ++pos; return true; }
+	while(true) {
+		std::string key, value;
+		if (!parse_string(key) || !expect(':') || !parse_value(value))
+			return false;
+		fields[key] = value;
+		skip_spaces();
+		if (pos < str.size() && str[pos] == ',')
+			{ ++pos; continue; }
+		return expect('}');
+	}
+}
+
+bool
+JsonParser::parse(Fields& fields)
+{
+	if (!parse_object(fields))
+		return false;
+	skip_spaces();
+	return pos == str.size() || fail(_("Unexpected data after the object"));
+}
@@ -0,0 +1,62 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/jsonparser.h
+**	\brief JSON lines of Synfig Tool Batch Rendering Server
+**
+**	\legal
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifndef __SYNFIG_JSONPARSER_H
+#define __SYNFIG_JSONPARSER_H
+
+#include <map>
+#include <string>
+
+/// Reads and writes single-line JSON objects of the batch rendering server
+class JsonParser
+{
+public:
+	typedef std::map<std::string, std::string> Fields;
+
+	/// Parses an object with string, number, boolean and null values,
+	/// numbers and booleans are kept as they are written, null is an empty string
+	static bool parse_object(const std::string& line, Fields& fields, std::string& error);
+	/// Parses a number, it does not depend on the locale
+	static bool parse_number(const std::string& str, double& x);
+
+	static std::string quote(const std::string& str);
+	static std::string number(double x);
+
+private:
+	const std::string& str;
+	size_t pos;
+	std::string error;
+
+	explicit JsonParser(const std::string& str): str(str), pos() { }
+
+	void skip_spaces();
+	bool fail(const std::string& message);
+	bool expect(char c);
+	bool hex4(unsigned int& code);
+	bool parse_string(std::string& value);
+	bool parse_value(std::string& value);
+	bool parse_object(Fields& fields);
+	bool parse(Fields& fields);
+};
+
+#endif // __SYNFIG_JSONPARSER_H
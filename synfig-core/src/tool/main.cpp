@@ -51,6 +51,7 @@
 #include "synfigtoolexception.h"
 #include "optionsprocessor.h"
 #include "joblistprocessor.h"
+#include "jobserver.h"
 #include "printing_functions.h"
 
 #endif
@@ -120,6 +121,13 @@ int main(int argc, char* argv[])
 		// Info options -----------------------------------------------
 		parser.process_info_options();
 
+		// Batch rendering server ------------------------------------
+		if (int server_jobs = parser.extract_server_jobs())
+		{
+			JobServer server(parser.extract_targetparam(), server_jobs);
+			return server.run(std::cin, std::cout) ? SYNFIGTOOL_RENDERFAILURE : SYNFIGTOOL_OK;
+		}
+
 		std::list<Job> job_list;
 
 		// Processing --------------------------------------------------
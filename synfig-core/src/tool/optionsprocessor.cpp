@@ -32,7 +32,10 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
+#include <iterator>
 
 #include <autorevision.h>
 #include <synfig/general.h>
@@ -45,7 +48,9 @@
 #include <synfig/importer.h>
 #include <synfig/loadcanvas.h>
 #include <synfig/valuenode_registry.h>
+#include <synfig/rendering/profiler.h>
 #include <synfig/rendering/renderer.h>
+#include <synfig/threadpool.h>
 
 #include "definitions.h"
 #include "job.h"
@@ -85,6 +90,7 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	og_switch("switch", _("Switch options"), _("Show switch help")),
 	og_misc("misc", _("Misc options"), _("Show Misc options help")),
 	og_ffmpeg("ffmpeg", _("FFMPEG target options"), _("Show FFMPEG target options help")),
+	og_openexr("openexr", _("OpenEXR target options"), _("Show OpenEXR target options help")),
 	og_info("info", _("Synfig info options"), _("Show Synfig info options help")),
 #ifdef _DEBUG
 	og_debug("debug", _("Synfig debug flags"), _("Show Synfig debug flags help")),
@@ -96,9 +102,13 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	set_antialias(),
 	set_quality(),
 	set_num_threads(),
+	set_frames_in_flight(),
+	set_encoder_threads(),
 	set_input_file(),
 	set_output_file(),
 	set_sequence_separator(),
+	set_png_compression(-1),
+	set_png_filter(),
 	set_canvas_id(),
 	set_fps(),
 	set_time(),
@@ -109,21 +119,36 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	set_dpi_x(),
 	set_dpi_y(),
 	set_repeats(),
+	set_trace_file(),
+	set_shard(),
+	set_shard_mode(),
+	set_manifest_file(),
 
 	// Switch group
 	sw_verbosity(),
 	sw_quiet(),
 	sw_print_benchmarks(),
 	sw_extract_alpha(),
+	sw_pin_threads(),
+	sw_skip_existing(),
 
 	// Misc group
 	misc_append_filename(),
 	misc_canvas_info(),
 	misc_canvases(),
+	misc_server_jobs(),
 
 	//FFMPEG group
 	video_codec(),
 	video_bitrate(),
+	video_pixel_format(),
+
+	//OpenEXR group
+	exr_pixel_type(),
+	exr_compression(),
+	exr_tile_size(),
+	exr_threads(-1),
+	exr_data_window(),
 
 	// Synfig info group
 	show_help(),
@@ -155,11 +180,15 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	add_option(og_set, "span",        's', set_span,		_("Set the diagonal size of image window (Span)"), "NUM");
 	add_option(og_set, "antialias",   'a', set_antialias,	_("Set antialias amount for parametric renderer."), "1..30");
 	//og_set.add_option("quality",     'Q', quality_arg_desc, strprintf(_("Specify image quality for accelerated renderer (Default: %d)"), DEFAULT_QUALITY).c_str(), "NUM");
-	add_option(og_set, "threads",     'T', set_num_threads, _("Enable multithreaded renderer using the specified number of threads"), "NUM");
+	add_option(og_set, "threads",     'T', set_num_threads, _("Enable multithreaded renderer using the specified number of threads, the same number limits the other working threads"), "NUM");
+	add_option(og_set, "frames-in-flight", ' ', set_frames_in_flight, _("Render the specified number of frames simultaneously"), "NUM");
+	add_option(og_set, "encoder-threads", ' ', set_encoder_threads, _("Write frames of image sequence by the specified number of background threads"), "NUM");
 	add_option(og_set, "input-file",  'i', set_input_file, 	_("Specify input filename"), "filename");
 	add_option(og_set, "output-file", 'o', set_output_file, _("Specify output filename"), "filename");
 	add_option(og_set, "renderer",    ' ', set_renderer,    _("Specify which renderer to use"), "string");
 	add_option(og_set, "sequence-separator", ' ', set_sequence_separator, _("Output file sequence separator string (Use double quotes if you want to use spaces)"), "string");
+	add_option(og_set, "png-compression", ' ', set_png_compression, _("Set the compression level of PNG files (0 is the fastest)"), "0..9");
+	add_option(og_set, "png-filter",  ' ', set_png_filter,  _("Set the row filter of PNG files (Default: none)"), "none|sub|up|average|paeth|all");
 	add_option(og_set, "canvas",      'c', set_canvas_id, 	_("Render the canvas with the given id instead of the root."), "id");
 	add_option(og_set, "fps",         ' ', set_fps, 		_("Set the frame rate"), "NUM");
 	add_option(og_set, "time",        ' ', set_time, 		_("Render a single frame at <time> in synfig format (e.g. \"0s 6f\")"), "time");
@@ -170,6 +199,10 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	add_option(og_set, "dpi-x",       ' ', set_dpi_x, 		_("Set the physical X resolution (Dots-per-inch)"), "NUM");
 	add_option(og_set, "dpi-y",       ' ', set_dpi_y, 		_("Set the physical Y resolution (Dots-per-inch)"), "NUM");
 	add_option(og_set, "repeats",	  ' ', set_repeats,		_("Set the number of times to render the same target"), "NUM");
+	add_option_filename(og_set, "trace", ' ', set_trace_file, _("Write timeline of rendering tasks to <filename> in Chrome trace format"), _("filename"));
+	add_option(og_set, "shard",       ' ', set_shard,       _("Render only the <i>-th of <N> parts of the frames of image sequence"), "i/N");
+	add_option(og_set, "shard-mode",  ' ', set_shard_mode,  _("Split frames to shards by contiguous ranges (default) or interleaved"), "contiguous|interleaved");
+	add_option_filename(og_set, "manifest", ' ', set_manifest_file, _("Append rendered frames and their render time to <filename>"), _("filename"));
 
 	// Switch options
 	//og_switch("switch", _("Switch options"), "Show switch help");
@@ -177,15 +210,26 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	add_option(og_switch, "quiet",         'q', sw_quiet, 				_("Quiet mode (No progress/time-remaining display)"), "");
 	add_option(og_switch, "benchmarks",    'b', sw_print_benchmarks,	_("Print benchmarks"), "");
 	add_option(og_switch, "extract-alpha", 'x', sw_extract_alpha, 		_("Extract alpha"), "");
+	add_option(og_switch, "pin-threads",   ' ', sw_pin_threads, 		_("Bind rendering threads to CPU cores"), "");
+	add_option(og_switch, "skip-existing", ' ', sw_skip_existing, 		_("Do not render frames of image sequence which are already rendered"), "");
 
 	//SynfigOptionGroup og_misc("misc", _("Misc options"), "Show Misc options help");
 	add_option_filename(og_misc, "append", ' ', misc_append_filename, 	_("Append layers in <filename> to composition"), _("filename"));
 	add_option(og_misc, "canvas-info",     ' ', misc_canvas_info, 			_("Print out specified details of the root canvas"), _("fields"));
 	add_option(og_misc, "canvases",		   ' ', misc_canvases,				_("Print out the list of exported canvases in the composition"), "");
+	add_option(og_misc, "server",		   ' ', misc_server_jobs,			_("Read jobs as JSON lines from standard input and render <NUM> of them simultaneously"), "NUM");
 
 	//SynfigOptionGroup og_ffmpeg("ffmpeg", _("FFMPEG target options"), "Show FFMPEG target options help");
 	add_option(og_ffmpeg, "video-codec",   ' ', video_codec, 	_("Set the codec for the video. See --target-video-codecs"), _("codec"));
 	add_option(og_ffmpeg, "video-bitrate", ' ', video_bitrate,	_("Set the bitrate for the output video"), _("bitrate"));
+	add_option(og_ffmpeg, "video-pixel-format", ' ', video_pixel_format,	_("Set the pixel format of frames passed to the encoder: rgb24, rgb48 or gbrpf32"), _("format"));
+
+	//SynfigOptionGroup og_openexr("openexr", _("OpenEXR target options"), "Show OpenEXR target options help");
+	add_option(og_openexr, "exr-pixel-type",  ' ', exr_pixel_type,  _("Set the type of channels of OpenEXR files (Default: half)"), "half|float");
+	add_option(og_openexr, "exr-compression", ' ', exr_compression, _("Set the compression of OpenEXR files (Default: zip)"), "none|rle|zips|zip|piz|pxr24|b44|b44a|dwaa|dwab");
+	add_option(og_openexr, "exr-tile-size",   ' ', exr_tile_size,   _("Write OpenEXR files by square tiles of the given size instead of scanlines"), "NUM");
+	add_option(og_openexr, "exr-threads",     ' ', exr_threads,     _("Set the count of threads used to compress OpenEXR files (Default: count of CPU cores, divided by encoder threads)"), "NUM");
+	add_option(og_openexr, "exr-data-window", ' ', exr_data_window, _("Write only the bounding box of non-transparent pixels to OpenEXR files"), "");
 
 	//SynfigOptionGroup og_info("info", _("Synfig info options"), "Show Synfig info options help");
 	add_option(og_info, "help",       ' ', show_help, 			_("Produce this help message"), "");
@@ -217,6 +261,7 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	context.add_group(og_switch);
 	context.add_group(og_misc);
 	context.add_group(og_ffmpeg);
+	context.add_group(og_openexr);
 	//context.add_group(og_info);
 	context.set_main_group(og_info); // remaining args works only in main group (OMG!)
 #ifdef _DEBUG	
@@ -370,10 +415,33 @@ void SynfigCommandLineParser::process_settings_options() const
 	if (set_num_threads > 0)
 	{
 		SynfigToolGeneralOptions::instance()->set_threads(size_t(set_num_threads));
+		// called before synfig::Main, so the rendering threads will use it too
+		ThreadPool::set_thread_budget(set_num_threads);
 	}
 
+	if (sw_pin_threads)
+		ThreadPool::set_pinning(true);
+
+	// appended while rendering and completed when rendering subsystem stops
+	if (!set_trace_file.empty())
+		rendering::Profiler::start(set_trace_file);
+
 	VERBOSE_OUT(1) << _("Threads set to ")
 				   << SynfigToolGeneralOptions::instance()->get_threads() << std::endl;
+
+	if (set_frames_in_flight > 0)
+	{
+		SynfigToolGeneralOptions::instance()->set_frames_in_flight(set_frames_in_flight);
+		VERBOSE_OUT(1) << _("Frames in flight set to ")
+					   << SynfigToolGeneralOptions::instance()->get_frames_in_flight() << std::endl;
+	}
+
+	if (set_encoder_threads > 0)
+	{
+		SynfigToolGeneralOptions::instance()->set_encoder_threads(set_encoder_threads);
+		VERBOSE_OUT(1) << _("Encoder threads set to ")
+					   << SynfigToolGeneralOptions::instance()->get_encoder_threads() << std::endl;
+	}
 }
 
 void SynfigCommandLineParser::process_trivial_info_options()
@@ -645,6 +713,12 @@ TargetParam SynfigCommandLineParser::extract_targetparam()
 		VERBOSE_OUT(1) << _("Target bitrate set to: ") << params.bitrate << "k."
 					   << std::endl;
 	}
+	if (!video_pixel_format.empty())
+	{
+		params.pixel_format = video_pixel_format;
+		strtolower(params.pixel_format);
+		VERBOSE_OUT(1) << _("Target pixel format set to: ") << params.pixel_format << std::endl;
+	}
 	if (!set_sequence_separator.empty())
 	{
 		params.sequence_separator = set_sequence_separator;
@@ -653,6 +727,61 @@ TargetParam SynfigCommandLineParser::extract_targetparam()
                        << "'."
 					   << std::endl;
 	}
+	if (set_png_compression >= 0)
+	{
+		if (set_png_compression > 9)
+			throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT,
+				strprintf(_("PNG compression level must be in range 0..9, got %d"), set_png_compression));
+		params.png_compression_level = set_png_compression;
+		VERBOSE_OUT(1) << _("PNG compression level set to: ") << params.png_compression_level << std::endl;
+	}
+	if (!set_png_filter.empty())
+	{
+		params.png_filter = set_png_filter;
+		strtolower(params.png_filter);
+		static const char *filters[] = { "none", "sub", "up", "average", "paeth", "all" };
+		if (std::find(std::begin(filters), std::end(filters), params.png_filter) == std::end(filters))
+			throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT,
+				strprintf(_("PNG filter \"%s\" is not supported."), params.png_filter.c_str()));
+		VERBOSE_OUT(1) << _("PNG filter set to: ") << params.png_filter << std::endl;
+	}
+	if (!exr_pixel_type.empty())
+	{
+		params.exr_pixel_type = exr_pixel_type;
+		strtolower(params.exr_pixel_type);
+		if (params.exr_pixel_type != "half" && params.exr_pixel_type != "float")
+			throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT,
+				strprintf(_("OpenEXR pixel type \"%s\" is not supported."), params.exr_pixel_type.c_str()));
+		VERBOSE_OUT(1) << _("OpenEXR pixel type set to: ") << params.exr_pixel_type << std::endl;
+	}
+	if (!exr_compression.empty())
+	{
+		params.exr_compression = exr_compression;
+		strtolower(params.exr_compression);
+		static const char *compressions[] = { "none", "rle", "zips", "zip", "piz", "pxr24", "b44", "b44a", "dwaa", "dwab" };
+		if (std::find(std::begin(compressions), std::end(compressions), params.exr_compression) == std::end(compressions))
+			throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT,
+				strprintf(_("OpenEXR compression \"%s\" is not supported."), params.exr_compression.c_str()));
+		VERBOSE_OUT(1) << _("OpenEXR compression set to: ") << params.exr_compression << std::endl;
+	}
+	if (exr_tile_size != 0)
+	{
+		if (exr_tile_size < 0)
+			throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT,
+				strprintf(_("OpenEXR tile size must be positive, got %d"), exr_tile_size));
+		params.exr_tile_size = exr_tile_size;
+		VERBOSE_OUT(1) << _("OpenEXR tile size set to: ") << params.exr_tile_size << std::endl;
+	}
+	if (exr_threads >= 0)
+	{
+		params.exr_threads = exr_threads;
+		VERBOSE_OUT(1) << _("OpenEXR threads set to: ") << params.exr_threads << std::endl;
+	}
+	if (exr_data_window)
+	{
+		params.exr_data_window = true;
+		VERBOSE_OUT(1) << _("OpenEXR data window is enabled") << std::endl;
+	}
 
 	return params;
 }
@@ -736,6 +865,34 @@ Job SynfigCommandLineParser::extract_job()
 		job.extract_alpha = true;
 	}
 
+	if (!set_shard.empty())
+	{
+		int index = 0, count = 0;
+		char tail = 0;
+		if (sscanf(set_shard.c_str(), "%d/%d%c", &index, &count, &tail) != 2 || count < 1 || index < 1 || index > count)
+			throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT,
+				strprintf(_("Invalid shard \"%s\", expected <i>/<N> where 1 <= i <= N."), set_shard.c_str()));
+		job.shard_index = index;
+		job.shard_count = count;
+		VERBOSE_OUT(1) << strprintf(_("Rendering shard %d of %d"), index, count) << std::endl;
+	}
+
+	if (!set_shard_mode.empty())
+	{
+		if (set_shard_mode == "interleaved")
+			job.shard_interleaved = true;
+		else
+		if (set_shard_mode != "contiguous")
+			throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT,
+				strprintf(_("Invalid shard mode \"%s\"."), set_shard_mode.c_str()));
+	}
+
+	if (sw_skip_existing)
+		job.skip_existing = true;
+
+	if (!set_manifest_file.empty())
+		job.manifest = filesystem::Path(set_manifest_file);
+
 	if (set_quality > 0)
 		job.quality = set_quality;
 	else
@@ -831,6 +988,11 @@ Job SynfigCommandLineParser::extract_job()
 	return job;
 }
 
+int SynfigCommandLineParser::extract_server_jobs() const
+{
+	return misc_server_jobs > 0 ? misc_server_jobs : 0;
+}
+
 void SynfigCommandLineParser::print_target_video_codecs_help() const
 {
 	for (std::vector<VideoCodec>::const_iterator itr = _allowed_video_codecs.begin();
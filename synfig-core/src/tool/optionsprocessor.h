@@ -71,6 +71,10 @@ public:
 	/// canvas-info
 	void extract_canvas_info(Job& job);
 
+	/// Count of jobs rendered simultaneously by batch rendering server, 0 if it is not requested
+	/// server
+	int extract_server_jobs() const;
+
 	void print_target_video_codecs_help() const;
 
 #ifdef _DEBUG
@@ -90,6 +94,7 @@ private:
 	Glib::OptionGroup og_switch;
 	Glib::OptionGroup og_misc;
 	Glib::OptionGroup og_ffmpeg;
+	Glib::OptionGroup og_openexr;
 	Glib::OptionGroup og_info;
 #ifdef _DEBUG	
 	Glib::OptionGroup og_debug;
@@ -104,10 +109,14 @@ private:
 	int				set_antialias;
 	int				set_quality;
 	int				set_num_threads;
+	int				set_frames_in_flight;
+	int				set_encoder_threads;
 	Glib::ustring	set_input_file;
 	Glib::ustring	set_output_file;
 	Glib::ustring   set_renderer;
 	Glib::ustring	set_sequence_separator;
+	int				set_png_compression;
+	Glib::ustring	set_png_filter;
 	Glib::ustring	set_canvas_id;
 	double			set_fps;
 	Glib::ustring	set_time;
@@ -118,21 +127,36 @@ private:
 	double			set_dpi_x;
 	double			set_dpi_y;
 	int				set_repeats;
+	std::string		set_trace_file;
+	Glib::ustring	set_shard;
+	Glib::ustring	set_shard_mode;
+	std::string		set_manifest_file;
 
 	// Switch group
 	int				sw_verbosity;
 	bool			sw_quiet;
 	bool			sw_print_benchmarks;
 	bool			sw_extract_alpha;
+	bool			sw_pin_threads;
+	bool			sw_skip_existing;
 
 	// Misc group
 	std::string		misc_append_filename;
 	Glib::ustring	misc_canvas_info;
 	bool			misc_canvases;
+	int				misc_server_jobs;
 
 	//FFMPEG group
 	Glib::ustring	video_codec;
 	int				video_bitrate;
+	Glib::ustring	video_pixel_format;
+
+	//OpenEXR group
+	Glib::ustring	exr_pixel_type;
+	Glib::ustring	exr_compression;
+	int				exr_tile_size;
+	int				exr_threads;
+	bool			exr_data_window;
 
 	// Synfig info group
 	bool			show_help;
@@ -95,6 +95,10 @@ bool RenderProgress::amount_complete(int current_frame, int frames_count)
             time_since_start.count() * remaining_rendered_proportion_;
 
         printRemainingTime(outputStream, remaining_seconds);
+
+        if (encoded_frame_ >= 0)
+            outputStream << synfig::strprintf(_(" Frame %d encoded in %.1f ms."),
+                encoded_frame_, encode_milliseconds_);
     }
     else
     {
@@ -115,6 +119,15 @@ bool RenderProgress::amount_complete(int current_frame, int frames_count)
     return true;
 }
 
+void RenderProgress::frame_encoded(int frame, double milliseconds)
+{
+    encoded_frame_ = frame;
+    encode_milliseconds_ = milliseconds;
+    VERBOSE_OUT(2) << std::endl
+                   << synfig::strprintf(_("Frame %d encoded in %.1f ms"), frame, milliseconds)
+                   << std::endl;
+}
+
 void RenderProgress::printRemainingTime(std::ostream& os,
                                         double remaining_seconds) const
 {
@@ -49,6 +49,9 @@ public:
     virtual bool warning(const std::string& task);
 
     virtual bool amount_complete(int scanline, int height);
+
+    //! Shows the time of encoding of the frame written in background
+    void frame_encoded(int frame, double milliseconds);
 private:
     std::string taskname_;
     int last_frame_;
@@ -62,6 +65,10 @@ private:
 
 	int repeated_ = 0;
 
+	//! the last frame written by encoder threads, -1 if there are no such frames
+	int encoded_frame_ = -1;
+	double encode_milliseconds_ = 0;
+
     void printRemainingTime(std::ostream& os, double remaining_seconds) const;
 
     void printRemainingTime(std::ostream& os,
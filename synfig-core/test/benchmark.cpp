@@ -24,18 +24,35 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdio>
+#include <thread>
+#include <vector>
 
 #include <synfig/angle.h>
 #include <synfig/bezier.h>
 #include <synfig/clock.h>
+#include <synfig/surface.h>
 #include <synfig/surface_etl.h>
+#include <synfig/rendering/renderqueue.h>
+#include <synfig/rendering/software/function/blend.h>
+#include <synfig/rendering/software/function/blur.h>
+#include <synfig/rendering/software/function/contour.h>
 
 /* === M A C R O S ========================================================= */
 
 using namespace synfig;
 
 #define HERMITE_TEST_ITERATIONS		(100000)
+#define BLEND_TEST_SIZE				(512)
+#define BLEND_TEST_ITERATIONS		(20)
+#define QUEUE_TEST_TASKS			(20000)
+#define QUEUE_TEST_ITERATIONS		(10)
+#define CONTOUR_TEST_VERTICES		(2000)
+#define CONTOUR_TEST_WIDTH			(3840)
+#define CONTOUR_TEST_HEIGHT			(2160)
 
 /* === C L A S S E S ======================================================= */
 
@@ -281,6 +298,227 @@ int hermite_angle_test(void)
 	return ret;
 }
 
+int blend_test(void)
+{
+	using namespace synfig::rendering::software;
+
+	const Color::BlendMethod methods[] = {
+		Color::BLEND_COMPOSITE, Color::BLEND_STRAIGHT, Color::BLEND_ONTO, Color::BLEND_BEHIND,
+		Color::BLEND_ADD, Color::BLEND_MULTIPLY, Color::BLEND_SCREEN, Color::BLEND_ALPHA_OVER };
+
+	Surface src(BLEND_TEST_SIZE, BLEND_TEST_SIZE);
+	Surface dest(BLEND_TEST_SIZE, BLEND_TEST_SIZE);
+	for(int y = 0; y < src.get_h(); ++y)
+		for(int x = 0; x < src.get_w(); ++x)
+			src[y][x] = Color(x/(float)src.get_w(), y/(float)src.get_h(), 0.5f, ((x + y) % 64)/63.f);
+
+	synfig::clock timer;
+	const RectInt rect(0, 0, BLEND_TEST_SIZE, BLEND_TEST_SIZE);
+	for(Color::BlendMethod method : methods)
+	{
+		// existing path, pixel by pixel through the alpha pen
+		dest.fill(Color(0.25f, 0.5f, 0.75f, 0.5f));
+		timer.reset();
+		for(int i = 0; i < BLEND_TEST_ITERATIONS; ++i)
+		{
+			Surface::alpha_pen ap(dest.get_pen(0, 0));
+			ap.set_blend_method(method);
+			ap.set_alpha(0.75f);
+			src.blit_to(ap, 0, 0, src.get_w(), src.get_h());
+		}
+		printf("blend method %2d, alpha_pen: time=%f milliseconds\n", (int)method, timer()*1000);
+
+		for(int j = 0; j <= Blend::get_best_implementation(); ++j)
+		{
+			Blend::set_implementation((Blend::Implementation)j);
+			dest.fill(Color(0.25f, 0.5f, 0.75f, 0.5f));
+			timer.reset();
+			for(int i = 0; i < BLEND_TEST_ITERATIONS; ++i)
+				Blend::blend(dest, rect, src, VectorInt(0, 0), 0.75f, method);
+			printf("blend method %2d, %-9s: time=%f milliseconds\n",
+				(int)method, Blend::get_implementation_name((Blend::Implementation)j), timer()*1000);
+		}
+	}
+	Blend::set_implementation(Blend::get_best_implementation());
+
+	return 0;
+}
+
+// many tiny tasks, so the time is spent mostly for the queue itself
+int renderqueue_test(void)
+{
+	using namespace synfig::rendering;
+
+	RenderQueue queue;
+	synfig::clock timer;
+
+	for(int layers = 1; layers <= 100; layers *= 10)
+	{
+		timer.reset();
+		for(int i = 0; i < QUEUE_TEST_ITERATIONS; ++i)
+		{
+			// each task of layer depends on two tasks of previous layer
+			const int width = QUEUE_TEST_TASKS/layers;
+			Task::List list;
+			for(int j = 0; j < QUEUE_TEST_TASKS; ++j)
+			{
+				Task::Handle task(new TaskEvent());
+				if (j >= width)
+					for(int k = 0; k < 2; ++k) {
+						const Task::Handle &dep = list[j - width + (j + k)%width - j%width];
+						task->renderer_data.deps.insert(dep);
+						dep->renderer_data.back_deps.insert(task);
+					}
+				list.push_back(task);
+			}
+
+			TaskEvent::Handle finish(new TaskEvent());
+			for(int j = QUEUE_TEST_TASKS - width; j < QUEUE_TEST_TASKS; ++j) {
+				finish->renderer_data.deps.insert(list[j]);
+				list[j]->renderer_data.back_deps.insert(finish);
+			}
+			list.push_back(finish);
+
+			queue.enqueue(list, Task::RunParams());
+			finish->wait();
+		}
+		printf("render queue, %d threads, %d tasks in %3d layers: time=%f milliseconds\n",
+			queue.get_threads_count(), QUEUE_TEST_TASKS, layers, timer()*1000/QUEUE_TEST_ITERATIONS);
+	}
+
+	return 0;
+}
+
+// rasterization of thousand-vertex outline split into strips like OptimizerSplit does,
+// each strip processes all of the contour or only its part from the shared edge table
+int contour_split_test(void)
+{
+	using namespace synfig::rendering;
+
+	rendering::Contour contour;
+	const Vector center(CONTOUR_TEST_WIDTH/2, CONTOUR_TEST_HEIGHT/2);
+	contour.move_to(center + Vector(1000, 0));
+	for(int i = 1; i <= CONTOUR_TEST_VERTICES; ++i)
+	{
+		Real a = 2*PI*i/CONTOUR_TEST_VERTICES;
+		Real r = i % 2 ? 700 : 1000;
+		Vector c0 = center + Vector(std::cos(a - 0.6*PI/CONTOUR_TEST_VERTICES), std::sin(a - 0.6*PI/CONTOUR_TEST_VERTICES))*r;
+		Vector c1 = center + Vector(std::cos(a - 0.3*PI/CONTOUR_TEST_VERTICES), std::sin(a - 0.3*PI/CONTOUR_TEST_VERTICES))*r;
+		contour.cubic_to(center + Vector(std::cos(a), std::sin(a))*r, c0, c1);
+	}
+	contour.close();
+
+	const RectInt window(0, 0, CONTOUR_TEST_WIDTH, CONTOUR_TEST_HEIGHT);
+	const int threads = std::max(1, (int)std::thread::hardware_concurrency());
+	const Real detail = 0.5;
+	Matrix matrix;
+
+	for(int strips = 1; strips <= 128; strips *= 4)
+	{
+		for(int shared = 0; shared < 2; ++shared)
+		{
+			synfig::clock timer;
+			EdgeTable edge_table;
+			if (shared)
+				software::Contour::build_edge_table(contour.get_chunks(), matrix, window, edge_table, detail);
+
+			std::atomic<int> next(0);
+			std::vector<std::thread> workers;
+			for(int i = 0; i < threads; ++i)
+				workers.push_back(std::thread([&]() {
+					for(int j = next++; j < strips; j = next++) {
+						const int h = CONTOUR_TEST_HEIGHT/strips;
+						Polyspan polyspan;
+						polyspan.init(0, j*h, CONTOUR_TEST_WIDTH, j + 1 == strips ? CONTOUR_TEST_HEIGHT : (j + 1)*h);
+						if (shared) {
+							edge_table.add_to(polyspan);
+						} else {
+							software::Contour::build_polyspan(contour.get_chunks(), matrix, polyspan, detail);
+							polyspan.close();
+						}
+						polyspan.sort_marks();
+					}
+				}));
+			for(std::thread &worker : workers)
+				worker.join();
+
+			printf("contour %d vertices, %3d strips, %d threads, %-10s: time=%f milliseconds\n",
+				CONTOUR_TEST_VERTICES, strips, threads, shared ? "edge table" : "polyspan", timer()*1000);
+		}
+	}
+
+	return 0;
+}
+
+int contour_rasterizer_test(void)
+{
+	using namespace synfig::rendering;
+
+	// star with straight spikes, rendered into the surface of full frame
+	rendering::Contour contour;
+	const Vector center(CONTOUR_TEST_WIDTH/2, CONTOUR_TEST_HEIGHT/2);
+	contour.move_to(center + Vector(1000, 0));
+	for(int i = 1; i <= CONTOUR_TEST_VERTICES; ++i)
+	{
+		Real a = 2*PI*i/CONTOUR_TEST_VERTICES;
+		Real r = i % 2 ? 700 : 1000;
+		contour.line_to(center + Vector(std::cos(a), std::sin(a))*r);
+	}
+	contour.close();
+
+	const RectInt window(0, 0, CONTOUR_TEST_WIDTH, CONTOUR_TEST_HEIGHT);
+	synfig::Surface surface(CONTOUR_TEST_WIDTH, CONTOUR_TEST_HEIGHT);
+	Matrix matrix;
+
+	for(int rows = 0; rows < 2; ++rows)
+	{
+		surface.fill(Color());
+		synfig::clock timer;
+		for(int i = 0; i < 10; ++i)
+		{
+			Polyspan polyspan;
+			polyspan.init(window);
+			software::Contour::build_polyspan(contour.get_chunks(), matrix, polyspan, 0.5);
+			polyspan.close();
+			if (rows) {
+				polyspan.finish_marks();
+				software::Contour::render_polyspan_rows(surface, polyspan, false, true, rendering::Contour::WINDING_NON_ZERO, Color::red(), 1.f, Color::BLEND_COMPOSITE);
+			} else {
+				polyspan.sort_marks();
+				software::Contour::render_polyspan(surface, polyspan, false, true, rendering::Contour::WINDING_NON_ZERO, Color::red(), 1.f, Color::BLEND_COMPOSITE);
+			}
+		}
+
+		printf("contour %d vertices, %-6s rasterizer: time=%f milliseconds\n",
+			CONTOUR_TEST_VERTICES, rows ? "rows" : "sorted", timer()*1000/10);
+	}
+
+	return 0;
+}
+
+int blur_box_test(void)
+{
+	using namespace synfig::rendering;
+
+	const int extra = 200;
+	synfig::Surface src(CONTOUR_TEST_WIDTH + 2*extra, CONTOUR_TEST_HEIGHT + 2*extra);
+	synfig::Surface dest(CONTOUR_TEST_WIDTH, CONTOUR_TEST_HEIGHT);
+	for(int y = 0; y < src.get_h(); ++y)
+		for(int x = 0; x < src.get_w(); ++x)
+			src[y][x] = Color((x % 11)/10.f, (y % 5)/4.f, ((x + y) % 17)/16.f, ((x*y) % 9)/8.f);
+
+	synfig::clock timer;
+	software::Blur::blur(software::Blur::Params(
+		dest, RectInt(0, 0, CONTOUR_TEST_WIDTH, CONTOUR_TEST_HEIGHT),
+		src, VectorInt(extra, extra),
+		rendering::Blur::FASTGAUSSIAN, Vector(100, 100),
+		false, Color::BLEND_COMPOSITE, 1.f ));
+	printf("blur %dx%d, fast gaussian, radius 100: time=%f milliseconds\n",
+		CONTOUR_TEST_WIDTH, CONTOUR_TEST_HEIGHT, timer()*1000);
+
+	return 0;
+}
+
 
 /* === E N T R Y P O I N T ================================================= */
 
@@ -292,6 +530,11 @@ int main()
 	error+=hermite_double_test();
 	error+=hermite_int_test();
 	error+=hermite_angle_test();
+	error+=blend_test();
+	error+=renderqueue_test();
+	error+=contour_split_test();
+	error+=contour_rasterizer_test();
+	error+=blur_box_test();
 
 	return error;
 }
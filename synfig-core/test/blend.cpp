@@ -0,0 +1,154 @@
+/* === S Y N F I G ========================================================= */
+/*! \file blend.cpp
+**  \brief Test synfig::rendering::software::Blend
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/rendering/software/function/blend.h>
+
+#include "test_base.h"
+
+#include <vector>
+
+using namespace synfig;
+using namespace rendering;
+using namespace software;
+
+/* === P R O C E D U R E S ================================================= */
+
+static const Color::BlendMethod methods[] = {
+	Color::BLEND_COMPOSITE,
+	Color::BLEND_STRAIGHT,
+	Color::BLEND_ONTO,
+	Color::BLEND_BEHIND,
+	Color::BLEND_ADD,
+	Color::BLEND_MULTIPLY,
+	Color::BLEND_SCREEN,
+	Color::BLEND_ALPHA_OVER,
+	Color::BLEND_HARD_LIGHT, // not optimized, uses generic code
+};
+
+static const ColorReal amounts[] = { 1.f, 0.5f, -0.75f, 0.f };
+
+static std::vector<Color>
+create_row(int count, int seed)
+{
+	std::vector<Color> row;
+	for(int i = 0; i < count; ++i) {
+		int k = i*7 + seed*13;
+		row.push_back(Color(
+			(k % 11)/10.f,
+			(k % 5)/4.f,
+			(k % 17)/8.f - 0.5f,
+			i % 4 == 0 ? 0.f : (k % 9)/8.f ));
+	}
+	return row;
+}
+
+static bool
+same_color(const Color &a, const Color &b)
+{
+	const ColorReal precision = 1e-5f;
+	return std::fabs(a.get_r() - b.get_r()) < precision
+		&& std::fabs(a.get_g() - b.get_g()) < precision
+		&& std::fabs(a.get_b() - b.get_b()) < precision
+		&& std::fabs(a.get_a() - b.get_a()) < precision;
+}
+
+static void
+check_implementation(Blend::Implementation implementation)
+{
+	ASSERT(Blend::set_implementation(implementation));
+
+	// odd count to process the tail of row too
+	const int count = 37;
+	const std::vector<Color> src = create_row(count, 1);
+	const std::vector<Color> dest = create_row(count, 2);
+
+	for(Color::BlendMethod method : methods)
+		for(ColorReal amount : amounts) {
+			std::vector<Color> result = dest;
+			Blend::blend_row(&result.front(), &src.front(), count, amount, method);
+			for(int i = 0; i < count; ++i) {
+				Color expected = Color::blend(src[i], dest[i], amount, method);
+				if (!same_color(expected, result[i])) {
+					std::ostringstream oss;
+					oss << "\t - " << Blend::get_implementation_name(implementation)
+						<< ", method " << (int)method
+						<< ", amount " << amount
+						<< ", pixel " << i
+						<< ": expected " << expected.get_string()
+						<< ", got " << result[i].get_string() << std::endl;
+					throw SynfigTestException{__FUNCTION__, __LINE__, oss.str()};
+				}
+			}
+		}
+}
+
+static void
+test_all_implementations_match_color_blend()
+{
+	for(int i = 0; i <= Blend::get_best_implementation(); ++i)
+		check_implementation((Blend::Implementation)i);
+	Blend::set_implementation(Blend::get_best_implementation());
+}
+
+static void
+test_generic_implementation_is_always_supported()
+{
+	ASSERT(Blend::set_implementation(Blend::IMPLEMENTATION_GENERIC));
+	ASSERT_EQUAL(Blend::IMPLEMENTATION_GENERIC, Blend::get_implementation());
+	ASSERT(Blend::set_implementation(Blend::get_best_implementation()));
+}
+
+static void
+test_blend_surface_region()
+{
+	synfig::Surface dest(8, 6), src(5, 5);
+	dest.fill(Color(0.f, 0.f, 1.f, 1.f));
+	src.fill(Color(1.f, 0.f, 0.f, 0.5f));
+
+	// blend 3x2 pixels of src from (1, 2) to (4, 3) of dest
+	Blend::blend(dest, RectInt(4, 3, 7, 5), src, VectorInt(-3, -1), 1.f, Color::BLEND_COMPOSITE);
+
+	const Color blended = Color::blend(Color(1.f, 0.f, 0.f, 0.5f), Color(0.f, 0.f, 1.f, 1.f), 1.f, Color::BLEND_COMPOSITE);
+	for(int y = 0; y < dest.get_h(); ++y)
+		for(int x = 0; x < dest.get_w(); ++x) {
+			bool inside = x >= 4 && x < 7 && y >= 3 && y < 5;
+			ASSERT(same_color(inside ? blended : Color(0.f, 0.f, 1.f, 1.f), dest[y][x]));
+		}
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_all_implementations_match_color_blend);
+	TEST_FUNCTION(test_generic_implementation_is_always_supported);
+	TEST_FUNCTION(test_blend_surface_region);
+
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -0,0 +1,301 @@
+/* === S Y N F I G ========================================================= */
+/*! \file blur.cpp
+**  \brief Test synfig::rendering::software::Blur
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/rendering/software/function/blur.h>
+#include <synfig/rendering/software/function/blurtemplates.h>
+#include <synfig/rendering/software/function/fft.h>
+
+#include "test_base.h"
+
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <vector>
+
+using namespace synfig;
+using namespace rendering;
+using software::Array;
+using software::BlurTemplates;
+using software::FFT;
+
+/* === P R O C E D U R E S ================================================= */
+
+static void
+fill_surface(synfig::Surface &surface)
+{
+	for(int y = 0; y < surface.get_h(); ++y)
+		for(int x = 0; x < surface.get_w(); ++x) {
+			int k = x*7 + y*13;
+			surface[y][x] = Color((k % 11)/10.f, (k % 5)/4.f, (k % 17)/16.f, (k % 9)/8.f);
+		}
+}
+
+//! Box blur by channels and by Array views, as it was done before the blocked implementation
+static void
+blur_box_reference(synfig::Surface &dest, software::Blur::Params params)
+{
+	if (!params.validate()) return;
+
+	const int channels = 4;
+	int rows = params.src_rect.get_size()[1];
+	int cols = params.src_rect.get_size()[0];
+
+	std::vector<ColorReal> surface(rows*cols*channels);
+	Array<ColorReal, 3> arr_surface(&surface.front());
+	arr_surface
+		.set_dim(rows, cols*channels)
+		.set_dim(cols, channels)
+		.set_dim(channels, 1);
+	BlurTemplates::surface_read(arr_surface, *params.src, VectorInt(0, 0), params.src_rect);
+
+	Vector size = params.amplified_size;
+	bool cross = params.type == rendering::Blur::CROSS;
+	if (params.type == rendering::Blur::FASTGAUSSIAN)
+		size *= 1.662155813;
+
+	std::deque<ColorReal> q;
+	std::vector<ColorReal> surface_copy;
+	Array<ColorReal, 3> arr_surface_rows(arr_surface.reorder(2, 0, 1));
+	Array<ColorReal, 3> arr_surface_cols(arr_surface_rows.reorder(0, 2, 1));
+	if (cross) {
+		arr_surface.process< std::multiplies<ColorReal> >(0.5);
+		surface_copy = surface;
+		arr_surface_cols.pointer = &surface_copy.front();
+	}
+
+	for(Array<ColorReal, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
+		for(Array<ColorReal, 2>::Iterator r(*channel); r; ++r)
+			BlurTemplates::blur_box_discrete(*r, q, (int)round(size[0]));
+	for(Array<ColorReal, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
+		for(Array<ColorReal, 2>::Iterator c(*channel); c; ++c)
+			BlurTemplates::blur_box_discrete(*c, q, (int)round(size[1]));
+
+	if (cross)
+		arr_surface_rows.process< std::plus<ColorReal> >(arr_surface_cols.reorder(0, 2, 1));
+
+	BlurTemplates::surface_write(
+		dest,
+		arr_surface,
+		params.dest_rect,
+		params.src_offset - params.src_rect.get_min(),
+		params.blend,
+		params.blend_method,
+		params.amount );
+}
+
+//! Blur by complex Furier transforms of each channel, as it was done before the real transforms
+static void
+blur_fft_reference(synfig::Surface &dest, const software::Blur::Params &params)
+{
+	const int channels = 4;
+	int rows = FFT::get_valid_count(params.src_rect.get_size()[1]);
+	int cols = FFT::get_valid_count(params.src_rect.get_size()[0]);
+	bool full = params.type == rendering::Blur::DISC;
+	bool cross = params.type == rendering::Blur::CROSS;
+
+	std::vector<Complex> surface(rows*cols*channels);
+	Array<Real, 4> arr_surface((Real*)&surface.front());
+	arr_surface
+		.set_dim(rows, cols*channels*2)
+		.set_dim(cols, channels*2)
+		.set_dim(channels, 2)
+		.set_dim(2, 1);
+	BlurTemplates::surface_read(arr_surface.reorder(0, 1, 2), *params.src, VectorInt(0, 0), params.src_rect);
+
+	if (full) {
+		std::vector<Complex> full_pattern(rows*cols);
+		Array<Real, 3> arr_full_pattern((Real*)&full_pattern.front());
+		arr_full_pattern
+			.set_dim(rows, 2*cols)
+			.set_dim(cols, 2)
+			.set_dim(2, 1);
+		BlurTemplates::fill_pattern_2d_disk(arr_full_pattern.reorder(0, 1), params.amplified_size[0], params.amplified_size[1]);
+		BlurTemplates::mirror_pattern_2d(arr_full_pattern.reorder(0, 1));
+		BlurTemplates::normalize_full_pattern_2d(arr_full_pattern.reorder(0, 1));
+
+		FFT::fft2d(arr_full_pattern.group_items<Complex>(), false);
+		for(Array<Complex, 3>::Iterator channel(arr_surface.group_items<Complex>().reorder(2, 0, 1)); channel; ++channel) {
+			FFT::fft2d(*channel, false);
+			channel->process< std::multiplies<Complex> >(arr_full_pattern.group_items<Complex>());
+			FFT::fft2d(*channel, true);
+		}
+	} else {
+		std::vector<Complex> row_pattern(cols), col_pattern(rows);
+		Array<Real, 2> arr_row_pattern((Real*)&row_pattern.front());
+		arr_row_pattern
+			.set_dim(cols, 2)
+			.set_dim(2, 1);
+		Array<Real, 2> arr_col_pattern((Real*)&col_pattern.front());
+		arr_col_pattern
+			.set_dim(rows, 2)
+			.set_dim(2, 1);
+		if (cross) {
+			BlurTemplates::fill_pattern_box(arr_row_pattern.reorder(0), params.amplified_size[0]);
+			BlurTemplates::fill_pattern_box(arr_col_pattern.reorder(0), params.amplified_size[1]);
+		} else {
+			BlurTemplates::fill_pattern_gauss(arr_row_pattern.reorder(0), params.amplified_size[0]);
+			BlurTemplates::fill_pattern_gauss(arr_col_pattern.reorder(0), params.amplified_size[1]);
+		}
+		BlurTemplates::mirror_pattern(arr_row_pattern.reorder(0));
+		BlurTemplates::mirror_pattern(arr_col_pattern.reorder(0));
+		BlurTemplates::normalize_full_pattern(arr_row_pattern.reorder(0));
+		BlurTemplates::normalize_full_pattern(arr_col_pattern.reorder(0));
+
+		std::vector<Complex> surface_copy;
+		Array<Complex, 3> arr_surface_rows(arr_surface.group_items<Complex>().reorder(2, 0, 1));
+		Array<Complex, 3> arr_surface_cols(arr_surface_rows.reorder(0, 2, 1));
+		if (cross) {
+			arr_row_pattern.reorder(0).process< std::multiplies<Real> >(0.5);
+			arr_col_pattern.reorder(0).process< std::multiplies<Real> >(0.5);
+			surface_copy = surface;
+			arr_surface_cols.pointer = &surface_copy.front();
+		}
+
+		FFT::fft(arr_row_pattern.group_items<Complex>(), false);
+		for(Array<Complex, 3>::Iterator channel(arr_surface_rows); channel; ++channel) {
+			FFT::fft2d(*channel, false, true, false);
+			for(Array<Complex, 2>::Iterator r(*channel); r; ++r)
+				r->process< std::multiplies<Complex> >(arr_row_pattern.group_items<Complex>());
+			FFT::fft2d(*channel, true, true, false);
+		}
+
+		FFT::fft(arr_col_pattern.group_items<Complex>(), false);
+		for(Array<Complex, 3>::Iterator channel(arr_surface_cols); channel; ++channel) {
+			FFT::fft2d(*channel, false, true, false);
+			for(Array<Complex, 2>::Iterator c(*channel); c; ++c)
+				c->process< std::multiplies<Complex> >(arr_col_pattern.group_items<Complex>());
+			FFT::fft2d(*channel, true, true, false);
+		}
+
+		arr_surface_rows.process< BlurTemplates::Abs<Complex> >();
+		if (cross) {
+			arr_surface_cols.process< BlurTemplates::Abs<Complex> >();
+			arr_surface_rows.split_items<Real>().reorder(0, 1, 2)
+				.process< std::plus<Real> >(arr_surface_cols.split_items<Real>().reorder(0, 2, 1));
+		}
+	}
+
+	BlurTemplates::surface_write(
+		dest,
+		arr_surface.reorder(0, 1, 2),
+		params.dest_rect,
+		params.src_offset - params.src_rect.get_min(),
+		params.blend,
+		params.blend_method,
+		params.amount );
+}
+
+static bool
+approximate_equal(const Color &a, const Color &b)
+{
+	const ColorReal precision = 1e-4;
+	return std::fabs(a.get_r() - b.get_r()) < precision
+	    && std::fabs(a.get_g() - b.get_g()) < precision
+	    && std::fabs(a.get_b() - b.get_b()) < precision
+	    && std::fabs(a.get_a() - b.get_a()) < precision;
+}
+
+static void
+test_box_matches_reference()
+{
+	const rendering::Blur::Type types[] = {
+		rendering::Blur::BOX,
+		rendering::Blur::CROSS,
+		rendering::Blur::FASTGAUSSIAN };
+	// sizes larger than the surface too
+	const Vector sizes[] = { Vector(1, 1), Vector(3.5, 7), Vector(20, 2), Vector(150, 150) };
+
+	synfig::Surface src(173, 131);
+	fill_surface(src);
+
+	for(rendering::Blur::Type type : types)
+		for(const Vector &size : sizes) {
+			synfig::Surface expected(150, 120), result(150, 120);
+			expected.fill(Color(0.f, 0.f, 1.f, 1.f));
+			result.fill(Color(0.f, 0.f, 1.f, 1.f));
+
+			software::Blur::Params params(result, RectInt(5, 3, 140, 110), src, VectorInt(9, 11), type, size, true, Color::BLEND_COMPOSITE, 0.75f);
+			software::Blur::blur(params);
+			params.dest = &expected;
+			blur_box_reference(expected, params);
+
+			for(int y = 0; y < result.get_h(); ++y)
+				for(int x = 0; x < result.get_w(); ++x)
+					ASSERT(result[y][x] == expected[y][x]);
+		}
+}
+
+static void
+test_fft_matches_complex_transforms()
+{
+	const rendering::Blur::Type types[] = {
+		rendering::Blur::DISC,
+		rendering::Blur::GAUSSIAN,
+		rendering::Blur::CROSS };
+	// the larger surface is transformed by several parts of FFT::min_part_values
+	const VectorInt surface_sizes[] = { VectorInt(173, 131), VectorInt(420, 300) };
+	const Vector sizes[] = { Vector(8, 5), Vector(30, 20) };
+
+	for(const VectorInt &surface_size : surface_sizes)
+	for(rendering::Blur::Type type : types)
+		for(const Vector &size : sizes) {
+			const int w = surface_size[0], h = surface_size[1];
+			synfig::Surface src(w, h);
+			fill_surface(src);
+
+			synfig::Surface expected(w, h), result(w, h);
+			expected.fill(Color(0.f, 0.f, 1.f, 1.f));
+			result.fill(Color(0.f, 0.f, 1.f, 1.f));
+
+			software::Blur::Params params(result, RectInt(0, 0, w, h), src, VectorInt(0, 0), type, size, true, Color::BLEND_COMPOSITE, 0.75f);
+			ASSERT(params.validate());
+			if (w > 256)
+				ASSERT(FFT::get_valid_count(params.src_rect.get_width())*FFT::get_valid_count(params.src_rect.get_height()) >= FFT::min_part_values);
+			software::Blur::blur_fft(params);
+			blur_fft_reference(expected, params);
+
+			for(int y = 0; y < result.get_h(); ++y)
+				for(int x = 0; x < result.get_w(); ++x)
+					ASSERT(approximate_equal(result[y][x], expected[y][x]));
+		}
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	FFT::initialize();
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_box_matches_reference);
+	TEST_FUNCTION(test_fft_matches_complex_transforms);
+
+	TEST_SUITE_END()
+
+	FFT::deinitialize();
+	return tst_exit_status;
+}
@@ -0,0 +1,139 @@
+/* === S Y N F I G ========================================================= */
+/*! \file contextsnapshot.cpp
+**  \brief Test synfig::ContextSnapshot
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/contextsnapshot.h>
+
+#include "test_base.h"
+
+#include <synfig/canvas.h>
+#include <synfig/layers/layer_pastecanvas.h>
+#include <synfig/valuenodes/valuenode_const.h>
+#include <synfig/valuenodes/valuenode_linear.h>
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+struct Document
+{
+	Canvas::Handle root;
+	Canvas::Handle inline_canvas;
+	Layer::Handle group;
+	Layer::Handle solid;
+	ValueNode::Handle amount;
+
+	Document()
+	{
+		root = Canvas::create();
+		inline_canvas = Canvas::create_inline(root);
+
+		// amount of the solid color layer is equal to the time
+		ValueNode_Linear::Handle linear = ValueNode_Linear::create(Real(0));
+		linear->set_link("slope", ValueNode_Const::create(Real(1)));
+		amount = linear;
+
+		solid = Layer::create("solid_color");
+		solid->connect_dynamic_param("amount", amount);
+		inline_canvas->push_back(solid);
+
+		group = Layer::create("group");
+		group->set_param("canvas", inline_canvas);
+		root->push_back(group);
+
+		root->set_time(Time(0.25));
+	}
+
+	Layer::Handle get_cloned_solid(const ContextSnapshot &snapshot) const
+	{
+		Layer_PasteCanvas::Handle paste = Layer_PasteCanvas::Handle::cast_dynamic(*snapshot.get_context());
+		if (!paste || !paste->get_sub_canvas() || paste->get_sub_canvas()->empty())
+			return Layer::Handle();
+		return paste->get_sub_canvas()->front();
+	}
+};
+
+static void
+test_snapshot_is_evaluated_at_its_time()
+{
+	Document doc;
+	ContextSnapshot snapshot(doc.root->get_context(ContextParams()), Time(0.75));
+
+	Layer::Handle solid = doc.get_cloned_solid(snapshot);
+	ASSERT(solid);
+	ASSERT(solid != doc.solid);
+	ASSERT_APPROX_EQUAL(0.75, solid->get_param("amount").get(Real()));
+
+	// the same clones are evaluated again
+	snapshot.set_time(Time(0.5));
+	ASSERT(solid == doc.get_cloned_solid(snapshot));
+	ASSERT_APPROX_EQUAL(0.5, solid->get_param("amount").get(Real()));
+}
+
+static void
+test_snapshot_does_not_touch_document()
+{
+	Document doc;
+	const std::size_t parents = doc.amount->parent_count();
+	{
+		ContextSnapshot snapshot(doc.root->get_context(ContextParams()), Time(0.75));
+		ASSERT_EQUAL(parents, doc.amount->parent_count());
+		ASSERT_APPROX_EQUAL(0.25, doc.solid->get_param("amount").get(Real()));
+		ASSERT_EQUAL(std::size_t(1), doc.inline_canvas->size());
+	}
+	ASSERT_EQUAL(parents, doc.amount->parent_count());
+}
+
+static void
+test_copy_of_inline_canvas_has_the_same_parent()
+{
+	Document doc;
+	ContextSnapshot snapshot(doc.root->get_context(ContextParams()), Time(0.75));
+
+	Layer_PasteCanvas::Handle paste = Layer_PasteCanvas::Handle::cast_dynamic(*snapshot.get_context());
+	ASSERT(paste);
+	Canvas::Handle copy = paste->get_sub_canvas();
+	ASSERT(copy);
+	ASSERT(copy != doc.inline_canvas);
+	ASSERT(copy->parent() == doc.root);
+	ASSERT(doc.inline_canvas->parent() == doc.root);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main()
+{
+	Type::subsys_init();
+	Layer::subsys_init();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_snapshot_is_evaluated_at_its_time);
+		TEST_FUNCTION(test_snapshot_does_not_touch_document);
+		TEST_FUNCTION(test_copy_of_inline_canvas_has_the_same_parent);
+	TEST_SUITE_END()
+
+	Layer::subsys_stop();
+	Type::subsys_stop();
+	return tst_exit_status;
+}
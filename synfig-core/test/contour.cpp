@@ -0,0 +1,158 @@
+/* === S Y N F I G ========================================================= */
+/*! \file contour.cpp
+**  \brief Test synfig::rendering::software::Contour rasterizers
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/angle.h>
+#include <synfig/rendering/software/function/contour.h>
+
+#include "test_base.h"
+
+#include <cmath>
+
+using namespace synfig;
+using namespace rendering;
+
+/* === P R O C E D U R E S ================================================= */
+
+static rendering::Contour::ChunkList
+create_chunks()
+{
+	// self-intersecting star partially outside of the window,
+	// with spikes thinner than a pixel
+	rendering::Contour contour;
+	const int count = 150;
+	contour.move_to(Vector(250, 90));
+	for(int i = 1; i <= count; ++i) {
+		Real a = 2*PI*i/count;
+		Real r = i % 2 ? 40 : 170;
+		Vector p(90 + r*std::cos(a), 90 + r*std::sin(a));
+		if (i % 3)
+			contour.line_to(p);
+		else
+			contour.conic_to(p, Vector(90 + 60*std::cos(7*a), 90 + 60*std::sin(7*a)));
+	}
+	contour.close();
+	return contour.get_chunks();
+}
+
+static void
+render(
+	synfig::Surface &surface,
+	const RectInt &window,
+	bool rows,
+	bool invert,
+	bool antialias,
+	rendering::Contour::WindingStyle winding_style,
+	Color::BlendMethod blend_method )
+{
+	surface.set_wh(200, 160);
+	surface.fill(Color(0.25f, 0.5f, 0.75f, 0.5f));
+
+	Polyspan polyspan;
+	polyspan.init(window);
+	software::Contour::build_polyspan(create_chunks(), Matrix(), polyspan, 0.5);
+	polyspan.close();
+
+	const Color color(1.f, 0.5f, 0.f, 1.f);
+	if (rows) {
+		polyspan.finish_marks();
+		software::Contour::render_polyspan_rows(surface, polyspan, invert, antialias, winding_style, color, 0.75f, blend_method);
+	} else {
+		polyspan.sort_marks();
+		software::Contour::render_polyspan(surface, polyspan, invert, antialias, winding_style, color, 0.75f, blend_method);
+	}
+}
+
+static bool
+same_surface(const synfig::Surface &a, const synfig::Surface &b)
+{
+	const ColorReal precision = 1e-5f;
+	for(int y = 0; y < a.get_h(); ++y)
+		for(int x = 0; x < a.get_w(); ++x)
+			if ( std::fabs(a[y][x].get_r() - b[y][x].get_r()) > precision
+			  || std::fabs(a[y][x].get_g() - b[y][x].get_g()) > precision
+			  || std::fabs(a[y][x].get_b() - b[y][x].get_b()) > precision
+			  || std::fabs(a[y][x].get_a() - b[y][x].get_a()) > precision )
+				return false;
+	return true;
+}
+
+static void
+test_rows_match_sorted()
+{
+	const RectInt windows[] = {
+		RectInt(0, 0, 200, 160),
+		RectInt(13, 21, 150, 97),    // contour crosses all of the borders
+		RectInt(60, 70, 120, 110) }; // window inside of the contour
+	const rendering::Contour::WindingStyle winding_styles[] = {
+		rendering::Contour::WINDING_NON_ZERO,
+		rendering::Contour::WINDING_EVEN_ODD };
+	const Color::BlendMethod blend_methods[] = {
+		Color::BLEND_COMPOSITE,
+		Color::BLEND_STRAIGHT };
+
+	for(const RectInt &window : windows)
+	for(rendering::Contour::WindingStyle winding_style : winding_styles)
+	for(Color::BlendMethod blend_method : blend_methods)
+	for(int invert = 0; invert < 2; ++invert)
+	for(int antialias = 0; antialias < 2; ++antialias) {
+		synfig::Surface expected, result;
+		render(expected, window, false, invert, antialias, winding_style, blend_method);
+		render(result, window, true, invert, antialias, winding_style, blend_method);
+		ASSERT(same_surface(expected, result));
+	}
+}
+
+static void
+test_empty_polyspan()
+{
+	const RectInt window(10, 10, 30, 20);
+	for(int invert = 0; invert < 2; ++invert) {
+		synfig::Surface expected(40, 30), result(40, 30);
+		expected.fill(Color());
+		result.fill(Color());
+
+		Polyspan polyspan;
+		polyspan.init(window);
+		polyspan.sort_marks();
+		software::Contour::render_polyspan(expected, polyspan, invert, true, rendering::Contour::WINDING_NON_ZERO, Color::red(), 1.f, Color::BLEND_COMPOSITE);
+		software::Contour::render_polyspan_rows(result, polyspan, invert, true, rendering::Contour::WINDING_NON_ZERO, Color::red(), 1.f, Color::BLEND_COMPOSITE);
+		ASSERT(same_surface(expected, result));
+		ASSERT_EQUAL((invert ? 1.f : 0.f), result[15][20].get_a());
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_rows_match_sorted);
+	TEST_FUNCTION(test_empty_polyspan);
+
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
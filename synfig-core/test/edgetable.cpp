@@ -0,0 +1,186 @@
+/* === S Y N F I G ========================================================= */
+/*! \file edgetable.cpp
+**  \brief Test synfig::rendering::EdgeTable
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/angle.h>
+#include <synfig/rendering/software/function/contour.h>
+
+#include "test_base.h"
+
+#include <cmath>
+#include <map>
+
+using namespace synfig;
+using namespace rendering;
+
+/* === P R O C E D U R E S ================================================= */
+
+typedef std::map<std::pair<int, int>, std::pair<Real, Real>> CellMap;
+
+static rendering::Contour::ChunkList
+create_chunks()
+{
+	// star with lines, conics and cubics, partially outside of the window,
+	// and with a lot of short lines, which are merged by Polyspan
+	rendering::Contour contour;
+	const int count = 200;
+	contour.move_to(Vector(260, 100));
+	for(int i = 1; i <= count; ++i) {
+		Real a = 2*PI*i/count;
+		Real r = i % 2 ? 120 : 160;
+		Vector p(100 + r*std::cos(a), 100 + r*std::sin(a));
+		Vector c(100 + 200*std::cos(a - 0.01), 100 + 200*std::sin(a - 0.01));
+		switch(i % 4) {
+		case 0: contour.line_to(p); break;
+		case 1: contour.conic_to(p, c); break;
+		case 2: contour.cubic_to(p, c, Vector(100, 100)); break;
+		default:
+			for(int j = 1; j <= 10; ++j)
+				contour.line_to(p + Vector(j*0.01, -j*0.02));
+		}
+	}
+	contour.close();
+	return contour.get_chunks();
+}
+
+static CellMap
+get_cells(const Polyspan &polyspan)
+{
+	CellMap cells;
+	for(const Polyspan::PenMark &mark : polyspan.get_covers()) {
+		std::pair<Real, Real> &cell = cells[std::make_pair(mark.y, mark.x)];
+		cell.first += mark.cover;
+		cell.second += mark.area;
+	}
+	return cells;
+}
+
+static bool
+same_cells(const CellMap &a, const CellMap &b)
+{
+	const Real precision = 1e-9;
+	CellMap all = a;
+	all.insert(b.begin(), b.end());
+	for(const CellMap::value_type &cell : all) {
+		CellMap::const_iterator ia = a.find(cell.first);
+		CellMap::const_iterator ib = b.find(cell.first);
+		std::pair<Real, Real> va = ia == a.end() ? std::pair<Real, Real>() : ia->second;
+		std::pair<Real, Real> vb = ib == b.end() ? std::pair<Real, Real>() : ib->second;
+		if ( std::fabs(va.first - vb.first) > precision
+		  || std::fabs(va.second - vb.second) > precision )
+			return false;
+	}
+	return true;
+}
+
+static void
+test_strips_match_polyspan()
+{
+	const rendering::Contour::ChunkList chunks = create_chunks();
+	const RectInt window(0, 0, 240, 200);
+	const Real detail = 0.5;
+	Matrix matrix;
+
+	EdgeTable edge_table;
+	software::Contour::build_edge_table(chunks, matrix, window, edge_table, detail);
+	ASSERT(!edge_table.empty());
+
+	// strips are not aligned to buckets
+	for(int y = window.miny; y < window.maxy; y += 7) {
+		RectInt rect(window.minx, y, window.maxx, std::min(y + 7, window.maxy));
+
+		Polyspan expected;
+		expected.init(rect);
+		software::Contour::build_polyspan(chunks, matrix, expected, detail);
+		expected.close();
+		expected.sort_marks();
+
+		Polyspan result;
+		result.init(rect);
+		edge_table.add_to(result);
+		result.sort_marks();
+
+		ASSERT(same_cells(get_cells(expected), get_cells(result)));
+	}
+}
+
+static void
+test_tiles_match_polyspan()
+{
+	const rendering::Contour::ChunkList chunks = create_chunks();
+	const RectInt window(0, 0, 240, 200);
+	const Real detail = 0.5;
+	Matrix matrix;
+
+	EdgeTable edge_table;
+	software::Contour::build_edge_table(chunks, matrix, window, edge_table, detail);
+
+	// parts of the split task may be narrower than the table
+	for(int y = window.miny; y < window.maxy; y += 23)
+	for(int x = window.minx; x < window.maxx; x += 37) {
+		RectInt rect(x, y, std::min(x + 37, window.maxx), std::min(y + 23, window.maxy));
+
+		Polyspan expected;
+		expected.init(rect);
+		software::Contour::build_polyspan(chunks, matrix, expected, detail);
+		expected.close();
+		expected.sort_marks();
+
+		Polyspan result;
+		result.init(rect);
+		edge_table.add_to(result);
+		result.sort_marks();
+
+		ASSERT(same_cells(get_cells(expected), get_cells(result)));
+	}
+}
+
+static void
+test_empty_contour()
+{
+	EdgeTable edge_table;
+	software::Contour::build_edge_table(rendering::Contour::ChunkList(), Matrix(), RectInt(0, 0, 64, 64), edge_table);
+	ASSERT(edge_table.empty());
+
+	Polyspan polyspan;
+	polyspan.init(RectInt(0, 16, 64, 32));
+	edge_table.add_to(polyspan);
+	polyspan.sort_marks();
+	ASSERT(polyspan.get_covers().empty());
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_strips_match_polyspan);
+	TEST_FUNCTION(test_tiles_match_polyspan);
+	TEST_FUNCTION(test_empty_contour);
+
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
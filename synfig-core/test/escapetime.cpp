@@ -0,0 +1,166 @@
+/* === S Y N F I G ========================================================= */
+/*! \file escapetime.cpp
+**  \brief Test escape-time iteration of fractal layers
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <modules/lyr_std/escapetime.h>
+
+#include "test_base.h"
+
+#include <cstring>
+
+#include <synfig/rendering/common/optimizer/optimizersplit.h>
+#include <synfig/token.h>
+
+using namespace synfig;
+using namespace modules::lyr_std;
+
+/* === C L A S S E S ======================================================= */
+
+//! Task of the escape time, as Mandelbrot and Julia layers have
+class TaskTestEscapeTime: public TaskEscapeTime
+{
+public:
+	typedef etl::handle<TaskTestEscapeTime> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+};
+
+class TaskTestEscapeTimeSW: public TaskTestEscapeTime, public TaskEscapeTimeSW
+{
+public:
+	typedef etl::handle<TaskTestEscapeTimeSW> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	bool run(RunParams&) const override
+		{ return run_escape_time_task(); }
+	Color get_color(const Vector& pos) const override
+		{ return escape_time.calc(pos).iteration < 0 ? Color::black() : Color::white(); }
+};
+
+rendering::Task::Token TaskTestEscapeTime::token(
+	DescAbstract<TaskTestEscapeTime>("TaskTestEscapeTime") );
+rendering::Task::Token TaskTestEscapeTimeSW::token(
+	DescReal<TaskTestEscapeTimeSW, TaskTestEscapeTime>("TaskTestEscapeTimeSW") );
+
+/* === P R O C E D U R E S ================================================= */
+
+template<typename T>
+static bool
+same_bits(const T &a, const T &b)
+	{ return std::memcmp(&a, &b, sizeof(T)) == 0; }
+
+//! Row crosses the boundary of the set, so there are escaped and inner points,
+//! odd count also checks the points after the SIMD part.
+//! Steps are powers of two, so positions are the same even if this file is built with FMA
+static void
+check_row_is_the_same(const EscapeTime &escape_time)
+{
+	const Vector pos(-2.1, -0.93);
+	const Vector dx(0.03125, 0.015625);
+	const int count = 101;
+	std::vector<EscapeTime::Result> row(count);
+	escape_time.calc_row(pos, dx, count, row.data());
+
+	int escaped = 0;
+	for(int i = 0; i < count; ++i) {
+		const EscapeTime::Result r = escape_time.calc(pos + dx*Real(i));
+		ASSERT_EQUAL(r.iteration, row[i].iteration);
+		ASSERT(same_bits(r.zr, row[i].zr));
+		ASSERT(same_bits(r.zi, row[i].zi));
+		ASSERT(same_bits(r.mag, row[i].mag));
+		if (r.iteration >= 0) ++escaped;
+	}
+	ASSERT(escaped > 0);
+	ASSERT(escaped < count);
+}
+
+static EscapeTime
+create_escape_time(bool julia, bool broken)
+{
+	EscapeTime escape_time;
+	escape_time.julia = julia;
+	escape_time.broken = broken;
+	escape_time.iterations = 64;
+	escape_time.bailout = 4;
+	escape_time.seed = Vector(-0.75, 0.11);
+	return escape_time;
+}
+
+static void
+test_mandelbrot_row_is_the_same()
+	{ check_row_is_the_same(create_escape_time(false, false)); }
+
+static void
+test_broken_mandelbrot_row_is_the_same()
+	{ check_row_is_the_same(create_escape_time(false, true)); }
+
+static void
+test_julia_row_is_the_same()
+	{ check_row_is_the_same(create_escape_time(true, false)); }
+
+static void
+test_broken_julia_row_is_the_same()
+	{ check_row_is_the_same(create_escape_time(true, true)); }
+
+static void
+test_task_is_split()
+{
+	TaskTestEscapeTimeSW::Handle task(new TaskTestEscapeTimeSW());
+	task->escape_time = create_escape_time(false, false);
+	task->set_coords(Rect(-2.0, -2.0, 2.0, 2.0), VectorInt(256, 256));
+
+	rendering::Task::List list;
+	list.push_back(task);
+	rendering::OptimizerSplit optimizer(4);
+	optimizer.run(rendering::Optimizer::RunParams(rendering::Optimizer::CATEGORY_ID_SPECIALIZED, list));
+
+	// iterations make the small task heavy enough for all threads
+	ASSERT_EQUAL(std::size_t(4), list.size());
+	RectInt bounds = list.front()->target_rect;
+	for(const rendering::Task::Handle &part : list) {
+		ASSERT(TaskTestEscapeTimeSW::Handle::cast_dynamic(part));
+		bounds |= part->target_rect;
+	}
+	ASSERT(bounds == RectInt(0, 0, 256, 256));
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	Token::rebuild();
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_mandelbrot_row_is_the_same);
+	TEST_FUNCTION(test_broken_mandelbrot_row_is_the_same);
+	TEST_FUNCTION(test_julia_row_is_the_same);
+	TEST_FUNCTION(test_broken_julia_row_is_the_same);
+	TEST_FUNCTION(test_task_is_split);
+
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -0,0 +1,127 @@
+/* === S Y N F I G ========================================================= */
+/*! \file fft.cpp
+**  \brief Test synfig::rendering::software::FFT
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/rendering/software/function/fft.h>
+
+#include "test_base.h"
+
+#include <vector>
+
+using namespace synfig;
+using namespace rendering;
+using software::Array;
+using software::FFT;
+
+/* === P R O C E D U R E S ================================================= */
+
+static const int planes = 3;
+static const int rows = 12;
+static const int cols = 15;
+
+static Real
+value(int plane, int row, int col)
+	{ return ((plane*5 + row*7 + col*13) % 17)/16.0 - 0.5; }
+
+static std::vector<Real>
+create_planes(int stride)
+{
+	std::vector<Real> data(planes*rows*stride);
+	for(int p = 0; p < planes; ++p)
+		for(int r = 0; r < rows; ++r)
+			for(int c = 0; c < cols; ++c)
+				data[(p*rows + r)*stride + c] = value(p, r, c);
+	return data;
+}
+
+static Array<Real, 3>
+planes_array(std::vector<Real> &data, int stride)
+{
+	Array<Real, 3> x(&data.front());
+	x.set_dim(planes, rows*stride)
+	 .set_dim(rows, stride)
+	 .set_dim(cols, 1);
+	return x;
+}
+
+static void
+test_real_transform_matches_complex_transform()
+{
+	const int stride = FFT::get_real_stride(cols);
+	std::vector<Real> data = create_planes(stride);
+	FFT::fft2d_real(planes_array(data, stride), false);
+
+	for(int p = 0; p < planes; ++p)
+	{
+		std::vector<Complex> full(rows*cols);
+		for(int r = 0; r < rows; ++r)
+			for(int c = 0; c < cols; ++c)
+				full[r*cols + c] = Complex(value(p, r, c));
+		Array<Complex, 2> arr_full(&full.front());
+		arr_full.set_dim(rows, cols).set_dim(cols, 1);
+		FFT::fft2d(arr_full, false);
+
+		// real transform keeps the first half of each row of spectrum
+		const Complex *half = (const Complex*)&data[p*rows*stride];
+		for(int r = 0; r < rows; ++r)
+			for(int c = 0; c <= cols/2; ++c)
+				ASSERT(std::abs(full[r*cols + c] - half[r*stride/2 + c]) < 1e-9);
+	}
+}
+
+static void
+test_real_transform_inverts()
+{
+	// wide rows to check the padding after the spectrum
+	const int stride = FFT::get_real_stride(cols) + 4;
+	for(int do_cols = 0; do_cols < 2; ++do_cols)
+	{
+		std::vector<Real> data = create_planes(stride);
+		FFT::fft2d_real(planes_array(data, stride), false, do_cols);
+		FFT::fft2d_real(planes_array(data, stride), true, do_cols);
+
+		for(int p = 0; p < planes; ++p)
+			for(int r = 0; r < rows; ++r)
+				for(int c = 0; c < cols; ++c)
+					ASSERT(std::fabs(data[(p*rows + r)*stride + c] - value(p, r, c)) < 1e-9);
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	FFT::initialize();
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_real_transform_matches_complex_transform);
+	TEST_FUNCTION(test_real_transform_inverts);
+
+	TEST_SUITE_END()
+
+	FFT::deinitialize();
+
+	return tst_exit_status;
+}
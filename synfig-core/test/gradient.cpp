@@ -606,6 +606,49 @@ test_BAD_gradient_3_colors_fetches_similar_to_the_LAST_color_for_position_near_t
 	// ASSERT(Color(0, .2, .8, 1.) == g1(0.6));
 }
 
+void
+test_compiled_gradient_batch_average_is_the_same_as_average_for_each_position()
+{
+	Gradient g(Color::red(), Color::green(), Color::blue());
+	for(int repeat = 0; repeat < 2; ++repeat) {
+		CompiledGradient cg(g, repeat, false);
+
+		// positions go forward, back and jump out of the range
+		const int count = 40;
+		Real x[count], w[count];
+		for(int i = 0; i < count; ++i) {
+			x[i] = i < 30 ? i*0.05 - 0.2 : 1.5 - i*0.1;
+			w[i] = i % 7 ? 0.01*(i % 3) : 0.0;
+		}
+
+		Color colors[count];
+		cg.average(x, w, count, colors);
+		for(int i = 0; i < count; ++i)
+			ASSERT(cg.average(x[i] - w[i], x[i] + w[i]) == colors[i]);
+	}
+}
+
+void
+test_compiled_gradient_row_is_the_same_as_average_for_each_pixel()
+{
+	Gradient g(Color::red(), Color::green(), Color::blue());
+	CompiledGradient cg(g, true, false);
+
+	// longer than one chunk of positions
+	const int count = 150;
+	const Vector p(-0.3, 0.5), dx(0.01, 0.002);
+	auto position = [](const Vector& point, Real& x, Real& w) { x = point[0] + point[1]; w = 0.005*point[1]; };
+
+	Color colors[count];
+	cg.average_row(p, dx, count, colors, position);
+	Vector point = p;
+	for(int i = 0; i < count; ++i, point += dx) {
+		Real x, w;
+		position(point, x, w);
+		ASSERT(cg.average(x - w, x + w) == colors[i]);
+	}
+}
+
 /* === E N T R Y P O I N T ================================================= */
 
 int main() {
@@ -654,6 +697,9 @@ int main() {
 	TEST_FUNCTION(test_BAD_gradient_3_colors_fetches_similar_to_the_FIRST_color_for_position_near_to_the_middle_position_from_left)
 	TEST_FUNCTION(test_BAD_gradient_3_colors_fetches_similar_to_the_LAST_color_for_position_near_to_the_middle_position_from_right)
 
+	TEST_FUNCTION(test_compiled_gradient_batch_average_is_the_same_as_average_for_each_position)
+	TEST_FUNCTION(test_compiled_gradient_row_is_the_same_as_average_for_each_pixel)
+
 	TEST_SUITE_END()
 
 	return tst_exit_status;
@@ -0,0 +1,165 @@
+/* === S Y N F I G ========================================================= */
+/*! \file importer.cpp
+**  \brief Test cache and prefetching of frames of synfig::Importer
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/importer.h>
+
+#include "test_base.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <synfig/surface.h>
+#include <synfig/threadpool.h>
+
+using namespace synfig;
+
+/* === C L A S S E S ======================================================= */
+
+//! Animated importer which counts decoded frames
+class FrameImporter : public Importer
+{
+public:
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::map<Time, int> decoded;
+	std::map<Time, std::thread::id> threads;
+
+	FrameImporter(): Importer(FileSystem::Identifier(nullptr, "frames.avi")) { }
+
+	bool is_animated() override { return true; }
+
+	bool get_frame(Surface &surface, const RendDesc &, Time time, ProgressCallback *) override
+	{
+		surface.set_wh(1, 1);
+		surface[0][0] = Color::white();
+		std::lock_guard<std::mutex> lock(mutex);
+		++decoded[time];
+		threads[time] = std::this_thread::get_id();
+		cond.notify_all();
+		return true;
+	}
+
+	int get_decoded(const Time &time)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return decoded.count(time) ? decoded[time] : 0;
+	}
+
+	std::thread::id get_thread(const Time &time)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return threads[time];
+	}
+
+	bool wait_decoded(const Time &time, int milliseconds)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return cond.wait_for(lock, std::chrono::milliseconds(milliseconds), [&]() { return decoded.count(time) > 0; });
+	}
+};
+
+/* === P R O C E D U R E S ================================================= */
+
+static void
+test_frames_are_cached()
+{
+	etl::handle<FrameImporter> importer(new FrameImporter());
+	RendDesc desc;
+	ASSERT(importer->Importer::get_frame(desc, Time(0)));
+	ASSERT(importer->Importer::get_frame(desc, Time(0)));
+	ASSERT_EQUAL(1, importer->get_decoded(Time(0)));
+}
+
+static void
+test_prefetch_runs_while_frame_renders()
+{
+	// rendering threads take the whole budget, as RenderQueue does while the frame renders
+	std::vector<std::unique_ptr<ThreadPool::BusyLock>> locks;
+	for(int i = 0; i < ThreadPool::get_thread_budget(); ++i)
+		locks.emplace_back(new ThreadPool::BusyLock());
+
+	etl::handle<FrameImporter> importer(new FrameImporter());
+	RendDesc desc;
+	ASSERT(importer->Importer::get_frame(desc, Time(0)));
+	ASSERT(importer->Importer::get_frame(desc, Time(1)));
+
+	// the next frame is decoded in advance, not when it is requested
+	ASSERT(importer->wait_decoded(Time(2), 5000));
+	ASSERT(importer->Importer::get_frame(desc, Time(2)));
+	ASSERT_EQUAL(1, importer->get_decoded(Time(2)));
+
+	locks.clear();
+}
+
+static void
+test_sequence_is_decoded_in_advance()
+{
+	etl::handle<FrameImporter> importer(new FrameImporter());
+	RendDesc desc;
+	for(int i = 0; i < 8; ++i) {
+		const Time time(i);
+		ASSERT(importer->Importer::get_frame(desc, time));
+
+		// frame renders by the whole budget until the next one is ready
+		std::vector<std::unique_ptr<ThreadPool::BusyLock>> locks;
+		for(int j = 0; j < ThreadPool::get_thread_budget(); ++j)
+			locks.emplace_back(new ThreadPool::BusyLock());
+		if (i > 0)
+			ASSERT(importer->wait_decoded(Time(i + 1), 5000));
+	}
+
+	// the step between frames is known after the second one,
+	// and all the next frames are decoded once and not by the renderer
+	for(int i = 2; i < 8; ++i) {
+		ASSERT_EQUAL(1, importer->get_decoded(Time(i)));
+		ASSERT(importer->get_thread(Time(i)) != std::this_thread::get_id());
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	ThreadPool::set_thread_budget(2);
+	ThreadPool::subsys_init();
+	Importer::subsys_init();
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_frames_are_cached);
+	TEST_FUNCTION(test_prefetch_runs_while_frame_renders);
+	TEST_FUNCTION(test_sequence_is_decoded_in_advance);
+
+	TEST_SUITE_END()
+
+	// prefetching slots keep handles of importers
+	ThreadPool::subsys_stop();
+	Importer::subsys_stop();
+	return tst_exit_status;
+}
@@ -0,0 +1,141 @@
+/* === S Y N F I G ========================================================= */
+/*! \file jsonparser.cpp
+**  \brief Test JSON lines of the batch rendering server
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <tool/jsonparser.h>
+
+#include "test_base.h"
+
+/* === P R O C E D U R E S ================================================= */
+
+static bool
+parse(const std::string &line, JsonParser::Fields &fields)
+{
+	std::string error;
+	fields.clear();
+	return JsonParser::parse_object(line, fields, error);
+}
+
+static void
+test_values()
+{
+	JsonParser::Fields fields;
+	ASSERT(parse(" { \"id\" : \"a\", \"fps\":24.5, \"quality\":-3, \"sif\":true, \"canvas\":null } ", fields));
+	ASSERT_EQUAL(std::size_t(5), fields.size());
+	ASSERT_EQUAL(std::string("a"), fields["id"]);
+	ASSERT_EQUAL(std::string("24.5"), fields["fps"]);
+	ASSERT_EQUAL(std::string("-3"), fields["quality"]);
+	ASSERT_EQUAL(std::string("true"), fields["sif"]);
+	ASSERT_EQUAL(std::string(), fields["canvas"]);
+
+	ASSERT(parse("{}", fields));
+	ASSERT(fields.empty());
+}
+
+static void
+test_escapes()
+{
+	JsonParser::Fields fields;
+	ASSERT(parse("{\"file\":\"a\\\"b\\\\c\\/d\\n\\t\"}", fields));
+	ASSERT_EQUAL(std::string("a\"b\\c/d\n\t"), fields["file"]);
+
+	ASSERT(parse("{\"file\":\"\\u0041\\u00e9\\u20AC\"}", fields));
+	ASSERT_EQUAL(std::string("A\xC3\xA9\xE2\x82\xAC"), fields["file"]);
+
+	// U+1F600 by surrogate pair
+	ASSERT(parse("{\"file\":\"\\ud83d\\ude00\"}", fields));
+	ASSERT_EQUAL(std::string("\xF0\x9F\x98\x80"), fields["file"]);
+}
+
+static void
+test_invalid_surrogates()
+{
+	JsonParser::Fields fields;
+	// high surrogate without low one
+	ASSERT(!parse("{\"file\":\"\\ud83d\"}", fields));
+	ASSERT(!parse("{\"file\":\"\\ud83dx\"}", fields));
+	// the second half is not a low surrogate
+	ASSERT(!parse("{\"file\":\"\\ud83d\\u0041\"}", fields));
+	ASSERT(!parse("{\"file\":\"\\ud83d\\ud83d\"}", fields));
+	// low surrogate alone
+	ASSERT(!parse("{\"file\":\"\\ude00\"}", fields));
+}
+
+static void
+test_errors()
+{
+	JsonParser::Fields fields;
+	std::string error;
+	ASSERT(!JsonParser::parse_object("{\"id\":\"a\"", fields, error));
+	ASSERT(!error.empty());
+
+	ASSERT(!parse("", fields));
+	ASSERT(!parse("[]", fields));
+	ASSERT(!parse("{\"id\":}", fields));
+	ASSERT(!parse("{\"id\":\"a\",}", fields));
+	ASSERT(!parse("{\"id\":\"a\"} x", fields));
+	ASSERT(!parse("{\"id\":\"unterminated}", fields));
+	ASSERT(!parse("{\"fps\":2x4}", fields));
+	ASSERT(!parse("{\"file\":\"\\u00g1\"}", fields));
+}
+
+static void
+test_quote_is_parsed_back()
+{
+	const std::string str = "a\"b\\c\nd\re\tf\x01g";
+	JsonParser::Fields fields;
+	ASSERT(parse("{\"s\":" + JsonParser::quote(str) + "}", fields));
+	ASSERT_EQUAL(str, fields["s"]);
+}
+
+static void
+test_numbers()
+{
+	double x = 0;
+	ASSERT(JsonParser::parse_number("1.5", x));
+	ASSERT_APPROX_EQUAL(1.5, x);
+	ASSERT(JsonParser::parse_number("-2e3", x));
+	ASSERT_APPROX_EQUAL(-2000.0, x);
+	ASSERT(!JsonParser::parse_number("1,5", x));
+	ASSERT(!JsonParser::parse_number("", x));
+	ASSERT_EQUAL(std::string("0.25"), JsonParser::number(0.25));
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_values);
+	TEST_FUNCTION(test_escapes);
+	TEST_FUNCTION(test_invalid_surrogates);
+	TEST_FUNCTION(test_errors);
+	TEST_FUNCTION(test_quote_is_parsed_back);
+	TEST_FUNCTION(test_numbers);
+
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
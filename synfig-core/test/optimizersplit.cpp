@@ -0,0 +1,176 @@
+/* === S Y N F I G ========================================================= */
+/*! \file optimizersplit.cpp
+**  \brief Test synfig::rendering::OptimizerSplit
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/rendering/common/optimizer/optimizersplit.h>
+#include <synfig/rendering/costmodel.h>
+
+#include "test_base.h"
+
+#include <synfig/canvas.h>
+#include <synfig/context.h>
+#include <synfig/layer.h>
+#include <synfig/rendering/software/renderersw.h>
+#include <synfig/target_scanline.h>
+#include <synfig/token.h>
+
+using namespace synfig;
+using namespace rendering;
+
+/* === P R O C E D U R E S ================================================= */
+
+static void
+test_small_task_is_not_split()
+{
+	VectorInt grid = OptimizerSplit::get_grid(RectInt(0, 0, 64, 64), 1.0, 0.0, false, CostModel::default_seconds_per_unit, 8);
+	ASSERT_EQUAL(1, grid[0]*grid[1]);
+}
+
+static void
+test_single_thread_is_not_split()
+{
+	VectorInt grid = OptimizerSplit::get_grid(RectInt(0, 0, 4096, 4096), 1.0, 0.0, false, CostModel::default_seconds_per_unit, 1);
+	ASSERT_EQUAL(1, grid[0]*grid[1]);
+}
+
+static void
+test_parts_count_is_limited_by_threads()
+{
+	VectorInt grid = OptimizerSplit::get_grid(RectInt(0, 0, 1920, 1080), 1.0, 0.0, false, CostModel::default_seconds_per_unit, 8);
+	ASSERT_EQUAL(8, grid[0]*grid[1]);
+	// tiles, not strips
+	ASSERT(grid[0] > 1);
+	ASSERT(grid[1] > 1);
+}
+
+static void
+test_split_by_rows()
+{
+	VectorInt grid = OptimizerSplit::get_grid(RectInt(0, 0, 1920, 1080), 1.0, 0.0, true, CostModel::default_seconds_per_unit, 8);
+	ASSERT_EQUAL(1, grid[0]);
+	ASSERT_EQUAL(8, grid[1]);
+}
+
+static void
+test_part_cost_reduces_count()
+{
+	// each part repeats the work comparable with the whole pixels work
+	const Real pixels = 1920.0*1080.0;
+	VectorInt cheap = OptimizerSplit::get_grid(RectInt(0, 0, 1920, 1080), 1.0, 0.0, true, CostModel::default_seconds_per_unit, 8);
+	VectorInt heavy = OptimizerSplit::get_grid(RectInt(0, 0, 1920, 1080), 1.0, 0.2*pixels, true, CostModel::default_seconds_per_unit, 8);
+	ASSERT(heavy[1] < cheap[1]);
+}
+
+static Optimizer::Handle
+find_split_optimizer(const Renderer &renderer)
+{
+	for(const Optimizer::Handle &optimizer : renderer.get_optimizers(Optimizer::CATEGORY_ID_LIST))
+		if (dynamic_cast<const OptimizerSplit*>(optimizer.get()))
+			return optimizer;
+	return Optimizer::Handle();
+}
+
+//! Optimizes the frame of the scene with a large triangle, as the software renderer does
+static Task::List
+optimize_scene(int threads)
+{
+	ValueBase points;
+	points.set_list_of(std::vector<Point>{ Point(-3.0, -2.0), Point(3.0, -2.0), Point(0.0, 2.0) });
+	Layer::Handle polygon = Layer::create("polygon");
+	polygon->set_param("vector_list", points);
+	Canvas::Handle canvas = Canvas::create();
+	canvas->push_back(polygon);
+
+	RendDesc desc;
+	desc.set_wh(1920, 1080);
+	desc.set_tl(Point(-4.0, 2.25));
+	desc.set_br(Point(4.0, -2.25));
+
+	Task::List list;
+	list.push_back(Target_Scanline::build_frame_task(new SurfaceResource(), *canvas, ContextParams(), desc));
+
+	RendererSW renderer;
+	renderer.unregister_optimizer(find_split_optimizer(renderer));
+	renderer.register_optimizer(new OptimizerSplit(threads));
+	renderer.optimize(list);
+	return list;
+}
+
+static int
+count_contour_parts(const Task::List &list, RectInt &bounds)
+{
+	int count = 0;
+	for(const Task::Handle &task : list)
+		if (task && task->get_token()->name == "ContourSW") {
+			bounds = count ? bounds | task->target_rect : task->target_rect;
+			++count;
+		}
+	return count;
+}
+
+static void
+test_registered_in_software_renderer()
+{
+	RendererSW renderer;
+	ASSERT(find_split_optimizer(renderer));
+}
+
+static void
+test_scene_is_split()
+{
+	RectInt bounds;
+	ASSERT_EQUAL(1, count_contour_parts(optimize_scene(1), bounds));
+	const RectInt whole = bounds;
+
+	const int count = count_contour_parts(optimize_scene(4), bounds);
+	ASSERT(count > 1);
+	ASSERT(count <= 4);
+	ASSERT(bounds == whole);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	// tasks are specialized for the software renderer by their tokens
+	Token::rebuild();
+	Type::subsys_init();
+	Layer::subsys_init();
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_small_task_is_not_split);
+	TEST_FUNCTION(test_single_thread_is_not_split);
+	TEST_FUNCTION(test_parts_count_is_limited_by_threads);
+	TEST_FUNCTION(test_split_by_rows);
+	TEST_FUNCTION(test_part_cost_reduces_count);
+	TEST_FUNCTION(test_registered_in_software_renderer);
+	TEST_FUNCTION(test_scene_is_split);
+
+	TEST_SUITE_END()
+
+	Layer::subsys_stop();
+	Type::subsys_stop();
+	return tst_exit_status;
+}
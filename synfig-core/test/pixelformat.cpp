@@ -0,0 +1,211 @@
+/* === S Y N F I G ========================================================= */
+/*! \file pixelformat.cpp
+**  \brief Test conversions of synfig::PixelFormat and synfig::Gamma
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/color/pixelformat.h>
+
+#include "test_base.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+static std::vector<Color>
+create_row(int count)
+{
+	std::vector<Color> row;
+	for(int i = 0; i < count; ++i)
+		row.push_back(Color(
+			(i % 23)/20.f - 0.05f,
+			(i % 7)/6.f,
+			(i % 101)/100.f,
+			(i % 13)/12.f ));
+	return row;
+}
+
+//! the simple conversion of one channel to 8 bits
+static unsigned char
+to_byte(ColorReal x)
+	{ return (unsigned char)(std::max(ColorReal(0), std::min(ColorReal(1), x))*ColorReal(255.9)); }
+
+void
+test_simple_formats_match_per_pixel_conversion()
+{
+	const PixelFormat formats[] = {
+		PF_RGB, PF_BGR, PF_RGB|PF_A, PF_BGR|PF_A, PF_RGB|PF_A|PF_A_START, PF_BGR|PF_A|PF_A_START };
+
+	// odd count to process the tail of row too
+	const int count = 37;
+	const std::vector<Color> src = create_row(count);
+
+	for(PixelFormat pf : formats) {
+		std::vector<unsigned char> dst(count*pixel_size(pf));
+		color_to_pixelformat(dst.data(), src.data(), pf, nullptr, count);
+
+		const unsigned char *d = dst.data();
+		for(int i = 0; i < count; ++i) {
+			const Color &c = src[i];
+			if (FLAGS(pf, PF_A_START))
+				ASSERT_EQUAL(to_byte(c.get_a()), *d++);
+			if (FLAGS(pf, PF_BGR)) {
+				ASSERT_EQUAL(to_byte(c.get_b()), *d++);
+				ASSERT_EQUAL(to_byte(c.get_g()), *d++);
+				ASSERT_EQUAL(to_byte(c.get_r()), *d++);
+			} else {
+				ASSERT_EQUAL(to_byte(c.get_r()), *d++);
+				ASSERT_EQUAL(to_byte(c.get_g()), *d++);
+				ASSERT_EQUAL(to_byte(c.get_b()), *d++);
+			}
+			if (FLAGS(pf, PF_A) && !FLAGS(pf, PF_A_START))
+				ASSERT_EQUAL(to_byte(c.get_a()), *d++);
+		}
+	}
+}
+
+//! the conversion of one channel through the 16-bit value, used for gamma-corrected colors
+static unsigned char
+to_byte_by_word(ColorReal x)
+	{ return (unsigned char)((int)(std::max(ColorReal(0), std::min(ColorReal(1), x))*ColorReal(65535.99)) >> 8); }
+
+void
+test_conversion_with_gamma_keeps_quantization_by_words()
+{
+	const PixelFormat formats[] = { PF_RGB, PF_BGR|PF_A, PF_RGB|PF_A|PF_A_START };
+
+	// values where 255.9 and 65535.99/256 quantizations differ
+	const int count = 37;
+	std::vector<Color> src = create_row(count);
+	for(int i = 0; i < count; ++i)
+		src[i].set_g((i + 1)/ColorReal(255.95));
+
+	// gamma 1 keeps colors exactly, so only the quantization is tested
+	const Gamma gamma(1.f, 1.f, 1.f);
+	for(PixelFormat pf : formats) {
+		std::vector<unsigned char> dst(count*pixel_size(pf));
+		color_to_pixelformat(dst.data(), src.data(), pf, &gamma, count);
+
+		const unsigned char *d = dst.data();
+		for(int i = 0; i < count; ++i) {
+			const Color &c = src[i];
+			const unsigned char a = (unsigned char)(std::max(ColorReal(0), std::min(ColorReal(1), c.get_a()))*ColorReal(255.99));
+			if (FLAGS(pf, PF_A_START))
+				ASSERT_EQUAL(a, *d++);
+			if (FLAGS(pf, PF_BGR)) {
+				ASSERT_EQUAL(to_byte_by_word(c.get_b()), *d++);
+				ASSERT_EQUAL(to_byte_by_word(c.get_g()), *d++);
+				ASSERT_EQUAL(to_byte_by_word(c.get_r()), *d++);
+			} else {
+				ASSERT_EQUAL(to_byte_by_word(c.get_r()), *d++);
+				ASSERT_EQUAL(to_byte_by_word(c.get_g()), *d++);
+				ASSERT_EQUAL(to_byte_by_word(c.get_b()), *d++);
+			}
+			if (FLAGS(pf, PF_A) && !FLAGS(pf, PF_A_START))
+				ASSERT_EQUAL(a, *d++);
+		}
+	}
+}
+
+void
+test_conversion_with_gamma_is_close_to_gamma_apply()
+{
+	const PixelFormat formats[] = {
+		PF_RGB, PF_RGB|PF_A, PF_RGB|PF_A|PF_A_PREMULT, PF_GRAY, PF_GRAY|PF_A|PF_A_PREMULT };
+
+	const int count = 1000;
+	std::vector<Color> src = create_row(count);
+	for(int i = 0; i < count; ++i)
+		src[i].set_r(i/ColorReal(count - 1));
+
+	const Gamma gamma(1/2.2f, 1/1.8f, 2.2f);
+	std::vector<Color> applied(count);
+	for(int i = 0; i < count; ++i)
+		applied[i] = gamma.apply(src[i]);
+
+	for(PixelFormat pf : formats) {
+		std::vector<unsigned char> expected(count*pixel_size(pf)), dst(expected.size());
+		color_to_pixelformat(expected.data(), applied.data(), pf, nullptr, count);
+		color_to_pixelformat(dst.data(), src.data(), pf, &gamma, count);
+		for(size_t i = 0; i < dst.size(); ++i)
+			ASSERT(std::abs(expected[i] - dst[i]) <= 1);
+	}
+}
+
+void
+test_gamma_apply_row_is_close_to_gamma_apply()
+{
+	const Gamma gamma(2.2f, 1.f, 1/2.2f);
+	std::vector<Color> src = create_row(1000);
+	for(int i = 0; i < 1000; ++i)
+		src[i].set_r((i - 100)/ColorReal(200));
+
+	std::vector<Color> dst(src.size());
+	gamma.apply_row(dst.data(), src.data(), (int)src.size());
+	for(size_t i = 0; i < src.size(); ++i) {
+		const Color expected = gamma.apply(src[i]);
+		// relative error
+		ASSERT(std::fabs(expected.get_r() - dst[i].get_r()) <= 1e-5f*std::fabs(expected.get_r()));
+		ASSERT(std::fabs(expected.get_b() - dst[i].get_b()) <= 1e-5f*std::fabs(expected.get_b()));
+		ASSERT_EQUAL(src[i].get_g(), dst[i].get_g());
+		ASSERT_EQUAL(src[i].get_a(), dst[i].get_a());
+	}
+}
+
+void
+test_gamma_table_matches_gamma_apply()
+{
+	const Gamma gamma(2.2f, 1.8f, 1/2.2f);
+	for(int maxval : { 1, 255, 65535 }) {
+		GammaTable table(gamma, maxval);
+		ASSERT_EQUAL(maxval, table.get_maxval());
+		for(int i = 0; i <= maxval; i += 1 + maxval/300) {
+			const ColorReal x = i/ColorReal(maxval);
+			const Color c = table.apply(i, i, i, i);
+			ASSERT_EQUAL(gamma.apply_r(x), c.get_r());
+			ASSERT_EQUAL(gamma.apply_g(x), c.get_g());
+			ASSERT_EQUAL(gamma.apply_b(x), c.get_b());
+			ASSERT_EQUAL(x, c.get_a());
+		}
+	}
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_simple_formats_match_per_pixel_conversion);
+	TEST_FUNCTION(test_conversion_with_gamma_keeps_quantization_by_words);
+	TEST_FUNCTION(test_conversion_with_gamma_is_close_to_gamma_apply);
+	TEST_FUNCTION(test_gamma_apply_row_is_close_to_gamma_apply);
+	TEST_FUNCTION(test_gamma_table_matches_gamma_apply);
+
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
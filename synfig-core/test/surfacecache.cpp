@@ -0,0 +1,185 @@
+/* === S Y N F I G ========================================================= */
+/*! \file surfacecache.cpp
+**  \brief Test synfig::rendering::SurfaceCache
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/rendering/surfacecache.h>
+
+#include "test_base.h"
+
+#include <synfig/color.h>
+#include <synfig/rendering/common/task/taskblend.h>
+
+using namespace synfig;
+using namespace rendering;
+
+/* === P R O C E D U R E S ================================================= */
+
+static SurfaceResource::Handle
+create_surface(int width, int height)
+{
+	SurfaceResource::Handle surface = new SurfaceResource();
+	surface->create(width, height);
+	return surface;
+}
+
+static void
+test_empty_cache_counts_misses()
+{
+	SurfaceCache cache(1024*1024);
+	ASSERT_FALSE(cache.get(1));
+	ASSERT_FALSE(cache.get(2));
+
+	SurfaceCache::Stats stats = cache.get_stats();
+	ASSERT_EQUAL(0, stats.hits);
+	ASSERT_EQUAL(2, stats.misses);
+	ASSERT_EQUAL(0u, stats.count);
+}
+
+static void
+test_key_is_admitted_on_second_request()
+{
+	SurfaceCache cache(1024*1024);
+	ASSERT_FALSE(cache.admit(1));
+	ASSERT_FALSE(cache.admit(2));
+	ASSERT(cache.admit(1));
+	ASSERT_FALSE(cache.admit(1));
+}
+
+static void
+test_put_and_get_surface()
+{
+	SurfaceCache cache(1024*1024);
+	SurfaceResource::Handle surface = create_surface(16, 8);
+	cache.put(1, surface);
+	ASSERT(cache.get(1) == surface);
+
+	SurfaceCache::Stats stats = cache.get_stats();
+	ASSERT_EQUAL(1, stats.hits);
+	ASSERT_EQUAL(1u, stats.count);
+	ASSERT_EQUAL(16*8*sizeof(Color), stats.size);
+}
+
+static void
+test_least_recently_used_surface_is_evicted()
+{
+	const size_t surface_size = 10*10*sizeof(Color);
+	SurfaceCache cache(2*surface_size);
+	cache.put(1, create_surface(10, 10));
+	cache.put(2, create_surface(10, 10));
+	ASSERT(cache.get(1));
+	cache.put(3, create_surface(10, 10));
+
+	ASSERT(cache.get(1));
+	ASSERT_FALSE(cache.get(2));
+	ASSERT(cache.get(3));
+
+	SurfaceCache::Stats stats = cache.get_stats();
+	ASSERT_EQUAL(1, stats.evictions);
+	ASSERT_EQUAL(2u, stats.count);
+	ASSERT_EQUAL(2*surface_size, stats.size);
+}
+
+static void
+test_surface_larger_than_limit_is_not_cached()
+{
+	SurfaceCache cache(10*10*sizeof(Color));
+	cache.put(1, create_surface(10, 10));
+	cache.put(2, create_surface(20, 20));
+	ASSERT(cache.get(1));
+	ASSERT_FALSE(cache.get(2));
+	ASSERT_EQUAL(0, cache.get_stats().evictions);
+}
+
+static void
+test_reducing_limit_evicts_surfaces()
+{
+	SurfaceCache cache(1024*1024);
+	cache.put(1, create_surface(10, 10));
+	cache.put(2, create_surface(10, 10));
+	cache.set_max_size(10*10*sizeof(Color));
+	ASSERT_FALSE(cache.get(1));
+	ASSERT(cache.get(2));
+
+	cache.set_max_size(0);
+	ASSERT_FALSE(cache.is_enabled());
+	ASSERT_EQUAL(0u, cache.get_stats().count);
+}
+
+static Task::Handle
+create_blend_task(ColorReal amount)
+{
+	TaskBlend::Handle task = new TaskBlend();
+	task->amount = amount;
+	return task;
+}
+
+static void
+test_key_depends_on_task_and_surface_size()
+{
+	Task::Handle a = create_blend_task(0.5);
+	Task::Handle b = create_blend_task(0.25);
+	ASSERT(SurfaceCache::get_key(*a, VectorInt(10, 10)).hash);
+	ASSERT(SurfaceCache::get_key(*a, VectorInt(10, 10)) == SurfaceCache::get_key(*create_blend_task(0.5), VectorInt(10, 10)));
+	ASSERT(SurfaceCache::get_key(*a, VectorInt(10, 10)) != SurfaceCache::get_key(*a, VectorInt(10, 20)));
+	ASSERT(SurfaceCache::get_key(*a, VectorInt(10, 10)) != SurfaceCache::get_key(*b, VectorInt(10, 10)));
+}
+
+static void
+test_key_of_unhashable_task_is_empty()
+{
+	Task::Handle list = new TaskList();
+	list->sub_tasks.push_back(new TaskSurface());
+	ASSERT_FALSE(SurfaceCache::get_key(*list, VectorInt(10, 10)).hash);
+}
+
+static void
+test_keys_with_equal_hashes_are_not_mixed_up()
+{
+	SurfaceCache cache(1024*1024);
+	SurfaceResource::Handle surface = create_surface(10, 10);
+	cache.put(SurfaceCache::Key(1, "first task"), surface);
+	ASSERT_FALSE(cache.get(SurfaceCache::Key(1, "second task")));
+	ASSERT(cache.get(SurfaceCache::Key(1, "first task")) == surface);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_empty_cache_counts_misses);
+	TEST_FUNCTION(test_key_is_admitted_on_second_request);
+	TEST_FUNCTION(test_put_and_get_surface);
+	TEST_FUNCTION(test_least_recently_used_surface_is_evicted);
+	TEST_FUNCTION(test_surface_larger_than_limit_is_not_cached);
+	TEST_FUNCTION(test_reducing_limit_evicts_surfaces);
+	TEST_FUNCTION(test_key_depends_on_task_and_surface_size);
+	TEST_FUNCTION(test_key_of_unhashable_task_is_empty);
+	TEST_FUNCTION(test_keys_with_equal_hashes_are_not_mixed_up);
+
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -0,0 +1,315 @@
+/* === S Y N F I G ========================================================= */
+/*! \file target.cpp
+**  \brief Test frames of synfig::Target
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/target_scanline.h>
+
+#include "test_base.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include <synfig/canvas.h>
+#include <synfig/general.h>
+#include <synfig/layer.h>
+#include <synfig/rendering/renderer.h>
+#include <synfig/target_async.h>
+#include <synfig/token.h>
+
+using namespace synfig;
+
+/* === C L A S S E S ======================================================= */
+
+//! Records the frames passed to the target and the times of frames
+class RecordTarget : public Target_Scanline
+{
+	std::vector<Color> buffer;
+
+public:
+	typedef etl::handle<RecordTarget> Handle;
+
+	std::vector<int> frames;
+	std::vector<Time> times;
+	std::vector<int> done;
+	//! end_frame() of this frame fails
+	int fail_frame = -1;
+
+	RecordTarget()
+	{
+		set_engine("software");
+		signal_frame_done().connect([this](int frame) { done.push_back(frame); });
+	}
+
+	filesystem::Path get_frame_filename(int frame) const override
+		{ return filesystem::Path(strprintf("out.%04d.png", frame)); }
+
+	int next_frame(Time& time) override
+	{
+		int remaining = Target_Scanline::next_frame(time);
+		times.push_back(time);
+		return remaining;
+	}
+
+	bool start_frame(ProgressCallback*) override
+	{
+		frames.push_back(get_frame());
+		buffer.resize(desc.get_w());
+		return true;
+	}
+	void end_frame() override
+	{
+		if (get_frame() == fail_frame)
+			set_frame_failed();
+	}
+	Color* start_scanline(int) override { return buffer.data(); }
+	bool end_scanline() override { return true; }
+};
+
+//! Frames written by the targets of Target_Async
+struct FrameLog
+{
+	std::mutex mutex;
+	std::vector<int> frames;
+	std::vector<std::string> filenames;
+	int fail_frame = -1;
+	int fail_write_frame = -1;
+};
+
+//! Target of the single frame, called from encoder threads
+class FrameTarget : public Target_Scanline
+{
+	FrameLog &log;
+	std::vector<Color> buffer;
+
+public:
+	explicit FrameTarget(FrameLog &log): log(log) { }
+
+	filesystem::Path get_frame_filename(int frame) const override
+		{ return filesystem::Path(strprintf("out.%04d.png", frame)); }
+
+	bool start_frame(ProgressCallback*) override
+	{
+		buffer.resize(desc.get_w());
+		return get_frame() != log.fail_frame;
+	}
+	void end_frame() override
+	{
+		if (get_frame() == log.fail_write_frame)
+			{ set_frame_failed(); return; }
+		std::lock_guard<std::mutex> lock(log.mutex);
+		log.frames.push_back(get_frame());
+		log.filenames.push_back(get_frame_filename(get_frame()).u8string());
+	}
+	Color* start_scanline(int) override { return buffer.data(); }
+	bool end_scanline() override { return true; }
+};
+
+/* === P R O C E D U R E S ================================================= */
+
+static Canvas::Handle
+create_canvas()
+{
+	Canvas::Handle canvas = Canvas::create();
+	RendDesc &desc = canvas->rend_desc();
+	desc.set_wh(8, 8);
+	desc.set_frame_rate(10);
+	desc.set_time_start(Time(1));
+	desc.set_time_end(Time(2));
+	return canvas;
+}
+
+static void
+test_next_frame_of_whole_range()
+{
+	RecordTarget::Handle target = new RecordTarget();
+	target->set_canvas(create_canvas());
+	ASSERT_EQUAL(11, target->get_frame_count());
+	ASSERT_EQUAL(10, target->get_frame());
+
+	Time t;
+	ASSERT_EQUAL(10, target->next_frame(t));
+	ASSERT_EQUAL(10, target->get_frame());
+	ASSERT_APPROX_EQUAL(1.0, (double)t);
+	ASSERT_EQUAL(9, target->next_frame(t));
+	ASSERT_EQUAL(11, target->get_frame());
+	ASSERT_APPROX_EQUAL(1.1, (double)t);
+}
+
+static void
+test_next_frame_of_list()
+{
+	RecordTarget::Handle target = new RecordTarget();
+	target->set_canvas(create_canvas());
+	target->set_frame_list(std::vector<int>{ 12, 15, 20 });
+	ASSERT_EQUAL(3, target->get_frame_count());
+	ASSERT_EQUAL(12, target->get_frame());
+
+	Time t;
+	ASSERT_EQUAL(2, target->next_frame(t));
+	ASSERT_EQUAL(12, target->get_frame());
+	ASSERT_APPROX_EQUAL(1.2, (double)t);
+	ASSERT_EQUAL(1, target->next_frame(t));
+	ASSERT_EQUAL(15, target->get_frame());
+	ASSERT_APPROX_EQUAL(1.5, (double)t);
+	ASSERT_EQUAL(0, target->next_frame(t));
+	ASSERT_EQUAL(20, target->get_frame());
+	ASSERT_APPROX_EQUAL(2.0, (double)t);
+}
+
+static void
+check_render_frame_list(int frames_in_flight)
+{
+	RecordTarget::Handle target = new RecordTarget();
+	target->set_canvas(create_canvas());
+	target->set_frames_in_flight(frames_in_flight);
+	const std::vector<int> frames{ 11, 13, 14, 19 };
+	target->set_frame_list(frames);
+	ASSERT(target->render());
+
+	ASSERT(target->frames == frames);
+	ASSERT(target->done == frames);
+	ASSERT_EQUAL(frames.size(), target->times.size());
+	for(size_t i = 0; i < frames.size(); ++i)
+		ASSERT_APPROX_EQUAL(frames[i]/10.0, (double)target->times[i]);
+	ASSERT_EQUAL(std::string("out.0013.png"), target->get_frame_filename(target->frames[1]).u8string());
+}
+
+static void
+test_render_frame_list()
+	{ check_render_frame_list(1); }
+
+static void
+test_render_frame_list_in_flight()
+	{ check_render_frame_list(3); }
+
+static void
+check_render_fails_if_frame_is_not_written(int frames_in_flight)
+{
+	RecordTarget::Handle target = new RecordTarget();
+	target->set_canvas(create_canvas());
+	target->set_frames_in_flight(frames_in_flight);
+	target->fail_frame = 13;
+	ASSERT(!target->render());
+	ASSERT(target->done == std::vector<int>({ 10, 11, 12 }));
+}
+
+static void
+test_render_fails_if_frame_is_not_written()
+{
+	check_render_fails_if_frame_is_not_written(1);
+	check_render_fails_if_frame_is_not_written(3);
+}
+
+static void
+test_add_frame_fails_if_frame_is_not_written()
+{
+	RecordTarget::Handle target = new RecordTarget();
+	target->set_canvas(create_canvas());
+	Surface surface(8, 8);
+	ASSERT(target->add_frame(&surface, nullptr));
+	target->fail_frame = target->get_frame();
+	ASSERT(!target->add_frame(&surface, nullptr));
+}
+
+static Target_Async::Handle
+create_async_target(FrameLog &log)
+{
+	Target_Async::Handle target = new Target_Async(
+		[&log]() { return Target_Scanline::Handle(new FrameTarget(log)); }, 2 );
+	target->set_engine("software");
+	target->set_canvas(create_canvas());
+	return target;
+}
+
+static void
+test_async_writes_frames_by_their_numbers()
+{
+	FrameLog log;
+	Target_Async::Handle target = create_async_target(log);
+	const std::vector<int> frames{ 10, 12, 13, 17, 20 };
+	target->set_frame_list(frames);
+
+	std::vector<int> encoded;
+	target->signal_frame_encoded().connect([&encoded](int frame, double) { encoded.push_back(frame); });
+	ASSERT(target->render());
+
+	// encoders may finish frames in any order
+	std::sort(log.frames.begin(), log.frames.end());
+	std::sort(log.filenames.begin(), log.filenames.end());
+	std::sort(encoded.begin(), encoded.end());
+	ASSERT(log.frames == frames);
+	ASSERT(encoded == frames);
+	ASSERT_EQUAL(std::string("out.0010.png"), log.filenames.front());
+	ASSERT_EQUAL(std::string("out.0020.png"), log.filenames.back());
+	ASSERT_EQUAL(std::string("out.0013.png"), target->get_frame_filename(13).u8string());
+}
+
+static void
+test_async_fails_if_frame_is_not_written()
+{
+	FrameLog log;
+	log.fail_frame = 13;
+	Target_Async::Handle target = create_async_target(log);
+
+	std::vector<int> encoded;
+	target->signal_frame_encoded().connect([&encoded](int frame, double) { encoded.push_back(frame); });
+	ASSERT(!target->render());
+	ASSERT(std::find(encoded.begin(), encoded.end(), 13) == encoded.end());
+	ASSERT(std::find(log.frames.begin(), log.frames.end(), 13) == log.frames.end());
+
+	// error is found after the frame was passed to encoder
+	FrameLog write_log;
+	write_log.fail_write_frame = 15;
+	target = create_async_target(write_log);
+	ASSERT(!target->render());
+	ASSERT(std::find(write_log.frames.begin(), write_log.frames.end(), 15) == write_log.frames.end());
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	Token::rebuild();
+	Type::subsys_init();
+	rendering::Renderer::subsys_init();
+	Layer::subsys_init();
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_next_frame_of_whole_range);
+	TEST_FUNCTION(test_next_frame_of_list);
+	TEST_FUNCTION(test_render_frame_list);
+	TEST_FUNCTION(test_render_frame_list_in_flight);
+	TEST_FUNCTION(test_render_fails_if_frame_is_not_written);
+	TEST_FUNCTION(test_add_frame_fails_if_frame_is_not_written);
+	TEST_FUNCTION(test_async_writes_frames_by_their_numbers);
+	TEST_FUNCTION(test_async_fails_if_frame_is_not_written);
+
+	TEST_SUITE_END()
+
+	Layer::subsys_stop();
+	rendering::Renderer::subsys_stop();
+	Type::subsys_stop();
+	return tst_exit_status;
+}
@@ -0,0 +1,124 @@
+/* === S Y N F I G ========================================================= */
+/*! \file threadpool.cpp
+**  \brief Test classes of work of synfig::ThreadPool
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/threadpool.h>
+
+#include "test_base.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include <sigc++/bind.h>
+
+using namespace synfig;
+
+/* === C L A S S E S ======================================================= */
+
+//! Flag which is set by the slot of ThreadPool
+struct Done
+{
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool done = false;
+
+	void set()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		done = true;
+		cond.notify_all();
+	}
+
+	bool wait(int milliseconds)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return cond.wait_for(lock, std::chrono::milliseconds(milliseconds), [this]() { return done; });
+	}
+};
+
+/* === P R O C E D U R E S ================================================= */
+
+static void
+set_done(Done *done)
+	{ done->set(); }
+
+static void
+wait_done(Done *done)
+	{ done->wait(60000); }
+
+static void
+test_io_runs_while_budget_is_busy()
+{
+	// rendering threads take the whole budget, as RenderQueue does while the frame renders
+	std::vector<std::unique_ptr<ThreadPool::BusyLock>> locks;
+	for(int i = 0; i < ThreadPool::get_thread_budget(); ++i)
+		locks.emplace_back(new ThreadPool::BusyLock());
+
+	Done render, io;
+	ThreadPool::instance().enqueue(sigc::bind(sigc::ptr_fun(&set_done), &render), ThreadPool::PRIORITY_RENDER);
+	ThreadPool::instance().enqueue(sigc::bind(sigc::ptr_fun(&set_done), &io), ThreadPool::PRIORITY_IO);
+
+	ASSERT(io.wait(5000));
+	ASSERT(!render.wait(50));
+
+	locks.clear();
+	ASSERT(render.wait(5000));
+}
+
+static void
+test_io_places_are_limited()
+{
+	const int count = ThreadPool::instance().get_max_io_threads();
+	ASSERT(count > 0);
+
+	// the last slot is queued after the ones which take all places of IO
+	Done release, last;
+	for(int i = 0; i < count; ++i)
+		ThreadPool::instance().enqueue(sigc::bind(sigc::ptr_fun(&wait_done), &release), ThreadPool::PRIORITY_IO);
+	ThreadPool::instance().enqueue(sigc::bind(sigc::ptr_fun(&set_done), &last), ThreadPool::PRIORITY_IO);
+	ASSERT(!last.wait(100));
+
+	release.set();
+	ASSERT(last.wait(5000));
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	ThreadPool::set_thread_budget(2);
+	ThreadPool::subsys_init();
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_io_runs_while_budget_is_busy);
+	TEST_FUNCTION(test_io_places_are_limited);
+
+	TEST_SUITE_END()
+
+	ThreadPool::subsys_stop();
+	return tst_exit_status;
+}
@@ -0,0 +1,179 @@
+/* === S Y N F I G ========================================================= */
+/*! \file valuenode_composite.cpp
+**  \brief Test synfig::ValueNode_Composite and the value cache of nodes
+**
+**  \legal
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <synfig/valuenodes/valuenode_composite.h>
+
+#include "test_base.h"
+
+#include <synfig/valuenodes/valuenode_const.h>
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+static void
+test_vector_composite_returns_components()
+{
+	ValueNode::Handle composite = ValueNode_Composite::create(Vector(1.0, 2.0));
+	ASSERT_VECTOR_APPROX_EQUAL(Vector(1.0, 2.0), (*composite)(0).get(Vector()));
+}
+
+static void
+test_value_cache_is_disabled_by_default()
+{
+	ValueNode::Handle composite = ValueNode_Composite::create(Vector(1.0, 2.0));
+	ASSERT_FALSE(composite->get_value_cache_enabled());
+
+	long long hits, misses;
+	ValueNode::reset_value_cache_stats();
+	(*composite)(0);
+	(*composite)(0);
+	ValueNode::get_value_cache_stats(hits, misses);
+	ASSERT_EQUAL(0, hits);
+	ASSERT_EQUAL(0, misses);
+}
+
+static void
+test_value_cache_hits_for_the_same_time()
+{
+	ValueNode::Handle composite = ValueNode_Composite::create(Vector(1.0, 2.0));
+	composite->set_value_cache_enabled(true);
+
+	long long hits, misses;
+	ValueNode::reset_value_cache_stats();
+	ASSERT_VECTOR_APPROX_EQUAL(Vector(1.0, 2.0), (*composite)(1).get(Vector()));
+	ASSERT_VECTOR_APPROX_EQUAL(Vector(1.0, 2.0), (*composite)(1).get(Vector()));
+	ASSERT_VECTOR_APPROX_EQUAL(Vector(1.0, 2.0), (*composite)(2).get(Vector()));
+	ValueNode::get_value_cache_stats(hits, misses);
+	ASSERT_EQUAL(1, hits);
+	ASSERT_EQUAL(2, misses);
+}
+
+static void
+test_value_cache_is_dropped_when_child_changed()
+{
+	ValueNode_Composite::Handle composite = ValueNode_Composite::create(Vector(1.0, 2.0));
+	composite->set_value_cache_enabled(true);
+	ASSERT_VECTOR_APPROX_EQUAL(Vector(1.0, 2.0), (*composite)(0).get(Vector()));
+
+	ValueNode_Const::Handle x = ValueNode_Const::Handle::cast_dynamic(composite->get_link(0));
+	ASSERT(x);
+	x->set_value(Real(5.0));
+	ASSERT_VECTOR_APPROX_EQUAL(Vector(5.0, 2.0), (*composite)(0).get(Vector()));
+}
+
+static void
+test_value_cache_is_dropped_by_invalidate()
+{
+	ValueNode::Handle composite = ValueNode_Composite::create(Vector(1.0, 2.0));
+	composite->set_value_cache_enabled(true);
+	(*composite)(0);
+
+	long long hits, misses;
+	ValueNode::reset_value_cache_stats();
+	composite->invalidate_value_cache();
+	(*composite)(0);
+	ValueNode::get_value_cache_stats(hits, misses);
+	ASSERT_EQUAL(0, hits);
+	ASSERT_EQUAL(1, misses);
+}
+
+static void
+test_value_cache_is_dropped_when_child_is_invalidated()
+{
+	ValueNode_Composite::Handle composite = ValueNode_Composite::create(Vector(1.0, 2.0));
+	composite->set_value_cache_enabled(true);
+	(*composite)(0);
+
+	long long hits, misses;
+	ValueNode::reset_value_cache_stats();
+	composite->get_link(0)->invalidate_value_cache();
+	(*composite)(0);
+	ValueNode::get_value_cache_stats(hits, misses);
+	ASSERT_EQUAL(0, hits);
+	ASSERT_EQUAL(1, misses);
+}
+
+static void
+test_value_cache_is_kept_when_other_node_changed()
+{
+	ValueNode_Composite::Handle composite = ValueNode_Composite::create(Vector(1.0, 2.0));
+	ValueNode_Composite::Handle other = ValueNode_Composite::create(Vector(3.0, 4.0));
+	composite->set_value_cache_enabled(true);
+	(*composite)(0);
+
+	long long hits, misses;
+	ValueNode::reset_value_cache_stats();
+	ValueNode_Const::Handle::cast_dynamic(other->get_link(0))->set_value(Real(5.0));
+	other->invalidate_value_cache();
+	(*composite)(0);
+	ValueNode::get_value_cache_stats(hits, misses);
+	ASSERT_EQUAL(1, hits);
+	ASSERT_EQUAL(0, misses);
+}
+
+static void
+test_value_cache_drops_least_recently_used_value()
+{
+	ValueNode::Handle composite = ValueNode_Composite::create(Vector(1.0, 2.0));
+	composite->set_value_cache_enabled(true);
+
+	// time 0 is used all the time, so it stays in the full cache
+	for(int i = 1; i <= 100; ++i) {
+		(*composite)(0);
+		(*composite)(Time(i));
+	}
+
+	long long hits, misses;
+	ValueNode::reset_value_cache_stats();
+	(*composite)(0);
+	(*composite)(Time(100));
+	(*composite)(Time(1));
+	ValueNode::get_value_cache_stats(hits, misses);
+	ASSERT_EQUAL(2, hits);
+	ASSERT_EQUAL(1, misses);
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	Type::subsys_init();
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_vector_composite_returns_components);
+	TEST_FUNCTION(test_value_cache_is_disabled_by_default);
+	TEST_FUNCTION(test_value_cache_hits_for_the_same_time);
+	TEST_FUNCTION(test_value_cache_is_dropped_when_child_changed);
+	TEST_FUNCTION(test_value_cache_is_dropped_by_invalidate);
+	TEST_FUNCTION(test_value_cache_is_dropped_when_child_is_invalidated);
+	TEST_FUNCTION(test_value_cache_is_kept_when_other_node_changed);
+	TEST_FUNCTION(test_value_cache_drops_least_recently_used_value);
+
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -573,7 +573,7 @@ Renderer_Canvas::enqueue_render_frame(
 		// Renderer::enqueue contains the expensive 'optimization' stage, so call it async
 		ThreadPool::instance().enqueue( sigc::bind(
 			sigc::ptr_fun(&rendering::Renderer::enqueue_task_func),
-			renderer, tile_task, tile->event, false ));
+			renderer, tile_task, tile->event, false ), ThreadPool::PRIORITY_OPTIMIZE );
 	}
 
 	return true;